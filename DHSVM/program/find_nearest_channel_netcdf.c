@@ -23,17 +23,21 @@
 
 /* This code is used to find out the location of the nearest channel to ALL in-basin cells (mask > 0)
    
-   ************ One potential issue with this code is that if no channel is found in 100 cell-moves or loops,
-    the location of the nearest channel is wherevere at the time of the bail ************
+   The result is written as a pair of NetCDF int maps, <output_file>.drains_y.nc (Basin.DrainsY)
+   and <output_file>.drains_x.nc (Basin.DrainsX), holding the row and column of the channel cell
+   each cell drains to.  These are the IMPERVIOUS DRAINS Y FILE and IMPERVIOUS DRAINS X FILE
+   inputs to DHSVM.
 
-   ****Usage: nrows ncols binary_flowd_file binary_mask_file stream_map_file n_header_map_file
-   Note that n_header_map_file = the number of header lines in the stream map file ********
+   ****Usage: nrows ncols cell_size Xorig Yorig flowd_file mask_file stream_map_file output_file n_header [text]
+   Writes output_file.drains_y.nc and output_file.drains_x.nc
+   Note that n_header = the number of header lines in the stream map file ********
+   If "text" is given, the old-style text surface routing file is also written to output_file.
 
    Algorithms used to find the nearest channel:
 1) Recast the flow direction from 1~128
    |-----|-----|-----|      
    | 32  | 64  | 128 |      The central cell searches its nearest channel. The search radius/path coincides with
-   |-----|-----|-----|      the flow direction.The searching radius < 100 grid cells. 
+   |-----|-----|-----|      the flow direction.
    | 16  |     |  1  |       
    |-----|-----|-----|      
    |  8	 |  4  |  2  |
@@ -53,7 +57,14 @@ Code Credit:   Original code believed to be written by Pascal Storck, 3/13/2001
 imperfect basin masks (in coastal areas) and 8-direction flow by Matthew Wiley 12/15/2004.
 *********************************************************************************************************************************/
 
+#define UNRESOLVED -1
+#define ONPATH -2
+
 int GetNumber(char *numberStr);
+void TraceToChannel(int nrows, int ncols, unsigned char **flowd,
+		    unsigned char **mask, unsigned char **has_channel,
+		    int *drains);
+void WriteDrainsNetCDF(char *FileName, int *drains, MAPSIZE *Map, int getx);
 float GetFloat(char *numberStr);
 int CopyDouble(double *Value, char *Str, const int NValues);
 
@@ -77,13 +88,10 @@ int main(int argc, char **argv)
   int y,x;
   int i,nskip;
   char line[255],flowdname[255],maskname[255],mapname[255], outputpath[255];
-  int miny,minx;
+  char drainsname[2][300];
+  int *drains;
+  int writetext;
   int icol,irow;
-  int dist,mindist,sx,sy,mx,my,tempy,tempx,tx,ty;
-  int gotchannel;
-  int xneighbor[16] = {1, 1, 0, -1, -1, -1, 0, 1, 1, 1, 0, -1, -1, -1, 0, 1};
-  int yneighbor[16] = {0, 1, 1, 1, 0, -1, -1, -1, 0, 1, 1, 1, 0, -1, -1, -1};
-  int err = 1;
   MAPSIZE Map;
   MAPDUMP DMap;
   char VarName[255];
@@ -94,15 +102,18 @@ int main(int argc, char **argv)
 
   if(argc < 11) {
     printf("usage: <nrows> <ncols> <cell_size> <Xorig> <Yorig> <flowd_file> \n"); 
-	printf("usage: <mask_file> <stream_map_file> <n_header>\n");
+	printf("usage: <mask_file> <stream_map_file> <output_file> <n_header> [text]\n");
     printf("where: flowd_file is a netCDF flow direction file in the same format as mask file\n");
     printf("       make sure that the flowd_file is free of sinks, etc\n");
     printf("       flowdirection is assumed to be from ARC-INFO, i.e. 1 to 128\n");
     printf("       netCDF mask_file and stream_map_file are the DHSVM specific \n");
     printf("       input files for mask and stream_map file, respectively \n");
+    printf("       output_file is the base name of the output surface routing maps, \n");
+    printf("       <output_file>.drains_y.nc and <output_file>.drains_x.nc \n");
     printf("       n_header are the number of header lines in the stream map file\n");
     printf("       enter 0 if there are no header lines, i.e. lines starting with #\n");
     printf("       caution: make sure you are referring to the map file not the network file\n");
+    printf("       text also writes the old text surface routing file to output_file\n");
     exit(-1);
   }
 
@@ -121,6 +132,7 @@ int main(int argc, char **argv)
   strcpy(mapname,argv[8]);
   strcpy(outputpath, argv[9]);
   nskip = GetNumber(argv[10]);
+  writetext = (argc > 11 && strcmp(argv[11], "text") == 0);
 
 
   Map.X = 0;
@@ -140,7 +152,10 @@ int main(int argc, char **argv)
     printf("input file not opened \n");
     exit(-1);
   }
-  if (!(outfile = fopen(outputpath, "wt"))){
+  sprintf(drainsname[0], "%s.drains_y.nc", outputpath);
+  sprintf(drainsname[1], "%s.drains_x.nc", outputpath);
+  outfile = NULL;
+  if (writetext && !(outfile = fopen(outputpath, "wt"))){
     printf("output file not opened \n");
     exit(-1);
   }
@@ -288,57 +303,163 @@ int main(int argc, char **argv)
       //printf("%d %d \n",icol,irow);
   } 
  
-  /* Trace each pixel in the masked area to the nearest downslope pixel */
+  /* Trace each pixel in the masked area to the nearest downslope channel */
   printf("looking for channels \n");
-  for (y = 0; y < nrows; y++) 
-  {
-	  // printf("row %d \n",y);
-	  for (x = 0; x < ncols; x++) 
-	  {
-		  if (mask[y][x]>0) 
-		  {
-			  /* remember the starting point and reset the total distance (in # of cells of moves)*/
-			  sx=x;
-		      sy=y;
-			  mx=x;
-		      my=y;
-			  dist = 0;
-			  gotchannel=0;
-			  gotchannel=has_channel[sy][sx];
-			  /* provide a switch to bail if we haven't escaped in 100 moves, uses wherevere it was at the time of the bail */
-			  while(dist < 100.0 && gotchannel == 0) 
-			  {
-				  /*make the move and check to see if it has a channel*/   
-				  tempx=xneighbor[flowd[my][mx]];
-				  tempy=yneighbor[flowd[my][mx]];
-				  tx = mx;
-				  ty = my;
-				  mx+=tempx;
-				  my+=tempy;
-				  err = 1;
-				  while (mask[my][mx] == 0 ) 
-				  {
-					  //printf("Routing out of mask! Changing flowd[%d][%d] from %d to %d\n", ty,tx,flowd[ty][tx], flowd[ty][tx]+ err);
-					  mx = tx;
-					  my = ty;
-				      tempx=xneighbor[flowd[ty][tx]+ err];
-					  tempy=yneighbor[flowd[ty][tx]+ err];
-					  err++;
-					  mx+=tempx;
-					  my+=tempy;
-				  }
-				  gotchannel=has_channel[my][mx];
-				  dist+=1.0;
-				  //printf("start cell(%d, %d) to cell(%d, %d) with flow dir = %d \n",sy,sx,my,mx,flowd[my][mx]);
-			  }
-			  printf("nearest channel to cell(%d, %d) is cell(%d, %d) \n",y,x,my,mx);
-			  fprintf(outfile,"%d %d %d %d \n",sy,sx,my,mx);
-		  } 
-	  }
+  if (!(drains = (int *) calloc(nrows * ncols, sizeof(int)))) {
+    printf("failed to allocate memory \n");
+    exit(-1);
+  }
+  TraceToChannel(nrows, ncols, flowd, mask, has_channel, drains);
+
+  /* Write the drains_y and drains_x maps as NetCDF int grids, which DHSVM
+     reads with Read2DMatrix() */
+  WriteDrainsNetCDF(drainsname[0], drains, &Map, 0);
+  WriteDrainsNetCDF(drainsname[1], drains, &Map, 1);
+  printf("wrote %s and %s \n", drainsname[0], drainsname[1]);
+
+  /* The text routing file is only written on request */
+  if (outfile != NULL) {
+    for (y = 0; y < nrows; y++) {
+      for (x = 0; x < ncols; x++) {
+	if (mask[y][x] > 0)
+	  fprintf(outfile, "%d %d %d %d \n", y, x,
+		  drains[y*ncols + x] / ncols, drains[y*ncols + x] % ncols);
+      }
+    }
+    fclose(outfile);
   }
+  free(drains);
   return EXIT_SUCCESS;
 }
 
+/*****************************************************************************
+  TraceToChannel()
+
+  Finds the channel cell each in-basin cell drains to by following the flow
+  directions.  A flow path is only walked until it meets a cell whose target
+  is already known; that target is then assigned to every cell on the path.
+  Each cell is therefore visited once and the whole map is resolved in
+  O(nrows*ncols).  As before, a move that leaves the mask is turned to the
+  next direction clockwise.  A path that closes on itself drains to the cell
+  where the loop was found, and a cell with no in-mask neighbor drains to
+  itself.
+
+  drains holds the target as y*ncols + x, or -1 outside the mask.
+*****************************************************************************/
+void TraceToChannel(int nrows, int ncols, unsigned char **flowd,
+		    unsigned char **mask, unsigned char **has_channel,
+		    int *drains)
+{
+  int xneighbor[16] = {1, 1, 0, -1, -1, -1, 0, 1, 1, 1, 0, -1, -1, -1, 0, 1};
+  int yneighbor[16] = {0, 1, 1, 1, 0, -1, -1, -1, 0, 1, 1, 1, 0, -1, -1, -1};
+  int *path;
+  int npath;
+  int cell, next, target;
+  int x, y, mx, my, tx, ty;
+  int err, i;
+
+  if (!(path = (int *) calloc(nrows * ncols, sizeof(int)))) {
+    printf("failed to allocate memory \n");
+    exit(-1);
+  }
+  for (i = 0; i < nrows * ncols; i++)
+    drains[i] = UNRESOLVED;
+
+  for (y = 0; y < nrows; y++) {
+    for (x = 0; x < ncols; x++) {
+      if (mask[y][x] == 0 || drains[y*ncols + x] >= 0)
+	continue;
+
+      npath = 0;
+      cell = y*ncols + x;
+      while (1) {
+	ty = cell / ncols;
+	tx = cell % ncols;
+	if (has_channel[ty][tx]) {
+	  drains[cell] = target = cell;
+	  break;
+	}
+	drains[cell] = ONPATH;
+	path[npath++] = cell;
+
+	/* make the move, turning away from cells outside the mask */
+	next = -1;
+	for (err = 0; err < 8; err++) {
+	  mx = tx + xneighbor[flowd[ty][tx] + err];
+	  my = ty + yneighbor[flowd[ty][tx] + err];
+	  if (mx >= 0 && mx < ncols && my >= 0 && my < nrows && mask[my][mx] > 0) {
+	    next = my*ncols + mx;
+	    break;
+	  }
+	}
+
+	if (next < 0) {
+	  target = cell;
+	  break;
+	}
+	if (drains[next] >= 0) {
+	  target = drains[next];
+	  break;
+	}
+	if (drains[next] == ONPATH) {
+	  printf("flow path from cell(%d, %d) loops at cell(%d, %d) \n",
+		 y, x, next / ncols, next % ncols);
+	  target = next;
+	  break;
+	}
+	cell = next;
+      }
+      for (i = 0; i < npath; i++)
+	drains[path[i]] = target;
+    }
+  }
+  free(path);
+}
+
+/*****************************************************************************
+  WriteDrainsNetCDF()
+
+  Writes the row (getx = 0) or column (getx = 1) of each cell's target as a
+  NetCDF int map, -1 outside the mask
+*****************************************************************************/
+void WriteDrainsNetCDF(char *FileName, int *drains, MAPSIZE *Map, int getx)
+{
+  MAPDUMP DMap;
+  int *tempi;
+  int i;
+
+  if (!(tempi = (int *) calloc(Map->NY * Map->NX, sizeof(int)))) {
+    printf("failed to allocate memory \n");
+    exit(-1);
+  }
+  for (i = 0; i < Map->NY * Map->NX; i++) {
+    if (drains[i] < 0)
+      tempi[i] = -1;
+    else
+      tempi[i] = getx ? drains[i] % Map->NX : drains[i] / Map->NX;
+  }
+
+  strcpy(DMap.FileName, FileName);
+  DMap.ID = getx ? 024 : 023;
+  DMap.Layer = 1;
+  DMap.Resolution = MAP_OUTPUT;
+  strcpy(DMap.Name, getx ? "Basin.DrainsX" : "Basin.DrainsY");
+  strcpy(DMap.LongName, getx ? "Impervious drainage column" : "Impervious drainage row");
+  strcpy(DMap.Format, "%d");
+  strcpy(DMap.FileLabel, DMap.LongName);
+  strcpy(DMap.Units, "");
+  DMap.NumberType = NC_INT;
+  DMap.MaxVal = 0;
+  DMap.MinVal = 0;
+  DMap.N = 1;
+  DMap.DumpDate = NULL;
+
+  CreateMapFileNetCDF(DMap.FileName, DMap.FileLabel, Map);
+  Write2DMatrixNetCDF(DMap.FileName, tempi, DMap.NumberType, Map->NY, Map->NX,
+		      &DMap, 0);
+  free(tempi);
+}
+
 /*****************************************************************************
   GetNumber()
 *****************************************************************************/
@@ -10,7 +10,14 @@
  *               state variables over the basin.
  * DESCRIP-END.
  * FUNCTIONS:    Aggregate()
- * COMMENTS:
+ *               AggregateRow()
+ * COMMENTS:     Sums are accumulated in double precision, one row at a time,
+ *               and rows are combined in a fixed pairwise order, so the
+ *               result does not depend on the number of OpenMP threads.
+ *               The averages that enter the mass balance are kept in double
+ *               precision in Total->Water and the AGGREGATED doubles.
+ *               The same pass updates the snow statistics and counts the
+ *               saturated pixels, so the grid is only swept once per step.
  * $Id: Aggregate.c,v 1.17 2018/02/18 ning Exp $
  */
 
@@ -24,6 +31,58 @@
 #include "functions.h"
 #include "constants.h"
 
+/* Slots of the double precision row sums.  Layered quantities follow the
+   scalars, see AggregateOffsets() */
+enum AGGSLOTS {
+  AGG_NPIXELS = 0, AGG_SATURATED, AGG_SATEXTENT, AGG_HASSNOW,
+  AGG_ETOT, AGG_EVAPSOIL,
+  AGG_PRECIP, AGG_SNOWFALL, AGG_CANOPYWATER,
+  AGG_TAIR, AGG_OBSSHORTIN, AGG_BEAMIN, AGG_DIFFUSEIN, AGG_PIXELNETSHORT,
+  AGG_NETRAD,
+  AGG_SWQ, AGG_GLACIER, AGG_MELT, AGG_PACKWATER, AGG_TPACK, AGG_SURFWATER,
+  AGG_SNOWTSURF, AGG_COLDCONTENT, AGG_ALBEDO, AGG_SNOWDEPTH, AGG_SNOWQE,
+  AGG_SNOWQS, AGG_SNOWQSW, AGG_SNOWQLW, AGG_SNOWQP, AGG_MELTENERGY,
+  AGG_VAPORFLUX, AGG_CANOPYVAPORFLUX,
+  AGG_GAPQSW, AGG_GAPQLIN, AGG_GAPQLW, AGG_GAPQE, AGG_GAPQS, AGG_GAPQP,
+  AGG_GAPSWQ, AGG_GAPMELTENERGY,
+  AGG_SOILDEPTH, AGG_SOILWATER, AGG_TABLEDEPTH, AGG_WATERLEVEL, AGG_SATFLOW,
+  AGG_SOILTSURF, AGG_QNET, AGG_SOILQS, AGG_SOILQE, AGG_QG, AGG_QST,
+  AGG_IEXCESS, AGG_DETENTION, AGG_INFILTACC, AGG_RUNOFF, AGG_CHANNELINT,
+  AGG_ROADINT,
+  NAGGSCALARS
+};
+
+typedef struct {
+  int EPot;			/* MaxVegLayers + 1 */
+  int EAct;			/* MaxVegLayers + 1 */
+  int EInt;			/* MaxVegLayers */
+  int ESoil;			/* MaxVegLayers * MaxSoilLayers */
+  int IntRain;			/* MaxVegLayers */
+  int IntSnow;			/* MaxVegLayers */
+  int Moist;			/* MaxSoilLayers + 1 */
+  int Perc;			/* MaxSoilLayers */
+  int Temp;			/* MaxSoilLayers */
+  int Size;			/* total number of slots */
+} AGGOFFSETS;
+
+static void AggregateOffsets(LAYER *Soil, LAYER *Veg, AGGOFFSETS *Off);
+static void AggregateRow(int y, MAPSIZE *Map, OPTIONSTRUCT *Options,
+			 TOPOPIX **TopoMap, LAYER *Soil, LAYER *Veg,
+			 VEGPIX **VegMap, EVAPPIX **Evap, PRECIPPIX **Precip,
+			 PIXRAD **RadMap, SNOWPIX **Snow, SOILPIX **SoilMap,
+			 VEGTABLE *VType, ROADSTRUCT **Network, int DNum,
+			 AGGOFFSETS *Off, double *Sum);
+
+/* Average a float field: add the basin sum and divide by the number of
+   pixels in double precision */
+#define AVERAGE(Field, Value, N) \
+  (Field) = (float) (((double) (Field) + (Value)) / (N))
+
+/* Average a field that enters the mass balance into its double precision
+   total, and store the float copy that is dumped */
+#define AVERAGEWATER(Water, Field, Value, N) \
+  (Field) = (float) ((Water) = ((double) (Field) + (Value)) / (N))
+
 /*****************************************************************************
   Aggregate()
   
@@ -35,188 +94,118 @@
   
   The aggregated values are set to zero in the function RestAggregate,
   which is executed at the beginning of each time step.
+
+  Each row is summed into its own double precision block by AggregateRow()
+  (in parallel if compiled with OpenMP).  The row blocks are then combined
+  by a pairwise tree whose shape only depends on the number of rows.
+
+  If Now is not NULL and Options->SnowStats is set, the snow statistics of
+  each pixel are updated for the date Now in the same pass.
 *****************************************************************************/
 void Aggregate(MAPSIZE *Map, OPTIONSTRUCT *Options, TOPOPIX **TopoMap,
 	       LAYER *Soil, LAYER *Veg, VEGPIX **VegMap, EVAPPIX **Evap,
 	       PRECIPPIX **Precip, PIXRAD **RadMap, SNOWPIX **Snow,
 	       SOILPIX **SoilMap, AGGREGATED *Total, VEGTABLE *VType,
 	       ROADSTRUCT **Network, CHANNEL *ChannelData, float *roadarea,
-         int Dt)
+	       DATE *Now, int Dt)
 {
-  int NPixels;			/* Number of pixels in the basin */
-  int NSoilL;			/* Number of soil layers for current pixel */
-  int NVegL;			/* Number of vegetation layers for current pixel */
+  const char *Routine = "Aggregate";
+  static double *RowSum = NULL;	/* row sums, NY blocks of Off.Size */
+  static int RowSumSize = 0;
+  AGGOFFSETS Off;
+  double *Sum;			/* basin sums */
+  double NPixels;		/* Number of pixels in the basin */
   int i;				/* counter */
   int j;				/* counter */
-  int x;
+  int k;
   int y;
-  float DeepDepth;		/* depth to bottom of lowest rooting zone */
+  int Step;
+  int DNum;			/* date for the snow statistics, YYYYMMDD */
 
-  NPixels = 0;
-  *roadarea = 0.;
+  AggregateOffsets(Soil, Veg, &Off);
 
-  for (y = 0; y < Map->NY; y++) {
-    for (x = 0; x < Map->NX; x++) {
-      if (INBASIN(TopoMap[y][x].Mask)) {
-		  NPixels++;
-		  NSoilL = Soil->NLayers[SoilMap[y][x].Soil - 1];
-		  NVegL = Veg->NLayers[VegMap[y][x].Veg - 1];
-		  
-		  /* aggregate the evaporation data */
-		  Total->Evap.ETot += Evap[y][x].ETot;
-		  for (i = 0; i < NVegL; i++) {
-			  Total->Evap.EPot[i] += Evap[y][x].EPot[i];
-			  Total->Evap.EAct[i] += Evap[y][x].EAct[i];
-			  Total->Evap.EInt[i] += Evap[y][x].EInt[i];
-		  }
-		  Total->Evap.EPot[Veg->MaxLayers] += Evap[y][x].EPot[NVegL];
-		  Total->Evap.EAct[Veg->MaxLayers] += Evap[y][x].EAct[NVegL];
-		  
-		  for (i = 0; i < NVegL; i++) {
-			  for (j = 0; j < NSoilL; j++) {
-				  Total->Evap.ESoil[i][j] += Evap[y][x].ESoil[i][j];
-			  }
-		  }
-		  Total->Evap.EvapSoil += Evap[y][x].EvapSoil;
-		  
-		  /* aggregate precipitation data */
-		  Total->Precip.Precip += Precip[y][x].Precip;
-          Total->Precip.SnowFall += Precip[y][x].SnowFall;
-		  for (i = 0; i < NVegL; i++) {
-			  Total->Precip.IntRain[i] += Precip[y][x].IntRain[i];
-			  Total->Precip.IntSnow[i] += Precip[y][x].IntSnow[i];
-			  Total->CanopyWater += Precip[y][x].IntRain[i] +
-			  Precip[y][x].IntSnow[i];
-		  }
-
-	/* aggregate radiation data */
-	if (Options->MM5 == TRUE) {
-	  Total->Rad.BeamIn = NOT_APPLICABLE;
-	  Total->Rad.DiffuseIn = NOT_APPLICABLE;
-	}
-	else {
-      Total->Rad.Tair += RadMap[y][x].Tair;
-      Total->Rad.ObsShortIn += RadMap[y][x].ObsShortIn;
-	  Total->Rad.BeamIn += RadMap[y][x].BeamIn;
-	  Total->Rad.DiffuseIn += RadMap[y][x].DiffuseIn;
-      Total->Rad.PixelNetShort += RadMap[y][x].PixelNetShort;
-      Total->NetRad += RadMap[y][x].NetRadiation[0] + RadMap[y][x].NetRadiation[1];
-	}
+  DNum = 0;
+  if (Options->SnowStats && Now != NULL)
+    DNum = Now->Year * 10000 + Now->Month * 100 + Now->Day;
 
-	/* aggregate snow data */
-	if (Snow[y][x].HasSnow)
-		Total->Snow.HasSnow = TRUE;
-		Total->Snow.Swq += Snow[y][x].Swq;
-		Total->Snow.Glacier += Snow[y][x].Glacier;
-		/* Total->Snow.Melt += Snow[y][x].Melt; */
-		Total->Snow.Melt += Snow[y][x].Outflow;
-		Total->Snow.PackWater += Snow[y][x].PackWater;
-		Total->Snow.TPack += Snow[y][x].TPack;
-		Total->Snow.SurfWater += Snow[y][x].SurfWater;
-		Total->Snow.TSurf += Snow[y][x].TSurf;
-		Total->Snow.ColdContent += Snow[y][x].ColdContent;
-		Total->Snow.Albedo += Snow[y][x].Albedo;
-		Total->Snow.Depth += Snow[y][x].Depth;
-		Total->Snow.Qe += Snow[y][x].Qe;
-		Total->Snow.Qs += Snow[y][x].Qs;
-		Total->Snow.Qsw += Snow[y][x].Qsw;
-		Total->Snow.Qlw += Snow[y][x].Qlw;
-		Total->Snow.Qp += Snow[y][x].Qp;
-		Total->Snow.MeltEnergy += Snow[y][x].MeltEnergy;
-		Total->Snow.VaporMassFlux += Snow[y][x].VaporMassFlux;
-		Total->Snow.CanopyVaporMassFlux += Snow[y][x].CanopyVaporMassFlux;
-
-		if (VegMap[y][x].Gapping > 0.0 ) {
-		  Total->Veg.Type[Opening].Qsw += VegMap[y][x].Type[Opening].Qsw;
-		  Total->Veg.Type[Opening].Qlin += VegMap[y][x].Type[Opening].Qlin;
-		  Total->Veg.Type[Opening].Qlw += VegMap[y][x].Type[Opening].Qlw;
-		  Total->Veg.Type[Opening].Qe += VegMap[y][x].Type[Opening].Qe;
-		  Total->Veg.Type[Opening].Qs += VegMap[y][x].Type[Opening].Qs;
-		  Total->Veg.Type[Opening].Qp += VegMap[y][x].Type[Opening].Qp;
-		  Total->Veg.Type[Opening].Swq += VegMap[y][x].Type[Opening].Swq;
-		  Total->Veg.Type[Opening].MeltEnergy += VegMap[y][x].Type[Opening].MeltEnergy;
-		}
-		/* aggregate soil moisture data */
-		Total->Soil.Depth += SoilMap[y][x].Depth;
-		DeepDepth = 0.0;
-
-		for (i = 0; i < NSoilL; i++) {
-			Total->Soil.Moist[i] += SoilMap[y][x].Moist[i];
-			assert(SoilMap[y][x].Moist[i] >= 0.0);
-			Total->Soil.Perc[i] += SoilMap[y][x].Perc[i];
-			Total->Soil.Temp[i] += SoilMap[y][x].Temp[i];
-			Total->SoilWater += SoilMap[y][x].Moist[i] * VType[VegMap[y][x].Veg - 1].RootDepth[i] * Network[y][x].Adjust[i]; 
-			DeepDepth += VType[VegMap[y][x].Veg - 1].RootDepth[i];
-		}
-
-		Total->Soil.Moist[Soil->MaxLayers] += SoilMap[y][x].Moist[NSoilL];
-		Total->SoilWater += SoilMap[y][x].Moist[NSoilL] * (SoilMap[y][x].Depth - DeepDepth) * Network[y][x].Adjust[NSoilL];
-		Total->Soil.TableDepth += SoilMap[y][x].TableDepth;
-
-		if (SoilMap[y][x].TableDepth <= 0)
-			(Total->Saturated)++;
-		
-		Total->Soil.WaterLevel += SoilMap[y][x].WaterLevel;
-		Total->Soil.SatFlow += SoilMap[y][x].SatFlow;
-		Total->Soil.TSurf += SoilMap[y][x].TSurf;
-		Total->Soil.Qnet += SoilMap[y][x].Qnet;
-		Total->Soil.Qs += SoilMap[y][x].Qs;
-		Total->Soil.Qe += SoilMap[y][x].Qe;
-		Total->Soil.Qg += SoilMap[y][x].Qg;
-		Total->Soil.Qst += SoilMap[y][x].Qst;
-		Total->Soil.IExcess += SoilMap[y][x].IExcess;
-		Total->Soil.DetentionStorage += SoilMap[y][x].DetentionStorage;
-		
-		if (Options->Infiltration == DYNAMIC)
-			Total->Soil.InfiltAcc += SoilMap[y][x].InfiltAcc;
-		
-		Total->Soil.Runoff += SoilMap[y][x].Runoff;
-		Total->ChannelInt += SoilMap[y][x].ChannelInt;
-		SoilMap[y][x].ChannelInt = 0.0;
-		Total->RoadInt += SoilMap[y][x].RoadInt;
-		SoilMap[y][x].RoadInt = 0.0;
-      }
-    }
+  if (RowSumSize < Map->NY * Off.Size) {
+    free(RowSum);
+    RowSumSize = Map->NY * Off.Size;
+    if (!(RowSum = (double *) malloc(RowSumSize * sizeof(double))))
+      ReportError((char *) Routine, 1);
   }
+
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+  for (y = 0; y < Map->NY; y++)
+    AggregateRow(y, Map, Options, TopoMap, Soil, Veg, VegMap, Evap, Precip,
+		 RadMap, Snow, SoilMap, VType, Network, DNum, &Off,
+		 &RowSum[y * Off.Size]);
+
+  /* fixed-shape pairwise reduction over the rows */
+  for (Step = 1; Step < Map->NY; Step *= 2)
+    for (y = 0; y + Step < Map->NY; y += 2 * Step)
+      for (k = 0; k < Off.Size; k++)
+	RowSum[y * Off.Size + k] += RowSum[(y + Step) * Off.Size + k];
+  Sum = RowSum;
+
+  NPixels = Sum[AGG_NPIXELS];
+  Total->Saturated += (int) Sum[AGG_SATURATED];
+  Total->SaturationExtent =
+    100. * ((float) Sum[AGG_SATEXTENT] / (float) NPixels);
+  if (Sum[AGG_HASSNOW] > 0.)
+    Total->Snow.HasSnow = TRUE;
+  Total->Snow.Glacier += (float) Sum[AGG_GLACIER];
+
+  if (Options->MM5 == TRUE) {
+    Total->Rad.BeamIn = NOT_APPLICABLE;
+    Total->Rad.DiffuseIn = NOT_APPLICABLE;
+  }
+
   /* divide road area by pixel area so it can be used to calculate depths
      over the road surface in FinalMassBalancs */
+  *roadarea = 0.;
   *roadarea /= Map->DX * Map->DY * NPixels;
 
   /* calculate average values for all quantities except the surface flow */
 
   /* average evaporation data */
-  Total->Evap.ETot /= NPixels;
+  AVERAGEWATER(Total->Water.ETot, Total->Evap.ETot, Sum[AGG_ETOT], NPixels);
   for (i = 0; i < Veg->MaxLayers + 1; i++) {
     /* convert EPot from m/s to m */
-    Total->Evap.EPot[i] /= NPixels;
+    AVERAGE(Total->Evap.EPot[i], Sum[Off.EPot + i], NPixels);
     Total->Evap.EPot[i] *= Dt;
-    Total->Evap.EAct[i] /= NPixels;
+    AVERAGE(Total->Evap.EAct[i], Sum[Off.EAct + i], NPixels);
   }
   for (i = 0; i < Veg->MaxLayers; i++)
-    Total->Evap.EInt[i] /= NPixels;
+    AVERAGE(Total->Evap.EInt[i], Sum[Off.EInt + i], NPixels);
   for (i = 0; i < Veg->MaxLayers; i++) {
     for (j = 0; j < Soil->MaxLayers; j++) {
-      Total->Evap.ESoil[i][j] /= NPixels;
+      AVERAGE(Total->Evap.ESoil[i][j],
+	      Sum[Off.ESoil + i * Soil->MaxLayers + j], NPixels);
     }
   }
-  Total->Evap.EvapSoil /= NPixels;;
+  AVERAGE(Total->Evap.EvapSoil, Sum[AGG_EVAPSOIL], NPixels);
 
   /* average precipitation data */
-  Total->Precip.Precip /= NPixels;
-  Total->Precip.SnowFall /= NPixels;
+  AVERAGEWATER(Total->Water.Precip, Total->Precip.Precip, Sum[AGG_PRECIP],
+	       NPixels);
+  AVERAGEWATER(Total->Water.SnowFall, Total->Precip.SnowFall,
+	       Sum[AGG_SNOWFALL], NPixels);
   for (i = 0; i < Veg->MaxLayers; i++) {
-    Total->Precip.IntRain[i] /= NPixels;
-    Total->Precip.IntSnow[i] /= NPixels;
+    AVERAGE(Total->Precip.IntRain[i], Sum[Off.IntRain + i], NPixels);
+    AVERAGE(Total->Precip.IntSnow[i], Sum[Off.IntSnow + i], NPixels);
   }
-  Total->CanopyWater /= NPixels;
+  Total->CanopyWater = (Total->CanopyWater + Sum[AGG_CANOPYWATER]) / NPixels;
 
   /* average radiation data */
-  Total->Rad.Tair /= NPixels;
-  Total->Rad.ObsShortIn /= NPixels;
-  Total->Rad.PixelNetShort /= NPixels;
-  Total->NetRad /= NPixels;
-  Total->Rad.BeamIn /= NPixels;
-  Total->Rad.DiffuseIn /= NPixels;
+  AVERAGE(Total->Rad.Tair, Sum[AGG_TAIR], NPixels);
+  AVERAGE(Total->Rad.ObsShortIn, Sum[AGG_OBSSHORTIN], NPixels);
+  AVERAGE(Total->Rad.PixelNetShort, Sum[AGG_PIXELNETSHORT], NPixels);
+  AVERAGE(Total->NetRad, Sum[AGG_NETRAD], NPixels);
+  AVERAGE(Total->Rad.BeamIn, Sum[AGG_BEAMIN], NPixels);
+  AVERAGE(Total->Rad.DiffuseIn, Sum[AGG_DIFFUSEIN], NPixels);
   for (i = 0; i <= 2; i++) {
     Total->Rad.NetShort[i] /= NPixels;
 	Total->Rad.LongIn[i] /= NPixels;
@@ -224,62 +213,244 @@ void Aggregate(MAPSIZE *Map, OPTIONSTRUCT *Options, TOPOPIX **TopoMap,
   }
 
   /* average snow data */
-  Total->Snow.Swq /= NPixels;
-  Total->Snow.Melt /= NPixels;
-  Total->Snow.PackWater /= NPixels;
-  Total->Snow.TPack /= NPixels;
-  Total->Snow.SurfWater /= NPixels;
-  Total->Snow.TSurf /= NPixels;
-  Total->Snow.ColdContent /= NPixels;
-  Total->Snow.Albedo /= NPixels;
-  Total->Snow.Depth /= NPixels;
-  Total->Snow.Qe /= NPixels;
-  Total->Snow.Qs /= NPixels;
-  Total->Snow.Qsw /= NPixels;
-  Total->Snow.Qlw /= NPixels;
-  Total->Snow.Qp /= NPixels;
-  Total->Snow.MeltEnergy /= NPixels;
-  Total->Snow.VaporMassFlux /= NPixels;
-  Total->Snow.CanopyVaporMassFlux /= NPixels;
+  AVERAGEWATER(Total->Water.Swq, Total->Snow.Swq, Sum[AGG_SWQ], NPixels);
+  AVERAGEWATER(Total->Water.Melt, Total->Snow.Melt, Sum[AGG_MELT], NPixels);
+  AVERAGE(Total->Snow.PackWater, Sum[AGG_PACKWATER], NPixels);
+  AVERAGE(Total->Snow.TPack, Sum[AGG_TPACK], NPixels);
+  AVERAGE(Total->Snow.SurfWater, Sum[AGG_SURFWATER], NPixels);
+  AVERAGE(Total->Snow.TSurf, Sum[AGG_SNOWTSURF], NPixels);
+  AVERAGE(Total->Snow.ColdContent, Sum[AGG_COLDCONTENT], NPixels);
+  AVERAGE(Total->Snow.Albedo, Sum[AGG_ALBEDO], NPixels);
+  AVERAGE(Total->Snow.Depth, Sum[AGG_SNOWDEPTH], NPixels);
+  AVERAGE(Total->Snow.Qe, Sum[AGG_SNOWQE], NPixels);
+  AVERAGE(Total->Snow.Qs, Sum[AGG_SNOWQS], NPixels);
+  AVERAGE(Total->Snow.Qsw, Sum[AGG_SNOWQSW], NPixels);
+  AVERAGE(Total->Snow.Qlw, Sum[AGG_SNOWQLW], NPixels);
+  AVERAGE(Total->Snow.Qp, Sum[AGG_SNOWQP], NPixels);
+  AVERAGE(Total->Snow.MeltEnergy, Sum[AGG_MELTENERGY], NPixels);
+  AVERAGEWATER(Total->Water.VaporMassFlux, Total->Snow.VaporMassFlux,
+	       Sum[AGG_VAPORFLUX], NPixels);
+  AVERAGEWATER(Total->Water.CanopyVaporMassFlux,
+	       Total->Snow.CanopyVaporMassFlux, Sum[AGG_CANOPYVAPORFLUX],
+	       NPixels);
 
   if (TotNumGap > 0) {
-	Total->Veg.Type[Opening].Qsw /= TotNumGap;
-	Total->Veg.Type[Opening].Qlin /= TotNumGap;
-	Total->Veg.Type[Opening].Qlw /= TotNumGap;
-	Total->Veg.Type[Opening].Qe /= TotNumGap;
-	Total->Veg.Type[Opening].Qs /= TotNumGap;
-	Total->Veg.Type[Opening].Qp /= TotNumGap;
-	Total->Veg.Type[Opening].Swq /= TotNumGap;
-	Total->Veg.Type[Opening].MeltEnergy /= TotNumGap;
+	AVERAGE(Total->Veg.Type[Opening].Qsw, Sum[AGG_GAPQSW], TotNumGap);
+	AVERAGE(Total->Veg.Type[Opening].Qlin, Sum[AGG_GAPQLIN], TotNumGap);
+	AVERAGE(Total->Veg.Type[Opening].Qlw, Sum[AGG_GAPQLW], TotNumGap);
+	AVERAGE(Total->Veg.Type[Opening].Qe, Sum[AGG_GAPQE], TotNumGap);
+	AVERAGE(Total->Veg.Type[Opening].Qs, Sum[AGG_GAPQS], TotNumGap);
+	AVERAGE(Total->Veg.Type[Opening].Qp, Sum[AGG_GAPQP], TotNumGap);
+	AVERAGE(Total->Veg.Type[Opening].Swq, Sum[AGG_GAPSWQ], TotNumGap);
+	AVERAGE(Total->Veg.Type[Opening].MeltEnergy, Sum[AGG_GAPMELTENERGY],
+		TotNumGap);
   }
   /* average soil moisture data */
-  Total->Soil.Depth /= NPixels;
+  AVERAGE(Total->Soil.Depth, Sum[AGG_SOILDEPTH], NPixels);
   for (i = 0; i < Soil->MaxLayers; i++) {
-    Total->Soil.Moist[i] /= NPixels;
-    Total->Soil.Perc[i] /= NPixels;
-    Total->Soil.Temp[i] /= NPixels;
+    AVERAGE(Total->Soil.Moist[i], Sum[Off.Moist + i], NPixels);
+    AVERAGE(Total->Soil.Perc[i], Sum[Off.Perc + i], NPixels);
+    AVERAGE(Total->Soil.Temp[i], Sum[Off.Temp + i], NPixels);
   }
-  Total->Soil.Moist[Soil->MaxLayers] /= NPixels;
-  Total->Soil.TableDepth /= NPixels;
-  Total->Soil.WaterLevel /= NPixels;
-  Total->Soil.SatFlow /= NPixels;
-  Total->Soil.TSurf /= NPixels;
-  Total->Soil.Qnet /= NPixels;
-  Total->Soil.Qs /= NPixels;
-  Total->Soil.Qe /= NPixels;
-  Total->Soil.Qg /= NPixels;
-  Total->Soil.Qst /= NPixels;
-  Total->Soil.IExcess /= NPixels;
-  Total->Soil.DetentionStorage /= NPixels;
-  Total->Road.IExcess /= NPixels;
+  AVERAGE(Total->Soil.Moist[Soil->MaxLayers], Sum[Off.Moist + Soil->MaxLayers],
+	  NPixels);
+  AVERAGE(Total->Soil.TableDepth, Sum[AGG_TABLEDEPTH], NPixels);
+  AVERAGE(Total->Soil.WaterLevel, Sum[AGG_WATERLEVEL], NPixels);
+  AVERAGEWATER(Total->Water.SatFlow, Total->Soil.SatFlow, Sum[AGG_SATFLOW],
+	       NPixels);
+  AVERAGE(Total->Soil.TSurf, Sum[AGG_SOILTSURF], NPixels);
+  AVERAGE(Total->Soil.Qnet, Sum[AGG_QNET], NPixels);
+  AVERAGE(Total->Soil.Qs, Sum[AGG_SOILQS], NPixels);
+  AVERAGE(Total->Soil.Qe, Sum[AGG_SOILQE], NPixels);
+  AVERAGE(Total->Soil.Qg, Sum[AGG_QG], NPixels);
+  AVERAGE(Total->Soil.Qst, Sum[AGG_QST], NPixels);
+  AVERAGEWATER(Total->Water.IExcess, Total->Soil.IExcess, Sum[AGG_IEXCESS],
+	       NPixels);
+  AVERAGEWATER(Total->Water.DetentionStorage, Total->Soil.DetentionStorage,
+	       Sum[AGG_DETENTION], NPixels);
+  AVERAGEWATER(Total->Water.RoadIExcess, Total->Road.IExcess, 0., NPixels);
   
   if (Options->Infiltration == DYNAMIC)
-    Total->Soil.InfiltAcc /= NPixels;
+    AVERAGE(Total->Soil.InfiltAcc, Sum[AGG_INFILTACC], NPixels);
 
-  Total->SoilWater /= NPixels;
-  Total->Soil.Runoff /= NPixels;
-  Total->ChannelInt /= NPixels;
-  Total->RoadInt /= NPixels;
+  Total->SoilWater = (Total->SoilWater + Sum[AGG_SOILWATER]) / NPixels;
+  AVERAGE(Total->Soil.Runoff, Sum[AGG_RUNOFF], NPixels);
+  Total->ChannelInt = (Total->ChannelInt + Sum[AGG_CHANNELINT]) / NPixels;
+  Total->RoadInt = (Total->RoadInt + Sum[AGG_ROADINT]) / NPixels;
   Total->CulvertReturnFlow /= NPixels;
   Total->CulvertToChannel /= NPixels;
 }
+
+/*****************************************************************************
+  AggregateOffsets()
+
+  Lay out the layered quantities after the scalar slots
+*****************************************************************************/
+static void AggregateOffsets(LAYER *Soil, LAYER *Veg, AGGOFFSETS *Off)
+{
+  Off->EPot = NAGGSCALARS;
+  Off->EAct = Off->EPot + Veg->MaxLayers + 1;
+  Off->EInt = Off->EAct + Veg->MaxLayers + 1;
+  Off->ESoil = Off->EInt + Veg->MaxLayers;
+  Off->IntRain = Off->ESoil + Veg->MaxLayers * Soil->MaxLayers;
+  Off->IntSnow = Off->IntRain + Veg->MaxLayers;
+  Off->Moist = Off->IntSnow + Veg->MaxLayers;
+  Off->Perc = Off->Moist + Soil->MaxLayers + 1;
+  Off->Temp = Off->Perc + Soil->MaxLayers;
+  Off->Size = Off->Temp + Soil->MaxLayers;
+}
+
+/*****************************************************************************
+  AggregateRow()
+
+  Sum the pixels of row y in double precision.  Rows are independent of
+  each other, so this can be called in parallel.  With DNum > 0 the snow
+  statistics of the pixels are updated as well.
+*****************************************************************************/
+static void AggregateRow(int y, MAPSIZE *Map, OPTIONSTRUCT *Options,
+			 TOPOPIX **TopoMap, LAYER *Soil, LAYER *Veg,
+			 VEGPIX **VegMap, EVAPPIX **Evap, PRECIPPIX **Precip,
+			 PIXRAD **RadMap, SNOWPIX **Snow, SOILPIX **SoilMap,
+			 VEGTABLE *VType, ROADSTRUCT **Network, int DNum,
+			 AGGOFFSETS *Off, double *Sum)
+{
+  int NSoilL;			/* Number of soil layers for current pixel */
+  int NVegL;			/* Number of vegetation layers for current pixel */
+  int i;				/* counter */
+  int j;				/* counter */
+  int x;
+  float DeepDepth;		/* depth to bottom of lowest rooting zone */
+
+  for (i = 0; i < Off->Size; i++)
+    Sum[i] = 0.;
+
+  for (x = 0; x < Map->NX; x++) {
+    if (INBASIN(TopoMap[y][x].Mask)) {
+      Sum[AGG_NPIXELS] += 1.;
+      NSoilL = Soil->NLayers[SoilMap[y][x].Soil - 1];
+      NVegL = Veg->NLayers[VegMap[y][x].Veg - 1];
+
+      /* aggregate the evaporation data */
+      Sum[AGG_ETOT] += Evap[y][x].ETot;
+      for (i = 0; i < NVegL; i++) {
+	Sum[Off->EPot + i] += Evap[y][x].EPot[i];
+	Sum[Off->EAct + i] += Evap[y][x].EAct[i];
+	Sum[Off->EInt + i] += Evap[y][x].EInt[i];
+      }
+      Sum[Off->EPot + Veg->MaxLayers] += Evap[y][x].EPot[NVegL];
+      Sum[Off->EAct + Veg->MaxLayers] += Evap[y][x].EAct[NVegL];
+
+      for (i = 0; i < NVegL; i++) {
+	for (j = 0; j < NSoilL; j++) {
+	  Sum[Off->ESoil + i * Soil->MaxLayers + j] += Evap[y][x].ESoil[i][j];
+	}
+      }
+      Sum[AGG_EVAPSOIL] += Evap[y][x].EvapSoil;
+
+      /* aggregate precipitation data */
+      Sum[AGG_PRECIP] += Precip[y][x].Precip;
+      Sum[AGG_SNOWFALL] += Precip[y][x].SnowFall;
+      for (i = 0; i < NVegL; i++) {
+	Sum[Off->IntRain + i] += Precip[y][x].IntRain[i];
+	Sum[Off->IntSnow + i] += Precip[y][x].IntSnow[i];
+	Sum[AGG_CANOPYWATER] += Precip[y][x].IntRain[i] +
+	  Precip[y][x].IntSnow[i];
+      }
+
+      /* aggregate radiation data */
+      if (Options->MM5 == FALSE) {
+	Sum[AGG_TAIR] += RadMap[y][x].Tair;
+	Sum[AGG_OBSSHORTIN] += RadMap[y][x].ObsShortIn;
+	Sum[AGG_BEAMIN] += RadMap[y][x].BeamIn;
+	Sum[AGG_DIFFUSEIN] += RadMap[y][x].DiffuseIn;
+	Sum[AGG_PIXELNETSHORT] += RadMap[y][x].PixelNetShort;
+	Sum[AGG_NETRAD] += RadMap[y][x].NetRadiation[0] +
+	  RadMap[y][x].NetRadiation[1];
+      }
+
+      /* aggregate snow data */
+      if (Snow[y][x].HasSnow)
+	Sum[AGG_HASSNOW] += 1.;
+      Sum[AGG_SWQ] += Snow[y][x].Swq;
+      Sum[AGG_GLACIER] += Snow[y][x].Glacier;
+      /* Sum[AGG_MELT] += Snow[y][x].Melt; */
+      Sum[AGG_MELT] += Snow[y][x].Outflow;
+      Sum[AGG_PACKWATER] += Snow[y][x].PackWater;
+      Sum[AGG_TPACK] += Snow[y][x].TPack;
+      Sum[AGG_SURFWATER] += Snow[y][x].SurfWater;
+      Sum[AGG_SNOWTSURF] += Snow[y][x].TSurf;
+      Sum[AGG_COLDCONTENT] += Snow[y][x].ColdContent;
+      Sum[AGG_ALBEDO] += Snow[y][x].Albedo;
+      Sum[AGG_SNOWDEPTH] += Snow[y][x].Depth;
+      Sum[AGG_SNOWQE] += Snow[y][x].Qe;
+      Sum[AGG_SNOWQS] += Snow[y][x].Qs;
+      Sum[AGG_SNOWQSW] += Snow[y][x].Qsw;
+      Sum[AGG_SNOWQLW] += Snow[y][x].Qlw;
+      Sum[AGG_SNOWQP] += Snow[y][x].Qp;
+      Sum[AGG_MELTENERGY] += Snow[y][x].MeltEnergy;
+      Sum[AGG_VAPORFLUX] += Snow[y][x].VaporMassFlux;
+      Sum[AGG_CANOPYVAPORFLUX] += Snow[y][x].CanopyVaporMassFlux;
+      if (DNum > 0)
+	SnowStats(DNum, &(Snow[y][x]));
+
+      if (VegMap[y][x].Gapping > 0.0) {
+	Sum[AGG_GAPQSW] += VegMap[y][x].Type[Opening].Qsw;
+	Sum[AGG_GAPQLIN] += VegMap[y][x].Type[Opening].Qlin;
+	Sum[AGG_GAPQLW] += VegMap[y][x].Type[Opening].Qlw;
+	Sum[AGG_GAPQE] += VegMap[y][x].Type[Opening].Qe;
+	Sum[AGG_GAPQS] += VegMap[y][x].Type[Opening].Qs;
+	Sum[AGG_GAPQP] += VegMap[y][x].Type[Opening].Qp;
+	Sum[AGG_GAPSWQ] += VegMap[y][x].Type[Opening].Swq;
+	Sum[AGG_GAPMELTENERGY] += VegMap[y][x].Type[Opening].MeltEnergy;
+      }
+
+      /* aggregate soil moisture data */
+      Sum[AGG_SOILDEPTH] += SoilMap[y][x].Depth;
+      DeepDepth = 0.0;
+
+      for (i = 0; i < NSoilL; i++) {
+	Sum[Off->Moist + i] += SoilMap[y][x].Moist[i];
+	assert(SoilMap[y][x].Moist[i] >= 0.0);
+	Sum[Off->Perc + i] += SoilMap[y][x].Perc[i];
+	Sum[Off->Temp + i] += SoilMap[y][x].Temp[i];
+	Sum[AGG_SOILWATER] += SoilMap[y][x].Moist[i] *
+	  VType[VegMap[y][x].Veg - 1].RootDepth[i] * Network[y][x].Adjust[i];
+	DeepDepth += VType[VegMap[y][x].Veg - 1].RootDepth[i];
+      }
+
+      Sum[Off->Moist + Soil->MaxLayers] += SoilMap[y][x].Moist[NSoilL];
+      Sum[AGG_SOILWATER] += SoilMap[y][x].Moist[NSoilL] *
+	(SoilMap[y][x].Depth - DeepDepth) * Network[y][x].Adjust[NSoilL];
+      Sum[AGG_TABLEDEPTH] += SoilMap[y][x].TableDepth;
+
+      if (SoilMap[y][x].TableDepth <= 0)
+	Sum[AGG_SATURATED] += 1.;
+
+      /* saturation extent: pixels with a water table that is at least
+	 MTHRESH of soil depth */
+      if ((SoilMap[y][x].Depth - SoilMap[y][x].TableDepth) /
+	  SoilMap[y][x].Depth > MTHRESH)
+	Sum[AGG_SATEXTENT] += 1.;
+
+      Sum[AGG_WATERLEVEL] += SoilMap[y][x].WaterLevel;
+      Sum[AGG_SATFLOW] += SoilMap[y][x].SatFlow;
+      Sum[AGG_SOILTSURF] += SoilMap[y][x].TSurf;
+      Sum[AGG_QNET] += SoilMap[y][x].Qnet;
+      Sum[AGG_SOILQS] += SoilMap[y][x].Qs;
+      Sum[AGG_SOILQE] += SoilMap[y][x].Qe;
+      Sum[AGG_QG] += SoilMap[y][x].Qg;
+      Sum[AGG_QST] += SoilMap[y][x].Qst;
+      Sum[AGG_IEXCESS] += SoilMap[y][x].IExcess;
+      Sum[AGG_DETENTION] += SoilMap[y][x].DetentionStorage;
+
+      if (Options->Infiltration == DYNAMIC)
+	Sum[AGG_INFILTACC] += SoilMap[y][x].InfiltAcc;
+
+      Sum[AGG_RUNOFF] += SoilMap[y][x].Runoff;
+      Sum[AGG_CHANNELINT] += SoilMap[y][x].ChannelInt;
+      SoilMap[y][x].ChannelInt = 0.0;
+      Sum[AGG_ROADINT] += SoilMap[y][x].RoadInt;
+      SoilMap[y][x].RoadInt = 0.0;
+    }
+  }
+}
@@ -8,7 +8,8 @@
  * ORIG-DATE:    Feb-15
  * DESCRIPTION:  Represent Snow Redistribution
  * DESCRIP-END.
- * FUNCTIONS:    Avalanche()
+ * FUNCTIONS:    InitAvalanche()
+ *               Avalanche()
  */
 #include <math.h>
 #include <stdio.h>
@@ -20,6 +21,44 @@
 #include "constants.h"
 #include "slopeaspect.h"
 
+/* snow surface slope of each cell, kept between time steps and only
+   recomputed where the snow surface of the cell or a neighbor changed */
+typedef struct {
+  float SlopeSwq;                /* Swq when the slope was computed */
+  float CheckSwq;                /* Swq when the cell was last checked */
+  float SlopeDeg;                /* Snow surface slope in degrees */
+  float Shd;                     /* Snow holding depth (m) */
+  unsigned char Dir[MAXDIRS];    /* Fraction of flux moving in each direction*/
+  unsigned int TotalDir;         /* Sum of Dir array */
+  unsigned char Stale;           /* slope has to be recomputed */
+  unsigned char Check;           /* cell has to be checked for a slide */
+} SNOWSLOPE;
+
+static SNOWSLOPE **SnowSlope = NULL;
+
+ /*****************************************************************************
+   InitAvalanche()
+
+   Allocates the snow surface slope state.  Every cell is computed and
+   checked in the first call of Avalanche().
+ *****************************************************************************/
+void InitAvalanche(MAPSIZE *Map)
+{
+  const char *Routine = "InitAvalanche";
+  int y, x;
+
+  if (!(SnowSlope = (SNOWSLOPE **)calloc(Map->NY, sizeof(SNOWSLOPE *))))
+    ReportError((char *)Routine, 1);
+  for (y = 0; y < Map->NY; y++) {
+    if (!(SnowSlope[y] = (SNOWSLOPE *)calloc(Map->NX, sizeof(SNOWSLOPE))))
+      ReportError((char *)Routine, 1);
+    for (x = 0; x < Map->NX; x++) {
+      SnowSlope[y][x].Stale = TRUE;
+      SnowSlope[y][x].Check = TRUE;
+    }
+  }
+}
+
  /*****************************************************************************
    Avalanche()
 
@@ -30,125 +69,112 @@
 
    This routine follows Bernhardt, M., and K. Schulz (2010) in calculating gravitational
    redistribution of snow. Routing algorithms are similar to those used in
-   RouteSubsurface.c. The local gradient is taken to be equal to the slope of the land
-   surface. The slope is not currently calculated based on surface elevation of
-   the snowpack.
+   RouteSubsurface.c. The local gradient is taken to be equal to the slope of the
+   snow surface at the start of the time step.
 
    Set the gradient with pixels that are outside tha basin to zero.  This
    ensures that there is no flux of water across the basin boundary.
 
+   Only cells whose Swq changed since they were last checked, or whose slope
+   changed, can slide.  The slope is recomputed only for cells where the Swq
+   of the cell or of one of its neighbors changed.  The cells are checked from
+   the highest to the lowest, so that snow sliding onto a lower cell can slide
+   further down in the same time step.
+
    WORK IN PROGRESS:
-   Calculate slope based on Ice and Snow on top of topography.
    Transfer Cold Content of Snowpack with Mass.
  *****************************************************************************/
 void Avalanche(MAPSIZE *Map, TOPOPIX **TopoMap, TIMESTRUCT *Time, OPTIONSTRUCT *Options,
   SNOWPIX **Snow)
 {
-
-  float Shd;                     /*Snow Holding Depth of a cell(m) as a function slope*/
-  unsigned char ***SubDir;       /* Fraction of flux moving in each direction*/
-  unsigned int **SubTotalDir;    /* Sum of Dir array */
-  float **slope_deg;             /* Surface Slope in Degrees */
-  float **SubSnowGrad;           /* Snow Surface Slope*/
-  const char *Routine = "Avalanche";
+  SNOWSLOPE *Cell;
+  float SubSnowGrad;             /* Snow Surface Slope*/
   int x;                         /* counter */
   int y;                         /* counter */
-  int i, j, k;
+  int k, n;
   float Snowout;
 
-  /*****************************************************************************
-     Allocate memory
-    ****************************************************************************/
-  if (!(SubSnowGrad = (float **)calloc(Map->NY, sizeof(float *))))
-    ReportError((char *)Routine, 1);
-  for (i = 0; i < Map->NY; i++) {
-    if (!(SubSnowGrad[i] = (float *)calloc(Map->NX, sizeof(float))))
-      ReportError((char *)Routine, 1);
-  }
-  if (!(slope_deg = (float **)calloc(Map->NY, sizeof(float *))))
-    ReportError((char *)Routine, 1);
-  for (i = 0; i < Map->NY; i++) {
-    if (!(slope_deg[i] = (float *)calloc(Map->NX, sizeof(float))))
-      ReportError((char *)Routine, 1);
-  }
-  if (!((SubDir) = (unsigned char ***)calloc(Map->NY, sizeof(unsigned char **))))
-    ReportError((char *)Routine, 1);
-  for (i = 0; i < Map->NY; i++) {
-    if (!((SubDir)[i] = (unsigned char **)calloc(Map->NX, sizeof(unsigned char*))))
-      ReportError((char *)Routine, 1);
-    for (j = 0; j < Map->NX; j++) {
-      if (!(SubDir[i][j] = (unsigned char *)calloc(NDIRS, sizeof(unsigned char))))
-        ReportError((char *)Routine, 1);
+  /* mark the cells where the snow surface changed, and their neighbors */
+  for (y = 0; y < Map->NY; y++) {
+    for (x = 0; x < Map->NX; x++) {
+      if (INBASIN(TopoMap[y][x].Mask)) {
+        Cell = &(SnowSlope[y][x]);
+        if (Snow[y][x].Swq != Cell->CheckSwq)
+          Cell->Check = TRUE;
+        if (Snow[y][x].Swq != Cell->SlopeSwq) {
+          Cell->Stale = TRUE;
+          for (n = 0; n < NNEIGHBORS; n++) {
+            int nx = xneighbor[n] + x;
+            int ny = yneighbor[n] + y;
+            if (valid_cell(Map, nx, ny))
+              SnowSlope[ny][nx].Stale = TRUE;
+          }
+        }
+      }
     }
   }
-  if (!(SubTotalDir = (unsigned int **)calloc(Map->NY, sizeof(unsigned int *))))
-    ReportError((char *)Routine, 1);
-  for (i = 0; i < Map->NY; i++) {
-    if (!(SubTotalDir[i] = (unsigned int *)calloc(Map->NX, sizeof(unsigned int))))
-      ReportError((char *)Routine, 1);
-  }
 
   /* calculate snow surface slope in the same approach as subflow direction */
-  SnowSlopeAspect(Map, TopoMap, Snow, SubSnowGrad, SubDir, SubTotalDir);
-
   for (y = 0; y < Map->NY; y++) {
     for (x = 0; x < Map->NX; x++) {
-      if (INBASIN(TopoMap[y][x].Mask)) {
+      Cell = &(SnowSlope[y][x]);
+      if (Cell->Stale && INBASIN(TopoMap[y][x].Mask)) {
+        SnowSlopeAspect(Map, TopoMap, Snow, y, x, &SubSnowGrad, Cell->Dir,
+          &(Cell->TotalDir));
         /* convert slope from radian to degree */
-        slope_deg[y][x] = atan(SubSnowGrad[y][x])*(180 / PI);
-
+        Cell->SlopeDeg = atan(SubSnowGrad)*(180 / PI);
         /* snow holding depth as a function of slope and slide parameters */
-        Shd = SNOWSLIDE1*exp(-slope_deg[y][x] * SNOWSLIDE2);
-
-        /* only redistribute snow if Swq is above holding capacity */
-        if (slope_deg[y][x] > 30. && Snow[y][x].Swq > Shd) {
-
-          /*If avalanche occurs on glacier surface, Leave a 10mm of snow behind so that glacier 
-          surface is not prematurely exposed */
-          /* if (Snow[y][x].Iwq > 1.0) {
-            Snowout = Snow[y][x].Swq - 0.01;
-            Snow[y][x].Swq = 0.01;
-          } */
-          
-          Snowout = Snow[y][x].Swq;
-          Snow[y][x].Swq = 0.0;
-          
-
-          Snow[y][x].TSurf = 0.0;
-          Snow[y][x].TPack = 0.0;
-          Snow[y][x].PackWater = 0.0;
-          Snow[y][x].SurfWater = 0.0;
-          
-          /* Assign the avalanched snow to appropriate surrounding pixels */
-          if (SubTotalDir[y][x] > 0) {
-            Snowout /= (float)SubTotalDir[y][x];
+        Cell->Shd = SNOWSLIDE1*exp(-Cell->SlopeDeg * SNOWSLIDE2);
+        Cell->SlopeSwq = Snow[y][x].Swq;
+        Cell->Check = TRUE;
+      }
+      Cell->Stale = FALSE;
+    }
+  }
 
-          }
-          else {
-            Snowout = 0.0;
-            Snow[y][x].Swq = Snowout;
-          }
-          for (k = 0; k < NDIRS; k++) {
-            int nx = xdirection[k] + x;
-            int ny = ydirection[k] + y;
-            if (valid_cell(Map, nx, ny)) {
-              Snow[ny][nx].Swq += Snowout * SubDir[y][x][k];
-            }
-          }
+  for (k = Map->NumCells - 1; k >= 0; k--) {
+    y = Map->OrderedCells[k].y;
+    x = Map->OrderedCells[k].x;
+    Cell = &(SnowSlope[y][x]);
+    if (!Cell->Check)
+      continue;
+    Cell->Check = FALSE;
+
+    /* only redistribute snow if Swq is above holding capacity */
+    if (Cell->SlopeDeg > 30. && Snow[y][x].Swq > Cell->Shd) {
+
+      /*If avalanche occurs on glacier surface, Leave a 10mm of snow behind so that glacier 
+      surface is not prematurely exposed */
+      /* if (Snow[y][x].Iwq > 1.0) {
+        Snowout = Snow[y][x].Swq - 0.01;
+        Snow[y][x].Swq = 0.01;
+      } */
+
+      Snowout = Snow[y][x].Swq;
+      Snow[y][x].Swq = 0.0;
+
+      Snow[y][x].TSurf = 0.0;
+      Snow[y][x].TPack = 0.0;
+      Snow[y][x].PackWater = 0.0;
+      Snow[y][x].SurfWater = 0.0;
+
+      /* Assign the avalanched snow to appropriate surrounding pixels */
+      if (Cell->TotalDir > 0) {
+        Snowout /= (float)Cell->TotalDir;
+      }
+      else {
+        Snowout = 0.0;
+        Snow[y][x].Swq = Snowout;
+      }
+      for (n = 0; n < NDIRS; n++) {
+        int nx = xdirection[n] + x;
+        int ny = ydirection[n] + y;
+        if (valid_cell(Map, nx, ny) && Cell->Dir[n] > 0) {
+          Snow[ny][nx].Swq += Snowout * Cell->Dir[n];
+          SnowSlope[ny][nx].Check = TRUE;
         }
       }
     }
+    Cell->CheckSwq = Snow[y][x].Swq;
   }
-  for (i = 0; i < Map->NY; i++) {
-    free(SubTotalDir[i]);
-    free(slope_deg[i]);
-    free(SubSnowGrad[i]);
-    for (j = 0; j < Map->NX; j++)
-      free(SubDir[i][j]);
-    free(SubDir[i]);
-  }
-  free(SubDir);
-  free(SubTotalDir);
-  free(slope_deg);
-  free(SubSnowGrad);
 }
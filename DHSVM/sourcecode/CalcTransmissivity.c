@@ -41,6 +41,9 @@
     float LateralKs  - Lateral hydraulic conductivity in m/s
     float KsExponent - Exponent that describes exponential decay of LateralKs
                        with depth below the soil surface
+    float DepthThresh - Water table depth below which transmissivity decays
+                       linearly
+    FLOATTABLE *KsTable - Table of exp(-KsExponent * z), or NULL to call exp()
 
   Returns      : Transmissivity in m2/s
 
@@ -58,9 +61,33 @@
 
     The hydraulic conductivity is assumed exponentially with depth, based on
     material in Beven [1982].
+
+    With a KsTable each decay term has a relative error below the table
+    tolerance Tol, so the difference exp(-k z1) - exp(-k z2) has a relative
+    error below Tol * coth(k (z2 - z1) / 2), which grows without bound as the
+    two depths approach each other.  The table is therefore only used when
+    the depths are at least KSDIFFSTEPS table steps apart, i.e.
+    k (z2 - z1) >= KSDIFFSTEPS * sqrt(4 Tol), which bounds the relative error
+    of the difference by about Tol + sqrt(Tol) / KSDIFFSTEPS (4e-4 for the
+    default Tol of 1e-5).  Closer depths are evaluated with exp().
 *****************************************************************************/
+#define KSDIFFSTEPS 8
+
+static double KsDecayDiff(float Upper, float Lower, float KsExponent,
+			  FLOATTABLE *KsTable)
+{
+  float UpperDecay;
+  float LowerDecay;
+
+  if (KsTable != NULL && Lower - Upper >= KSDIFFSTEPS * KsTable->Delta &&
+      FloatInterpolate(Upper, KsTable, &UpperDecay) &&
+      FloatInterpolate(Lower, KsTable, &LowerDecay))
+    return (double) UpperDecay - (double) LowerDecay;
+  return exp(-KsExponent * Upper) - exp(-KsExponent * Lower);
+}
+
 float CalcTransmissivity(float SoilDepth, float WaterTable, float LateralKs,
-			 float KsExponent, float DepthThresh)
+			 float KsExponent, float DepthThresh, FLOATTABLE *KsTable)
 {
   float Transmissivity;		/* Transmissivity (m^2/s) */
   float TransThresh;
@@ -70,10 +97,10 @@ float CalcTransmissivity(float SoilDepth, float WaterTable, float LateralKs,
   else {
 	/* a smaller value of WaterTable variables indicates a higher actual water table depth */
 	if (WaterTable < DepthThresh) {
-	  Transmissivity = (LateralKs / KsExponent) * (exp(-KsExponent * WaterTable) - exp(-KsExponent * SoilDepth));
+	  Transmissivity = (LateralKs / KsExponent) * KsDecayDiff(WaterTable, SoilDepth, KsExponent, KsTable);
 	}
     else  {
-	  TransThresh = (LateralKs / KsExponent) * (exp(-KsExponent * DepthThresh) - exp(-KsExponent * SoilDepth));
+	  TransThresh = (LateralKs / KsExponent) * KsDecayDiff(DepthThresh, SoilDepth, KsExponent, KsTable);
 	  if(SoilDepth < DepthThresh) {
 		printf("Warning: Soil DepthThreshold (%.2f) > the soil depth (%.2f)!\n", DepthThresh, SoilDepth);
 		printf("Transmissivity is set to zero!");
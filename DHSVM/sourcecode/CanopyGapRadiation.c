@@ -54,9 +54,12 @@ void CanopyGapRadiation(CanopyGapStruct **Gap, float SunAngle, float Rs,
   (*Gap)[Opening].UnderStory = VType->UnderStory;
 
   /* net shortwave received by the opening*/
-  (*Gap)[Opening].NetShort[1] = CanopyGapShortRadiation((*Gap)[Opening].UnderStory,
-    (*Gap)[Opening].GapView, VType->Height[0], Gapping, SunAngle, Rsb,
-    Rsd, VType->ExtnCoeff, SoilAlbedo, VType, LocalSnow, LocalVeg->Fract[0]);
+  if (Rsb == 0. && Rsd == 0.)
+    (*Gap)[Opening].NetShort[1] = 0.;
+  else
+    (*Gap)[Opening].NetShort[1] = CanopyGapShortRadiation((*Gap)[Opening].UnderStory,
+      (*Gap)[Opening].GapView, VType->Height[0], Gapping, SunAngle, Rsb,
+      Rsd, VType->ExtnCoeff, SoilAlbedo, VType, LocalSnow, LocalVeg->Fract[0]);
   (*Gap)[Opening].NetShort[0] = 0;
 
   /* net longwave received by the opening*/
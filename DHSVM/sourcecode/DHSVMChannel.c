@@ -11,6 +11,7 @@
    ------------------------------------------------------------- */
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <math.h>
 #include <string.h>
 #include "constants.h"
@@ -22,15 +23,21 @@
 #include "errorhandler.h"
 #include "fileio.h"
 
+static void InitChannelCells(MAPSIZE *Map, TOPOPIX **TopoMap,
+			     CHANNEL *channel);
+static COORD *ShrinkChannelCells(COORD *Cells, int N);
+
 /* -----------------------------------------------------------------------------
    InitChannel
    Reads stream and road files and builds the networks.
    -------------------------------------------------------------------------- */
 void
-InitChannel(LISTPTR Input, MAPSIZE *Map, int deltat, CHANNEL *channel,
-	    SOILPIX ** SoilMap, int *MaxStreamID, int *MaxRoadID, OPTIONSTRUCT *Options)
+InitChannel(LISTPTR Input, MAPSIZE *Map, TOPOPIX **TopoMap, int deltat,
+	    CHANNEL *channel, SOILPIX ** SoilMap, int *MaxStreamID,
+	    int *MaxRoadID, OPTIONSTRUCT *Options)
 {
   int i;
+  float courant;
   STRINIENTRY StrEnv[] = {
     {"ROUTING", "STREAM NETWORK FILE", "", ""},
     {"ROUTING", "STREAM MAP FILE", "", ""},
@@ -39,6 +46,7 @@ InitChannel(LISTPTR Input, MAPSIZE *Map, int deltat, CHANNEL *channel,
     {"ROUTING", "ROAD NETWORK FILE", "", "none"},
     {"ROUTING", "ROAD MAP FILE", "", "none"},
     {"ROUTING", "ROAD CLASS FILE", "", "none"},
+    {"ROUTING", "CHANNEL COURANT NUMBER", "", "0"},
     {NULL, NULL, "", NULL}
   };
 
@@ -66,6 +74,12 @@ InitChannel(LISTPTR Input, MAPSIZE *Map, int deltat, CHANNEL *channel,
   channel->roads = NULL;
   channel->stream_map = NULL;
   channel->road_map = NULL;
+  channel->stream_substeps = 1;
+  channel->road_substeps = 1;
+
+  /* segments with K * deltat above this are routed in sub steps */
+  if (!CopyFloat(&courant, StrEnv[channel_courant].VarStr, 1) || courant < 0.0)
+    ReportError(StrEnv[channel_courant].KeyName, 51);
 
   channel_init();
   channel_grid_init(Map->NX, Map->NY);
@@ -91,6 +105,13 @@ InitChannel(LISTPTR Input, MAPSIZE *Map, int deltat, CHANNEL *channel,
     error_handler(ERRHDL_STATUS,
 		  "InitChannel: computing stream network routing coefficients");
     channel_routing_parameters(channel->streams, (double) deltat);
+    channel->stream_substeps =
+      channel_routing_substeps(channel->streams, deltat, courant);
+    if (channel->stream_substeps > 1) {
+      printf("\tRouting streams in %d sub steps\n", channel->stream_substeps);
+      channel_routing_parameters(channel->streams,
+				 (double) deltat / channel->stream_substeps);
+    }
   }
 
   if (Options->StreamTemp) {
@@ -105,7 +126,7 @@ InitChannel(LISTPTR Input, MAPSIZE *Map, int deltat, CHANNEL *channel,
     printf("\tReading Road data\n");
 
     if ((channel->road_class =
-	 channel_read_classes(StrEnv[road_class].VarStr, road_class) == NULL)) {
+	 channel_read_classes(StrEnv[road_class].VarStr, road_class)) == NULL) {
       ReportError(StrEnv[road_class].VarStr, 5);
     }
     if ((channel->roads =
@@ -121,7 +142,101 @@ InitChannel(LISTPTR Input, MAPSIZE *Map, int deltat, CHANNEL *channel,
     error_handler(ERRHDL_STATUS,
 		  "InitChannel: computing road network routing coefficients");
     channel_routing_parameters(channel->roads, (double) deltat);
+    channel->road_substeps =
+      channel_routing_substeps(channel->roads, deltat, courant);
+    if (channel->road_substeps > 1) {
+      printf("\tRouting roads in %d sub steps\n", channel->road_substeps);
+      channel_routing_parameters(channel->roads,
+				 (double) deltat / channel->road_substeps);
+    }
+  }
+
+  InitChannelCells(Map, TopoMap, channel);
+}
+
+/* -------------------------------------------------------------
+   InitChannelCells
+   Lists the basin cells RouteChannel has to visit: roads without
+   a sink, which collect the surface water, roads with a sink
+   (culverts) outside the streams, which return the road flow to
+   the surface, and the stream cells.  Each list is in row order.
+   ------------------------------------------------------------- */
+static void InitChannelCells(MAPSIZE *Map, TOPOPIX **TopoMap,
+			     CHANNEL *channel)
+{
+  const char *Routine = "InitChannelCells";
+  int x, y;
+  int road, stream;
+
+  channel->nroad_cells = 0;
+  channel->nculvert_cells = 0;
+  channel->nstream_cells = 0;
+  if (!(channel->road_cells = (COORD *) calloc(Map->NumCells + 1, sizeof(COORD))) ||
+      !(channel->culvert_cells = (COORD *) calloc(Map->NumCells + 1, sizeof(COORD))) ||
+      !(channel->stream_cells = (COORD *) calloc(Map->NumCells + 1, sizeof(COORD))))
+    ReportError((char *) Routine, 1);
+
+  for (y = 0; y < Map->NY; y++) {
+    for (x = 0; x < Map->NX; x++) {
+      if (!INBASIN(TopoMap[y][x].Mask))
+	continue;
+      road = channel_grid_has_channel(channel->road_map, x, y);
+      stream = channel_grid_has_channel(channel->stream_map, x, y);
+      if (road && !channel_grid_has_sink(channel->road_map, x, y)) {
+	channel->road_cells[channel->nroad_cells].N = y;
+	channel->road_cells[channel->nroad_cells++].E = x;
+      }
+      else if (road && !stream) {
+	channel->culvert_cells[channel->nculvert_cells].N = y;
+	channel->culvert_cells[channel->nculvert_cells++].E = x;
+      }
+      if (stream) {
+	channel->stream_cells[channel->nstream_cells].N = y;
+	channel->stream_cells[channel->nstream_cells++].E = x;
+      }
+    }
   }
+
+  channel->road_cells = ShrinkChannelCells(channel->road_cells,
+					   channel->nroad_cells);
+  channel->culvert_cells = ShrinkChannelCells(channel->culvert_cells,
+					      channel->nculvert_cells);
+  channel->stream_cells = ShrinkChannelCells(channel->stream_cells,
+					     channel->nstream_cells);
+}
+
+/* -------------------------------------------------------------
+   ShrinkChannelCells
+   Trims a cell list allocated for the whole basin to its N cells.
+   An empty list is released.
+   ------------------------------------------------------------- */
+static COORD *ShrinkChannelCells(COORD *Cells, int N)
+{
+  COORD *Shrunk;
+
+  if (N == 0) {
+    free(Cells);
+    return NULL;
+  }
+  if (!(Shrunk = (COORD *) realloc(Cells, N * sizeof(COORD))))
+    ReportError("ShrinkChannelCells", 1);
+  return Shrunk;
+}
+
+/* -------------------------------------------------------------
+   FreeChannelCells
+   ------------------------------------------------------------- */
+void FreeChannelCells(CHANNEL *channel)
+{
+  free(channel->road_cells);
+  channel->road_cells = NULL;
+  channel->nroad_cells = 0;
+  free(channel->culvert_cells);
+  channel->culvert_cells = NULL;
+  channel->nculvert_cells = 0;
+  free(channel->stream_cells);
+  channel->stream_cells = NULL;
+  channel->nstream_cells = 0;
 }
 
 /* -------------------------------------------------------------
@@ -133,12 +248,16 @@ void InitChannelDump(OPTIONSTRUCT *Options, CHANNEL * channel,
   char buffer[NAMESIZE];
 
   if (channel->streams != NULL) {
-    sprintf(buffer, "%sStream.Flow", DumpPath);
-    OpenFile(&(channel->streamout), buffer, "w", TRUE);
-    sprintf(buffer, "%sStreamflow.Only", DumpPath);
-    OpenFile(&(channel->streamflowout), buffer, "w", TRUE);
+    /* with STREAM SERIES FORMAT the records are set up by 
+       channel_series_init() instead */
+    if (!Options->StreamSeries) {
+      sprintf(buffer, "%sStream.Flow", DumpPath);
+      OpenFile(&(channel->streamout), buffer, "w", TRUE);
+      sprintf(buffer, "%sStreamflow.Only", DumpPath);
+      OpenFile(&(channel->streamflowout), buffer, "w", TRUE);
+    }
     /* output files for John's RBM model */
-	if (Options->StreamTemp) {
+	if (Options->StreamTemp && Options->RBMText) {
       //inflow to segment
       sprintf(buffer, "%sInflow.Only", DumpPath);
       OpenFile(&(channel->streaminflow), buffer, "w", TRUE);
@@ -164,6 +283,11 @@ void InitChannelDump(OPTIONSTRUCT *Options, CHANNEL * channel,
       sprintf(buffer, "%sMelt.Only", DumpPath);
       OpenFile(&(channel->streamMelt), buffer, "w", TRUE);                      
 	}
+	/* forcing for RBM written directly, bypassing Create_File, unless
+	   RBM runs in the time loop (channel_rbm_init) */
+	if (Options->StreamTemp && Options->RBMProject[0] != '\0' &&
+	    !Options->RBMCoupled)
+	  channel_open_rbm_forcing(Options->RBMProject, channel);
   }
   if (channel->roads != NULL) {
     sprintf(buffer, "%sRoad.Flow", DumpPath);
@@ -199,73 +323,77 @@ RouteChannel(CHANNEL *ChannelData, TIMESTRUCT *Time, MAPSIZE *Map,
 	     OPTIONSTRUCT *Options, ROADSTRUCT **Network, SOILTABLE *SType, 
 		 PRECIPPIX **PrecipMap, float Tair, float Rh, SNOWPIX **SnowMap)
 {
-  int x, y;
+  int i, x, y;
   int flag;
   char buffer[32];
   float CulvertFlow;
   float temp;
 
   /* give any surface water to roads w/o sinks */
-  for (y = 0; y < Map->NY; y++) {
-    for (x = 0; x < Map->NX; x++) {
-      if (INBASIN(TopoMap[y][x].Mask)) {
-        if (channel_grid_has_channel(ChannelData->road_map, x, y) && 
-          !channel_grid_has_sink(ChannelData->road_map, x, y)) {	/* road w/o sink */
-            SoilMap[y][x].RoadInt += SoilMap[y][x].IExcess; 
-          channel_grid_inc_inflow(ChannelData->road_map, x, y, SoilMap[y][x].IExcess * Map->DX * Map->DY);
-          SoilMap[y][x].IExcess = 0.0f;
-        }
-      }
-    }
+  for (i = 0; i < ChannelData->nroad_cells; i++) {
+    y = ChannelData->road_cells[i].N;
+    x = ChannelData->road_cells[i].E;
+    SoilMap[y][x].RoadInt += SoilMap[y][x].IExcess; 
+    channel_grid_inc_inflow(ChannelData->road_map, x, y, SoilMap[y][x].IExcess * Map->DX * Map->DY);
+    SoilMap[y][x].IExcess = 0.0f;
   }
 
   /* route the road network and save results */
   SPrintDate(&(Time->Current), buffer);
   flag = IsEqualTime(&(Time->Current), &(Time->Start));
   if (ChannelData->roads != NULL) {
-    channel_route_network(ChannelData->roads, Time->Dt);
+    channel_route_network_substeps(ChannelData->roads, Time->Dt,
+				   ChannelData->road_substeps);
     channel_save_outflow_text(buffer, ChannelData->roads,
 			      ChannelData->roadout, ChannelData->roadflowout, flag);
   }
   
-  /* add culvert outflow to surface water */
+  /* add culvert outflow to surface water, all other cells outside the
+     streams have no culvert flow */
   Total->CulvertReturnFlow = 0.0;
-  for (y = 0; y < Map->NY; y++) {
-    for (x = 0; x < Map->NX; x++) {
-      if (INBASIN(TopoMap[y][x].Mask)) {
-		CulvertFlow = ChannelCulvertFlow(y, x, ChannelData);
-		CulvertFlow /= Map->DX * Map->DY;
-		
-		/* CulvertFlow = (CulvertFlow > 0.0) ? CulvertFlow : 0.0; */
-		if (channel_grid_has_channel(ChannelData->stream_map, x, y)) {
-		  channel_grid_inc_inflow(ChannelData->stream_map, x, y,
-				  (SoilMap[y][x].IExcess + CulvertFlow) * Map->DX * Map->DY);
-
-		  if (SnowMap[y][x].Outflow > SoilMap[y][x].IExcess)
-        temp = SoilMap[y][x].IExcess;
-		  else
-        temp = SnowMap[y][x].Outflow;
-		  channel_grid_inc_melt(ChannelData->stream_map, x, y, temp * Map->DX * Map->DY);                                                                                  
-		  SoilMap[y][x].ChannelInt += SoilMap[y][x].IExcess;
-		  Total->CulvertToChannel += CulvertFlow;
-		  SoilMap[y][x].IExcess = 0.0f;
-		}
-		else {
-		  SoilMap[y][x].IExcess += CulvertFlow;
-		  Total->CulvertReturnFlow += CulvertFlow;
-		}
-      }
-    }
+  for (i = 0; i < ChannelData->nculvert_cells; i++) {
+    y = ChannelData->culvert_cells[i].N;
+    x = ChannelData->culvert_cells[i].E;
+    CulvertFlow = ChannelCulvertFlow(y, x, ChannelData);
+    CulvertFlow /= Map->DX * Map->DY;
+    SoilMap[y][x].IExcess += CulvertFlow;
+    Total->CulvertReturnFlow += CulvertFlow;
   }
+
+  /* give surface water and culvert outflow to the streams */
+  for (i = 0; i < ChannelData->nstream_cells; i++) {
+    y = ChannelData->stream_cells[i].N;
+    x = ChannelData->stream_cells[i].E;
+    CulvertFlow = ChannelCulvertFlow(y, x, ChannelData);
+    CulvertFlow /= Map->DX * Map->DY;
+    channel_grid_inc_inflow(ChannelData->stream_map, x, y,
+			    (SoilMap[y][x].IExcess + CulvertFlow) * Map->DX * Map->DY);
+
+    if (SnowMap[y][x].Outflow > SoilMap[y][x].IExcess)
+      temp = SoilMap[y][x].IExcess;
+    else
+      temp = SnowMap[y][x].Outflow;
+    channel_grid_inc_melt(ChannelData->stream_map, x, y, temp * Map->DX * Map->DY);
+    SoilMap[y][x].ChannelInt += SoilMap[y][x].IExcess;
+    Total->CulvertToChannel += CulvertFlow;
+    SoilMap[y][x].IExcess = 0.0f;
+  }
+
   /* route stream channels */
   if (ChannelData->streams != NULL) {
-    channel_route_network(ChannelData->streams, Time->Dt);
-    channel_save_outflow_text(buffer, ChannelData->streams,
-			      ChannelData->streamout,
-			      ChannelData->streamflowout, flag);
+    channel_route_network_substeps(ChannelData->streams, Time->Dt,
+				   ChannelData->stream_substeps);
+    if (ChannelData->series != NULL)
+      channel_series_save(Time, ChannelData->series);
+    else
+      channel_save_outflow_text(buffer, ChannelData->streams,
+				ChannelData->streamout,
+				ChannelData->streamflowout, flag);
 	/* save parameters for John's RBM model */
-	if (Options->StreamTemp)
+	if (Options->StreamTemp && Options->RBMText)
 	  channel_save_outflow_text_cplmt(Time, buffer,ChannelData->streams,ChannelData, flag);
+	if (ChannelData->streamforcing != NULL)
+	  channel_save_rbm_forcing(Time, Options->RBMProject, ChannelData, flag);
   }
   
 }
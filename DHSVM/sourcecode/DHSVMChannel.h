@@ -19,6 +19,15 @@
 #include "channel.h"
 #include "channel_grid.h"
 
+/* number of values in each record of the RBM forcing file */
+#define RBM_NFORCING 9
+
+/* state of the in-process RBM stream temperature model (channel_rbm.c) */
+typedef struct _RBMSTATE RBMSTATE;
+
+/* columnar stream segment output (channel_series.c) */
+typedef struct _CHANNELSERIES CHANNELSERIES;
+
 /* -------------------------------------------------------------
    struct CHANNEL
    ------------------------------------------------------------- */
@@ -42,14 +51,31 @@ typedef struct {
   FILE *streamWND;
   FILE *streamATP;
   FILE *streamMelt;
+  /* direct access forcing file for RBM, one record per RBM segment
+     per time step */
+  FILE *streamforcing;
+  Channel **rbmseg;		/* stream segments in RBM order */
+  int nrbmseg;
+  RBMSTATE *rbm;		/* stream temperatures when coupled to RBM */
+  CHANNELSERIES *series;	/* stream records instead of Stream.Flow */
+  int stream_substeps;		/* routing sub steps per time step */
+  int road_substeps;
+  /* basin cells visited by RouteChannel, in row order */
+  COORD *road_cells;		/* road without sink */
+  int nroad_cells;
+  COORD *culvert_cells;		/* road with sink, no stream */
+  int nculvert_cells;
+  COORD *stream_cells;
+  int nstream_cells;
 } CHANNEL;
 
 /* -------------------------------------------------------------
    available functions
    ------------------------------------------------------------- */
-void InitChannel(LISTPTR Input, MAPSIZE *Map, int deltat, CHANNEL *channel,
-		 SOILPIX **SoilMap, int *MaxStreamID, int *MaxRoadID, OPTIONSTRUCT *Options);
+void InitChannel(LISTPTR Input, MAPSIZE *Map, TOPOPIX **TopoMap, int deltat,
+		 CHANNEL *channel, SOILPIX **SoilMap, int *MaxStreamID, int *MaxRoadID, OPTIONSTRUCT *Options);
 void InitChannelDump(OPTIONSTRUCT *Options, CHANNEL *channel, char *DumpPath);
+void FreeChannelCells(CHANNEL *channel);
 double ChannelCulvertFlow(int y, int x, CHANNEL *ChannelData);
 void RouteChannel(CHANNEL *ChannelData, TIMESTRUCT *Time, MAPSIZE *Map,
 		  TOPOPIX **TopoMap, SOILPIX **SoilMap, AGGREGATED *Total, 
@@ -0,0 +1,1352 @@
+/*
+ * SUMMARY:      DHSVMModel.c - DHSVM as a library
+ * USAGE:        Part of DHSVM
+ *
+ * DESCRIPTION:  Holds the state of one model run, which main() used to
+ *               keep as local variables, and drives it step by step:
+ *               initialization, time steps, access to the maps and
+ *               parameters, in-memory snapshots of the model state, and
+ *               the final output.
+ * DESCRIP-END.
+ * FUNCTIONS:    DHSVMInit()
+ *               DHSVMLoad()
+ *               DHSVMStart()
+ *               DHSVMStep()
+ *               DHSVMFinished()
+ *               DHSVMGetSize()
+ *               DHSVMGetTime()
+ *               DHSVMGetField()
+ *               DHSVMGetOutflow()
+ *               DHSVMSetParameter()
+ *               DHSVMSnapshot()
+ *               DHSVMRestore()
+ *               DHSVMFreeSnapshot()
+ *               DHSVMFinalize()
+ *               DHSVMVersion()
+ * COMMENTS:     Errors reported with ReportError() or error_handler() while
+ *               a call runs return to that call through ErrorReturn, and
+ *               the call returns the error code instead of exiting.
+ */
+
+/******************************************************************************/
+/*				    INCLUDES                                  */
+/******************************************************************************/
+#include <setjmp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "settings.h"
+#include "constants.h"
+#include "data.h"
+#include "DHSVMerror.h"
+#include "functions.h"
+#include "fileio.h"
+#include "getinit.h"
+#include "DHSVMChannel.h"
+#include "channel.h"
+#include "slopeaspect.h"
+#include "varid.h"
+#include "dhsvm.h"
+
+/******************************************************************************/
+/*				GLOBAL VARIABLES                              */
+/******************************************************************************/
+
+/* global strings */
+char *version = "Version 3.2";        /* store version string */
+char commandline[BUFSIZE + 1] = "";		/* store command line */
+char fileext[BUFSIZ + 1] = "";			/* file extension */
+char errorstr[BUFSIZ + 1] = "";			/* error message */
+
+/******************************************************************************/
+/*				  MODEL STATE                                 */
+/******************************************************************************/
+struct _DHSVM {
+  float *Hydrograph;
+  float ***MM5Input;
+  float **PrecipLapseMap;
+  float **PrismMap;
+  unsigned char ***ShadowMap;
+  float **SkyViewMap;
+  float ***WindModel;
+  float **PptMultiplierMap;
+  int MaxStreamID, MaxRoadID;
+  float roadarea;
+  int shade_offset;		/* a fast way of handling arraay position given the number of mm5 input options */
+  int NStats;			/* Number of meteorological stations */
+  uchar ***MetWeights;		/* 3D array with weights for interpolating meteorological variables between the stations */
+  int NGraphics;		/* number of graphics for X11 */
+  int *which_graphics;		/* which graphics for X11 */
+  int Started;			/* TRUE after DHSVMStart() */
+  int Failed;			/* TRUE after an error in DHSVMStart() or DHSVMStep() */
+
+  AGGREGATED Total;		/* Total or average value of a  variable over the entire basin */
+  CHANNEL ChannelData;
+  DUMPSTRUCT Dump;
+  EVAPPIX **EvapMap;
+  INPUTFILES InFiles;
+  LAYER Soil;
+  LAYER Veg;
+  LISTPTR Input;		/* Linked list with input strings */
+  MAPSIZE Map;			/* Size and location of model area */
+  MAPSIZE Radar;		/* Size and location of area covered by precipitation radar */
+  MAPSIZE MM5Map;		/* Size and location of area covered by MM5 input files */
+  GRID Grid;
+  METLOCATION *Stat;
+  OPTIONSTRUCT Options;		/* Structure with information which program options to follow */
+  PIXMET LocalMet;		/* Meteorological conditions for current pixel */
+  PRECIPPIX **PrecipMap;
+  RADARPIX **RadarMap;
+  PIXRAD **RadiationMap;
+  ROADSTRUCT **Network;		/* 2D Array with channel information for each pixel */
+  SNOWPIX **SnowMap;
+  MET_MAP_PIX **MetMap;
+  SOILPIX **SoilMap;
+  SOILTABLE *SType;
+  SOLARGEOMETRY SolarGeo;	/* Geometry of Sun-Earth system (needed for INLINE radiation calculations */
+  TIMESTRUCT Time;
+  TOPOPIX **TopoMap;
+  UNITHYDR **UnitHydrograph;
+  UNITHYDRINFO HydrographInfo;	/* Information about unit hydrograph */
+  VEGPIX **VegMap;
+  VEGTABLE *VType;
+  WATERBALANCE Mass;		/* parameter for mass balance calculations */
+};
+
+struct _DHSVMSNAPSHOT {
+  DHSVM *Model;			/* Model the state was saved from */
+  long *MetPos;			/* Position in each met station file */
+  size_t Size;			/* Bytes allocated for Data */
+  size_t Used;			/* Bytes saved or restored */
+  unsigned char *Data;		/* Model state */
+};
+
+/* parameters that can be changed with DHSVMSetParameter() */
+enum {
+  soil_lateral_ks, soil_exponent, soil_max_infiltration, soil_porosity,
+  soil_pore_size, soil_bubbling_pressure, soil_field_capacity,
+  soil_vertical_ks, veg_max_resistance, veg_min_resistance,
+  veg_moisture_threshold, veg_vpd, const_temp_lapse, const_precip_lapse,
+  const_snow_water_capacity, const_rain_threshold, const_snow_threshold,
+  const_fresh_alb, const_alb_acc_lambda, const_alb_melt_lambda,
+  const_alb_acc_min, const_alb_melt_min
+};
+
+static const struct {
+  const char *Section;
+  const char *Key;
+} ModelParameter[] = {
+  {"SOILS", "LATERAL CONDUCTIVITY"},
+  {"SOILS", "EXPONENTIAL DECREASE"},
+  {"SOILS", "MAXIMUM INFILTRATION"},
+  {"SOILS", "POROSITY"},
+  {"SOILS", "PORE SIZE DISTRIBUTION"},
+  {"SOILS", "BUBBLING PRESSURE"},
+  {"SOILS", "FIELD CAPACITY"},
+  {"SOILS", "VERTICAL CONDUCTIVITY"},
+  {"VEGETATION", "MAXIMUM RESISTANCE"},
+  {"VEGETATION", "MINIMUM RESISTANCE"},
+  {"VEGETATION", "MOISTURE THRESHOLD"},
+  {"VEGETATION", "VAPOR PRESSURE DEFICIT"},
+  {"CONSTANTS", "TEMPERATURE LAPSE RATE"},
+  {"CONSTANTS", "PRECIPITATION LAPSE RATE"},
+  {"CONSTANTS", "SNOW WATER CAPACITY"},
+  {"CONSTANTS", "RAIN THRESHOLD"},
+  {"CONSTANTS", "SNOW THRESHOLD"},
+  {"CONSTANTS", "FRESH SNOW ALBEDO"},
+  {"CONSTANTS", "ALBEDO ACCUMULATION LAMBDA"},
+  {"CONSTANTS", "ALBEDO MELTING LAMBDA"},
+  {"CONSTANTS", "ALBEDO ACCUMULATION MIN"},
+  {"CONSTANTS", "ALBEDO MELTING MIN"},
+  {NULL, NULL}
+};
+
+static void ModelStep(DHSVM *Model);
+static void ReopenMetFiles(DHSVM *Model);
+static void SetSoilParameter(DHSVM *Model, int Id, int Class, int Layer,
+			     float Value);
+static void SaveState(DHSVM *Model, DHSVMSNAPSHOT *Snap, int Restore);
+static void SaveBlock(DHSVMSNAPSHOT *Snap, int Restore, void *Data,
+		      size_t Size);
+static void CloseModelFiles(DHSVM *Model);
+
+/*****************************************************************************
+  DHSVMInit()
+
+  Reads the input file and initializes a model.  On error no model is
+  returned.
+*****************************************************************************/
+int DHSVMInit(const char *ConfigFile, DHSVM **Model)
+{
+  int Code;
+
+  if ((Code = DHSVMLoad(ConfigFile, Model)) != DHSVM_OK)
+    return Code;
+
+  if ((Code = DHSVMStart(*Model, NULL)) != DHSVM_OK) {
+    DHSVMFinalize(*Model);
+    *Model = NULL;
+  }
+  return Code;
+}
+
+/*****************************************************************************
+  DHSVMLoad()
+
+  Reads the input file and the inputs that do not depend on the initial
+  state or the output:  the parameter tables, the terrain, soil and
+  vegetation maps, the channel network, the met stations and met maps and
+  the interpolation weights.  The model is then started with DHSVMStart().
+  On error no model is returned.
+*****************************************************************************/
+int DHSVMLoad(const char *ConfigFile, DHSVM **Model)
+{
+  jmp_buf Env;
+  int Code;
+  int i;
+  int j;
+  DHSVM *M;
+
+  if (ConfigFile == NULL || Model == NULL ||
+      strlen(ConfigFile) > BUFSIZE)
+    return DHSVM_INVALID;
+  *Model = NULL;
+
+  if (!(M = (DHSVM *) calloc(1, sizeof(DHSVM)))) {
+    ReportWarning("DHSVMLoad", 1);
+    return 1;
+  }
+
+  if ((Code = setjmp(Env)) != 0) {
+    ErrorReturn = NULL;
+    if (M->Input != NULL)
+      DeleteList(M->Input);
+    free(M);
+    return Code;
+  }
+  ErrorReturn = &Env;
+
+  if (IsEmptyStr(commandline))
+    sprintf(commandline, "DHSVM %s", ConfigFile);
+  strcpy(M->InFiles.Const, ConfigFile);
+  M->NGraphics = 0;
+  M->which_graphics = NULL;
+
+  /* initiate input/output format */
+
+  ReadInitFile(M->InFiles.Const, &(M->Input));
+  InitConstants(M->Input, &(M->Options), &(M->Map), &(M->SolarGeo), &(M->Time));
+
+  InitFileIO(M->Options.FileFormat);
+  InitTables(M->Time.NDaySteps, M->Input, &(M->Options), &(M->Map), &(M->SType),
+	     &(M->Soil), &(M->VType), &(M->Veg));
+
+  InitTerrainMaps(M->Input, &(M->Options), &(M->Map), &(M->Soil), &(M->Veg),
+		  &(M->TopoMap), M->SType, &(M->SoilMap), M->VType, &(M->VegMap));
+
+  InitSnowMap(&(M->Map), &(M->SnowMap), &(M->Time));
+
+  InitMappedConstants(M->Input, &(M->Options), &(M->Map), &(M->SnowMap));
+
+  CheckOut(&(M->Options), M->Veg, M->Soil, M->VType, M->SType, &(M->Map),
+	   M->TopoMap, M->VegMap, M->SoilMap);
+
+#ifdef TOPO_DUMP
+  DumpTopo(&(M->Map), M->TopoMap);
+#endif
+
+  if (M->Options.HasNetwork)
+    InitChannel(M->Input, &(M->Map), M->TopoMap, M->Time.Dt, &(M->ChannelData),
+		M->SoilMap, &(M->MaxStreamID), &(M->MaxRoadID), &(M->Options));
+  else if (M->Options.Extent != POINT)
+    InitUnitHydrograph(M->Input, &(M->Map), M->TopoMap, &(M->UnitHydrograph),
+		       &(M->Hydrograph), &(M->HydrographInfo));
+
+  InitNetwork(&(M->Map), M->TopoMap, M->SoilMap, M->VegMap, M->VType,
+	      &(M->Network), &(M->ChannelData), M->Veg, &(M->Options));
+
+  InitMetSources(M->Input, &(M->Options), &(M->Map), M->TopoMap,
+		 M->Soil.MaxLayers, &(M->Time), &(M->InFiles), &(M->NStats),
+		 &(M->Stat), &(M->Radar), &(M->MM5Map), &(M->Grid));
+
+  /* the following piece of code is for the UW PRISM project */
+  /* for real-time verification of SWE at Snotel sites */
+  /* Other users, set OPTION.SNOTEL to FALSE, or use TRUE with caution */
+
+  if (M->Options.Snotel == TRUE && M->Options.Outside == FALSE) {
+    printf
+      ("Warning: All met stations locations are being set to the vegetation class GLACIER\n");
+    printf
+      ("Warning: This requires that you have such a vegetation class in your vegetation table\n");
+    printf("To disable this feature set Snotel OPTION to FALSE\n");
+    for (i = 0; i < M->NStats; i++) {
+      printf("veg type for station %d is %d ", i,
+	     M->VegMap[M->Stat[i].Loc.N][M->Stat[i].Loc.E].Veg);
+      for (j = 0; j < M->Veg.NTypes; j++) {
+	if (M->VType[j].Index == GLACIER) {
+	  M->VegMap[M->Stat[i].Loc.N][M->Stat[i].Loc.E].Veg = j;
+	  break;
+	}
+      }
+      if (j == M->Veg.NTypes) {	/* glacier class not found */
+	ReportError("MainDHSVM", 62);
+      }
+      printf("setting to glacier type (assumed bare class): %d\n", j);
+    }
+  }
+
+  InitMetMaps(M->Input, M->Time.NDaySteps, &(M->Map), &(M->Radar),
+	      &(M->Options), M->InFiles.WindMapPath, M->InFiles.PrecipLapseFile,
+	      &(M->PrecipLapseMap), &(M->PrismMap), &(M->ShadowMap),
+	      &(M->SkyViewMap), &(M->EvapMap), &(M->PrecipMap),
+	      &(M->PptMultiplierMap), &(M->RadarMap), &(M->RadiationMap),
+	      M->SoilMap, &(M->Soil), M->VegMap, &(M->Veg), M->TopoMap,
+	      &(M->MM5Input), &(M->WindModel));
+
+  /* monthly PRISM and shade maps kept in memory, shared by forked members */
+  InitMonthlyMaps(&(M->Time), &(M->Options), &(M->Map));
+
+  InitInterpolationWeights(&(M->Map), &(M->Options), M->TopoMap,
+			   &(M->MetWeights), M->Stat, M->NStats);
+
+  M->shade_offset = FALSE;
+  if (M->Options.Shading == TRUE)
+    M->shade_offset = TRUE;
+
+  ErrorReturn = NULL;
+  *Model = M;
+  return DHSVM_OK;
+}
+
+/*****************************************************************************
+  DHSVMStart()
+
+  Opens the output files, in OutputPath instead of the output directory of
+  the input file if OutputPath is not NULL, and reads the initial state.
+  The met station files are opened again at the same position, so models
+  started in processes forked after DHSVMLoad() do not share a file offset.
+*****************************************************************************/
+int DHSVMStart(DHSVM *Model, const char *OutputPath)
+{
+  jmp_buf Env;
+  int Code;
+  DHSVM *M = Model;
+
+  if (M == NULL || M->Started || M->Input == NULL ||
+      (OutputPath != NULL && strlen(OutputPath) > BUFSIZE / 2))
+    return DHSVM_INVALID;
+
+  if ((Code = setjmp(Env)) != 0) {
+    ErrorReturn = NULL;
+    M->Failed = TRUE;
+    return Code;
+  }
+  ErrorReturn = &Env;
+
+  if (OutputPath != NULL)
+    SetInitString("OUTPUT", "OUTPUT DIRECTORY", OutputPath, M->Input);
+
+  ReopenMetFiles(M);
+
+  InitDump(M->Input, &(M->Options), &(M->Map), M->Soil.MaxLayers,
+	   M->Veg.MaxLayers, M->Time.Dt, M->TopoMap, &(M->Dump),
+	   &(M->NGraphics), &(M->which_graphics));
+
+#ifndef SNOW_ONLY
+  if (M->Options.HasNetwork == TRUE) {
+    InitChannelDump(&(M->Options), &(M->ChannelData), M->Dump.Path);
+    if (M->Options.RBMCoupled)
+      channel_rbm_init(M->Options.RBMProject, M->Time.Dt, &(M->ChannelData));
+    if (M->Options.StreamSeries)
+      channel_series_init(&(M->Options), M->Dump.Path, &(M->Time.Start),
+			  &(M->ChannelData));
+    ReadChannelState(M->Dump.InitStatePath, &(M->Time.Start),
+		     M->ChannelData.streams);
+    if (M->Options.StreamTemp && M->Options.CanopyShading)
+      InitChannelRVeg(&(M->Time), M->ChannelData.streams);
+  }
+#endif
+
+  InitAggregated(&(M->Options), M->Veg.MaxLayers, M->Soil.MaxLayers, &(M->Total));
+
+  InitModelState(&(M->Time.Start), M->Time.NDaySteps, &(M->Map), &(M->Options),
+		 M->PrecipMap, M->SnowMap, M->SoilMap, M->Soil, M->SType,
+		 M->VegMap, M->Veg, M->VType, M->Dump.InitStatePath,
+		 M->TopoMap, M->Network, &(M->HydrographInfo), M->Hydrograph);
+
+  InitNewMonth(&(M->Time), &(M->Options), &(M->Map), M->TopoMap, M->PrismMap,
+	       M->ShadowMap, &(M->InFiles), M->Veg.NTypes, M->VType, M->NStats,
+	       M->Stat, M->Dump.InitStatePath, &(M->VegMap));
+
+  InitNewDay(M->Time.Current.JDay, &(M->SolarGeo));
+
+  if (M->Options.FlowGradient == WATERTABLE)
+    InitHeadSlopeAspect(&(M->Map));
+
+  if (M->Options.SnowSlide)
+    InitAvalanche(&(M->Map));
+
+  if (M->NGraphics > 0) {
+    if (M->Dump.Graphics.Mode == GRAPHICS_X11) {
+      printf("Initialzing X11 display and graphics \n");
+      InitXGraphics(0, NULL, M->Map.NY, M->Map.NX, M->NGraphics,
+		    &(M->Dump.Graphics));
+    }
+    InitGraphicsFrame(&(M->Map), M->NGraphics, &(M->Dump.Graphics), &(M->MetMap));
+  }
+
+  /* Done with initialization, delete the list with input strings */
+  DeleteList(M->Input);
+  M->Input = NULL;
+
+  /* setup for mass balance calculations */
+  Aggregate(&(M->Map), &(M->Options), M->TopoMap, &(M->Soil), &(M->Veg),
+	    M->VegMap, M->EvapMap, M->PrecipMap, M->RadiationMap, M->SnowMap,
+	    M->SoilMap, &(M->Total), M->VType, M->Network, &(M->ChannelData),
+	    &(M->roadarea), NULL, M->Time.Dt);
+
+  M->Mass.StartWaterStorage =
+    M->Total.Water.IExcess + M->Total.CanopyWater + M->Total.SoilWater +
+    M->Total.Water.Swq + M->Total.Water.SatFlow;
+  M->Mass.OldWaterStorage = M->Mass.StartWaterStorage;
+
+  /* computes the number of grid cell contributing to one segment */
+  if (M->Options.StreamTemp)
+    Init_segment_ncell(M->TopoMap, M->ChannelData.stream_map, M->Map.NY,
+		       M->Map.NX, M->ChannelData.streams);
+
+  M->Started = TRUE;
+  ErrorReturn = NULL;
+  return DHSVM_OK;
+}
+
+/*****************************************************************************
+  ReopenMetFiles()
+*****************************************************************************/
+static void ReopenMetFiles(DHSVM *Model)
+{
+  FILES *MetFile;
+  long Position;
+  int i;
+
+  for (i = 0; i < Model->NStats; i++) {
+    MetFile = &(Model->Stat[i].MetFile);
+    if (MetFile->FilePtr == NULL)
+      continue;
+    if ((Position = ftell(MetFile->FilePtr)) < 0)
+      ReportError(MetFile->FileName, 39);
+    fclose(MetFile->FilePtr);
+    OpenFile(&(MetFile->FilePtr), MetFile->FileName, "r", FALSE);
+    if (fseek(MetFile->FilePtr, Position, SEEK_SET))
+      ReportError(MetFile->FileName, 39);
+  }
+}
+
+/*****************************************************************************
+  DHSVMStep()
+
+  Runs NSteps time steps, or up to the end of the run if NSteps <= 0 or
+  fewer steps are left.
+*****************************************************************************/
+int DHSVMStep(DHSVM *Model, int NSteps)
+{
+  jmp_buf Env;
+  int Code;
+  int n;
+
+  if (Model == NULL || !Model->Started || Model->Failed)
+    return DHSVM_INVALID;
+
+  if ((Code = setjmp(Env)) != 0) {
+    ErrorReturn = NULL;
+    Model->Failed = TRUE;
+    return Code;
+  }
+  ErrorReturn = &Env;
+
+  for (n = 0; (NSteps <= 0 || n < NSteps) && !DHSVMFinished(Model); n++)
+    ModelStep(Model);
+
+  ErrorReturn = NULL;
+  return DHSVM_OK;
+}
+
+/*****************************************************************************
+  DHSVMFinished()
+
+  Returns TRUE once the last time step of the run has been done.
+*****************************************************************************/
+int DHSVMFinished(DHSVM *Model)
+{
+  return !(Before(&(Model->Time.Current), &(Model->Time.End)) ||
+	   IsEqualTime(&(Model->Time.Current), &(Model->Time.End)));
+}
+
+/*****************************************************************************
+  DHSVMGetSize()
+
+  Size of the model grid.  Fields are NY rows of NX values, north to south.
+*****************************************************************************/
+int DHSVMGetSize(DHSVM *Model, int *NY, int *NX)
+{
+  if (Model == NULL || NY == NULL || NX == NULL)
+    return DHSVM_INVALID;
+
+  *NY = Model->Map.NY;
+  *NX = Model->Map.NX;
+  return DHSVM_OK;
+}
+
+/*****************************************************************************
+  DHSVMGetTime()
+
+  Number of time steps done, number of time steps in the run and the time
+  step (s).  Any of the pointers may be NULL.
+*****************************************************************************/
+int DHSVMGetTime(DHSVM *Model, int *Step, int *NTotalSteps, int *Dt)
+{
+  if (Model == NULL)
+    return DHSVM_INVALID;
+
+  if (Step != NULL)
+    *Step = Model->Time.Step;
+  if (NTotalSteps != NULL)
+    *NTotalSteps = Model->Time.NTotalSteps;
+  if (Dt != NULL)
+    *Dt = Model->Time.Dt;
+  return DHSVM_OK;
+}
+
+/*****************************************************************************
+  DHSVMGetField()
+
+  Copies the map of a variable to Values (NY * NX).  ID and Layer are
+  those of the map output in the input file (see VarID.c); the values are
+  those DumpMap() would write at the current time.  For a variable that
+  DumpMap() writes once per soil layer (ID 104) the first layer is returned.
+*****************************************************************************/
+int DHSVMGetField(DHSVM *Model, int ID, int Layer, float *Values)
+{
+  jmp_buf Env;
+  int Code;
+  MAPDUMP DMap;
+
+  if (Model == NULL || Values == NULL || !IsValidID(ID))
+    return DHSVM_INVALID;
+
+  if (IsMultiLayer(ID)) {
+    if (Layer < 1 ||
+	Layer > GetVarNLayers(ID, Model->Soil.MaxLayers, Model->Veg.MaxLayers))
+      return DHSVM_INVALID;
+  }
+  else
+    Layer = 1;
+
+  memset(&DMap, 0, sizeof(MAPDUMP));
+  DMap.ID = ID;
+  DMap.Layer = Layer;
+  DMap.Resolution = MAP_OUTPUT;
+  GetVarNumberType(ID, &(DMap.NumberType));
+  DMap.Capture = Values;
+
+  if ((Code = setjmp(Env)) != 0) {
+    ErrorReturn = NULL;
+    return Code;
+  }
+  ErrorReturn = &Env;
+
+  DumpMap(&(Model->Map), &(Model->Time.Current), &DMap, Model->TopoMap,
+	  Model->EvapMap, Model->PrecipMap, Model->RadiationMap, Model->SnowMap,
+	  Model->SoilMap, &(Model->Soil), Model->VegMap, &(Model->Veg),
+	  Model->Network, &(Model->Options));
+
+  ErrorReturn = NULL;
+
+  /* variables without a map (only pixel output) */
+  if (DMap.Slot == 0)
+    return DHSVM_UNSUPPORTED;
+  return DHSVM_OK;
+}
+
+/*****************************************************************************
+  DHSVMGetOutflow()
+
+  Outflow (m3/timestep) of a stream segment in the last time step.
+*****************************************************************************/
+int DHSVMGetOutflow(DHSVM *Model, int SegmentID, float *Outflow)
+{
+  Channel *Segment;
+
+  if (Model == NULL || Outflow == NULL)
+    return DHSVM_INVALID;
+  if (!Model->Options.HasNetwork)
+    return DHSVM_UNSUPPORTED;
+
+  if ((Segment = channel_find_segment(Model->ChannelData.streams,
+				      SegmentID)) == NULL)
+    return DHSVM_INVALID;
+
+  *Outflow = Segment->outflow;
+  return DHSVM_OK;
+}
+
+/*****************************************************************************
+  DHSVMSetParameter()
+
+  Changes a parameter of the [SOILS], [VEGETATION] or [CONSTANTS] section
+  of the input file (see ModelParameter for the keys).  Class is the soil
+  or vegetation type and Layer the soil or vegetation layer (both from 1),
+  as in the key names of the input file; they are ignored where they do
+  not apply.  A soil parameter replaces any spatial map of that parameter
+  for the pixels of the soil type, a snow parameter any map of that
+  parameter.  The change takes effect from the next time step and is kept
+  by DHSVMRestore().
+*****************************************************************************/
+int DHSVMSetParameter(DHSVM *Model, const char *Section, const char *Key,
+		      int Class, int Layer, float Value)
+{
+  jmp_buf Env;
+  int Code;
+  int Id;
+  int MapId;
+  char SectionName[BUFSIZE + 1];
+  char KeyName[BUFSIZE + 1];
+  VEGTABLE *VType;
+
+  if (Model == NULL || Section == NULL || Key == NULL ||
+      strlen(Section) > BUFSIZE || strlen(Key) > BUFSIZE)
+    return DHSVM_INVALID;
+
+  /* keys are compared as the input file reader does */
+  strcpy(SectionName, Section);
+  strcpy(KeyName, Key);
+  MakeKeyString(SectionName);
+  MakeKeyString(KeyName);
+
+  for (Id = 0; ModelParameter[Id].Section != NULL; Id++)
+    if (strcmp(SectionName, ModelParameter[Id].Section) == 0 &&
+	strcmp(KeyName, ModelParameter[Id].Key) == 0)
+      break;
+  if (ModelParameter[Id].Section == NULL)
+    return DHSVM_INVALID;
+
+  if ((Code = setjmp(Env)) != 0) {
+    ErrorReturn = NULL;
+    return Code;
+  }
+  ErrorReturn = &Env;
+
+  switch (Id) {
+  case soil_lateral_ks:
+  case soil_exponent:
+  case soil_max_infiltration:
+  case soil_porosity:
+  case soil_pore_size:
+  case soil_bubbling_pressure:
+  case soil_field_capacity:
+  case soil_vertical_ks:
+    if (Class < 1 || Class > Model->Soil.NTypes ||
+	((Id == soil_porosity || Id == soil_pore_size ||
+	  Id == soil_bubbling_pressure || Id == soil_field_capacity ||
+	  Id == soil_vertical_ks) &&
+	 (Layer < 1 || Layer > Model->SType[Class - 1].NLayers))) {
+      ErrorReturn = NULL;
+      return DHSVM_INVALID;
+    }
+    SetSoilParameter(Model, Id, Class, Layer, Value);
+    break;
+
+  case veg_max_resistance:
+  case veg_min_resistance:
+  case veg_moisture_threshold:
+  case veg_vpd:
+    if (Class < 1 || Class > Model->Veg.NTypes ||
+	Layer < 1 || Layer > Model->VType[Class - 1].NVegLayers) {
+      ErrorReturn = NULL;
+      return DHSVM_INVALID;
+    }
+    VType = &(Model->VType[Class - 1]);
+    if (Id == veg_max_resistance)
+      VType->RsMax[Layer - 1] = Value;
+    else if (Id == veg_min_resistance)
+      VType->RsMin[Layer - 1] = Value;
+    else if (Id == veg_moisture_threshold)
+      VType->MoistThres[Layer - 1] = Value;
+    else
+      VType->VpdThres[Layer - 1] = Value;
+    break;
+
+  case const_temp_lapse:
+  case const_precip_lapse:
+    /* lapse rates from maps or the met files are not replaced */
+    if ((Id == const_temp_lapse && Model->Options.TempLapse != CONSTANT) ||
+	(Id == const_precip_lapse && Model->Options.PrecipLapse != CONSTANT)) {
+      ErrorReturn = NULL;
+      return DHSVM_UNSUPPORTED;
+    }
+    if (Id == const_temp_lapse)
+      TEMPLAPSE = Value;
+    else
+      PRECIPLAPSE = Value;
+    break;
+
+  case const_snow_water_capacity:
+    LIQUID_WATER_CAPACITY = Value;
+    break;
+
+  default:
+    /* snow parameters, also kept in each pixel of SnowMap */
+    switch (Id) {
+    case const_rain_threshold:
+      MIN_RAIN_TEMP = Value;
+      MapId = 801;
+      break;
+    case const_snow_threshold:
+      MAX_SNOW_TEMP = Value;
+      MapId = 800;
+      break;
+    case const_fresh_alb:
+      ALB_MAX = Value;
+      MapId = 802;
+      break;
+    case const_alb_acc_lambda:
+      ALB_ACC_LAMBDA = Value;
+      MapId = 803;
+      break;
+    case const_alb_melt_lambda:
+      ALB_MELT_LAMBDA = Value;
+      MapId = 804;
+      break;
+    case const_alb_acc_min:
+      ALB_ACC_MIN = Value;
+      MapId = 805;
+      break;
+    default:
+      ALB_MELT_MIN = Value;
+      MapId = 806;
+      break;
+    }
+    InitParameterMaps(&(Model->Options), &(Model->Map), MapId, NULL,
+		      &(Model->SnowMap), CONSTANT, Value);
+    break;
+  }
+
+  ErrorReturn = NULL;
+  return DHSVM_OK;
+}
+
+/*****************************************************************************
+  SetSoilParameter()
+
+  Sets a parameter of soil type Class, copies it to the pixels of that type
+  that keep their own value, and rebuilds the hydraulic tables.
+*****************************************************************************/
+static void SetSoilParameter(DHSVM *Model, int Id, int Class, int Layer,
+			     float Value)
+{
+  SOILTABLE *SType = &(Model->SType[Class - 1]);
+  int l = Layer - 1;
+  int x;
+  int y;
+
+  /* same checks as InitSoilTable() */
+  if ((Id == soil_porosity &&
+       (Value < SType->FCap[l] || Value < SType->WP[l])) ||
+      (Id == soil_field_capacity &&
+       (SType->Porosity[l] < Value || Value < SType->WP[l])))
+    ReportError(SType->Desc, 11);
+
+  switch (Id) {
+  case soil_lateral_ks:
+    SType->KsLat = Value;
+    break;
+  case soil_exponent:
+    SType->KsLatExp = Value;
+    break;
+  case soil_max_infiltration:
+    SType->MaxInfiltrationRate = Value;
+    break;
+  case soil_porosity:
+    SType->Porosity[l] = Value;
+    break;
+  case soil_pore_size:
+    SType->PoreDist[l] = Value;
+    break;
+  case soil_bubbling_pressure:
+    SType->Press[l] = Value;
+    break;
+  case soil_field_capacity:
+    SType->FCap[l] = Value;
+    break;
+  default:
+    SType->Ks[l] = Value;
+    break;
+  }
+
+  if (Id == soil_lateral_ks || Id == soil_porosity ||
+      Id == soil_field_capacity) {
+    for (y = 0; y < Model->Map.NY; y++) {
+      for (x = 0; x < Model->Map.NX; x++) {
+	if (INBASIN(Model->TopoMap[y][x].Mask) &&
+	    Model->SoilMap[y][x].Soil == Class) {
+	  if (Id == soil_lateral_ks)
+	    Model->SoilMap[y][x].KsLat = Value;
+	  else if (Id == soil_porosity)
+	    Model->SoilMap[y][x].Porosity[l] = Value;
+	  else
+	    Model->SoilMap[y][x].FCap[l] = Value;
+	}
+      }
+    }
+  }
+
+  if (Model->Options.HydraulicTables == TRUE) {
+    FreeHydraulicTables(SType);
+    InitHydraulicTables(SType, Model->Options.HydraulicTolerance);
+  }
+}
+
+/*****************************************************************************
+  DHSVMSnapshot()
+
+  Saves the state of the model in memory:  the state of every pixel, the
+  channel network, the mass balance and the position in the met station
+  files.  Parameters are not part of the state.  Output files are not
+  rewound by DHSVMRestore(), and a model coupled to RBM cannot be saved.
+*****************************************************************************/
+int DHSVMSnapshot(DHSVM *Model, DHSVMSNAPSHOT **Snapshot)
+{
+  jmp_buf Env;
+  int Code;
+  int i;
+  DHSVMSNAPSHOT *Snap;
+
+  if (Model == NULL || Snapshot == NULL || !Model->Started || Model->Failed)
+    return DHSVM_INVALID;
+  if (Model->Options.RBMCoupled)
+    return DHSVM_UNSUPPORTED;
+  *Snapshot = NULL;
+
+  if (!(Snap = (DHSVMSNAPSHOT *) calloc(1, sizeof(DHSVMSNAPSHOT))) ||
+      !(Snap->MetPos = (long *) calloc(Model->NStats + 1, sizeof(long)))) {
+    free(Snap);
+    ReportWarning("DHSVMSnapshot", 1);
+    return 1;
+  }
+  Snap->Model = Model;
+
+  if ((Code = setjmp(Env)) != 0) {
+    ErrorReturn = NULL;
+    DHSVMFreeSnapshot(Snap);
+    return Code;
+  }
+  ErrorReturn = &Env;
+
+  for (i = 0; i < Model->NStats; i++)
+    if (Model->Stat[i].MetFile.FilePtr != NULL &&
+	(Snap->MetPos[i] = ftell(Model->Stat[i].MetFile.FilePtr)) < 0)
+      ReportError(Model->Stat[i].MetFile.FileName, 39);
+
+  SaveState(Model, Snap, FALSE);
+
+  ErrorReturn = NULL;
+  *Snapshot = Snap;
+  return DHSVM_OK;
+}
+
+/*****************************************************************************
+  DHSVMRestore()
+
+  Returns the model to a state saved by DHSVMSnapshot().  The maps that
+  change each month are read again if the month of the state differs.
+*****************************************************************************/
+int DHSVMRestore(DHSVM *Model, DHSVMSNAPSHOT *Snapshot)
+{
+  jmp_buf Env;
+  int Code;
+  int i;
+  DATE Current;
+
+  if (Model == NULL || Snapshot == NULL || Snapshot->Model != Model ||
+      !Model->Started)
+    return DHSVM_INVALID;
+
+  if ((Code = setjmp(Env)) != 0) {
+    ErrorReturn = NULL;
+    Model->Failed = TRUE;
+    return Code;
+  }
+  ErrorReturn = &Env;
+
+  CopyDate(&Current, &(Model->Time.Current));
+  SaveState(Model, Snapshot, TRUE);
+
+  for (i = 0; i < Model->NStats; i++)
+    if (Model->Stat[i].MetFile.FilePtr != NULL &&
+	fseek(Model->Stat[i].MetFile.FilePtr, Snapshot->MetPos[i], SEEK_SET))
+      ReportError(Model->Stat[i].MetFile.FileName, 39);
+
+  if (Current.Month != Model->Time.Current.Month ||
+      Current.Year != Model->Time.Current.Year)
+    InitNewMonth(&(Model->Time), &(Model->Options), &(Model->Map),
+		 Model->TopoMap, Model->PrismMap, Model->ShadowMap,
+		 &(Model->InFiles), Model->Veg.NTypes, Model->VType,
+		 Model->NStats, Model->Stat, Model->Dump.InitStatePath,
+		 &(Model->VegMap));
+
+  Model->Failed = FALSE;
+  ErrorReturn = NULL;
+  return DHSVM_OK;
+}
+
+/*****************************************************************************
+  DHSVMFreeSnapshot()
+*****************************************************************************/
+void DHSVMFreeSnapshot(DHSVMSNAPSHOT *Snapshot)
+{
+  if (Snapshot == NULL)
+    return;
+
+  free(Snapshot->MetPos);
+  free(Snapshot->Data);
+  free(Snapshot);
+}
+
+/*****************************************************************************
+  DHSVMFinalize()
+
+  Writes the output at the end of the run, the final mass balance, and
+  closes the output files.  A model that was not started is only released.  The model maps are not released.
+*****************************************************************************/
+int DHSVMFinalize(DHSVM *Model)
+{
+  jmp_buf Env;
+  int Code;
+
+  if (Model == NULL)
+    return DHSVM_INVALID;
+
+  if ((Code = setjmp(Env)) != 0) {
+    ErrorReturn = NULL;
+    free(Model);
+    return Code;
+  }
+  ErrorReturn = &Env;
+
+  if (Model->Started && !Model->Failed) {
+    ExecDump(&(Model->Map), &(Model->Time.Current), &(Model->Time.Start),
+	     &(Model->Options), &(Model->Dump), Model->TopoMap, Model->EvapMap,
+	     Model->RadiationMap, Model->PrecipMap, Model->SnowMap,
+	     Model->MetMap, Model->VegMap, &(Model->Veg), Model->SoilMap,
+	     Model->Network, &(Model->ChannelData), &(Model->Soil),
+	     &(Model->Total), &(Model->HydrographInfo), Model->Hydrograph);
+
+#ifndef SNOW_ONLY
+    FinalMassBalance(&(Model->Dump.FinalBalance), &(Model->Total),
+		     &(Model->Mass));
+#endif
+    ReportMassEnergyPaths();
+  }
+
+  /* write the buffered records and close the shared series files */
+  CloseModelFiles(Model);
+  if (Model->Input != NULL)
+    DeleteList(Model->Input);
+
+  ErrorReturn = NULL;
+  free(Model);
+  return DHSVM_OK;
+}
+
+/*****************************************************************************
+  DHSVMVersion()
+*****************************************************************************/
+const char *DHSVMVersion(void)
+{
+  return version;
+}
+
+/*****************************************************************************
+  ModelStep()
+
+  One time step of the model.
+*****************************************************************************/
+static void ModelStep(DHSVM *Model)
+{
+  char buffer[32];
+  int i;
+  int x;			/* row counter */
+  int y;			/* column counter */
+  MAPSIZE *Map = &(Model->Map);
+  OPTIONSTRUCT *Options = &(Model->Options);
+  TIMESTRUCT *Time = &(Model->Time);
+  TOPOPIX **TopoMap = Model->TopoMap;
+
+  /* reset aggregated variables */
+  ResetAggregate(&(Model->Soil), &(Model->Veg), &(Model->Total), Options);
+
+  /* redistribute snow based on snow surface slope etc */
+  if (Options->SnowSlide)
+    Avalanche(Map, TopoMap, Time, Options, Model->SnowMap);
+
+  if (IsNewWaterYear(&(Time->Current)))
+    InitNewWaterYear(Time, Options, Map, TopoMap, Model->SnowMap);
+
+  if (IsNewMonth(&(Time->Current), Time->Dt))
+    InitNewMonth(Time, Options, Map, TopoMap, Model->PrismMap, Model->ShadowMap,
+		 &(Model->InFiles), Model->Veg.NTypes, Model->VType,
+		 Model->NStats, Model->Stat, Model->Dump.InitStatePath,
+		 &(Model->VegMap));
+
+  if (IsNewDay(Time->DayStep)) {
+    InitNewDay(Time->Current.JDay, &(Model->SolarGeo));
+    PrintDate(&(Time->Current), stdout);
+    printf("\n");
+  }
+
+  InitNewStep(&(Model->InFiles), Map, Time, Model->Soil.MaxLayers, Options,
+	      Model->NStats, Model->Stat, Model->InFiles.RadarFile,
+	      &(Model->Radar), Model->RadarMap, &(Model->SolarGeo), TopoMap,
+	      Model->SoilMap, Model->MM5Input, Model->PrecipLapseMap,
+	      Model->WindModel, &(Model->MM5Map));
+
+  /* initialize channel/road networks for time step */
+  if (Options->HasNetwork) {
+    channel_step_initialize_network(Model->ChannelData.streams);
+    channel_step_initialize_network(Model->ChannelData.roads);
+  }
+
+  for (y = 0; y < Map->NY; y++) {
+    for (x = 0; x < Map->NX; x++) {
+      if (INBASIN(TopoMap[y][x].Mask)) {
+	if (Options->Shading)
+	  Model->LocalMet =
+	    MakeLocalMetData(y, x, Map, Time->DayStep, Time->NDaySteps, Options,
+			     Model->NStats, Model->Stat, Model->MetWeights[y][x],
+			     TopoMap[y][x].Dem, &(Model->RadiationMap[y][x]),
+			     &(Model->PrecipMap[y][x]), &(Model->Radar),
+			     Model->RadarMap, Model->PrismMap,
+			     &(Model->SnowMap[y][x]), &(Model->VegMap[y][x].Type),
+			     &(Model->VegMap[y][x]), Model->MM5Input,
+			     Model->WindModel, Model->PrecipLapseMap,
+			     &(Model->MetMap), Model->PptMultiplierMap[y][x],
+			     Model->NGraphics, Time->Current.Month,
+			     Model->SkyViewMap[y][x],
+			     Model->ShadowMap[Time->DayStep][y][x],
+			     Model->SolarGeo.SunMax,
+			     Model->SolarGeo.SineSolarAltitude);
+	else
+	  Model->LocalMet =
+	    MakeLocalMetData(y, x, Map, Time->DayStep, Time->NDaySteps, Options,
+			     Model->NStats, Model->Stat, Model->MetWeights[y][x],
+			     TopoMap[y][x].Dem, &(Model->RadiationMap[y][x]),
+			     &(Model->PrecipMap[y][x]), &(Model->Radar),
+			     Model->RadarMap, Model->PrismMap,
+			     &(Model->SnowMap[y][x]), &(Model->VegMap[y][x].Type),
+			     &(Model->VegMap[y][x]), Model->MM5Input,
+			     Model->WindModel, Model->PrecipLapseMap,
+			     &(Model->MetMap), Model->PptMultiplierMap[y][x],
+			     Model->NGraphics, Time->Current.Month, 0.0, 0.0,
+			     Model->SolarGeo.SunMax,
+			     Model->SolarGeo.SineSolarAltitude);
+
+	/* get surface tempeature of each soil layer */
+	for (i = 0; i < Model->Soil.MaxLayers; i++) {
+	  if (Options->HeatFlux == TRUE) {
+	    if (Options->MM5 == TRUE)
+	      Model->SoilMap[y][x].Temp[i] =
+		Model->MM5Input[Model->shade_offset + i + N_MM5_MAPS][y][x];
+
+	    /* read tempeature of each soil layer from met station input */
+	    else
+	      Model->SoilMap[y][x].Temp[i] = Model->Stat[0].Data.Tsoil[i];
+	  }
+	  /* if heat flux option is turned off, soil temperature of all 3 layers
+	     is taken equal to air tempeature */
+	  else
+	    Model->SoilMap[y][x].Temp[i] = Model->LocalMet.Tair;
+	}
+
+	MassEnergyBalance(Options, y, x, Model->SolarGeo.SineSolarAltitude,
+			  Map->DX, Map->DY, Time->Dt, Options->HeatFlux,
+			  Options->CanopyRadAtt, Options->Infiltration,
+			  Model->Soil.MaxLayers, Model->Veg.MaxLayers,
+			  &(Model->LocalMet), &(Model->Network[y][x]),
+			  &(Model->PrecipMap[y][x]),
+			  &(Model->VType[Model->VegMap[y][x].Veg - 1]),
+			  &(Model->VegMap[y][x]),
+			  &(Model->SType[Model->SoilMap[y][x].Soil - 1]),
+			  &(Model->SoilMap[y][x]), &(Model->SnowMap[y][x]),
+			  &(Model->RadiationMap[y][x]), &(Model->EvapMap[y][x]),
+			  &(Model->Total.Rad), &(Model->ChannelData),
+			  Model->SkyViewMap);
+
+	Model->PrecipMap[y][x].SumPrecip += Model->PrecipMap[y][x].Precip;
+      }
+    }
+  }
+
+  /* Average all RBM inputs over each segment */
+  if (Options->StreamTemp) {
+    channel_grid_avg(Model->ChannelData.streams);
+    if (Options->CanopyShading)
+      CalcCanopyShading(Time, Model->ChannelData.streams, &(Model->SolarGeo));
+  }
+
+#ifndef SNOW_ONLY
+
+  RouteSubSurface(Time->Dt, Map, TopoMap, Model->VType, Model->VegMap,
+		  Model->Network, Model->SType, Model->SoilMap,
+		  &(Model->ChannelData), Time, Options, Model->MaxStreamID,
+		  Model->SnowMap);
+
+  if (Options->HasNetwork)
+    RouteChannel(&(Model->ChannelData), Time, Map, TopoMap, Model->SoilMap,
+		 &(Model->Total), Options, Model->Network, Model->SType,
+		 Model->PrecipMap, Model->LocalMet.Tair, Model->LocalMet.Rh,
+		 Model->SnowMap);
+
+  /* stream temperatures from the segment averages and routed flows */
+  if (Options->RBMCoupled)
+    channel_rbm_step(Time, &(Model->ChannelData));
+
+  if (Options->Extent == BASIN)
+    RouteSurface(Map, Time, TopoMap, Model->SoilMap, Options,
+		 Model->UnitHydrograph, &(Model->HydrographInfo),
+		 Model->Hydrograph, &(Model->Dump), Model->VegMap,
+		 Model->VType, &(Model->ChannelData));
+
+#endif
+
+  if (Model->NGraphics > 0)
+    draw(&(Time->Current), IsEqualTime(&(Time->Current), &(Time->Start)),
+	 Time->DayStep, Map, Model->NGraphics, Model->which_graphics,
+	 Model->VType, Model->SType, Model->SnowMap, Model->SoilMap,
+	 Model->VegMap, TopoMap, Model->PrecipMap, Model->PrismMap,
+	 Model->SkyViewMap, Model->ShadowMap, Model->EvapMap,
+	 Model->RadiationMap, Model->MetMap, Model->Network,
+	 &(Model->Dump.Graphics), Model->Dump.Path, Options);
+
+  Aggregate(Map, Options, TopoMap, &(Model->Soil), &(Model->Veg),
+	    Model->VegMap, Model->EvapMap, Model->PrecipMap,
+	    Model->RadiationMap, Model->SnowMap, Model->SoilMap,
+	    &(Model->Total), Model->VType, Model->Network,
+	    &(Model->ChannelData), &(Model->roadarea), &(Time->Current),
+	    Time->Dt);
+
+  /* saturation extent, counted in Aggregate() */
+  if (Model->Dump.Saturation.FilePtr != NULL) {
+    SPrintDate(&(Time->Current), buffer);
+    fprintf(Model->Dump.Saturation.FilePtr, "%-20s %.4f \n", buffer,
+	    Model->Total.SaturationExtent);
+  }
+
+  MassBalance(&(Time->Current), &(Time->Start), &(Model->Dump.Balance),
+	      &(Model->Total), &(Model->Mass));
+
+  ExecDump(Map, &(Time->Current), &(Time->Start), Options, &(Model->Dump),
+	   TopoMap, Model->EvapMap, Model->RadiationMap, Model->PrecipMap,
+	   Model->SnowMap, Model->MetMap, Model->VegMap, &(Model->Veg),
+	   Model->SoilMap, Model->Network, &(Model->ChannelData),
+	   &(Model->Soil), &(Model->Total), &(Model->HydrographInfo),
+	   Model->Hydrograph);
+
+  IncreaseTime(Time);
+}
+
+/*****************************************************************************
+  SaveState()
+
+  Copies the model state to the snapshot, or back if Restore is TRUE.  The
+  same traversal is used both ways, so the blocks are always in the same
+  order.  The parameters kept in SnowMap and SoilMap are not restored.
+*****************************************************************************/
+static void SaveState(DHSVM *Model, DHSVMSNAPSHOT *Snap, int Restore)
+{
+  int i;
+  int j;
+  int x;
+  int y;
+  int NSoil;			/* Number of soil layers for current pixel */
+  int NVeg;			/* Number of veg layers for current pixel */
+  Channel *Segment;
+  SNOWPIX Snow;
+  float KsLat;
+
+  Snap->Used = 0;
+
+  SaveBlock(Snap, Restore, &(Model->Time), sizeof(TIMESTRUCT));
+  SaveBlock(Snap, Restore, &(Model->SolarGeo), sizeof(SOLARGEOMETRY));
+  SaveBlock(Snap, Restore, &(Model->Mass), sizeof(WATERBALANCE));
+  SaveBlock(Snap, Restore, &(Model->Total), sizeof(AGGREGATED));
+  SaveBlock(Snap, Restore, &(Model->LocalMet), sizeof(PIXMET));
+
+  for (y = 0; y < Model->Map.NY; y++) {
+    for (x = 0; x < Model->Map.NX; x++) {
+      Snow = Model->SnowMap[y][x];
+      SaveBlock(Snap, Restore, &(Model->SnowMap[y][x]), sizeof(SNOWPIX));
+      if (Restore) {
+	Model->SnowMap[y][x].Ts = Snow.Ts;
+	Model->SnowMap[y][x].Tr = Snow.Tr;
+	Model->SnowMap[y][x].amax = Snow.amax;
+	Model->SnowMap[y][x].LamdaAcc = Snow.LamdaAcc;
+	Model->SnowMap[y][x].LamdaMelt = Snow.LamdaMelt;
+	Model->SnowMap[y][x].AccMin = Snow.AccMin;
+	Model->SnowMap[y][x].MeltMin = Snow.MeltMin;
+      }
+
+      KsLat = Model->SoilMap[y][x].KsLat;
+      SaveBlock(Snap, Restore, &(Model->SoilMap[y][x]), sizeof(SOILPIX));
+      Model->SoilMap[y][x].KsLat = KsLat;
+
+      SaveBlock(Snap, Restore, &(Model->PrecipMap[y][x]), sizeof(PRECIPPIX));
+      SaveBlock(Snap, Restore, &(Model->VegMap[y][x]), sizeof(VEGPIX));
+      SaveBlock(Snap, Restore, &(Model->EvapMap[y][x]), sizeof(EVAPPIX));
+      SaveBlock(Snap, Restore, &(Model->RadiationMap[y][x]), sizeof(PIXRAD));
+      SaveBlock(Snap, Restore, &(Model->Network[y][x]), sizeof(ROADSTRUCT));
+
+      if (INBASIN(Model->TopoMap[y][x].Mask)) {
+	NSoil = Model->Soil.NLayers[Model->SoilMap[y][x].Soil - 1];
+	NVeg = Model->Veg.NLayers[Model->VegMap[y][x].Veg - 1];
+	SaveBlock(Snap, Restore, Model->SoilMap[y][x].Moist,
+		  (NSoil + 1) * sizeof(float));
+	SaveBlock(Snap, Restore, Model->SoilMap[y][x].Perc,
+		  NSoil * sizeof(float));
+	SaveBlock(Snap, Restore, Model->SoilMap[y][x].Temp,
+		  NSoil * sizeof(float));
+	SaveBlock(Snap, Restore, Model->PrecipMap[y][x].IntRain,
+		  NVeg * sizeof(float));
+	SaveBlock(Snap, Restore, Model->PrecipMap[y][x].IntSnow,
+		  NVeg * sizeof(float));
+	SaveBlock(Snap, Restore, Model->EvapMap[y][x].EPot,
+		  (NVeg + 1) * sizeof(float));
+	SaveBlock(Snap, Restore, Model->EvapMap[y][x].EAct,
+		  (NVeg + 1) * sizeof(float));
+	SaveBlock(Snap, Restore, Model->EvapMap[y][x].EInt,
+		  NVeg * sizeof(float));
+	for (j = 0; j < NVeg; j++)
+	  SaveBlock(Snap, Restore, Model->EvapMap[y][x].ESoil[j],
+		    NSoil * sizeof(float));
+      }
+
+      /* the canopy gap structure is allocated for all pixels */
+      if (Model->Options.CanopyGapping) {
+	NSoil = Model->Soil.MaxLayers;
+	NVeg = Model->Veg.MaxLayers;
+	for (i = 0; i < CELL_PARTITION; i++) {
+	  SaveBlock(Snap, Restore, &(Model->VegMap[y][x].Type[i]),
+		    sizeof(CanopyGapStruct));
+	  SaveBlock(Snap, Restore, Model->VegMap[y][x].Type[i].IntRain,
+		    NVeg * sizeof(float));
+	  SaveBlock(Snap, Restore, Model->VegMap[y][x].Type[i].IntSnow,
+		    NVeg * sizeof(float));
+	  SaveBlock(Snap, Restore, Model->VegMap[y][x].Type[i].Moist,
+		    (NSoil + 1) * sizeof(float));
+	  SaveBlock(Snap, Restore, Model->VegMap[y][x].Type[i].EPot,
+		    (NVeg + 1) * sizeof(float));
+	  SaveBlock(Snap, Restore, Model->VegMap[y][x].Type[i].EAct,
+		    (NVeg + 1) * sizeof(float));
+	  SaveBlock(Snap, Restore, Model->VegMap[y][x].Type[i].EInt,
+		    NVeg * sizeof(float));
+	  for (j = 0; j < NVeg; j++)
+	    SaveBlock(Snap, Restore, Model->VegMap[y][x].Type[i].ESoil[j],
+		      NSoil * sizeof(float));
+	}
+      }
+    }
+  }
+
+  for (Segment = Model->ChannelData.streams; Segment != NULL;
+       Segment = Segment->next)
+    SaveBlock(Snap, Restore, Segment, sizeof(Channel));
+  for (Segment = Model->ChannelData.roads; Segment != NULL;
+       Segment = Segment->next)
+    SaveBlock(Snap, Restore, Segment, sizeof(Channel));
+
+  if (Model->Hydrograph != NULL)
+    SaveBlock(Snap, Restore, Model->Hydrograph,
+	      Model->HydrographInfo.TotalWaveLength * sizeof(float));
+}
+
+/*****************************************************************************
+  SaveBlock()
+
+  Appends Size bytes at Data to the snapshot, or copies the next Size
+  bytes of the snapshot to Data if Restore is TRUE.  Structures are copied
+  whole:  their pointers are the same when restored to the same model.
+*****************************************************************************/
+static void SaveBlock(DHSVMSNAPSHOT *Snap, int Restore, void *Data,
+		      size_t Size)
+{
+  const char *Routine = "SaveBlock";
+  size_t NewSize;
+
+  if (Restore) {
+    memcpy(Data, Snap->Data + Snap->Used, Size);
+  }
+  else {
+    if (Snap->Used + Size > Snap->Size) {
+      NewSize = Snap->Size > 0 ? 2 * Snap->Size : BUFSIZ;
+      while (NewSize < Snap->Used + Size)
+	NewSize *= 2;
+      if (!(Snap->Data = (unsigned char *) realloc(Snap->Data, NewSize)))
+	ReportError((char *) Routine, 1);
+      Snap->Size = NewSize;
+    }
+    memcpy(Snap->Data + Snap->Used, Data, Size);
+  }
+  Snap->Used += Size;
+}
+
+/*****************************************************************************
+  CloseModelFiles()
+*****************************************************************************/
+static void CloseModelFiles(DHSVM *Model)
+{
+  DUMPSTRUCT *Dump = &(Model->Dump);
+  CHANNEL *ChannelData = &(Model->ChannelData);
+
+  if (Dump->Aggregate.FilePtr != NULL)
+    fclose(Dump->Aggregate.FilePtr);
+  if (Dump->Balance.FilePtr != NULL)
+    fclose(Dump->Balance.FilePtr);
+  if (Dump->FinalBalance.FilePtr != NULL)
+    fclose(Dump->FinalBalance.FilePtr);
+  if (Dump->Saturation.FilePtr != NULL)
+    fclose(Dump->Saturation.FilePtr);
+  ClosePixSeries(Dump->PixSeries);
+  Dump->PixSeries = NULL;
+  if (ChannelData->streamflowout != NULL)
+    fclose(ChannelData->streamflowout);
+  if (ChannelData->streamout != NULL)
+    fclose(ChannelData->streamout);
+  channel_series_close(ChannelData);
+  CloseMappedFiles();
+  if (ChannelData->roadflowout != NULL)
+    fclose(ChannelData->roadflowout);
+  if (ChannelData->roadout != NULL)
+    fclose(ChannelData->roadout);
+  FreeChannelCells(ChannelData);
+
+  if (Model->Options.StreamTemp) {
+    if (ChannelData->streaminflow != NULL)
+      fclose(ChannelData->streaminflow);
+    if (ChannelData->streamoutflow != NULL)
+      fclose(ChannelData->streamoutflow);
+    if (ChannelData->streamMelt != NULL)
+      fclose(ChannelData->streamMelt);
+    if (ChannelData->streamNSW != NULL)
+      fclose(ChannelData->streamNSW);
+    if (ChannelData->streamNLW != NULL)
+      fclose(ChannelData->streamNLW);
+    if (ChannelData->streamVP != NULL)
+      fclose(ChannelData->streamVP);
+    if (ChannelData->streamWND != NULL)
+      fclose(ChannelData->streamWND);
+    if (ChannelData->streamATP != NULL)
+      fclose(ChannelData->streamATP);
+    if (ChannelData->streamforcing != NULL)
+      fclose(ChannelData->streamforcing);
+    channel_rbm_close(ChannelData);
+  }
+}
@@ -16,7 +16,11 @@
 #ifndef DHSVM_ERROR_H
 #define DHSVM_ERROR_H
 
+#include <setjmp.h>
+
 extern char errorstr[];
+extern jmp_buf *ErrorReturn;	/* if not NULL, errors return here instead of
+				   exiting, see DHSVMModel.c */
 void ReportError(char *ErrorString, int ErrorCode);
 void ReportWarning(char *ErrorString, int ErrorCode);
 
@@ -7,16 +7,20 @@
 * ORG:          University of Washington, Department of Civil Engineering
 * E-MAIL:       pstorck@u.washington.edu
 * ORIG-DATE:    2000
-* DESCRIPTION:  X11 routines for DHSVM
+* DESCRIPTION:  Live graphics for DHSVM
 * DESCRIP-END.
-* FUNCTIONS:   
-* COMMENTS:
+* FUNCTIONS:    draw()
+* COMMENTS:     The selected fields are rendered into the colour index frame
+*               of GraphicsFrame.c, which is then either written as a PPM
+*               file or put into the X11 window with one XPutImage().
 * $Id: Draw.c,v 1.12 2006/10/03 22:50:22 nathalie Exp $     
 */
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include "constants.h"
+#include "DHSVMerror.h"
 #include "settings.h"
 #include "data.h"
 #include "functions.h"
@@ -32,10 +36,10 @@
 extern Display *display;
 extern Window window;
 extern GC gc;
-extern XColor my_color[50];
-extern float **temp_array;
+extern XColor my_color[NGRAPHICSCOLORS];
 extern long black, white;
-extern int e, ndx;
+
+static void PutFrame(GRAPHICSDUMP *Graphics, int NGraphics);
 #endif
 
 void draw(DATE *Day, int first, int DayStep, MAPSIZE *Map, int NGraphics,
@@ -43,77 +47,76 @@ void draw(DATE *Day, int first, int DayStep, MAPSIZE *Map, int NGraphics,
           SOILPIX **SoilMap, VEGPIX **VegMap, TOPOPIX **TopoMap, PRECIPPIX **PrecipMap, 
           float **PrismMap, float **SkyViewMap, unsigned char ***ShadowMap, 
           EVAPPIX **EvapMap, PIXRAD **RadMap, MET_MAP_PIX **MetMap, 
-          ROADSTRUCT **Network, OPTIONSTRUCT *Options)
+          ROADSTRUCT **Network, GRAPHICSDUMP *Graphics, char *Path,
+          OPTIONSTRUCT *Options)
 {				
-  int i, j, k, ie, je, ir, jr;
-  int PX, PY;
+  int i, j, k;
   int MapNumber;
-  float min, max, scale;
-  float temp, surf_swe, pack_swe;
-  int index, skip_it;
+  float min, max;
+  float temp = 0.0, surf_swe, pack_swe;
   char *text;
-  char text2[6];
   char text3[20];
-  int length;
-  float max_temp;
-  float re;
-  int buf = 50;
-  int sample = 1;		/* if sample =0, then average if compression needed, otherwise if =1 then sample */
-  /*  obviously, for really large domains, the 1 option is much faster */
-  int expand;
-  int draw_static_colorbar;
+  float **temp_array;
+  int visible;			/* FALSE if the X11 window is iconized */
+  int large;			/* FALSE if the X11 window is too small */
+  int draw_static;
 #ifdef HAVE_X11
   XWindowAttributes windowattr;
+#endif
 
-  expand = e;
-  draw_static_colorbar = 1;
-  if (XGetWindowAttributes(display, window, &windowattr) == 0) {
-    printf("failed to get window attributes in draw \n");
-    exit(-1);
-  }
+  /* only every Interval time steps */
+  if (first != 1 && ++(Graphics->Step) < Graphics->Interval)
+    return;
+  Graphics->Step = 0;
 
-  /* windowatt.map_state = 0 if DHSVM realtime display is set to an icon */
-  /* windowatt.map_state = 2 if DHSVM realtime is active */
-  /* if the user iconizes DHSVM display then */
-  /* turn the graphics off and let DHSVM fly (or at least try to fly) */
+  temp_array = Graphics->Field;
+  visible = TRUE;
+  large = TRUE;
+  draw_static = (first == 1 || Day->Hour == 0);
+  SPrintDate(Day, text3);
 
-  if (windowattr.map_state > 0) {
-    XSetForeground(display, gc, black);
-    SPrintDate(Day, text3);
-    XClearArea(display, window, 10, 0, 100, 20, False);
-    XDrawString(display, window, gc, 10, 20, text3, 19);
+#ifdef HAVE_X11
+  if (Graphics->Mode == GRAPHICS_X11) {
+    if (XGetWindowAttributes(display, window, &windowattr) == 0) {
+      printf("failed to get window attributes in draw \n");
+      exit(-1);
+    }
+
+    /* windowatt.map_state = 0 if DHSVM realtime display is set to an icon */
+    /* windowatt.map_state = 2 if DHSVM realtime is active */
+    /* if the user iconizes DHSVM display then */
+    /* turn the graphics off and let DHSVM fly (or at least try to fly) */
+    visible = (windowattr.map_state > 0);
 
     /* if the user changes window size below 300 by 300 then */
     /* turn the graphics off and let DHSVM fly (or at least try to fly) */
     /* but at least print the date and time to the display */
-    if (windowattr.width > 300 && windowattr.height > 300) {
-      if (first == 1 || Day->Hour == 0)
-        draw_static_colorbar = 1;
+    large = (windowattr.width > 300 && windowattr.height > 300);
 
+    if (visible) {
+      XSetForeground(display, gc, black);
+      XClearArea(display, window, 10, 0, 100, 20, False);
+      XDrawString(display, window, gc, 10, 20, text3, 19);
+    }
+  }
+#endif
+
+  if (visible) {
+    if (large) {
       for (k = 0; k < NGraphics; k++) {
         /* this is the beginning of the master loop which tries to draw */
         /* all the graphic variables */
         /* however we override the static fields, 3, 4, 5 and 6 such that */
         /* they are only drawn on the first call or on each new day */
-        /* the same limitation is given to drawing all the color bars */
+        /* the frame keeps them in between */
         MapNumber = which_graphics[k];
-        if (MapNumber < 3 || MapNumber > 6 || draw_static_colorbar == 1) {
-          PY = k / ndx;
-          PX = k - ndx * PY;
-          if (expand > 0) {
-            PX = PX * (Map->NX * expand + buf) + 10;
-            PY = PY * (Map->NY * expand + buf) + 20;	/*top 20 pixels reserved for date stamp */
-          }
-          else {
-            PX = PX * (Map->NX * (1.0 / ((float) (-expand))) + buf) + 10;
-            PY = PY * (Map->NY * (1.0 / ((float) (-expand))) + buf) + 20;
-          }
+        if (MapNumber < 3 || MapNumber > 6 || draw_static == 1) {
+          text = NULL;
           max = -1000000.;
           min = 1000000.;
 
           if (MapNumber == 1) {
             text = "SWE (mm)";
-            length = 8;
             for (i = 0; i < Map->NX; i++) {
               for (j = 0; j < Map->NY; j++) {
                 if (INBASIN(TopoMap[j][i].Mask)) {
@@ -132,7 +135,6 @@ void draw(DATE *Day, int first, int DayStep, MAPSIZE *Map, int NGraphics,
 
           if (MapNumber == 2) {
             text = "Water Table Depth (mm)";
-            length = 22;
             for (i = 0; i < Map->NX; i++) {
               for (j = 0; j < Map->NY; j++) {
                 if (INBASIN(TopoMap[j][i].Mask)) {
@@ -149,7 +151,6 @@ void draw(DATE *Day, int first, int DayStep, MAPSIZE *Map, int NGraphics,
 
           if (MapNumber == 3) {
             text = "Digital Elevation Model (m)";
-            length = 27;
             for (i = 0; i < Map->NX; i++) {
               for (j = 0; j < Map->NY; j++) {
                 if (INBASIN(TopoMap[j][i].Mask)) {
@@ -166,7 +167,6 @@ void draw(DATE *Day, int first, int DayStep, MAPSIZE *Map, int NGraphics,
 
           if (MapNumber == 4) {
             text = "Vegetation Class";
-            length = 16;
             for (i = 0; i < Map->NX; i++) {
               for (j = 0; j < Map->NY; j++) {
                 if (INBASIN(TopoMap[j][i].Mask)) {
@@ -183,7 +183,6 @@ void draw(DATE *Day, int first, int DayStep, MAPSIZE *Map, int NGraphics,
 
           if (MapNumber == 5) {
             text = "Soil Class";
-            length = 10;
             for (i = 0; i < Map->NX; i++) {
               for (j = 0; j < Map->NY; j++) {
                 if (INBASIN(TopoMap[j][i].Mask)) {
@@ -200,7 +199,6 @@ void draw(DATE *Day, int first, int DayStep, MAPSIZE *Map, int NGraphics,
 
           if (MapNumber == 6) {
             text = "Soil Depth (mm)";
-            length = 15;
             for (i = 0; i < Map->NX; i++) {
               for (j = 0; j < Map->NY; j++) {
                 if (INBASIN(TopoMap[j][i].Mask)) {
@@ -217,7 +215,6 @@ void draw(DATE *Day, int first, int DayStep, MAPSIZE *Map, int NGraphics,
 
           if (MapNumber == 7) {
             text = "Precipitation (mm)";
-            length = 18;
             for (i = 0; i < Map->NX; i++) {
               for (j = 0; j < Map->NY; j++) {
                 if (INBASIN(TopoMap[j][i].Mask)) {
@@ -234,7 +231,6 @@ void draw(DATE *Day, int first, int DayStep, MAPSIZE *Map, int NGraphics,
 
           if (MapNumber == 8) {
             text = "Incoming Shortwave (W/sqm)";
-            length = 26;
             for (i = 0; i < Map->NX; i++) {
               for (j = 0; j < Map->NY; j++) {
                 if (INBASIN(TopoMap[j][i].Mask)) {
@@ -251,7 +247,6 @@ void draw(DATE *Day, int first, int DayStep, MAPSIZE *Map, int NGraphics,
 
           if (MapNumber == 9) {
             text = "Intercepted Snow (mm)";
-            length = 21;
             for (i = 0; i < Map->NX; i++) {
               for (j = 0; j < Map->NY; j++) {
                 if (INBASIN(TopoMap[j][i].Mask) && VType[VegMap[j][i].Veg - 1].OverStory == 1) {
@@ -271,7 +266,6 @@ void draw(DATE *Day, int first, int DayStep, MAPSIZE *Map, int NGraphics,
 
           if (MapNumber == 10) {
             text = "Snow Surface Temp (C)";
-            length = 21;
             max = 0.0;
             for (i = 0; i < Map->NX; i++) {
               for (j = 0; j < Map->NY; j++) {
@@ -291,7 +285,6 @@ void draw(DATE *Day, int first, int DayStep, MAPSIZE *Map, int NGraphics,
 
           if (MapNumber == 11) {
             text = "Cold Content (kJ)";
-            length = 17;
             max = 0.0;
             for (i = 0; i < Map->NX; i++) {
               for (j = 0; j < Map->NY; j++) {
@@ -320,7 +313,6 @@ void draw(DATE *Day, int first, int DayStep, MAPSIZE *Map, int NGraphics,
 
           if (MapNumber == 12) {
             text = "Snow Melt (mm)";
-            length = 14;
             for (i = 0; i < Map->NX; i++) {
               for (j = 0; j < Map->NY; j++) {
                 if (INBASIN(TopoMap[j][i].Mask)) {
@@ -337,7 +329,6 @@ void draw(DATE *Day, int first, int DayStep, MAPSIZE *Map, int NGraphics,
 
           if (MapNumber == 13) {
             text = "Snow Pack Outflow (mm)";
-            length = 22;
             for (i = 0; i < Map->NX; i++) {
               for (j = 0; j < Map->NY; j++) {
                 if (INBASIN(TopoMap[j][i].Mask)) {
@@ -356,7 +347,6 @@ void draw(DATE *Day, int first, int DayStep, MAPSIZE *Map, int NGraphics,
 
           if (MapNumber == 14) {
             text = "Sat. Subsurf Flow (mm) 0=white";
-            length = 30;
             for (i = 0; i < Map->NX; i++) {
               for (j = 0; j < Map->NY; j++) {
                 if (INBASIN(TopoMap[j][i].Mask)) {
@@ -375,7 +365,6 @@ void draw(DATE *Day, int first, int DayStep, MAPSIZE *Map, int NGraphics,
 
           if (MapNumber == 15) {
             text = "Overland Flow (mm)";
-            length = 18;
             for (i = 0; i < Map->NX; i++) {
               for (j = 0; j < Map->NY; j++) {
                 if (INBASIN(TopoMap[j][i].Mask)) {
@@ -392,7 +381,6 @@ void draw(DATE *Day, int first, int DayStep, MAPSIZE *Map, int NGraphics,
 
           if (MapNumber == 16) {
             text = "Total EvapoTranspiration (mm)";
-            length = 29;
             for (i = 0; i < Map->NX; i++) {
               for (j = 0; j < Map->NY; j++) {
                 if (INBASIN(TopoMap[j][i].Mask)) {
@@ -409,7 +397,6 @@ void draw(DATE *Day, int first, int DayStep, MAPSIZE *Map, int NGraphics,
 
           if (MapNumber == 17) {
             text = "Snow Pack Vapor Flux (mm)";
-            length = 25;
             for (i = 0; i < Map->NX; i++) {
               for (j = 0; j < Map->NY; j++) {
                 if (INBASIN(TopoMap[j][i].Mask)) {
@@ -428,7 +415,6 @@ void draw(DATE *Day, int first, int DayStep, MAPSIZE *Map, int NGraphics,
 
           if (MapNumber == 18) {
             text = "Int Snow Vapor Flux (mm)";
-            length = 24;
             for (i = 0; i < Map->NX; i++) {
               for (j = 0; j < Map->NY; j++) {
                 if (INBASIN(TopoMap[j][i].Mask)) {
@@ -447,7 +433,6 @@ void draw(DATE *Day, int first, int DayStep, MAPSIZE *Map, int NGraphics,
 
           if (MapNumber == 19) {
             text = "Soil Moist L1 (% Sat)";
-            length = 21;
             for (i = 0; i < Map->NX; i++) {
               for (j = 0; j < Map->NY; j++) {
                 if (INBASIN(TopoMap[j][i].Mask)) {
@@ -466,7 +451,6 @@ void draw(DATE *Day, int first, int DayStep, MAPSIZE *Map, int NGraphics,
 
           if (MapNumber == 20) {
             text = "Soil Moist L2 (% Sat)";
-            length = 21;
             for (i = 0; i < Map->NX; i++) {
               for (j = 0; j < Map->NY; j++) {
                 if (INBASIN(TopoMap[j][i].Mask)) {
@@ -485,7 +469,6 @@ void draw(DATE *Day, int first, int DayStep, MAPSIZE *Map, int NGraphics,
 
           if (MapNumber == 21) {
             text = "Soil Moist L3 (% Sat)";
-            length = 21;
             for (i = 0; i < Map->NX; i++) {
               for (j = 0; j < Map->NY; j++) {
                 if (INBASIN(TopoMap[j][i].Mask)) {
@@ -503,7 +486,6 @@ void draw(DATE *Day, int first, int DayStep, MAPSIZE *Map, int NGraphics,
 
           if (MapNumber == 22) {
             text = "Accumulated Precip (mm)";
-            length = 23;
             for (i = 0; i < Map->NX; i++) {
               for (j = 0; j < Map->NY; j++) {
                 if (INBASIN(TopoMap[j][i].Mask)) {
@@ -521,7 +503,6 @@ void draw(DATE *Day, int first, int DayStep, MAPSIZE *Map, int NGraphics,
 
           if (MapNumber == 23) {
             text = "Air Temp (C) 0=white";
-            length = 20;
             for (i = 0; i < Map->NX; i++) {
               for (j = 0; j < Map->NY; j++) {
                 if (INBASIN(TopoMap[j][i].Mask)) {
@@ -540,7 +521,6 @@ void draw(DATE *Day, int first, int DayStep, MAPSIZE *Map, int NGraphics,
 
           if (MapNumber == 24) {
             text = "Wind Speed (m/s)";
-            length = 16;
             for (i = 0; i < Map->NX; i++) {
               for (j = 0; j < Map->NY; j++) {
                 if (INBASIN(TopoMap[j][i].Mask)) {
@@ -557,7 +537,6 @@ void draw(DATE *Day, int first, int DayStep, MAPSIZE *Map, int NGraphics,
 
           if (MapNumber == 25) {
             text = "RH";
-            length = 2;
             for (i = 0; i < Map->NX; i++) {
               for (j = 0; j < Map->NY; j++) {
                 if (INBASIN(TopoMap[j][i].Mask)) {
@@ -575,7 +554,6 @@ void draw(DATE *Day, int first, int DayStep, MAPSIZE *Map, int NGraphics,
 
           if (MapNumber == 26) {
             text = "Prism Precip (mm)";
-            length = 17;
             for (i = 0; i < Map->NX; i++) {
               for (j = 0; j < Map->NY; j++) {
                 if (INBASIN(TopoMap[j][i].Mask)) {
@@ -594,7 +572,6 @@ void draw(DATE *Day, int first, int DayStep, MAPSIZE *Map, int NGraphics,
 
           if (MapNumber == 27) {
             text = "Deep Layer Storage (% Sat)";
-            length = 26;
             for (i = 0; i < Map->NX; i++) {
               for (j = 0; j < Map->NY; j++) {
                 if (INBASIN(TopoMap[j][i].Mask)) {
@@ -613,7 +590,6 @@ void draw(DATE *Day, int first, int DayStep, MAPSIZE *Map, int NGraphics,
 
           if (MapNumber == 28) {
             text = "Surface runoff from HOF and Return Flow (mm)";
-            length = 22;
             for (i = 0; i < Map->NX; i++) {
               for (j = 0; j < Map->NY; j++) {
 
@@ -631,7 +607,6 @@ void draw(DATE *Day, int first, int DayStep, MAPSIZE *Map, int NGraphics,
 
           if (MapNumber == 29 && Options->Infiltration == DYNAMIC) {
             text = "Infiltration Accumulation (mm)";
-            length = 22;
             for (i = 0; i < Map->NX; i++) {
               for (j = 0; j < Map->NY; j++) {
 
@@ -649,7 +624,6 @@ void draw(DATE *Day, int first, int DayStep, MAPSIZE *Map, int NGraphics,
 
           if (MapNumber == 31) {
             text = "Overstory Trans (mm)";
-            length = 20;
             for (i = 0; i < Map->NX; i++) {
               for (j = 0; j < Map->NY; j++) {
                 if (INBASIN(TopoMap[j][i].Mask)) {
@@ -666,7 +640,6 @@ void draw(DATE *Day, int first, int DayStep, MAPSIZE *Map, int NGraphics,
 
           if (MapNumber == 32) {
             text = "Understory Trans (mm)";
-            length = 21;
             for (i = 0; i < Map->NX; i++) {
               for (j = 0; j < Map->NY; j++) {
                 if (INBASIN(TopoMap[j][i].Mask)) {
@@ -683,7 +656,6 @@ void draw(DATE *Day, int first, int DayStep, MAPSIZE *Map, int NGraphics,
 
           if (MapNumber == 33) {
             text = "Soil Evaporation (mm)";
-            length = 21;
             for (i = 0; i < Map->NX; i++) {
               for (j = 0; j < Map->NY; j++) {
                 if (INBASIN(TopoMap[j][i].Mask)) {
@@ -700,7 +672,6 @@ void draw(DATE *Day, int first, int DayStep, MAPSIZE *Map, int NGraphics,
 
           if (MapNumber == 34) {
             text = "Overstory Int Evap (mm)";
-            length = 23;
             for (i = 0; i < Map->NX; i++) {
               for (j = 0; j < Map->NY; j++) {
                 if (INBASIN(TopoMap[j][i].Mask)) {
@@ -717,7 +688,6 @@ void draw(DATE *Day, int first, int DayStep, MAPSIZE *Map, int NGraphics,
 
           if (MapNumber == 35) {
             text = "Understory Int Evap (mm)";
-            length = 24;
             for (i = 0; i < Map->NX; i++) {
               for (j = 0; j < Map->NY; j++) {
                 if (INBASIN(TopoMap[j][i].Mask)) {
@@ -734,7 +704,6 @@ void draw(DATE *Day, int first, int DayStep, MAPSIZE *Map, int NGraphics,
 
           if (MapNumber == 41) {
             text = "Sky View Factor (%)";
-            length = 19;
             for (i = 0; i < Map->NX; i++) {
               for (j = 0; j < Map->NY; j++) {
                 if (INBASIN(TopoMap[j][i].Mask)) {
@@ -753,7 +722,6 @@ void draw(DATE *Day, int first, int DayStep, MAPSIZE *Map, int NGraphics,
 
           if (MapNumber == 42) {
             text = "Shade Map  (%)";
-            length = 14;
             for (i = 0; i < Map->NX; i++) {
               for (j = 0; j < Map->NY; j++) {
                 if (INBASIN(TopoMap[j][i].Mask)) {
@@ -772,7 +740,6 @@ void draw(DATE *Day, int first, int DayStep, MAPSIZE *Map, int NGraphics,
 
           if (MapNumber == 43) {
             text = "Incoming Direct Beam Shortwave (W/sqm)";
-            length = 24;
             for (i = 0; i < Map->NX; i++) {
               for (j = 0; j < Map->NY; j++) {
                 if (INBASIN(TopoMap[j][i].Mask)) {
@@ -789,7 +756,6 @@ void draw(DATE *Day, int first, int DayStep, MAPSIZE *Map, int NGraphics,
 
           if (MapNumber == 44) {
             text = "Incoming Diffuse Shortwave (W/sqm)";
-            length = 25;
             for (i = 0; i < Map->NX; i++) {
               for (j = 0; j < Map->NY; j++) {
                 if (INBASIN(TopoMap[j][i].Mask)) {
@@ -806,7 +772,6 @@ void draw(DATE *Day, int first, int DayStep, MAPSIZE *Map, int NGraphics,
 
           if (MapNumber == 45) {
             text = "Aspect (degrees)";
-            length = 16;
             for (i = 0; i < Map->NX; i++) {
               for (j = 0; j < Map->NY; j++) {
 
@@ -824,7 +789,6 @@ void draw(DATE *Day, int first, int DayStep, MAPSIZE *Map, int NGraphics,
 
           if (MapNumber == 46) {
             text = "Slope (percent)";
-            length = 15;
             for (i = 0; i < Map->NX; i++) {
               for (j = 0; j < Map->NY; j++) {
 
@@ -842,7 +806,6 @@ void draw(DATE *Day, int first, int DayStep, MAPSIZE *Map, int NGraphics,
 
           if (MapNumber == 50) {
             text = "Channel Sub Surf Int (mm)";
-            length = 25;
             for (i = 0; i < Map->NX; i++) {
               for (j = 0; j < Map->NY; j++) {
                 if (INBASIN(TopoMap[j][i].Mask)) {
@@ -861,7 +824,6 @@ void draw(DATE *Day, int first, int DayStep, MAPSIZE *Map, int NGraphics,
 
           if (MapNumber == 51) {
             text = "Road Sub Surf Inter (mm)";
-            length = 24;
             for (i = 0; i < Map->NX; i++) {
               for (j = 0; j < Map->NY; j++) {
                 if (INBASIN(TopoMap[j][i].Mask)) {
@@ -878,147 +840,80 @@ void draw(DATE *Day, int first, int DayStep, MAPSIZE *Map, int NGraphics,
             }
           }
 
-          if (fequal(max, min))
-            scale = 0.0;
-          else
-            scale = 50 / (max - min);
-
-          /* draw the raster image for the current data set */
-          /* all values set to -9999.0 will be drawn as white */
-          /* each image is left and bottom justified in its drawing area */
-          /* i.e. buf pixels are available on the top and right for text */
-          /* and the color bar */
-
-          if (expand > 0) {
-            for (i = 0; i < Map->NX; i++) {
-              for (j = 0; j < Map->NY; j++) {
-                if (!fequal(temp_array[j][i], -9999.0) && 
-                  INBASIN(TopoMap[j][i].Mask)) {
-                    index = (int) (scale * (temp_array[j][i] - min));
-                    if (index > 49)
-                      index = 49;
-                    XSetForeground(display, gc, my_color[index].pixel);
-                }
-                else {
-                  XSetForeground(display, gc, white);
-                }
-                for (ie = PX + i * expand; ie < PX + i * expand + expand; ie++){
-                  for (je = PY + j * expand; je < PY + j * expand + expand;
-                    je++) { 
-                      XDrawPoint(display, window, gc, ie, je + buf);
-                  }
-                }
-              }
-            }
-          }
-          else {		/* expand < 0 need to average image */
-            for (i = 0; i < Map->NX / (-expand); i++) {
-              for (j = 0; j < Map->NY / (-expand); j++) {
-                jr = j * (-expand);
-                ir = i * (-expand);
-                temp = 0.0;
-                skip_it = 0;
-                /* for map numbers less than 26 just get the average or a sample */
-
-                if (MapNumber < 50 && sample == 0) {
-                  for (ie = 0; ie < (-expand); ie++) {
-                    for (je = 0; je < (-expand); je++) {
-                      if (temp_array[je + jr][ie + ir] != -9999.0
-                        && (INBASIN(TopoMap[je + jr][ie + ir].Mask)))
-                        temp = temp + temp_array[je + jr][ie + ir];
-                      else
-                        skip_it = 1;
-                    }
-                  }
-                  temp = temp / ((float) (expand * expand));
-                }
-
-                if (MapNumber < 50 && sample == 1) {
-
-                  if (temp_array[jr][ir] != -9999.0
-                    && (INBASIN(TopoMap[jr][ir].Mask)))
-                    temp = temp_array[jr][ir];
-                  else
-                    skip_it = 1;
-
-                }
-
-                /* for map numbers of 50 or larger, which are the channel and runoff */
-                /* subsurface interception, get the max for each aggregated pixel */
-                if (MapNumber > 49) {
-                  max_temp = -10000.0;
-                  for (ie = 0; ie < (-expand); ie++) {
-                    for (je = 0; je < (-expand); je++) {
-                      if (INBASIN(TopoMap[je + jr][ie + ir].Mask)) {
-                        if (temp_array[je + jr][ie + ir] > max_temp)
-                          max_temp = temp_array[je + jr][ie + ir];
-                      }
-                      else {
-                        skip_it = 1;
-                      }
-                    }
-                  }
-                  temp = max_temp;
-                  if (temp == -9999.0)
-                    skip_it = 1;
-                }
-
-                index = (int) (scale * (temp - min));
-                if (index > 49)
-                  index = 49;
-
-                if (skip_it == 0) {
-                  XSetForeground(display, gc, my_color[index].pixel);
-                }
-                else {
-                  XSetForeground(display, gc, white);
-                }
-
-                XDrawPoint(display, window, gc, i + PX, j + PY + buf);
-
-              }
-            }
-          }
-
-          if (expand > 0)
-            re = (float) expand;
-          else
-            re = 1.0 / ((float) -expand);
-
-          if (draw_static_colorbar == 1) {
-            /* write the title */
-            XSetForeground(display, gc, black);
-            XSetBackground(display, gc, white);
-            XDrawString(display, window, gc, PX, PY + 40, text, length);
-
-            /* draw the color bar */
-            for (j = 0; j < Map->NY * re; j++) {
-              XSetForeground(display, gc,
-                my_color[(int) (50 * j / (Map->NY * re))].pixel);
-              /*    if((int)((float)(j*50/(Map->NY*re))/scale+min)==0) XSetForeground(display,gc,white); */
-              XDrawLine(display, window, gc, (int) (PX + Map->NX * re + 10),
-                (int) (PY + Map->NY * re - j + buf),
-                (int) (PX + Map->NX * re + 20),
-                (int) (PY + Map->NY * re - j + buf));
-            }
-          }
-          /* label the color bar */
-          sprintf(text2, "%6f", max);
-          XSetForeground(display, gc, black);
-          XClearArea(display, window, (int) (PX + Map->NX * re),
-            (int) (PY - 20 + buf), 50, 20, False);
-          XDrawString(display, window, gc, (int) (PX + Map->NX * re),
-            (int) (PY - 10 + buf), text2, 6);
-          sprintf(text2, "%6.1f", min);
-          XClearArea(display, window, (int) (PX + Map->NX * re),
-            (int) (PY + Map->NY * re + buf), 50, 30, False);
-          XDrawString(display, window, gc, (int) (PX + Map->NX * re),
-            (int) (PY + Map->NY * re + 20 + buf), text2, 6);
-
+          DrawGraphicsPanel(Graphics, k, MapNumber, Map, TopoMap, text, min,
+                            max);
         }
       }
+
+      if (Graphics->Mode == GRAPHICS_PPM)
+        WriteGraphicsFrame(Graphics, NGraphics, Path, text3);
+#ifdef HAVE_X11
+      else
+        PutFrame(Graphics, NGraphics);
+#endif
     }
   }
+}
+
+#ifdef HAVE_X11
+/*****************************************************************************
+  PutFrame()
+
+  Copies the colour index frame into the X11 window with one XPutImage()
+  and labels the maps.  The first 20 rows, with the date, are not copied.
+*****************************************************************************/
+static void PutFrame(GRAPHICSDUMP *Graphics, int NGraphics)
+{
+  static XImage *image = NULL;
+  static unsigned long pixel[NGRAPHICSCOLORS + 2];
+  unsigned char *index;
+  char text2[32];
+  int screen;
+  int x, y, k;
+  int PX, PY;
+  int buf = GRAPHICS_BORDER;
+
+  if (image == NULL) {
+    screen = DefaultScreen(display);
+    image = XCreateImage(display, DefaultVisual(display, screen),
+                         DefaultDepth(display, screen), ZPixmap, 0, NULL,
+                         Graphics->Width, Graphics->Height, 32, 0);
+    if (image == NULL)
+      ReportError("PutFrame", 1);
+    if ((image->data = (char *) malloc(image->bytes_per_line *
+                                       Graphics->Height)) == NULL)
+      ReportError("PutFrame", 1);
+    for (k = 0; k < NGRAPHICSCOLORS; k++)
+      pixel[k] = my_color[k].pixel;
+    pixel[GRAPHICS_WHITE] = white;
+    pixel[GRAPHICS_BLACK] = black;
+  }
 
-#endif
+  for (y = 20, index = Graphics->Image + 20 * Graphics->Width;
+       y < Graphics->Height; y++)
+    for (x = 0; x < Graphics->Width; x++, index++)
+      XPutPixel(image, x, y, pixel[*index]);
+  XPutImage(display, window, gc, image, 0, 20, 0, 20, Graphics->Width,
+            Graphics->Height - 20);
+
+  XSetForeground(display, gc, black);
+  XSetBackground(display, gc, white);
+  for (k = 0; k < NGraphics; k++) {
+    if (Graphics->Title[k] == NULL)
+      continue;
+    PX = (k % Graphics->NPanelX) * (Graphics->PanelNX + buf) + 10;
+    PY = (k / Graphics->NPanelX) * (Graphics->PanelNY + buf) + 20;
+    /* write the title */
+    XDrawString(display, window, gc, PX, PY + 40, Graphics->Title[k],
+                strlen(Graphics->Title[k]));
+    /* label the color bar */
+    snprintf(text2, sizeof(text2), "%6f", Graphics->Max[k]);
+    XDrawString(display, window, gc, PX + Graphics->PanelNX, PY - 10 + buf,
+                text2, 6);
+    snprintf(text2, sizeof(text2), "%6.1f", Graphics->Min[k]);
+    XDrawString(display, window, gc, PX + Graphics->PanelNX,
+                PY + Graphics->PanelNY + 20 + buf, text2, 6);
+  }
+  XFlush(display);
 }
+#endif
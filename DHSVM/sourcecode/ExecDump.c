@@ -10,6 +10,11 @@
 * DESCRIP-END.
 * FUNCTIONS:    ExecDump()
 *               DumpMap()
+*               DumpMapArray()
+*               ArrayToFloat()
+*               WriteMapStatistic()
+*               AccumulateStatistic()
+*               ReduceStatistic()
 *               DumpPix()
 * COMMENTS:
 * $Id: ExecDump.c, v 4.0  2018/1/25   Ning Exp $
@@ -27,6 +32,12 @@
 #include "constants.h"
 #include "varid.h"
 
+static int DumpMapArray(char *FileName, void *Array, int NumberType,
+  MAPSIZE *Map, MAPDUMP *DMap, int Index);
+static void ArrayToFloat(void *Array, int NumberType, int NPoints,
+  float *Value);
+static void WriteMapStatistic(MAPSIZE *Map, MAPDUMP *DMap);
+
 /*****************************************************************************
 ExecDump()
 *****************************************************************************/
@@ -82,10 +93,14 @@ void ExecDump(MAPSIZE *Map, DATE *Current, DATE *Start, OPTIONSTRUCT *Options,
       y = Dump->Pix[i].Loc.N;
       x = Dump->Pix[i].Loc.E;
 
-
-
-
-
+      /* all pixels go into one buffered record of the shared file */
+      if (Dump->PixSeries != NULL) {
+        DumpPixSeries(Current, IsEqualTime(Current, Start), Dump->PixSeries, i,
+          &(EvapMap[y][x]), &(PrecipMap[y][x]), &(RadMap[y][x]), &(SnowMap[y][x]),
+          &(SoilMap[y][x]), &(VegMap[y][x]), Soil->NLayers[(SoilMap[y][x].Soil - 1)],
+          Veg->NLayers[(VegMap[y][x].Veg - 1)]);
+        continue;
+      }
 
       /* output variable at the pixel */
       flag = 2;
@@ -95,9 +110,33 @@ void ExecDump(MAPSIZE *Map, DATE *Current, DATE *Start, OPTIONSTRUCT *Options,
         Veg->NLayers[(VegMap[y][x].Veg - 1)], Options, flag);
       fprintf(Dump->Pix[i].OutFile.FilePtr, "\n");
     }
+    if (Dump->PixSeries != NULL)
+      EndPixSeriesRecord(Current, Dump->PixSeries);
 
     /* check which maps need to be dumped at this timestep, and dump maps if needed */
     for (i = 0; i < Dump->NMaps; i++) {
+
+      /* aggregated maps are accumulated every time step of a period and
+         only the statistic is written at its end */
+      if (Dump->DMap[i].Statistic) {
+        if (Dump->DMap[i].Next < Dump->DMap[i].N &&
+          After(Current, &(Dump->DMap[i].PeriodStart))) {
+          Dump->DMap[i].Slot = 0;
+          DumpMap(Map, Current, &(Dump->DMap[i]), TopoMap, EvapMap,
+            PrecipMap, RadMap, SnowMap, SoilMap, Soil, VegMap,
+            Veg, Network, Options);
+          Dump->DMap[i].NSteps++;
+          if (IsEqualTime(Current,
+            &(Dump->DMap[i].DumpDate[Dump->DMap[i].Next]))) {
+            fprintf(stdout, "Dumping Maps at ");
+            PrintDate(Current, stdout);
+            fprintf(stdout, "\n");
+            WriteMapStatistic(Map, &(Dump->DMap[i]));
+          }
+        }
+        continue;
+      }
+
       for (j = 0; j < Dump->DMap[i].N; j++) {
         if (IsEqualTime(Current, &(Dump->DMap[i].DumpDate[j]))) {
           fprintf(stdout, "Dumping Maps at ");
@@ -191,7 +230,7 @@ void DumpMap(MAPSIZE *Map, DATE *Current, MAPDUMP *DMap, TOPOPIX **TopoMap,
       for (y = 0; y < Map->NY; y++)
         for (x = 0; x < Map->NX; x++)
           ((float *)Array)[y * Map->NX + x] = EvapMap[y][x].ETot;
-      Write2DMatrix(DMap->FileName, Array, DMap->NumberType, Map,
+      DumpMapArray(DMap->FileName, Array, DMap->NumberType, Map,
         DMap, Index);
     }
     else if (DMap->Resolution == IMAGE_OUTPUT) {
@@ -199,7 +238,7 @@ void DumpMap(MAPSIZE *Map, DATE *Current, MAPDUMP *DMap, TOPOPIX **TopoMap,
         for (x = 0; x < Map->NX; x++)
           ((unsigned char *)Array)[y * Map->NX + x] =
           (unsigned char)((EvapMap[y][x].ETot - Offset) / Range * MAXUCHAR);
-      Write2DMatrix(DMap->FileName, Array, NC_BYTE, Map, DMap,
+      DumpMapArray(DMap->FileName, Array, NC_BYTE, Map, DMap,
         Index);
     }
     else
@@ -227,7 +266,7 @@ void DumpMap(MAPSIZE *Map, DATE *Current, MAPDUMP *DMap, TOPOPIX **TopoMap,
             ((float *)Array)[y * Map->NX + x] = NA;
         }
       }
-      Write2DMatrix(DMap->FileName, Array, DMap->NumberType, Map,
+      DumpMapArray(DMap->FileName, Array, DMap->NumberType, Map,
         DMap, Index);
     }
     else if (DMap->Resolution == IMAGE_OUTPUT) {
@@ -250,7 +289,7 @@ void DumpMap(MAPSIZE *Map, DATE *Current, MAPDUMP *DMap, TOPOPIX **TopoMap,
             ((float *)Array)[y * Map->NX + x] = 0;
         }
       }
-      Write2DMatrix(DMap->FileName, Array, NC_BYTE, Map, DMap, Index);
+      DumpMapArray(DMap->FileName, Array, NC_BYTE, Map, DMap, Index);
     }
     else
       ReportError(VarIDStr, 66);
@@ -274,7 +313,7 @@ void DumpMap(MAPSIZE *Map, DATE *Current, MAPDUMP *DMap, TOPOPIX **TopoMap,
             ((float *)Array)[y * Map->NX + x] = NA;
         }
       }
-      Write2DMatrix(DMap->FileName, Array, DMap->NumberType, Map, DMap, Index);
+      DumpMapArray(DMap->FileName, Array, DMap->NumberType, Map, DMap, Index);
     }
     else if (DMap->Resolution == IMAGE_OUTPUT) {
       for (y = 0; y < Map->NY; y++) {
@@ -296,7 +335,7 @@ void DumpMap(MAPSIZE *Map, DATE *Current, MAPDUMP *DMap, TOPOPIX **TopoMap,
             ((unsigned char *)Array)[y * Map->NX + x] = 0;
         }
       }
-      Write2DMatrix(DMap->FileName, Array, NC_BYTE, Map, DMap, Index);
+      DumpMapArray(DMap->FileName, Array, NC_BYTE, Map, DMap, Index);
     }
     else
       ReportError(VarIDStr, 66);
@@ -320,7 +359,7 @@ void DumpMap(MAPSIZE *Map, DATE *Current, MAPDUMP *DMap, TOPOPIX **TopoMap,
               ((float *)Array)[y * Map->NX + x] = NA;
           }
         }
-        Write2DMatrix(DMap->FileName, Array, DMap->NumberType, Map, DMap, Index);
+        DumpMapArray(DMap->FileName, Array, DMap->NumberType, Map, DMap, Index);
       }
     }
     else if (DMap->Resolution == IMAGE_OUTPUT) {
@@ -340,7 +379,7 @@ void DumpMap(MAPSIZE *Map, DATE *Current, MAPDUMP *DMap, TOPOPIX **TopoMap,
               ((unsigned char *)Array)[y * Map->NX + x] = 0;
           }
         }
-        Write2DMatrix(DMap->FileName, Array, NC_BYTE, Map, DMap, Index);
+        DumpMapArray(DMap->FileName, Array, NC_BYTE, Map, DMap, Index);
       }
     }
     else
@@ -365,7 +404,7 @@ void DumpMap(MAPSIZE *Map, DATE *Current, MAPDUMP *DMap, TOPOPIX **TopoMap,
             ((float *)Array)[y * Map->NX + x] = NA;
         }
       }
-      Write2DMatrix(DMap->FileName, Array, DMap->NumberType, Map, DMap, Index);
+      DumpMapArray(DMap->FileName, Array, DMap->NumberType, Map, DMap, Index);
 
     }
     else if (DMap->Resolution == IMAGE_OUTPUT) {
@@ -388,7 +427,7 @@ void DumpMap(MAPSIZE *Map, DATE *Current, MAPDUMP *DMap, TOPOPIX **TopoMap,
             ((unsigned char *)Array)[y * Map->NX + x] = 0;
         }
       }
-      Write2DMatrix(DMap->FileName, Array, NC_BYTE, Map, DMap, Index);
+      DumpMapArray(DMap->FileName, Array, NC_BYTE, Map, DMap, Index);
 
     }
     else
@@ -402,7 +441,7 @@ void DumpMap(MAPSIZE *Map, DATE *Current, MAPDUMP *DMap, TOPOPIX **TopoMap,
           ((float *)Array)[y * Map->NX + x] = PrecipMap[y][x].Precip;
         }
       }
-      Write2DMatrix(DMap->FileName, Array, DMap->NumberType, Map, DMap, Index);
+      DumpMapArray(DMap->FileName, Array, DMap->NumberType, Map, DMap, Index);
 
     }
     else if (DMap->Resolution == IMAGE_OUTPUT) {
@@ -411,7 +450,7 @@ void DumpMap(MAPSIZE *Map, DATE *Current, MAPDUMP *DMap, TOPOPIX **TopoMap,
           ((unsigned char *)Array)[y * Map->NX + x] =
           (unsigned char)((PrecipMap[y][x].Precip - Offset) /
             Range * MAXUCHAR);
-      Write2DMatrix(DMap->FileName, Array, NC_BYTE, Map, DMap, Index);
+      DumpMapArray(DMap->FileName, Array, NC_BYTE, Map, DMap, Index);
     }
     else
       ReportError(VarIDStr, 66);
@@ -432,7 +471,7 @@ void DumpMap(MAPSIZE *Map, DATE *Current, MAPDUMP *DMap, TOPOPIX **TopoMap,
             ((float *)Array)[y * Map->NX + x] = NA;
         }
       }
-      Write2DMatrix(DMap->FileName, Array, DMap->NumberType, Map, DMap, Index);
+      DumpMapArray(DMap->FileName, Array, DMap->NumberType, Map, DMap, Index);
 
     }
     else if (DMap->Resolution == IMAGE_OUTPUT) {
@@ -451,7 +490,7 @@ void DumpMap(MAPSIZE *Map, DATE *Current, MAPDUMP *DMap, TOPOPIX **TopoMap,
             ((unsigned char *)Array)[y * Map->NX + x] = 0;
         }
       }
-      Write2DMatrix(DMap->FileName, Array, NC_BYTE, Map, DMap, Index);
+      DumpMapArray(DMap->FileName, Array, NC_BYTE, Map, DMap, Index);
     }
     else
       ReportError(VarIDStr, 66);
@@ -473,7 +512,7 @@ void DumpMap(MAPSIZE *Map, DATE *Current, MAPDUMP *DMap, TOPOPIX **TopoMap,
             ((float *)Array)[y * Map->NX + x] = NA;
         }
       }
-      Write2DMatrix(DMap->FileName, Array, DMap->NumberType, Map, DMap, Index);
+      DumpMapArray(DMap->FileName, Array, DMap->NumberType, Map, DMap, Index);
 
     }
     else if (DMap->Resolution == IMAGE_OUTPUT) {
@@ -492,7 +531,7 @@ void DumpMap(MAPSIZE *Map, DATE *Current, MAPDUMP *DMap, TOPOPIX **TopoMap,
             ((unsigned char *)Array)[y * Map->NX + x] = 0;
         }
       }
-      Write2DMatrix(DMap->FileName, Array, NC_BYTE, Map, DMap, Index);
+      DumpMapArray(DMap->FileName, Array, NC_BYTE, Map, DMap, Index);
 
     }
     else
@@ -506,7 +545,7 @@ void DumpMap(MAPSIZE *Map, DATE *Current, MAPDUMP *DMap, TOPOPIX **TopoMap,
           ((float *)Array)[y * Map->NX + x] = PrecipMap[y][x].SumPrecip;
         }
       }
-      Write2DMatrix(DMap->FileName, Array, DMap->NumberType, Map, DMap, Index);
+      DumpMapArray(DMap->FileName, Array, DMap->NumberType, Map, DMap, Index);
 
     }
     else if (DMap->Resolution == IMAGE_OUTPUT) {
@@ -515,7 +554,7 @@ void DumpMap(MAPSIZE *Map, DATE *Current, MAPDUMP *DMap, TOPOPIX **TopoMap,
           ((unsigned char *)Array)[y * Map->NX + x] =
           (unsigned char)((PrecipMap[y][x].Precip - Offset) /
             Range * MAXUCHAR);
-      Write2DMatrix(DMap->FileName, Array, NC_BYTE, Map, DMap, Index);
+      DumpMapArray(DMap->FileName, Array, NC_BYTE, Map, DMap, Index);
     }
     else
       ReportError(VarIDStr, 66);
@@ -529,14 +568,14 @@ void DumpMap(MAPSIZE *Map, DATE *Current, MAPDUMP *DMap, TOPOPIX **TopoMap,
           ((float *)Array)[y * Map->NX + x] = RadMap[y][x].ObsShortIn;
         }
       }
-      Write2DMatrix(DMap->FileName, Array, DMap->NumberType, Map, DMap, Index);
+      DumpMapArray(DMap->FileName, Array, DMap->NumberType, Map, DMap, Index);
     }
     else if (DMap->Resolution == IMAGE_OUTPUT) {
       for (y = 0; y < Map->NY; y++)
         for (x = 0; x < Map->NX; x++)
           ((unsigned char *)Array)[y * Map->NX + x] =
           (unsigned char)((RadMap[y][x].ObsShortIn - Offset) / Range * MAXUCHAR);
-      Write2DMatrix(DMap->FileName, Array, NC_BYTE, Map, DMap, Index);
+      DumpMapArray(DMap->FileName, Array, NC_BYTE, Map, DMap, Index);
     }
     else
       ReportError(VarIDStr, 66);
@@ -548,7 +587,7 @@ void DumpMap(MAPSIZE *Map, DATE *Current, MAPDUMP *DMap, TOPOPIX **TopoMap,
       for (y = 0; y < Map->NY; y++)
         for (x = 0; x < Map->NX; x++)
           ((float *)Array)[y * Map->NX + x] = RadMap[y][x].PixelNetShort;
-      Write2DMatrix(DMap->FileName, Array, DMap->NumberType, Map, DMap, Index);
+      DumpMapArray(DMap->FileName, Array, DMap->NumberType, Map, DMap, Index);
 
     }
     else if (DMap->Resolution == IMAGE_OUTPUT) {
@@ -557,7 +596,7 @@ void DumpMap(MAPSIZE *Map, DATE *Current, MAPDUMP *DMap, TOPOPIX **TopoMap,
           ((unsigned char *)Array)[y * Map->NX + x] =
           (unsigned char)((RadMap[y][x].PixelNetShort - Offset) /
             Range * MAXUCHAR);
-      Write2DMatrix(DMap->FileName, Array, NC_BYTE, Map, DMap, Index);
+      DumpMapArray(DMap->FileName, Array, NC_BYTE, Map, DMap, Index);
 
     }
     else
@@ -571,7 +610,7 @@ void DumpMap(MAPSIZE *Map, DATE *Current, MAPDUMP *DMap, TOPOPIX **TopoMap,
       for (y = 0; y < Map->NY; y++)
         for (x = 0; x < Map->NX; x++)
           ((float *)Array)[y * Map->NX + x] = RadMap[y][x].NetRadiation[0] + RadMap[y][x].NetRadiation[1];
-      Write2DMatrix(DMap->FileName, Array, DMap->NumberType, Map, DMap, Index);
+      DumpMapArray(DMap->FileName, Array, DMap->NumberType, Map, DMap, Index);
 
     }
     else if (DMap->Resolution == IMAGE_OUTPUT) {
@@ -579,7 +618,7 @@ void DumpMap(MAPSIZE *Map, DATE *Current, MAPDUMP *DMap, TOPOPIX **TopoMap,
         for (x = 0; x < Map->NX; x++)
           ((unsigned char *)Array)[y * Map->NX + x] =
           (unsigned char)((RadMap[y][x].NetRadiation[0] + RadMap[y][x].NetRadiation[1] - Offset) / Range * MAXUCHAR);
-      Write2DMatrix(DMap->FileName, Array, NC_BYTE, Map, DMap, Index);
+      DumpMapArray(DMap->FileName, Array, NC_BYTE, Map, DMap, Index);
 
     }
     else
@@ -591,14 +630,14 @@ void DumpMap(MAPSIZE *Map, DATE *Current, MAPDUMP *DMap, TOPOPIX **TopoMap,
       for (y = 0; y < Map->NY; y++)
         for (x = 0; x < Map->NX; x++)
           ((unsigned char *)Array)[y * Map->NX + x] = SnowMap[y][x].HasSnow;
-      Write2DMatrix(DMap->FileName, Array, DMap->NumberType, Map, DMap, Index);
+      DumpMapArray(DMap->FileName, Array, DMap->NumberType, Map, DMap, Index);
 
     }
     else if (DMap->Resolution == IMAGE_OUTPUT) {
       for (y = 0; y < Map->NY; y++)
         for (x = 0; x < Map->NX; x++)
           ((unsigned char *)Array)[y * Map->NX + x] = SnowMap[y][x].HasSnow;
-      Write2DMatrix(DMap->FileName, Array, NC_BYTE, Map, DMap, Index);
+      DumpMapArray(DMap->FileName, Array, NC_BYTE, Map, DMap, Index);
 
     }
     else
@@ -611,7 +650,7 @@ void DumpMap(MAPSIZE *Map, DATE *Current, MAPDUMP *DMap, TOPOPIX **TopoMap,
         for (x = 0; x < Map->NX; x++)
           ((unsigned char *)Array)[y * Map->NX + x] =
           SnowMap[y][x].SnowCoverOver;
-      Write2DMatrix(DMap->FileName, Array, DMap->NumberType, Map, DMap, Index);
+      DumpMapArray(DMap->FileName, Array, DMap->NumberType, Map, DMap, Index);
 
     }
     else if (DMap->Resolution == IMAGE_OUTPUT) {
@@ -619,7 +658,7 @@ void DumpMap(MAPSIZE *Map, DATE *Current, MAPDUMP *DMap, TOPOPIX **TopoMap,
         for (x = 0; x < Map->NX; x++)
           ((unsigned char *)Array)[y * Map->NX + x] =
           SnowMap[y][x].SnowCoverOver;
-      Write2DMatrix(DMap->FileName, Array, NC_BYTE, Map, DMap, Index);
+      DumpMapArray(DMap->FileName, Array, NC_BYTE, Map, DMap, Index);
 
     }
     else
@@ -631,7 +670,7 @@ void DumpMap(MAPSIZE *Map, DATE *Current, MAPDUMP *DMap, TOPOPIX **TopoMap,
       for (y = 0; y < Map->NY; y++)
         for (x = 0; x < Map->NX; x++)
           ((unsigned short *)Array)[y * Map->NX + x] = SnowMap[y][x].LastSnow;
-      Write2DMatrix(DMap->FileName, Array, DMap->NumberType, Map, DMap, Index);
+      DumpMapArray(DMap->FileName, Array, DMap->NumberType, Map, DMap, Index);
 
     }
     else if (DMap->Resolution == IMAGE_OUTPUT) {
@@ -640,7 +679,7 @@ void DumpMap(MAPSIZE *Map, DATE *Current, MAPDUMP *DMap, TOPOPIX **TopoMap,
           ((unsigned char *)Array)[y * Map->NX + x] =
           (unsigned char)(((float)SnowMap[y][x].LastSnow - Offset) / Range
             * MAXUCHAR);
-      Write2DMatrix(DMap->FileName, Array, NC_BYTE, Map, DMap, Index);
+      DumpMapArray(DMap->FileName, Array, NC_BYTE, Map, DMap, Index);
 
     }
     else
@@ -652,7 +691,7 @@ void DumpMap(MAPSIZE *Map, DATE *Current, MAPDUMP *DMap, TOPOPIX **TopoMap,
       for (y = 0; y < Map->NY; y++)
         for (x = 0; x < Map->NX; x++)
           ((float *)Array)[y * Map->NX + x] = SnowMap[y][x].Swq;
-      Write2DMatrix(DMap->FileName, Array, DMap->NumberType, Map, DMap, Index);
+      DumpMapArray(DMap->FileName, Array, DMap->NumberType, Map, DMap, Index);
 
     }
     else if (DMap->Resolution == IMAGE_OUTPUT) {
@@ -660,7 +699,7 @@ void DumpMap(MAPSIZE *Map, DATE *Current, MAPDUMP *DMap, TOPOPIX **TopoMap,
         for (x = 0; x < Map->NX; x++)
           ((unsigned char *)Array)[y * Map->NX + x] =
           (unsigned char)((SnowMap[y][x].Swq - Offset) / Range * MAXUCHAR);
-      Write2DMatrix(DMap->FileName, Array, NC_BYTE, Map, DMap, Index);
+      DumpMapArray(DMap->FileName, Array, NC_BYTE, Map, DMap, Index);
 
     }
     else
@@ -672,7 +711,7 @@ void DumpMap(MAPSIZE *Map, DATE *Current, MAPDUMP *DMap, TOPOPIX **TopoMap,
       for (y = 0; y < Map->NY; y++)
         for (x = 0; x < Map->NX; x++)
           ((float *)Array)[y * Map->NX + x] = SnowMap[y][x].Melt;
-      Write2DMatrix(DMap->FileName, Array, DMap->NumberType, Map, DMap, Index);
+      DumpMapArray(DMap->FileName, Array, DMap->NumberType, Map, DMap, Index);
 
     }
     else if (DMap->Resolution == IMAGE_OUTPUT) {
@@ -680,7 +719,7 @@ void DumpMap(MAPSIZE *Map, DATE *Current, MAPDUMP *DMap, TOPOPIX **TopoMap,
         for (x = 0; x < Map->NX; x++)
           ((unsigned char *)Array)[y * Map->NX + x] =
           (unsigned char)((SnowMap[y][x].Melt - Offset) / Range * MAXUCHAR);
-      Write2DMatrix(DMap->FileName, Array, NC_BYTE, Map, DMap, Index);
+      DumpMapArray(DMap->FileName, Array, NC_BYTE, Map, DMap, Index);
 
     }
     else
@@ -692,7 +731,7 @@ void DumpMap(MAPSIZE *Map, DATE *Current, MAPDUMP *DMap, TOPOPIX **TopoMap,
       for (y = 0; y < Map->NY; y++)
         for (x = 0; x < Map->NX; x++)
           ((float *)Array)[y * Map->NX + x] = SnowMap[y][x].PackWater;
-      Write2DMatrix(DMap->FileName, Array, DMap->NumberType, Map, DMap, Index);
+      DumpMapArray(DMap->FileName, Array, DMap->NumberType, Map, DMap, Index);
 
     }
     else if (DMap->Resolution == IMAGE_OUTPUT) {
@@ -701,7 +740,7 @@ void DumpMap(MAPSIZE *Map, DATE *Current, MAPDUMP *DMap, TOPOPIX **TopoMap,
           ((unsigned char *)Array)[y * Map->NX + x] =
           (unsigned char)((SnowMap[y][x].PackWater - Offset) /
             Range * MAXUCHAR);
-      Write2DMatrix(DMap->FileName, Array, NC_BYTE, Map, DMap, Index);
+      DumpMapArray(DMap->FileName, Array, NC_BYTE, Map, DMap, Index);
 
     }
     else
@@ -713,7 +752,7 @@ void DumpMap(MAPSIZE *Map, DATE *Current, MAPDUMP *DMap, TOPOPIX **TopoMap,
       for (y = 0; y < Map->NY; y++)
         for (x = 0; x < Map->NX; x++)
           ((float *)Array)[y * Map->NX + x] = SnowMap[y][x].TPack;
-      Write2DMatrix(DMap->FileName, Array, DMap->NumberType, Map, DMap, Index);
+      DumpMapArray(DMap->FileName, Array, DMap->NumberType, Map, DMap, Index);
 
     }
     else if (DMap->Resolution == IMAGE_OUTPUT) {
@@ -721,7 +760,7 @@ void DumpMap(MAPSIZE *Map, DATE *Current, MAPDUMP *DMap, TOPOPIX **TopoMap,
         for (x = 0; x < Map->NX; x++)
           ((unsigned char *)Array)[y * Map->NX + x] =
           (unsigned char)((SnowMap[y][x].TPack - Offset) / Range * MAXUCHAR);
-      Write2DMatrix(DMap->FileName, Array, NC_BYTE, Map, DMap,
+      DumpMapArray(DMap->FileName, Array, NC_BYTE, Map, DMap,
         Index);
     }
     else
@@ -733,7 +772,7 @@ void DumpMap(MAPSIZE *Map, DATE *Current, MAPDUMP *DMap, TOPOPIX **TopoMap,
       for (y = 0; y < Map->NY; y++)
         for (x = 0; x < Map->NX; x++)
           ((float *)Array)[y * Map->NX + x] = SnowMap[y][x].SurfWater;
-      Write2DMatrix(DMap->FileName, Array, DMap->NumberType, Map, DMap, Index);
+      DumpMapArray(DMap->FileName, Array, DMap->NumberType, Map, DMap, Index);
 
     }
     else if (DMap->Resolution == IMAGE_OUTPUT) {
@@ -742,7 +781,7 @@ void DumpMap(MAPSIZE *Map, DATE *Current, MAPDUMP *DMap, TOPOPIX **TopoMap,
           ((unsigned char *)Array)[y * Map->NX + x] =
           (unsigned char)((SnowMap[y][x].SurfWater - Offset) /
             Range * MAXUCHAR);
-      Write2DMatrix(DMap->FileName, Array, NC_BYTE, Map, DMap, Index);
+      DumpMapArray(DMap->FileName, Array, NC_BYTE, Map, DMap, Index);
 
     }
     else
@@ -754,7 +793,7 @@ void DumpMap(MAPSIZE *Map, DATE *Current, MAPDUMP *DMap, TOPOPIX **TopoMap,
       for (y = 0; y < Map->NY; y++)
         for (x = 0; x < Map->NX; x++)
           ((float *)Array)[y * Map->NX + x] = SnowMap[y][x].TSurf;
-      Write2DMatrix(DMap->FileName, Array, DMap->NumberType, Map, DMap, Index);
+      DumpMapArray(DMap->FileName, Array, DMap->NumberType, Map, DMap, Index);
 
     }
     else if (DMap->Resolution == IMAGE_OUTPUT) {
@@ -762,7 +801,7 @@ void DumpMap(MAPSIZE *Map, DATE *Current, MAPDUMP *DMap, TOPOPIX **TopoMap,
         for (x = 0; x < Map->NX; x++)
           ((unsigned char *)Array)[y * Map->NX + x] =
           (unsigned char)((SnowMap[y][x].TSurf - Offset) / Range * MAXUCHAR);
-      Write2DMatrix(DMap->FileName, Array, NC_BYTE, Map, DMap, Index);
+      DumpMapArray(DMap->FileName, Array, NC_BYTE, Map, DMap, Index);
 
     }
     else
@@ -774,7 +813,7 @@ void DumpMap(MAPSIZE *Map, DATE *Current, MAPDUMP *DMap, TOPOPIX **TopoMap,
       for (y = 0; y < Map->NY; y++)
         for (x = 0; x < Map->NX; x++)
           ((float *)Array)[y * Map->NX + x] = SnowMap[y][x].ColdContent;
-      Write2DMatrix(DMap->FileName, Array, DMap->NumberType, Map, DMap, Index);
+      DumpMapArray(DMap->FileName, Array, DMap->NumberType, Map, DMap, Index);
 
     }
     else if (DMap->Resolution == IMAGE_OUTPUT) {
@@ -783,7 +822,7 @@ void DumpMap(MAPSIZE *Map, DATE *Current, MAPDUMP *DMap, TOPOPIX **TopoMap,
           ((unsigned char *)Array)[y * Map->NX + x] =
           (unsigned char)((SnowMap[y][x].ColdContent - Offset) /
             Range * MAXUCHAR);
-      Write2DMatrix(DMap->FileName, Array, NC_BYTE, Map, DMap, Index);
+      DumpMapArray(DMap->FileName, Array, NC_BYTE, Map, DMap, Index);
 
     }
     else
@@ -795,7 +834,7 @@ void DumpMap(MAPSIZE *Map, DATE *Current, MAPDUMP *DMap, TOPOPIX **TopoMap,
       for (y = 0; y < Map->NY; y++)
         for (x = 0; x < Map->NX; x++)
           ((float *)Array)[y * Map->NX + x] = SnowMap[y][x].Albedo;
-      Write2DMatrix(DMap->FileName, Array, DMap->NumberType, Map,
+      DumpMapArray(DMap->FileName, Array, DMap->NumberType, Map,
         DMap, Index);
     }
     else if (DMap->Resolution == IMAGE_OUTPUT) {
@@ -804,7 +843,7 @@ void DumpMap(MAPSIZE *Map, DATE *Current, MAPDUMP *DMap, TOPOPIX **TopoMap,
           ((unsigned char *)Array)[y * Map->NX + x] =
           (unsigned char)((SnowMap[y][x].Albedo - Offset) /
             Range * MAXUCHAR);
-      Write2DMatrix(DMap->FileName, Array, NC_BYTE, Map, DMap, Index);
+      DumpMapArray(DMap->FileName, Array, NC_BYTE, Map, DMap, Index);
 
     }
     else
@@ -816,7 +855,7 @@ void DumpMap(MAPSIZE *Map, DATE *Current, MAPDUMP *DMap, TOPOPIX **TopoMap,
       for (y = 0; y < Map->NY; y++)
         for (x = 0; x < Map->NX; x++)
           ((float *)Array)[y * Map->NX + x] = SnowMap[y][x].MaxSwe;
-      Write2DMatrix(DMap->FileName, Array, DMap->NumberType, Map,
+      DumpMapArray(DMap->FileName, Array, DMap->NumberType, Map,
         DMap, Index);
     }
     else if (DMap->Resolution == IMAGE_OUTPUT) {
@@ -825,7 +864,7 @@ void DumpMap(MAPSIZE *Map, DATE *Current, MAPDUMP *DMap, TOPOPIX **TopoMap,
           ((unsigned char *)Array)[y * Map->NX + x] =
           (unsigned char)((SnowMap[y][x].MaxSwe - Offset) /
             Range * MAXUCHAR);
-      Write2DMatrix(DMap->FileName, Array, NC_BYTE, Map, DMap, Index);
+      DumpMapArray(DMap->FileName, Array, NC_BYTE, Map, DMap, Index);
 
     }
     else
@@ -837,7 +876,7 @@ void DumpMap(MAPSIZE *Map, DATE *Current, MAPDUMP *DMap, TOPOPIX **TopoMap,
       for (y = 0; y < Map->NY; y++)
         for (x = 0; x < Map->NX; x++)
           ((unsigned int *)Array)[y * Map->NX + x] = SnowMap[y][x].MaxSweDate;
-      Write2DMatrix(DMap->FileName, Array, DMap->NumberType, Map,
+      DumpMapArray(DMap->FileName, Array, DMap->NumberType, Map,
         DMap, Index);
     }
     else if (DMap->Resolution == IMAGE_OUTPUT) {
@@ -846,7 +885,7 @@ void DumpMap(MAPSIZE *Map, DATE *Current, MAPDUMP *DMap, TOPOPIX **TopoMap,
           ((unsigned char *)Array)[y * Map->NX + x] =
           (unsigned char)((SnowMap[y][x].MaxSweDate - Offset) /
             Range * MAXUCHAR);
-      Write2DMatrix(DMap->FileName, Array, NC_BYTE, Map, DMap, Index);
+      DumpMapArray(DMap->FileName, Array, NC_BYTE, Map, DMap, Index);
 
     }
     else
@@ -858,7 +897,7 @@ void DumpMap(MAPSIZE *Map, DATE *Current, MAPDUMP *DMap, TOPOPIX **TopoMap,
       for (y = 0; y < Map->NY; y++)
         for (x = 0; x < Map->NX; x++)
           ((unsigned int *)Array)[y * Map->NX + x] = SnowMap[y][x].MeltOutDate;
-      Write2DMatrix(DMap->FileName, Array, DMap->NumberType, Map,
+      DumpMapArray(DMap->FileName, Array, DMap->NumberType, Map,
         DMap, Index);
     }
     else if (DMap->Resolution == IMAGE_OUTPUT) {
@@ -867,7 +906,7 @@ void DumpMap(MAPSIZE *Map, DATE *Current, MAPDUMP *DMap, TOPOPIX **TopoMap,
           ((unsigned char *)Array)[y * Map->NX + x] =
           (unsigned char)((SnowMap[y][x].MeltOutDate - Offset) /
             Range * MAXUCHAR);
-      Write2DMatrix(DMap->FileName, Array, NC_BYTE, Map, DMap, Index);
+      DumpMapArray(DMap->FileName, Array, NC_BYTE, Map, DMap, Index);
 
     }
     else
@@ -890,7 +929,7 @@ void DumpMap(MAPSIZE *Map, DATE *Current, MAPDUMP *DMap, TOPOPIX **TopoMap,
             ((float *)Array)[y * Map->NX + x] = NA;
         }
       }
-      Write2DMatrix(DMap->FileName, Array, DMap->NumberType, Map, DMap, Index);
+      DumpMapArray(DMap->FileName, Array, DMap->NumberType, Map, DMap, Index);
 
     }
     else if (DMap->Resolution == IMAGE_OUTPUT) {
@@ -909,7 +948,7 @@ void DumpMap(MAPSIZE *Map, DATE *Current, MAPDUMP *DMap, TOPOPIX **TopoMap,
             ((unsigned char *)Array)[y * Map->NX + x] = 0;
         }
       }
-      Write2DMatrix(DMap->FileName, Array, NC_BYTE, Map, DMap, Index);
+      DumpMapArray(DMap->FileName, Array, NC_BYTE, Map, DMap, Index);
 
     }
     else
@@ -932,7 +971,7 @@ void DumpMap(MAPSIZE *Map, DATE *Current, MAPDUMP *DMap, TOPOPIX **TopoMap,
             ((float *)Array)[y * Map->NX + x] = NA;
         }
       }
-      Write2DMatrix(DMap->FileName, Array, DMap->NumberType, Map, DMap, Index);
+      DumpMapArray(DMap->FileName, Array, DMap->NumberType, Map, DMap, Index);
 
     }
     else if (DMap->Resolution == IMAGE_OUTPUT) {
@@ -951,7 +990,7 @@ void DumpMap(MAPSIZE *Map, DATE *Current, MAPDUMP *DMap, TOPOPIX **TopoMap,
             ((unsigned char *)Array)[y * Map->NX + x] = 0;
         }
       }
-      Write2DMatrix(DMap->FileName, Array, NC_BYTE, Map, DMap, Index);
+      DumpMapArray(DMap->FileName, Array, NC_BYTE, Map, DMap, Index);
 
     }
     else
@@ -963,7 +1002,7 @@ void DumpMap(MAPSIZE *Map, DATE *Current, MAPDUMP *DMap, TOPOPIX **TopoMap,
       for (y = 0; y < Map->NY; y++)
         for (x = 0; x < Map->NX; x++)
           ((float *)Array)[y * Map->NX + x] = SoilMap[y][x].TableDepth;
-      Write2DMatrix(DMap->FileName, Array, DMap->NumberType, Map, DMap, Index);
+      DumpMapArray(DMap->FileName, Array, DMap->NumberType, Map, DMap, Index);
 
     }
     else if (DMap->Resolution == IMAGE_OUTPUT) {
@@ -972,7 +1011,7 @@ void DumpMap(MAPSIZE *Map, DATE *Current, MAPDUMP *DMap, TOPOPIX **TopoMap,
           ((unsigned char *)Array)[y * Map->NX + x] =
           (unsigned char)((SoilMap[y][x].TableDepth - Offset) /
             Range * MAXUCHAR);
-      Write2DMatrix(DMap->FileName, Array, NC_BYTE, Map, DMap, Index);
+      DumpMapArray(DMap->FileName, Array, NC_BYTE, Map, DMap, Index);
 
     }
     else
@@ -984,7 +1023,7 @@ void DumpMap(MAPSIZE *Map, DATE *Current, MAPDUMP *DMap, TOPOPIX **TopoMap,
       for (y = 0; y < Map->NY; y++)
         for (x = 0; x < Map->NX; x++)
           ((float *)Array)[y * Map->NX + x] = SoilMap[y][x].SatFlow;
-      Write2DMatrix(DMap->FileName, Array, DMap->NumberType, Map, DMap, Index);
+      DumpMapArray(DMap->FileName, Array, DMap->NumberType, Map, DMap, Index);
 
     }
     else if (DMap->Resolution == IMAGE_OUTPUT) {
@@ -993,7 +1032,7 @@ void DumpMap(MAPSIZE *Map, DATE *Current, MAPDUMP *DMap, TOPOPIX **TopoMap,
           ((unsigned char *)Array)[y * Map->NX + x] =
           (unsigned char)((SoilMap[y][x].SatFlow - Offset) /
             Range * MAXUCHAR);
-      Write2DMatrix(DMap->FileName, Array, NC_BYTE, Map, DMap, Index);
+      DumpMapArray(DMap->FileName, Array, NC_BYTE, Map, DMap, Index);
 
     }
     else
@@ -1005,7 +1044,7 @@ void DumpMap(MAPSIZE *Map, DATE *Current, MAPDUMP *DMap, TOPOPIX **TopoMap,
       for (y = 0; y < Map->NY; y++)
         for (x = 0; x < Map->NX; x++)
           ((float *)Array)[y * Map->NX + x] = SoilMap[y][x].TSurf;
-      Write2DMatrix(DMap->FileName, Array, DMap->NumberType, Map, DMap, Index);
+      DumpMapArray(DMap->FileName, Array, DMap->NumberType, Map, DMap, Index);
 
     }
     else if (DMap->Resolution == IMAGE_OUTPUT) {
@@ -1013,7 +1052,7 @@ void DumpMap(MAPSIZE *Map, DATE *Current, MAPDUMP *DMap, TOPOPIX **TopoMap,
         for (x = 0; x < Map->NX; x++)
           ((unsigned char *)Array)[y * Map->NX + x] =
           (unsigned char)((SoilMap[y][x].TSurf - Offset) / Range * MAXUCHAR);
-      Write2DMatrix(DMap->FileName, Array, NC_BYTE, Map, DMap, Index);
+      DumpMapArray(DMap->FileName, Array, NC_BYTE, Map, DMap, Index);
 
     }
     else
@@ -1025,7 +1064,7 @@ void DumpMap(MAPSIZE *Map, DATE *Current, MAPDUMP *DMap, TOPOPIX **TopoMap,
       for (y = 0; y < Map->NY; y++)
         for (x = 0; x < Map->NX; x++)
           ((float *)Array)[y * Map->NX + x] = SoilMap[y][x].Qnet;
-      Write2DMatrix(DMap->FileName, Array, DMap->NumberType, Map, DMap, Index);
+      DumpMapArray(DMap->FileName, Array, DMap->NumberType, Map, DMap, Index);
 
     }
     else if (DMap->Resolution == IMAGE_OUTPUT) {
@@ -1033,7 +1072,7 @@ void DumpMap(MAPSIZE *Map, DATE *Current, MAPDUMP *DMap, TOPOPIX **TopoMap,
         for (x = 0; x < Map->NX; x++)
           ((unsigned char *)Array)[y * Map->NX + x] =
           (unsigned char)((SoilMap[y][x].Qnet - Offset) / Range * MAXUCHAR);
-      Write2DMatrix(DMap->FileName, Array, NC_BYTE, Map, DMap, Index);
+      DumpMapArray(DMap->FileName, Array, NC_BYTE, Map, DMap, Index);
 
     }
     else
@@ -1045,7 +1084,7 @@ void DumpMap(MAPSIZE *Map, DATE *Current, MAPDUMP *DMap, TOPOPIX **TopoMap,
       for (y = 0; y < Map->NY; y++)
         for (x = 0; x < Map->NX; x++)
           ((float *)Array)[y * Map->NX + x] = SoilMap[y][x].Qs;
-      Write2DMatrix(DMap->FileName, Array, DMap->NumberType, Map, DMap, Index);
+      DumpMapArray(DMap->FileName, Array, DMap->NumberType, Map, DMap, Index);
 
     }
     else if (DMap->Resolution == IMAGE_OUTPUT) {
@@ -1053,7 +1092,7 @@ void DumpMap(MAPSIZE *Map, DATE *Current, MAPDUMP *DMap, TOPOPIX **TopoMap,
         for (x = 0; x < Map->NX; x++)
           ((unsigned char *)Array)[y * Map->NX + x] =
           (unsigned char)((SoilMap[y][x].Qs - Offset) / Range * MAXUCHAR);
-      Write2DMatrix(DMap->FileName, Array, NC_BYTE, Map, DMap, Index);
+      DumpMapArray(DMap->FileName, Array, NC_BYTE, Map, DMap, Index);
 
     }
     else
@@ -1065,7 +1104,7 @@ void DumpMap(MAPSIZE *Map, DATE *Current, MAPDUMP *DMap, TOPOPIX **TopoMap,
       for (y = 0; y < Map->NY; y++)
         for (x = 0; x < Map->NX; x++)
           ((float *)Array)[y * Map->NX + x] = SoilMap[y][x].Qe;
-      Write2DMatrix(DMap->FileName, Array, DMap->NumberType, Map, DMap, Index);
+      DumpMapArray(DMap->FileName, Array, DMap->NumberType, Map, DMap, Index);
 
     }
     else if (DMap->Resolution == IMAGE_OUTPUT) {
@@ -1073,7 +1112,7 @@ void DumpMap(MAPSIZE *Map, DATE *Current, MAPDUMP *DMap, TOPOPIX **TopoMap,
         for (x = 0; x < Map->NX; x++)
           ((unsigned char *)Array)[y * Map->NX + x] =
           (unsigned char)((SoilMap[y][x].Qe - Offset) / Range * MAXUCHAR);
-      Write2DMatrix(DMap->FileName, Array, NC_BYTE, Map, DMap, Index);
+      DumpMapArray(DMap->FileName, Array, NC_BYTE, Map, DMap, Index);
 
     }
     else
@@ -1085,7 +1124,7 @@ void DumpMap(MAPSIZE *Map, DATE *Current, MAPDUMP *DMap, TOPOPIX **TopoMap,
       for (y = 0; y < Map->NY; y++)
         for (x = 0; x < Map->NX; x++)
           ((float *)Array)[y * Map->NX + x] = SoilMap[y][x].Qg;
-      Write2DMatrix(DMap->FileName, Array, DMap->NumberType, Map, DMap, Index);
+      DumpMapArray(DMap->FileName, Array, DMap->NumberType, Map, DMap, Index);
 
     }
     else if (DMap->Resolution == IMAGE_OUTPUT) {
@@ -1093,7 +1132,7 @@ void DumpMap(MAPSIZE *Map, DATE *Current, MAPDUMP *DMap, TOPOPIX **TopoMap,
         for (x = 0; x < Map->NX; x++)
           ((unsigned char *)Array)[y * Map->NX + x] =
           (unsigned char)((SoilMap[y][x].Qg - Offset) / Range * MAXUCHAR);
-      Write2DMatrix(DMap->FileName, Array, NC_BYTE, Map, DMap, Index);
+      DumpMapArray(DMap->FileName, Array, NC_BYTE, Map, DMap, Index);
 
     }
     else
@@ -1105,7 +1144,7 @@ void DumpMap(MAPSIZE *Map, DATE *Current, MAPDUMP *DMap, TOPOPIX **TopoMap,
       for (y = 0; y < Map->NY; y++)
         for (x = 0; x < Map->NX; x++)
           ((float *)Array)[y * Map->NX + x] = SoilMap[y][x].Qst;
-      Write2DMatrix(DMap->FileName, Array, DMap->NumberType, Map, DMap, Index);
+      DumpMapArray(DMap->FileName, Array, DMap->NumberType, Map, DMap, Index);
 
     }
     else if (DMap->Resolution == IMAGE_OUTPUT) {
@@ -1113,7 +1152,7 @@ void DumpMap(MAPSIZE *Map, DATE *Current, MAPDUMP *DMap, TOPOPIX **TopoMap,
         for (x = 0; x < Map->NX; x++)
           ((unsigned char *)Array)[y * Map->NX + x] =
           (unsigned char)((SoilMap[y][x].Qst - Offset) / Range * MAXUCHAR);
-      Write2DMatrix(DMap->FileName, Array, NC_BYTE, Map, DMap,
+      DumpMapArray(DMap->FileName, Array, NC_BYTE, Map, DMap,
         Index);
     }
     else
@@ -1125,7 +1164,7 @@ void DumpMap(MAPSIZE *Map, DATE *Current, MAPDUMP *DMap, TOPOPIX **TopoMap,
       for (y = 0; y < Map->NY; y++)
         for (x = 0; x < Map->NX; x++)
           ((float *)Array)[y * Map->NX + x] = SoilMap[y][x].IExcess;
-      Write2DMatrix(DMap->FileName, Array, DMap->NumberType, Map, DMap, Index);
+      DumpMapArray(DMap->FileName, Array, DMap->NumberType, Map, DMap, Index);
 
     }
     else if (DMap->Resolution == IMAGE_OUTPUT) {
@@ -1133,7 +1172,7 @@ void DumpMap(MAPSIZE *Map, DATE *Current, MAPDUMP *DMap, TOPOPIX **TopoMap,
         for (x = 0; x < Map->NX; x++)
           ((unsigned char *)Array)[y * Map->NX + x] =
           (unsigned char)((SoilMap[y][x].IExcess - Offset) / Range * MAXUCHAR);
-      Write2DMatrix(DMap->FileName, Array, NC_BYTE, Map, DMap, Index);
+      DumpMapArray(DMap->FileName, Array, NC_BYTE, Map, DMap, Index);
 
     }
     else
@@ -1148,7 +1187,7 @@ void DumpMap(MAPSIZE *Map, DATE *Current, MAPDUMP *DMap, TOPOPIX **TopoMap,
       for (y = 0; y < Map->NY; y++)
         for (x = 0; x < Map->NX; x++)
           ((float *)Array)[y * Map->NX + x] = SoilMap[y][x].InfiltAcc;
-      Write2DMatrix(DMap->FileName, Array, DMap->NumberType, Map, DMap, Index);
+      DumpMapArray(DMap->FileName, Array, DMap->NumberType, Map, DMap, Index);
 
     }
     else if (DMap->Resolution == IMAGE_OUTPUT) {
@@ -1156,13 +1195,190 @@ void DumpMap(MAPSIZE *Map, DATE *Current, MAPDUMP *DMap, TOPOPIX **TopoMap,
         for (x = 0; x < Map->NX; x++)
           ((unsigned char *)Array)[y * Map->NX + x] =
           (unsigned char)((SoilMap[y][x].InfiltAcc - Offset) / Range * MAXUCHAR);
-      Write2DMatrix(DMap->FileName, Array, NC_BYTE, Map, DMap, Index);
+      DumpMapArray(DMap->FileName, Array, NC_BYTE, Map, DMap, Index);
 
     }
     else
       ReportError(VarIDStr, 66);
     break;
   }
+
+  free(Array);
+}
+
+/*****************************************************************************
+DumpMapArray()
+
+Writes a map filled by DumpMap(), or adds it to the statistic of an
+aggregated map.  A variable can fill several maps per time step (one per
+layer), each is accumulated in its own slot.  A map with a Capture buffer
+is only copied there.
+*****************************************************************************/
+static int DumpMapArray(char *FileName, void *Array, int NumberType,
+  MAPSIZE *Map, MAPDUMP *DMap, int Index)
+{
+  const char *Routine = "DumpMapArray";
+  float *Value;
+  int numPoints;
+
+  numPoints = Map->NX * Map->NY;
+
+  if (DMap->Capture != NULL) {
+    if (DMap->Slot++ == 0)
+      ArrayToFloat(Array, NumberType, numPoints, DMap->Capture);
+    return numPoints;
+  }
+
+  if (!DMap->Statistic)
+    return Write2DMatrix(FileName, Array, NumberType, Map, DMap, Index);
+
+  if (DMap->Slot >= DMap->NSlots) {
+    if (!(DMap->Acc = (double *)realloc(DMap->Acc,
+      (size_t)(DMap->Slot + 1) * numPoints * sizeof(double))))
+      ReportError((char *)Routine, 1);
+    DMap->NSlots = DMap->Slot + 1;
+  }
+
+  if (!(Value = (float *)calloc(numPoints, sizeof(float))))
+    ReportError((char *)Routine, 1);
+  ArrayToFloat(Array, NumberType, numPoints, Value);
+  AccumulateStatistic(DMap->Statistic, DMap->NSteps, numPoints, Value,
+    DMap->Acc + (size_t)DMap->Slot * numPoints);
+  free(Value);
+
+  DMap->Slot++;
+  return numPoints;
+}
+
+/*****************************************************************************
+ArrayToFloat()
+
+Converts a map of any number type to 4-byte reals.
+*****************************************************************************/
+static void ArrayToFloat(void *Array, int NumberType, int NPoints,
+  float *Value)
+{
+  const char *Routine = "ArrayToFloat";
+  int i;
+
+  for (i = 0; i < NPoints; i++) {
+    switch (NumberType) {
+    case NC_BYTE:
+      Value[i] = ((unsigned char *)Array)[i];
+      break;
+    case NC_CHAR:
+      Value[i] = ((char *)Array)[i];
+      break;
+    case NC_SHORT:
+      Value[i] = ((short *)Array)[i];
+      break;
+    case NC_INT:
+      Value[i] = ((int *)Array)[i];
+      break;
+    case NC_FLOAT:
+      Value[i] = ((float *)Array)[i];
+      break;
+    case NC_DOUBLE:
+      Value[i] = ((double *)Array)[i];
+      break;
+    default:
+      ReportError((char *)Routine, 40);
+      break;
+    }
+  }
+}
+
+/*****************************************************************************
+WriteMapStatistic()
+
+Writes the statistic of the period ending at DumpDate[Next] and starts the
+next period.  The statistic is written as a 4-byte real whatever the number
+type of the variable, since a mean of integer fields is not an integer.
+DMap->NumberType stays the type DumpMap() fills, so the map is written
+through a copy of DMap with NC_FLOAT as number type (which is also the
+type a NetCDF file defines the variable with on the first write).
+*****************************************************************************/
+static void WriteMapStatistic(MAPSIZE *Map, MAPDUMP *DMap)
+{
+  const char *Routine = "WriteMapStatistic";
+  MAPDUMP StatMap;
+  float *Array;
+  int numPoints;
+  int k;
+
+  numPoints = Map->NX * Map->NY;
+
+  if (!(Array = (float *)calloc(numPoints, sizeof(float))))
+    ReportError((char *)Routine, 1);
+
+  StatMap = *DMap;
+  StatMap.NumberType = NC_FLOAT;
+  if (DMap->NumberType != NC_FLOAT && DMap->NumberType != NC_DOUBLE)
+    strcpy(StatMap.Format, "%.4g");
+
+  for (k = 0; k < DMap->NSlots; k++) {
+    ReduceStatistic(DMap->Statistic, DMap->NSteps, numPoints,
+      DMap->Acc + (size_t)k * numPoints, Array);
+    Write2DMatrix(DMap->FileName, Array, StatMap.NumberType, Map, &StatMap,
+      DMap->Next);
+  }
+  free(Array);
+
+  CopyDate(&(DMap->PeriodStart), &(DMap->DumpDate[DMap->Next]));
+  DMap->Next++;
+  DMap->NSteps = 0;
+}
+
+/*****************************************************************************
+AccumulateStatistic()
+
+Adds one time step of n values to the running statistic Acc, which holds
+NSteps time steps so far.  NA values stay NA for the whole period.
+*****************************************************************************/
+void AccumulateStatistic(int Statistic, int NSteps, int n, float *Value,
+  double *Acc)
+{
+  int i;
+
+  for (i = 0; i < n; i++) {
+    if (NSteps == 0 || Value[i] == NA) {
+      Acc[i] = Value[i];
+      continue;
+    }
+    if (Acc[i] == NA)
+      continue;
+    switch (Statistic) {
+    case DUMP_MIN:
+      if (Value[i] < Acc[i])
+        Acc[i] = Value[i];
+      break;
+    case DUMP_MAX:
+      if (Value[i] > Acc[i])
+        Acc[i] = Value[i];
+      break;
+    default:
+      Acc[i] += Value[i];
+      break;
+    }
+  }
+}
+
+/*****************************************************************************
+ReduceStatistic()
+
+Converts the running statistic of NSteps time steps into n output values
+*****************************************************************************/
+void ReduceStatistic(int Statistic, int NSteps, int n, double *Acc,
+  float *Value)
+{
+  int i;
+
+  for (i = 0; i < n; i++) {
+    if (Statistic == DUMP_MEAN && Acc[i] != NA)
+      Value[i] = Acc[i] / NSteps;
+    else
+      Value[i] = Acc[i];
+  }
 }
 
 /*****************************************************************************
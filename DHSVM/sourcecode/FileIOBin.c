@@ -9,8 +9,11 @@
  * DESCRIPTION:  Functions for binary IO
  * DESCRIP-END.
  * FUNCTIONS:    CreateMapFileBin()
+ *               Map2DMatrixBin()
+ *               Map2DMatrixByteSwapBin()
  *               Read2DMatrixBin()
  *               Read2DMatrixByteSwapBin()
+ *               CloseMappedFilesBin()
  *               Write2DMatrixBin()
  *		 Write2DMatrixByteSwapBin()
  *               SizeOfNumberType()
@@ -24,6 +27,13 @@
 #include <stdlib.h>
 #include <string.h>
 #include <sys/types.h>
+#include <sys/stat.h>
+#include <time.h>
+#ifdef HAVE_MMAP
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#endif
 #include "fifobin.h"
 #include "fileio.h"
 #include "sizeofnt.h"
@@ -52,6 +62,75 @@ void CreateMapFileBin(char *FileName, ...)
   OpenFile(&NewFile, FileName, "w", TRUE);
 }
 
+/*****************************************************************************
+  Mapped input files
+
+  Binary input files are mapped into memory the first time they are read and
+  stay mapped, so that repeated reads from the same file (the monthly shade
+  and PRISM files, the initial state maps) are an address calculation
+  instead of an open/fseek/fread/close.  At most MAXMAPPEDFILES files are kept;
+  the least recently used one is released when another one is needed.  A file
+  that has changed since it was mapped (size or modification time) is mapped
+  again.  Without mmap() the whole file is read into memory instead.
+*****************************************************************************/
+#define MAXMAPPEDFILES 32
+
+typedef struct {
+  char *Name;			/* file name */
+  unsigned char *Base;		/* start of the file in memory */
+  size_t Size;			/* file size in bytes */
+  time_t ModTime;		/* modification time when the file was mapped */
+  int Swap;			/* TRUE if the data sets are byte swapped */
+  size_t SliceSize;		/* bytes per data set (byte swapped files) */
+  unsigned char *Swapped;	/* TRUE for data sets already swapped */
+  unsigned long LastUsed;	/* for replacing the least recently used file */
+} MAPPEDFILE;
+
+static MAPPEDFILE MappedFiles[MAXMAPPEDFILES];
+static unsigned long MapClock = 0;
+
+static MAPPEDFILE *OpenMappedFile(char *FileName, int Swap);
+static void ReleaseMappedFile(MAPPEDFILE *File);
+static void SwapSlice(unsigned char *Slice, size_t ElemSize, size_t NElements);
+static void *SliceMappedFile(char *FileName, int NumberType, int NY, int NX,
+			     int NDataSet, int Swap);
+
+/*****************************************************************************
+  Function name: Map2DMatrixBin()
+
+  Purpose      : Return a pointer to a 2D array in a mapped binary file.
+
+  Required     :
+    FileName   - name of input file
+    NumberType - code for number type (see comments at the beginning of
+                 InitFileIO.c for more detail)
+    NY         - Number of rows
+    NX         - Number of columns
+    NDataSet   - number of the dataset, i.e. the first matrix in a file is
+                 number 0, etc.
+
+  Returns      : Pointer to the first element of the data set
+
+  Modifies     :
+
+  Comments     : The data are shared with the file cache and must not be
+                 modified.  The pointer stays valid until the file is
+                 released, i.e. until MAXMAPPEDFILES other files have been
+                 read or CloseMappedFilesBin() is called.
+*****************************************************************************/
+void *Map2DMatrixBin(char *FileName, int NumberType, int NY, int NX,
+		     int NDataSet)
+{
+  return SliceMappedFile(FileName, NumberType, NY, NX, NDataSet, FALSE);
+}
+
+/******************************************************************************/
+void *Map2DMatrixByteSwapBin(char *FileName, int NumberType, int NY, int NX,
+			     int NDataSet)
+{
+  return SliceMappedFile(FileName, NumberType, NY, NX, NDataSet, TRUE);
+}
+
 /*****************************************************************************
   Function name: Read2DMatrixBin()
 
@@ -72,69 +151,222 @@ void CreateMapFileBin(char *FileName, ...)
 
   Modifies     : Matrix
 
-  Comments     :
+  Comments     : Copies the data set from the mapped file
 *****************************************************************************/
 int Read2DMatrixBin(char *FileName, void *Matrix, int NumberType, int NY,
 		    int NX, int NDataSet, ...)
 {
-  FILE *InFile;
-  int NElements = 0;		/* number of elements read */
-  size_t ElemSize;
-  unsigned long OffSet;		/* number of bytes to OffSet (is non-zero when
-				   reading matrices other than the first one in the file */
-
-  OpenFile(&InFile, FileName, "rb", FALSE);
-  ElemSize = SizeOfNumberType(NumberType);
-  OffSet = NY * NX * ElemSize * NDataSet;
-
-  if (fseek(InFile, OffSet, SEEK_SET))
-    ReportError(FileName, 39);
-  NElements = fread(Matrix, ElemSize, NY * NX, InFile);
-  if (NElements != NY * NX)
-    ReportError(FileName, 2);
+  void *Slice;
 
-  fclose(InFile);
+  Slice = SliceMappedFile(FileName, NumberType, NY, NX, NDataSet, FALSE);
+  memcpy(Matrix, Slice, (size_t) NY * NX * SizeOfNumberType(NumberType));
 
-  return NElements;
+  return NY * NX;
 }
 
 /******************************************************************************/
 int Read2DMatrixByteSwapBin(char *FileName, void *Matrix, int NumberType,
 			    int NY, int NX, int NDataSet, ...)
 {
-  FILE *InFile;
-  int NElements = 0;		/* number of elements read */
-  size_t ElemSize;
-  unsigned long OffSet;		/* number of bytes to OffSet (is non-zero when
-				   reading matrices other than the first one
-				   in the file */
+  void *Slice;
 
-  OpenFile(&InFile, FileName, "rb", FALSE);
+  Slice = SliceMappedFile(FileName, NumberType, NY, NX, NDataSet, TRUE);
+  memcpy(Matrix, Slice, (size_t) NY * NX * SizeOfNumberType(NumberType));
+
+  return NY * NX;
+}
+
+/*****************************************************************************
+  Function name: CloseMappedFilesBin()
+
+  Purpose      : Release all mapped input files
+
+  Required     : 
+
+  Returns      : void
+
+  Modifies     : the file cache
+
+  Comments     : Pointers returned by Map2DMatrixBin() are invalid afterwards
+*****************************************************************************/
+void CloseMappedFilesBin(void)
+{
+  int i;
+
+  for (i = 0; i < MAXMAPPEDFILES; i++)
+    ReleaseMappedFile(&MappedFiles[i]);
+}
+
+/*****************************************************************************
+  SliceMappedFile()
+
+  Locates data set NDataSet in the mapped file, swapping its bytes in place
+  the first time it is used if Swap is TRUE.  The offset is computed in
+  size_t, so that files larger than 2 GB can be read.
+*****************************************************************************/
+static void *SliceMappedFile(char *FileName, int NumberType, int NY, int NX,
+			     int NDataSet, int Swap)
+{
+  MAPPEDFILE *File;
+  size_t ElemSize;
+  size_t SliceSize;
+  size_t NSlices;
+  size_t OffSet;
 
   ElemSize = SizeOfNumberType(NumberType);
+  SliceSize = (size_t) NY * NX * ElemSize;
+  OffSet = SliceSize * (size_t) NDataSet;
 
-  OffSet = NY * NX * ElemSize * NDataSet;
+  if (Swap && ElemSize != 1 && ElemSize != 2 && ElemSize != 4)
+    ReportError(FileName, 61);
 
-  if (fseek(InFile, OffSet, SEEK_SET)) {
-    ReportError(FileName, 39);
-  }
-  NElements = fread(Matrix, ElemSize, NY * NX, InFile);
-  if (NElements != NY * NX) {
+  File = OpenMappedFile(FileName, Swap);
+  if (NDataSet < 0 || OffSet + SliceSize > File->Size)
     ReportError(FileName, 2);
+
+  if (Swap && ElemSize > 1) {
+    if (File->Swapped == NULL || File->SliceSize != SliceSize) {
+      NSlices = File->Size / SliceSize;
+      if (File->Swapped != NULL && File->SliceSize != SliceSize) {
+	/* the file is read with another layout, start from the original */
+	ReleaseMappedFile(File);
+	File = OpenMappedFile(FileName, Swap);
+      }
+      if (!(File->Swapped = (unsigned char *) calloc(NSlices, sizeof(unsigned char))))
+	ReportError(FileName, 1);
+      File->SliceSize = SliceSize;
+    }
+    if (!File->Swapped[NDataSet]) {
+      SwapSlice(File->Base + OffSet, ElemSize, (size_t) NY * NX);
+      File->Swapped[NDataSet] = TRUE;
+    }
   }
-  fclose(InFile);
 
-  if (ElemSize == 4) {
-    byte_swap_long(Matrix, NElements);
+  return File->Base + OffSet;
+}
+
+/*****************************************************************************
+  OpenMappedFile()
+
+  Returns the cache entry for FileName, mapping the file if it is not in the
+  cache or if it has changed on disk since it was mapped.
+*****************************************************************************/
+static MAPPEDFILE *OpenMappedFile(char *FileName, int Swap)
+{
+  MAPPEDFILE *File = NULL;
+  MAPPEDFILE *Oldest = &MappedFiles[0];
+  struct stat Status;
+  int i;
+#ifdef HAVE_MMAP
+  int fd;
+#else
+  FILE *InFile;
+#endif
+
+  if (stat(FileName, &Status) != 0)
+    ReportError(FileName, 3);
+
+  for (i = 0; i < MAXMAPPEDFILES; i++) {
+    if (MappedFiles[i].Name != NULL && MappedFiles[i].Swap == Swap &&
+	strcmp(MappedFiles[i].Name, FileName) == 0) {
+      File = &MappedFiles[i];
+      break;
+    }
+    if (MappedFiles[i].LastUsed < Oldest->LastUsed)
+      Oldest = &MappedFiles[i];
   }
-  else if (ElemSize == 2) {
-    byte_swap_short(Matrix, NElements);
+
+  if (File != NULL && ((size_t) Status.st_size != File->Size ||
+		       Status.st_mtime != File->ModTime))
+    ReleaseMappedFile(File);
+  else if (File == NULL) {
+    File = Oldest;
+    ReleaseMappedFile(File);
   }
-  else if (ElemSize != 1) {
-    ReportError(FileName, 61);
+  File->LastUsed = ++MapClock;
+  if (File->Name != NULL)
+    return File;
+
+  File->Size = (size_t) Status.st_size;
+  File->ModTime = Status.st_mtime;
+  File->Swap = Swap;
+  if (File->Size == 0)
+    ReportError(FileName, 2);
+
+#ifdef HAVE_MMAP
+  if ((fd = open(FileName, O_RDONLY)) < 0)
+    ReportError(FileName, 3);
+  /* byte swapped files are swapped in a private copy of the pages */
+  File->Base = (unsigned char *) mmap(NULL, File->Size,
+				      Swap ? PROT_READ | PROT_WRITE : PROT_READ,
+				      MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (File->Base == (unsigned char *) MAP_FAILED) {
+    File->Base = NULL;
+    ReportError(FileName, 2);
   }
+#else
+  if (!(File->Base = (unsigned char *) malloc(File->Size)))
+    ReportError(FileName, 1);
+  OpenFile(&InFile, FileName, "rb", FALSE);
+  if (fread(File->Base, 1, File->Size, InFile) != File->Size)
+    ReportError(FileName, 2);
+  fclose(InFile);
+#endif
+
+  if (!(File->Name = (char *) malloc(strlen(FileName) + 1)))
+    ReportError(FileName, 1);
+  strcpy(File->Name, FileName);
 
-  return NElements;
+  return File;
+}
+
+/******************************************************************************/
+static void ReleaseMappedFile(MAPPEDFILE *File)
+{
+  if (File->Base != NULL) {
+#ifdef HAVE_MMAP
+    munmap(File->Base, File->Size);
+#else
+    free(File->Base);
+#endif
+  }
+  free(File->Name);
+  free(File->Swapped);
+  File->Name = NULL;
+  File->Base = NULL;
+  File->Swapped = NULL;
+  File->Size = 0;
+  File->SliceSize = 0;
+}
+
+/*****************************************************************************
+  SwapSlice()
+
+  Reverses the byte order of NElements elements of ElemSize bytes.  Works on
+  bytes rather than on long, which is eight bytes on LP64 systems.
+*****************************************************************************/
+static void SwapSlice(unsigned char *Slice, size_t ElemSize, size_t NElements)
+{
+  unsigned char *p;
+  unsigned char temp;
+  size_t i;
+
+  for (i = 0, p = Slice; i < NElements; i++, p += ElemSize) {
+    if (ElemSize == 4) {
+      temp = p[0];
+      p[0] = p[3];
+      p[3] = temp;
+      temp = p[1];
+      p[1] = p[2];
+      p[2] = temp;
+    }
+    else if (ElemSize == 2) {
+      temp = p[0];
+      p[0] = p[1];
+      p[1] = temp;
+    }
+  }
 }
 
 /*****************************************************************************
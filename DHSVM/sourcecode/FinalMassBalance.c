@@ -38,14 +38,14 @@
 *****************************************************************************/
 void FinalMassBalance(FILES *Out, AGGREGATED *Total, WATERBALANCE *Mass)
 {
-  float NewWaterStorage;	/* water storage at the end of the time step */
-  float Output;			/* total water flux leaving the basin;  */
-  float MassError;		/* mass balance error m  */
-  float Input;
+  double NewWaterStorage;	/* water storage at the end of the time step */
+  double Output;			/* total water flux leaving the basin;  */
+  double MassError;		/* mass balance error m  */
+  double Input;
 
-  NewWaterStorage = Total->Soil.IExcess + Total->Road.IExcess + 
+  NewWaterStorage = Total->Water.IExcess + Total->Water.RoadIExcess + 
     Total->CanopyWater + Total->SoilWater +
-    Total->Snow.Swq + Total->Soil.SatFlow + Total->Soil.DetentionStorage;
+    Total->Water.Swq + Total->Water.SatFlow + Total->Water.DetentionStorage;
 
   Output = Mass->CumChannelInt + ( Mass->CumRoadInt  -
     Mass->CumCulvertReturnFlow ) + Mass->CumET;
@@ -71,14 +71,14 @@ void FinalMassBalance(FILES *Out, AGGREGATED *Total, WATERBALANCE *Mass)
   fprintf(stderr, "\n  Storage Change .................        %.3f", (NewWaterStorage - Mass->StartWaterStorage)*1000);
   fprintf(stderr, "\n      Initial Storage ............        %.3f", Mass->StartWaterStorage*1000);
   fprintf(stderr, "\n      Final Storage ..............        %.3f", NewWaterStorage*1000);
-  fprintf(stderr, "\n          Final SWQ ..............        %.3f", Total->Snow.Swq*1000);
-  fprintf(stderr, "\n          Final Soil Moisture ....        %.3f", (Total->SoilWater + Total->Soil.SatFlow)*1000);
-  fprintf(stderr, "\n          Final Surface ..........        %.3f", (Total->Soil.IExcess  + 
-						                               Total->CanopyWater + Total->Soil.DetentionStorage)*1000);
-  fprintf(stderr, "\n          Final Road Surface .....        %.3f\n", Total->Road.IExcess*1000);
+  fprintf(stderr, "\n          Final SWQ ..............        %.3f", Total->Water.Swq*1000);
+  fprintf(stderr, "\n          Final Soil Moisture ....        %.3f", (Total->SoilWater + Total->Water.SatFlow)*1000);
+  fprintf(stderr, "\n          Final Surface ..........        %.3f", (Total->Water.IExcess  + 
+						                               Total->CanopyWater + Total->Water.DetentionStorage)*1000);
+  fprintf(stderr, "\n          Final Road Surface .....        %.3f\n", Total->Water.RoadIExcess*1000);
   fprintf(stderr, "\n  Mass added to glacier ..........        %.3f\n", Total->Snow.Glacier*1000);
   fprintf(stderr, "  ******************************************************");
-  fprintf(stderr, "\n  Mass Error (mm).................        %.3f\n", MassError*1000);
+  fprintf(stderr, "\n  Mass Error (mm).................        %.6f\n", MassError*1000);
   
     /* Print the runoff final balance results to the output file named final.mass.balance */
   fprintf(Out->FilePtr, "\n  ********************************               Depth");
@@ -95,27 +95,27 @@ void FinalMassBalance(FILES *Out, AGGREGATED *Total, WATERBALANCE *Mass)
   fprintf(Out->FilePtr, "\n  Storage Change .................        %.3f", (NewWaterStorage - Mass->StartWaterStorage)*1000);
   fprintf(Out->FilePtr, "\n      Initial Storage ............        %.3f", Mass->StartWaterStorage*1000);
   fprintf(Out->FilePtr, "\n      Final Storage ..............        %.3f", NewWaterStorage*1000);
-  fprintf(Out->FilePtr, "\n          Final SWQ ..............        %.3f", Total->Snow.Swq*1000);
-  fprintf(Out->FilePtr, "\n          Final Soil Moisture ....        %.3f", (Total->SoilWater + Total->Soil.SatFlow)*1000);
-  fprintf(Out->FilePtr, "\n          Final Surface ..........        %.3f", (Total->Soil.IExcess  + 
-						                               Total->CanopyWater + Total->Soil.DetentionStorage)*1000);
-  fprintf(Out->FilePtr, "\n          Final Road Surface .....        %.3f\n", Total->Road.IExcess*1000);
+  fprintf(Out->FilePtr, "\n          Final SWQ ..............        %.3f", Total->Water.Swq*1000);
+  fprintf(Out->FilePtr, "\n          Final Soil Moisture ....        %.3f", (Total->SoilWater + Total->Water.SatFlow)*1000);
+  fprintf(Out->FilePtr, "\n          Final Surface ..........        %.3f", (Total->Water.IExcess  + 
+						                               Total->CanopyWater + Total->Water.DetentionStorage)*1000);
+  fprintf(Out->FilePtr, "\n          Final Road Surface .....        %.3f\n", Total->Water.RoadIExcess*1000);
   fprintf(Out->FilePtr, "\n  Mass added to glacier ..........        %.3f\n", Total->Snow.Glacier*1000);
   fprintf(Out->FilePtr, "  ******************************************************");
-  fprintf(Out->FilePtr, "\n  Mass Error (mm).................        %.3f\n", MassError*1000);
+  fprintf(Out->FilePtr, "\n  Mass Error (mm).................        %.6f\n", MassError*1000);
   
      /* error check: negative soil moisture and surface ponding */
-  if (Total->SoilWater + Total->Soil.SatFlow < 0) {
+  if (Total->SoilWater + Total->Water.SatFlow < 0) {
     fprintf(stderr,
-      "FINAL MASS BALANCE ERROR:  Negative soil moisture %.3f\n", (Total->SoilWater + Total->Soil.SatFlow) * 1000);
+      "FINAL MASS BALANCE ERROR:  Negative soil moisture %.3f\n", (Total->SoilWater + Total->Water.SatFlow) * 1000);
     fprintf(Out->FilePtr,
-      "FINAL MASS BALANCE ERROR:  Negative soil moisture %.3f\n", (Total->SoilWater + Total->Soil.SatFlow) * 1000);
+      "FINAL MASS BALANCE ERROR:  Negative soil moisture %.3f\n", (Total->SoilWater + Total->Water.SatFlow) * 1000);
   }
-  if ((Total->Soil.IExcess + Total->CanopyWater + Total->Soil.DetentionStorage)/ Input > 0.1) {
+  if ((Total->Water.IExcess + Total->CanopyWater + Total->Water.DetentionStorage)/ Input > 0.1) {
     fprintf(stderr, "FINAL MASS BALANCE ERROR:  TOO MUCH SURFACE WATER PONDING %.3f\n", 
-      (Total->Soil.IExcess + Total->CanopyWater + Total->Soil.DetentionStorage) * 1000);
+      (Total->Water.IExcess + Total->CanopyWater + Total->Water.DetentionStorage) * 1000);
     fprintf(Out->FilePtr, "FINAL MASS BALANCE ERROR:  TOO MUCH SURFACE WATER PONDING %.3f\n",
-      (Total->Soil.IExcess + Total->CanopyWater + Total->Soil.DetentionStorage) * 1000);
+      (Total->Water.IExcess + Total->CanopyWater + Total->Water.DetentionStorage) * 1000);
   }
 	  	 
 }
@@ -27,6 +27,7 @@
  * FUNCTIONS:    GetInitString()
  *               GetInitLong()
  *               GetInitDouble()
+ *               SetInitString()
  *               LocateKey()
  *               LocateSection()
  *               Strip()
@@ -122,6 +123,67 @@ double GetInitDouble(const char *Section, const char *Key, double Default,
 
   return (Entry);
 }
+/*#####################################################################################
+ Sets the entry of a key, as if the input file had Key = Value in the
+ section.  An existing entry is replaced, otherwise the key (and the section)
+ is added.  Section and Key are upper case, as for GetInitString().
+ #####################################################################################*/
+void SetInitString(const char *Section, const char *Key, const char *Value,
+		   LISTPTR Input)
+{
+  LISTPTR Head = NULL;
+  LISTPTR Node = NULL;
+  char Buffer[BUFSIZE + 1];
+  char *StrPtr = NULL;
+
+  /* find the section line, or add the section at the end */
+  for (Head = Input; Head != NULL; Head = Head->Next) {
+    strncpy(Buffer, Head->Str, BUFSIZE);
+    if (IsSection(Buffer)) {
+      StrPtr = strchr(Buffer, CLOSESECTION);
+      *StrPtr = '\0';
+      memmove(Buffer, &Buffer[1], strlen(&Buffer[1]) + 1);
+      Strip(Buffer);
+      MakeKeyString(Buffer);
+      if (strcmp(Section, Buffer) == 0)
+	break;
+    }
+    if (Head->Next == NULL) {
+      Head->Next = CreateNode();
+      Head = Head->Next;
+      sprintf(Head->Str, "%c%.*s%c", OPENSECTION, BUFSIZE - 2, Section,
+	      CLOSESECTION);
+      break;
+    }
+  }
+  if (Head == NULL)
+    return;
+
+  /* find the key in the section, or add it after the section line */
+  for (Node = Head->Next; Node != NULL; Node = Node->Next) {
+    strncpy(Buffer, Node->Str, BUFSIZE);
+    if (IsSection(Buffer)) {
+      Node = NULL;
+      break;
+    }
+    if (IsKeyEntryPair(Buffer)) {
+      StrPtr = strchr(Buffer, SEPARATOR);
+      *StrPtr = '\0';
+      Strip(Buffer);
+      MakeKeyString(Buffer);
+      if (strcmp(Key, Buffer) == 0)
+	break;
+    }
+  }
+  if (Node == NULL) {
+    Node = CreateNode();
+    Node->Next = Head->Next;
+    Head->Next = Node;
+  }
+
+  sprintf(Node->Str, "%.*s %c ", BUFSIZE / 2, Key, SEPARATOR);
+  strncat(Node->Str, Value, BUFSIZE - strlen(Node->Str));
+}
 /*#####################################################################################
  This function is used to find the matching key word in the input file for the "key" 
  specified in the fucntion: InitVegTable( )
@@ -0,0 +1,357 @@
+/*
+ * SUMMARY:      GraphicsFrame.c - Colour index frame for the live graphics
+ * USAGE:        Part of DHSVM
+ *
+ * DESCRIPTION:  The maps selected with GRAPHICS ID are rendered into one
+ *               frame of colour indices, one byte per image pixel, laid out
+ *               the same way as the X11 window.  Each map is rendered in a
+ *               single pass, magnified or decimated to the frame
+ *               resolution.  Without an X server the frame is written to
+ *               <output>Frame.nnnnnn.ppm every GRAPHICS INTERVAL time steps.
+ * DESCRIP-END.
+ * FUNCTIONS:    InitGraphicsFrame()
+ *               GraphicsPalette()
+ *               DrawGraphicsPanel()
+ *               WriteGraphicsFrame()
+ * COMMENTS:     The titles, dates and colour bar ranges are written as
+ *               comments in the PPM header.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "settings.h"
+#include "data.h"
+#include "DHSVMerror.h"
+#include "fileio.h"
+#include "functions.h"
+#include "constants.h"
+
+/*****************************************************************************
+  Function name: InitGraphicsFrame()
+
+  Purpose      : Lay out the frame and allocate the memory used by draw()
+
+  Required     :
+    MAPSIZE *Map           - Size of the model grid
+    int NGraphics          - Number of maps in the frame
+    GRAPHICSDUMP *Graphics - Mode, Interval and Resolution; Expand and
+                             NPanelX have been set by InitXGraphics() in X11
+                             mode
+    MET_MAP_PIX ***MetMap  - Meteorology of each grid cell for draw()
+
+  Returns      : void
+
+  Modifies     : Graphics, MetMap
+
+  Comments     : In PPM mode the longest side of a map is decimated to at
+                 most Resolution pixels, or magnified by a whole factor up
+                 to it, and the maps are arranged in a square.
+*****************************************************************************/
+void InitGraphicsFrame(MAPSIZE *Map, int NGraphics, GRAPHICSDUMP *Graphics,
+		       MET_MAP_PIX ***MetMap)
+{
+  const char *Routine = "InitGraphicsFrame";
+  int NPanelY;
+  int Longest;
+  int y;
+
+  if (Graphics->Mode == GRAPHICS_PPM) {
+    Longest = Map->NX > Map->NY ? Map->NX : Map->NY;
+    if (Longest > Graphics->Resolution)
+      Graphics->Expand = -((Longest + Graphics->Resolution - 1) /
+			   Graphics->Resolution);
+    else
+      Graphics->Expand = Graphics->Resolution / Longest;
+    for (Graphics->NPanelX = 1;
+	 Graphics->NPanelX * Graphics->NPanelX < NGraphics; Graphics->NPanelX++) ;
+  }
+
+  if (Graphics->Expand > 0) {
+    Graphics->PanelNX = Map->NX * Graphics->Expand;
+    Graphics->PanelNY = Map->NY * Graphics->Expand;
+  }
+  else {
+    Graphics->PanelNX = Map->NX / (-Graphics->Expand);
+    Graphics->PanelNY = Map->NY / (-Graphics->Expand);
+  }
+  if (Graphics->PanelNX < 1)
+    Graphics->PanelNX = 1;
+  if (Graphics->PanelNY < 1)
+    Graphics->PanelNY = 1;
+
+  /* top 20 pixels reserved for the date stamp */
+  NPanelY = (NGraphics + Graphics->NPanelX - 1) / Graphics->NPanelX;
+  Graphics->Width = Graphics->NPanelX * (Graphics->PanelNX + GRAPHICS_BORDER)
+    + 10;
+  Graphics->Height = NPanelY * (Graphics->PanelNY + GRAPHICS_BORDER) + 60;
+
+  if (!(Graphics->Image = (unsigned char *) malloc(Graphics->Width *
+						   Graphics->Height)))
+    ReportError((char *) Routine, 1);
+  memset(Graphics->Image, GRAPHICS_WHITE, Graphics->Width * Graphics->Height);
+
+  if (!(Graphics->Title = (char **) calloc(NGraphics, sizeof(char *))) ||
+      !(Graphics->Min = (float *) calloc(NGraphics, sizeof(float))) ||
+      !(Graphics->Max = (float *) calloc(NGraphics, sizeof(float))))
+    ReportError((char *) Routine, 1);
+
+  if (!(Graphics->Field = (float **) calloc(Map->NY, sizeof(float *))))
+    ReportError((char *) Routine, 1);
+  for (y = 0; y < Map->NY; y++)
+    if (!(Graphics->Field[y] = (float *) calloc(Map->NX, sizeof(float))))
+      ReportError((char *) Routine, 1);
+
+  if (!((*MetMap) = (MET_MAP_PIX **) calloc(Map->NY, sizeof(MET_MAP_PIX *))))
+    ReportError((char *) Routine, 1);
+  for (y = 0; y < Map->NY; y++)
+    if (!((*MetMap)[y] = (MET_MAP_PIX *) calloc(Map->NX, sizeof(MET_MAP_PIX))))
+      ReportError((char *) Routine, 1);
+
+  Graphics->Step = 0;
+  Graphics->NFrames = 0;
+
+  if (Graphics->Mode == GRAPHICS_PPM)
+    printf("Writing %d x %d graphics frames every %d time steps\n",
+	   Graphics->Width, Graphics->Height, Graphics->Interval);
+}
+
+/*****************************************************************************
+  Function name: GraphicsPalette()
+
+  Purpose      : Colour of a colour index, black - blue - cyan - green -
+                 yellow - magenta - red for the ramp, then white and black
+
+  Required     :
+    int Index              - Colour index
+    unsigned short *Red    - 16 bit colour components
+    unsigned short *Green
+    unsigned short *Blue
+
+  Returns      : void
+
+  Modifies     : Red, Green, Blue
+
+  Comments     :
+*****************************************************************************/
+void GraphicsPalette(int i, unsigned short *Red, unsigned short *Green,
+		     unsigned short *Blue)
+{
+  if (i < 10) {			/* black to blue */
+    *Red = 0;
+    *Green = 0;
+    *Blue = 65535 * i / 9;
+  }
+  else if (i < 20) {		/* blue to cyan */
+    *Red = 0;
+    *Green = i * 65535 / 19;
+    *Blue = 65535;
+  }
+  else if (i < 25) {		/* cyan to green */
+    *Red = 0;
+    *Green = 65535;
+    *Blue = 65535 - (65535 * (i - 20) / 5);
+  }
+  else if (i < 30) {		/* green to yellow */
+    *Red = (i - 25) * 65535 / 5;
+    *Green = 65535;
+    *Blue = 0;
+  }
+  else if (i < 40) {		/* yellow to magenta */
+    *Red = 65535;
+    *Green = 65535 - (65535 * (i - 30) / 9);
+    *Blue = 65535 * (i - 30) / 9;
+  }
+  else if (i < NGRAPHICSCOLORS) {	/* magenta to red */
+    *Red = 65335;
+    *Green = 0;
+    *Blue = 65535 - (65535 * (i - 40) / 9);
+  }
+  else if (i == GRAPHICS_WHITE) {
+    *Red = 65535;
+    *Green = 65535;
+    *Blue = 65535;
+  }
+  else {
+    *Red = 0;
+    *Green = 0;
+    *Blue = 0;
+  }
+}
+
+/*****************************************************************************
+  Function name: DrawGraphicsPanel()
+
+  Purpose      : Render Graphics->Field into map number Panel of the frame
+
+  Required     :
+    GRAPHICSDUMP *Graphics - Frame and field
+    int Panel              - Position of the map in the frame
+    int MapNumber          - GRAPHICS ID of the field
+    MAPSIZE *Map           - Size of the model grid
+    TOPOPIX **TopoMap      - Basin mask
+    char *Title            - Title of the map, NULL if MapNumber is unknown
+    float min, max         - Range of the colour bar
+
+  Returns      : void
+
+  Modifies     : Graphics
+
+  Comments     : Values of -9999 and cells outside the basin are white.  A
+                 decimated map samples the first cell of each block, except
+                 for map numbers of 50 and larger (channel and road
+                 interception), which show the largest value of the block.
+                 The colour bar is drawn to the right of the map.
+*****************************************************************************/
+void DrawGraphicsPanel(GRAPHICSDUMP *Graphics, int Panel, int MapNumber,
+		       MAPSIZE *Map, TOPOPIX **TopoMap, char *Title, float min,
+		       float max)
+{
+  unsigned char *Row;
+  unsigned char Color;
+  float scale;
+  float temp;
+  int Block;
+  int index;
+  int PX, PY;
+  int i, j, ie, je, ir, jr;
+
+  Graphics->Title[Panel] = Title;
+  if (Title == NULL)
+    return;
+  Graphics->Min[Panel] = min;
+  Graphics->Max[Panel] = max;
+
+  if (fequal(max, min))
+    scale = 0.0;
+  else
+    scale = NGRAPHICSCOLORS / (max - min);
+
+  /* each map is left and bottom justified in its part of the frame, i.e.
+     GRAPHICS_BORDER pixels are available on the top and right for text and
+     the color bar */
+  PX = (Panel % Graphics->NPanelX) * (Graphics->PanelNX + GRAPHICS_BORDER) + 10;
+  PY = (Panel / Graphics->NPanelX) * (Graphics->PanelNY + GRAPHICS_BORDER) + 20 +
+    GRAPHICS_BORDER;
+
+  for (j = 0; j < Graphics->PanelNY; j++) {
+    Row = Graphics->Image + (PY + j) * Graphics->Width + PX;
+    if (Graphics->Expand > 0 && j % Graphics->Expand != 0) {
+      /* magnified rows repeat the first row of the cell */
+      memcpy(Row, Row - Graphics->Width, Graphics->PanelNX);
+      continue;
+    }
+    for (i = 0; i < Graphics->PanelNX; i++) {
+      if (Graphics->Expand > 0) {
+	ir = i / Graphics->Expand;
+	jr = j / Graphics->Expand;
+	Block = 1;
+      }
+      else {
+	ir = i * (-Graphics->Expand);
+	jr = j * (-Graphics->Expand);
+	Block = -Graphics->Expand;
+      }
+
+      if (MapNumber > 49 && Block > 1) {
+	temp = -10000.0;
+	for (je = jr; je < jr + Block && je < Map->NY; je++)
+	  for (ie = ir; ie < ir + Block && ie < Map->NX; ie++)
+	    if (INBASIN(TopoMap[je][ie].Mask) && Graphics->Field[je][ie] > temp)
+	      temp = Graphics->Field[je][ie];
+	if (temp == -10000.0)
+	  temp = -9999.0;
+      }
+      else if (INBASIN(TopoMap[jr][ir].Mask))
+	temp = Graphics->Field[jr][ir];
+      else
+	temp = -9999.0;
+
+      if (fequal(temp, -9999.0))
+	Color = GRAPHICS_WHITE;
+      else {
+	index = (int) (scale * (temp - min));
+	if (index > NGRAPHICSCOLORS - 1)
+	  index = NGRAPHICSCOLORS - 1;
+	if (index < 0)
+	  index = 0;
+	Color = (unsigned char) index;
+      }
+      if (Graphics->Expand > 1) {
+	memset(Row + i, Color, Graphics->Expand);
+	i += Graphics->Expand - 1;
+      }
+      else
+	Row[i] = Color;
+    }
+  }
+
+  /* the color bar, bottom to top */
+  for (j = 0; j < Graphics->PanelNY; j++) {
+    Row = Graphics->Image + (PY + Graphics->PanelNY - 1 - j) * Graphics->Width +
+      PX + Graphics->PanelNX + 10;
+    memset(Row, NGRAPHICSCOLORS * j / Graphics->PanelNY, 11);
+  }
+}
+
+/*****************************************************************************
+  Function name: WriteGraphicsFrame()
+
+  Purpose      : Write the frame as a binary PPM file
+
+  Required     :
+    GRAPHICSDUMP *Graphics - Frame
+    int NGraphics          - Number of maps in the frame
+    char *Path             - Output directory
+    char *DateStr          - Date of the frame
+
+  Returns      : void
+
+  Modifies     : Graphics->NFrames
+
+  Comments     : The file is <Path>Frame.nnnnnn.ppm, numbered from 0
+*****************************************************************************/
+void WriteGraphicsFrame(GRAPHICSDUMP *Graphics, int NGraphics, char *Path,
+			char *DateStr)
+{
+  const char *Routine = "WriteGraphicsFrame";
+  static unsigned char (*Palette)[3] = NULL;
+  static unsigned char *RGB = NULL;
+  unsigned short Red, Green, Blue;
+  unsigned char *Index;
+  char FileName[BUFSIZE + 1];
+  FILE *OutFile;
+  int i, k, x, y;
+
+  if (Palette == NULL) {
+    if (!(Palette = malloc((NGRAPHICSCOLORS + 2) * sizeof(*Palette))) ||
+	!(RGB = (unsigned char *) malloc(3 * Graphics->Width)))
+      ReportError((char *) Routine, 1);
+    for (i = 0; i < NGRAPHICSCOLORS + 2; i++) {
+      GraphicsPalette(i, &Red, &Green, &Blue);
+      Palette[i][0] = Red >> 8;
+      Palette[i][1] = Green >> 8;
+      Palette[i][2] = Blue >> 8;
+    }
+  }
+
+  sprintf(FileName, "%sFrame.%06d.ppm", Path, Graphics->NFrames);
+  OpenFile(&OutFile, FileName, "wb", TRUE);
+
+  fprintf(OutFile, "P6\n# DHSVM %s\n", DateStr);
+  for (k = 0; k < NGraphics; k++)
+    if (Graphics->Title[k] != NULL)
+      fprintf(OutFile, "# %d %s %g %g\n", k + 1, Graphics->Title[k],
+	      Graphics->Min[k], Graphics->Max[k]);
+  fprintf(OutFile, "%d %d\n255\n", Graphics->Width, Graphics->Height);
+
+  for (y = 0, Index = Graphics->Image; y < Graphics->Height; y++) {
+    for (x = 0; x < Graphics->Width; x++, Index++)
+      memcpy(RGB + 3 * x, Palette[*Index], 3);
+    if (fwrite(RGB, 3, Graphics->Width, OutFile) != (size_t) Graphics->Width)
+      ReportError(FileName, 41);
+  }
+  fclose(OutFile);
+
+  Graphics->NFrames++;
+}
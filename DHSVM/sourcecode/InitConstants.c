@@ -100,6 +100,17 @@ void InitConstants(LISTPTR Input, OPTIONSTRUCT *Options, MAPSIZE *Map,
     {"OPTIONS", "PRECIPITATION SEPARATION", "", "FALSE" },
     {"OPTIONS", "SNOW STATISTICS", "", "FALSE" },
     {"OPTIONS", "ROUTING NEIGHBORS", "", "4"},
+    {"OPTIONS", "HYDRAULIC TABLES", "", "FALSE" },
+    {"OPTIONS", "HYDRAULIC TABLE TOLERANCE", "", "1e-5" },
+    {"OPTIONS", "RBM FORCING PROJECT", "", "none" },
+    {"OPTIONS", "RBM TEXT OUTPUT", "", "TRUE" },
+    {"OPTIONS", "RBM COUPLED", "", "FALSE" },
+    {"OPTIONS", "STREAM SERIES FORMAT", "", "TEXT" },
+    {"OPTIONS", "STREAM SERIES SEGMENTS", "", "RECORDED" },
+    {"OPTIONS", "MONTHLY MAP CACHE", "", "NONE" },
+    {"OPTIONS", "WATER TABLE TOLERANCE", "", "0.0" },
+    {"OPTIONS", "OVERLAND ROUTING", "", "CONVENTIONAL" },
+    {"OPTIONS", "OVERLAND ROUGHNESS", "", "0.0" },
     {"AREA", "COORDINATE SYSTEM", "", ""},
     {"AREA", "EXTREME NORTH", "", ""},
     {"AREA", "EXTREME WEST", "", ""},
@@ -189,6 +200,34 @@ void InitConstants(LISTPTR Input, OPTIONSTRUCT *Options, MAPSIZE *Map,
   else
     Options->FlowGradient = NOT_APPLICABLE;
 
+  /* Water table gradients are only recomputed where the water level has
+     changed by more than this (m), 0 recomputes every change */
+  if (Options->FlowGradient == WATERTABLE) {
+    if (!CopyFloat(&(Options->WaterTableTolerance),
+      StrEnv[water_table_tolerance].VarStr, 1) ||
+      Options->WaterTableTolerance < 0.)
+      ReportError(StrEnv[water_table_tolerance].KeyName, 51);
+  }
+
+  /* Determine how surface water is routed over the land surface, and the
+     roughness that limits how far it travels in a time step */
+  if (strncmp(StrEnv[overland_routing].VarStr, "CONVENTIONAL", 12) == 0)
+    Options->OverlandRouting = CONVENTIONAL;
+  else if (strncmp(StrEnv[overland_routing].VarStr, "CASCADE", 7) == 0 ||
+           strncmp(StrEnv[overland_routing].VarStr, "KINEMATIC", 9) == 0)
+    Options->OverlandRouting = CASCADE;
+  else
+    ReportError(StrEnv[overland_routing].KeyName, 51);
+
+  if (Options->OverlandRouting == CASCADE) {
+    if (!CopyFloat(&(Options->OverlandRoughness),
+      StrEnv[overland_roughness].VarStr, 1) ||
+      Options->OverlandRoughness < 0.)
+      ReportError(StrEnv[overland_roughness].KeyName, 51);
+  }
+  else
+    Options->OverlandRoughness = 0.;
+
   /* Determine what meterological interpolation to use */
 
   if (strncmp(StrEnv[interpolation].VarStr, "INVDIST", 7) == 0)
@@ -321,6 +360,70 @@ void InitConstants(LISTPTR Input, OPTIONSTRUCT *Options, MAPSIZE *Map,
   else
     ReportError(StrEnv[canopy_shading].KeyName, 51);
 
+  /* Determine how the forcing for RBM is written.  With a project name
+     the forcing is written directly as <project>.forcing(.bin) */
+  if (Options->StreamTemp == TRUE &&
+      strncmp(StrEnv[rbm_project].VarStr, "none", 4) != 0 &&
+      !IsEmptyStr(StrEnv[rbm_project].VarStr))
+    strcpy(Options->RBMProject, StrEnv[rbm_project].VarStr);
+  else
+    Options->RBMProject[0] = '\0';
+
+  if (strncmp(StrEnv[rbm_text].VarStr, "TRUE", 4) == 0)
+    Options->RBMText = TRUE;
+  else if (strncmp(StrEnv[rbm_text].VarStr, "FALSE", 5) == 0)
+    Options->RBMText = FALSE;
+  else
+    ReportError(StrEnv[rbm_text].KeyName, 51);
+
+  /* Run RBM inside DHSVM instead of writing its forcing.  The project
+     name then locates the RBM network, Leopold and Mohseni files */
+  if (strncmp(StrEnv[rbm_coupled].VarStr, "TRUE", 4) == 0)
+    Options->RBMCoupled = TRUE;
+  else if (strncmp(StrEnv[rbm_coupled].VarStr, "FALSE", 5) == 0)
+    Options->RBMCoupled = FALSE;
+  else
+    ReportError(StrEnv[rbm_coupled].KeyName, 51);
+  if (Options->RBMCoupled && Options->StreamTemp == FALSE)
+    Options->RBMCoupled = FALSE;
+  if (Options->RBMCoupled && Options->RBMProject[0] == '\0')
+    ReportError(StrEnv[rbm_project].KeyName, 52);
+
+  /* Determine how the stream segment time series are saved:  as the
+     Stream.Flow and Streamflow.Only text files or one record per
+     variable per time step */
+  if (strncmp(StrEnv[stream_series].VarStr, "TEXT", 4) == 0)
+    Options->StreamSeries = FALSE;
+  else if (strncmp(StrEnv[stream_series].VarStr, "BIN", 3) == 0)
+    Options->StreamSeries = BIN;
+  else if (strncmp(StrEnv[stream_series].VarStr, "NETCDF", 6) == 0) {
+#ifdef HAVE_NETCDF
+    Options->StreamSeries = NETCDF;
+#else
+    ReportError(StrEnv[stream_series].KeyName, 56);
+#endif
+  }
+  else
+    ReportError(StrEnv[stream_series].KeyName, 51);
+
+  if (strncmp(StrEnv[stream_series_segments].VarStr, "RECORDED", 8) == 0)
+    Options->StreamSeriesAll = FALSE;
+  else if (strncmp(StrEnv[stream_series_segments].VarStr, "ALL", 3) == 0)
+    Options->StreamSeriesAll = TRUE;
+  else
+    ReportError(StrEnv[stream_series_segments].KeyName, 51);
+
+  /* Determine how many months of PRISM and shade maps are kept in memory:
+     NONE reads them every month, ALL reads all months at the start, n
+     keeps the last n months used */
+  if (strncmp(StrEnv[monthly_cache].VarStr, "NONE", 4) == 0)
+    Options->MonthlyCache = 0;
+  else if (strncmp(StrEnv[monthly_cache].VarStr, "ALL", 3) == 0)
+    Options->MonthlyCache = 12;
+  else if (!CopyInt(&(Options->MonthlyCache), StrEnv[monthly_cache].VarStr, 1) ||
+	   Options->MonthlyCache < 1 || Options->MonthlyCache > 12)
+    ReportError(StrEnv[monthly_cache].KeyName, 51);
+
   /* Determine if then improved radiation scheme will be used */
   if (strncmp(StrEnv[improv_radiation].VarStr, "TRUE", 4) == 0)
     Options->ImprovRadiation = TRUE;
@@ -352,6 +455,21 @@ void InitConstants(LISTPTR Input, OPTIONSTRUCT *Options, MAPSIZE *Map,
     Options->SnowStats = FALSE;
   else
     ReportError(StrEnv[snowstats].KeyName, 51);
+
+  /* Determine if transmissivity and drainage use per-soil lookup tables */
+  if (strncmp(StrEnv[hydraulic_tables].VarStr, "TRUE", 4) == 0)
+    Options->HydraulicTables = TRUE;
+  else if (strncmp(StrEnv[hydraulic_tables].VarStr, "FALSE", 5) == 0)
+    Options->HydraulicTables = FALSE;
+  else
+    ReportError(StrEnv[hydraulic_tables].KeyName, 51);
+
+  if (Options->HydraulicTables == TRUE) {
+    if (!CopyFloat(&(Options->HydraulicTolerance),
+      StrEnv[hydraulic_tolerance].VarStr, 1) ||
+      Options->HydraulicTolerance <= 0. || Options->HydraulicTolerance >= 1.)
+      ReportError(StrEnv[hydraulic_tolerance].KeyName, 51);
+  }
   
   /* Determine if use separate input of rain and snow */
   if (strncmp(StrEnv[sepr].VarStr, "TRUE", 4) == 0)
@@ -583,6 +701,9 @@ void InitConstants(LISTPTR Input, OPTIONSTRUCT *Options, MAPSIZE *Map,
     if (!CopyFloat(&SNOWSLIDE2, StrEnv[snowslide_parameter2].VarStr, 1))
       ReportError(StrEnv[snowslide_parameter2].KeyName, 51);
   }
+
+  /* the met interpolation for the met and precipitation sources of the run */
+  InitLocalMetData(Options);
 }
 
 
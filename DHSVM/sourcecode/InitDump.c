@@ -30,6 +30,10 @@
 #include "sizeofnt.h"
 #include "varid.h"
 
+static int ScanStatistic(char *Str);
+static int ScanInterval(char *Str, int Dt);
+static DATE PeriodEnd(DATE *Start, int Interval, int Dt, int n);
+
  /*******************************************************************************
    Function name: InitDump()
 
@@ -66,6 +70,9 @@ void InitDump(LISTPTR Input, OPTIONSTRUCT *Options, MAPSIZE *Map, int MaxSoilLay
   int NMapVars;			/* Number of different variables for which to
                    dump maps */
   int temp_count;
+  int NFlush;
+  int PixStatistic;
+  int PixInterval;
   uchar **BasinMask;
   char sumoutfile[100];
 
@@ -78,6 +85,14 @@ void InitDump(LISTPTR Input, OPTIONSTRUCT *Options, MAPSIZE *Map, int MaxSoilLay
     {"OUTPUT", "NUMBER OF MAP VARIABLES", "", ""},
     {"OUTPUT", "NUMBER OF IMAGE VARIABLES", "", ""},
     {"OUTPUT", "NUMBER OF GRAPHICS", "", ""},
+    {"OUTPUT", "PIXEL DUMP FORMAT", "", "TEXT"},
+    {"OUTPUT", "PIXEL DUMP VARIABLES", "", "ALL"},
+    {"OUTPUT", "PIXEL DUMP FLUSH STEPS", "", "24"},
+    {"OUTPUT", "PIXEL DUMP STATISTIC", "", "NONE"},
+    {"OUTPUT", "PIXEL DUMP INTERVAL", "", ""},
+    {"OUTPUT", "GRAPHICS OUTPUT", "", "X11"},
+    {"OUTPUT", "GRAPHICS INTERVAL", "", "1"},
+    {"OUTPUT", "GRAPHICS RESOLUTION", "", "400"},
     {NULL, NULL, "", NULL},
   };
 
@@ -107,6 +122,37 @@ void InitDump(LISTPTR Input, OPTIONSTRUCT *Options, MAPSIZE *Map, int MaxSoilLay
   else if (!CopyInt(&(Dump->NPix), StrEnv[npixels].VarStr, 1) || Dump->NPix < 0)
     ReportError(StrEnv[npixels].KeyName, 51);
 
+  /* The pixel dumps go to one Pixel.<name> text file per pixel, or all
+     pixels share one binary or NetCDF file that is written every NFlush
+     time steps */
+  if (strncmp(StrEnv[pixel_format].VarStr, "TEXT", 4) == 0)
+    Dump->PixFormat = FALSE;
+  else if (strncmp(StrEnv[pixel_format].VarStr, "BIN", 3) == 0)
+    Dump->PixFormat = BIN;
+  else if (strncmp(StrEnv[pixel_format].VarStr, "NETCDF", 6) == 0) {
+#ifdef HAVE_NETCDF
+    Dump->PixFormat = NETCDF;
+#else
+    ReportError(StrEnv[pixel_format].KeyName, 56);
+#endif
+  }
+  else
+    ReportError(StrEnv[pixel_format].KeyName, 51);
+  Dump->PixSeries = NULL;
+
+  if (!CopyInt(&NFlush, StrEnv[pixel_flush].VarStr, 1) || NFlush < 1)
+    ReportError(StrEnv[pixel_flush].KeyName, 51);
+
+  /* The shared pixel file can hold one record per period instead of one
+     per time step */
+  if ((PixStatistic = ScanStatistic(StrEnv[pixel_statistic].VarStr)) < 0 ||
+    (PixStatistic && !Dump->PixFormat))
+    ReportError(StrEnv[pixel_statistic].KeyName, 51);
+  PixInterval = Dt;
+  if (PixStatistic &&
+    (PixInterval = ScanInterval(StrEnv[pixel_interval].VarStr, Dt)) < 0)
+    ReportError(StrEnv[pixel_interval].KeyName, 51);
+
   if (IsEmptyStr(StrEnv[nstates].VarStr))
     Dump->NStates = 0;
   else if (!CopyInt(&(Dump->NStates), StrEnv[nstates].VarStr, 1))
@@ -131,6 +177,31 @@ void InitDump(LISTPTR Input, OPTIONSTRUCT *Options, MAPSIZE *Map, int MaxSoilLay
   if (Options->Extent == POINT)
     *NGraphics = 0;
 
+  /* The live graphics go to an X11 window, or are written as PPM frames
+     every GRAPHICS INTERVAL time steps with the longest side of each map
+     at most GRAPHICS RESOLUTION pixels */
+  if (strncmp(StrEnv[graphics_output].VarStr, "X11", 3) == 0) {
+#ifdef HAVE_X11
+    Dump->Graphics.Mode = GRAPHICS_X11;
+#else
+    if (*NGraphics > 0)
+      printf("No X11 support, writing the graphics as PPM frames\n");
+    Dump->Graphics.Mode = GRAPHICS_PPM;
+#endif
+  }
+  else if (strncmp(StrEnv[graphics_output].VarStr, "PPM", 3) == 0)
+    Dump->Graphics.Mode = GRAPHICS_PPM;
+  else
+    ReportError(StrEnv[graphics_output].KeyName, 51);
+
+  if (!CopyInt(&(Dump->Graphics.Interval), StrEnv[graphics_interval].VarStr, 1)
+      || Dump->Graphics.Interval < 1)
+    ReportError(StrEnv[graphics_interval].KeyName, 51);
+
+  if (!CopyInt(&(Dump->Graphics.Resolution), StrEnv[graphics_resolution].VarStr,
+	       1) || Dump->Graphics.Resolution < 1)
+    ReportError(StrEnv[graphics_resolution].KeyName, 51);
+
   Dump->NMaps = NMapVars + NImageVars;
 
   // Open file for recording aggregated values for entire basin
@@ -144,6 +215,13 @@ void InitDump(LISTPTR Input, OPTIONSTRUCT *Options, MAPSIZE *Map, int MaxSoilLay
 #ifndef SNOW_ONLY
   sprintf(Dump->FinalBalance.FileName, "%sMass.Final.Balance", Dump->Path);
   OpenFile(&(Dump->FinalBalance.FilePtr), Dump->FinalBalance.FileName, "w", TRUE);
+
+  /* Open file for recording the saturation extent, appended to as before */
+  if (snprintf(Dump->Saturation.FileName, sizeof(Dump->Saturation.FileName),
+	       "%ssaturation_extent.txt", Dump->Path) >=
+      (int) sizeof(Dump->Saturation.FileName))
+    ReportError(Dump->Path, 72);
+  OpenFile(&(Dump->Saturation.FilePtr), Dump->Saturation.FileName, "a", TRUE);
 #endif
 
   if (Options->Extent != POINT) {
@@ -165,7 +243,7 @@ void InitDump(LISTPTR Input, OPTIONSTRUCT *Options, MAPSIZE *Map, int MaxSoilLay
 
     if (Dump->NPix > 0) {
       temp_count = InitPixDump(Input, Map, BasinMask, Dump->Path, Dump->NPix,
-        &(Dump->Pix), Options);
+        &(Dump->Pix), Dump->PixFormat, Options);
 
       if (temp_count == 0) {
         Dump->NPix = 0;
@@ -174,6 +252,10 @@ void InitDump(LISTPTR Input, OPTIONSTRUCT *Options, MAPSIZE *Map, int MaxSoilLay
       else {
         Dump->NPix = temp_count;
         printf("total number of accepted dump pixels %d \n", Dump->NPix);
+        if (Dump->PixFormat)
+          Dump->PixSeries = InitPixSeries(Dump->Path, Dump->PixFormat,
+            StrEnv[pixel_variables].VarStr, NFlush, PixStatistic, PixInterval,
+            Dt, Dump->NPix, Dump->Pix, MaxSoilLayers, MaxVegLayers, Options);
       }
     }
     for (y = 0; y < Map->NY; y++)
@@ -181,7 +263,7 @@ void InitDump(LISTPTR Input, OPTIONSTRUCT *Options, MAPSIZE *Map, int MaxSoilLay
     free(BasinMask);
 
     if (Dump->NMaps > 0)
-      InitMapDump(Input, Map, MaxSoilLayers, MaxVegLayers, Dump->Path,
+      InitMapDump(Input, Dt, Map, MaxSoilLayers, MaxVegLayers, Dump->Path,
         Dump->NMaps, NMapVars, &(Dump->DMap));
     if (NImageVars > 0)
       InitImageDump(Input, Dt, Map, MaxSoilLayers, MaxVegLayers, Dump->Path,
@@ -402,6 +484,7 @@ void InitImageDump(LISTPTR Input, int Dt, MAPSIZE * Map, int MaxSoilLayers,
 
   Required     :
     LISTPTR Input         - Linked list with input strings
+    int Dt                - Model timestep in seconds
     MAPSIZE *MapDump      - Information about areal extent
     int MaxSoilLayers     - Maximum number of soil layers
     int MaxVegLayers      - Maximum number of vegetation layers
@@ -414,26 +497,39 @@ void InitImageDump(LISTPTR Input, int Dt, MAPSIZE * Map, int MaxSoilLayers,
 
   Modifies     : DMap and its members
 
-  Comments     :
+  Comments     : With a MAP STATISTIC (MEAN, SUM, MIN or MAX) a map is the
+                 statistic over each MAP INTERVAL (in hours, or MONTH) from
+                 MAP START to MAP END, instead of the state at each MAP DATE.
+                 The map dated MAP START covers the period ending then.
+                 MONTH periods are calendar months, like the pixel series,
+                 and each is dated by its last time step.
 *******************************************************************************/
-void InitMapDump(LISTPTR Input, MAPSIZE * Map, int MaxSoilLayers,
+void InitMapDump(LISTPTR Input, int Dt, MAPSIZE * Map, int MaxSoilLayers,
   int MaxVegLayers, char *Path, int TotalMapImages, int NMaps,
   MAPDUMP ** DMap)
 {
   char *Routine = "InitMapDump";
+  DATE End;			/* End of the last aggregation period */
+  DATE Start;			/* End of the first aggregation period */
+  DATE Date;
   int i;			/* counter */
   int j;			/* counter */
+  int Interval;			/* Aggregation period in seconds */
   int MaxLayers;		/* Maximum number of layers allowed for this
                    variable */
-  char KeyName[map_date + 1][BUFSIZE + 1];
+  char KeyName[map_interval + 1][BUFSIZE + 1];
   char *KeyStr[] = {
     "MAP VARIABLE",
     "MAP LAYER",
     "NUMBER OF MAPS",
     "MAP DATE",
+    "MAP STATISTIC",
+    "MAP START",
+    "MAP END",
+    "MAP INTERVAL"
   };
   char *SectionName = "OUTPUT";
-  char VarStr[map_date + 1][BUFSIZE + 1];
+  char VarStr[map_interval + 1][BUFSIZE + 1];
 
   if (!(*DMap = (MAPDUMP *)calloc(TotalMapImages, sizeof(MAPDUMP))))
     ReportError(Routine, 1);
@@ -471,6 +567,45 @@ void InitMapDump(LISTPTR Input, MAPSIZE * Map, int MaxSoilLayers,
 
     CreateMapFile((*DMap)[i].FileName, (*DMap)[i].FileLabel, Map);
 
+    for (j = map_statistic; j <= map_interval; j++) {
+      sprintf(KeyName[j], "%s %d", KeyStr[j], i + 1);
+      GetInitString(SectionName, KeyName[j], "", VarStr[j],
+        (unsigned long)BUFSIZE, Input);
+    }
+    if (((*DMap)[i].Statistic = ScanStatistic(VarStr[map_statistic])) < 0)
+      ReportError(KeyName[map_statistic], 51);
+
+    if ((*DMap)[i].Statistic) {
+      if (!SScanDate(VarStr[map_start], &Start))
+        ReportError(KeyName[map_start], 51);
+      if (!SScanDate(VarStr[map_end], &End))
+        ReportError(KeyName[map_end], 51);
+      if ((Interval = ScanInterval(VarStr[map_interval], Dt)) < 0)
+        ReportError("Input Options File", 24);
+
+      /* number of periods ending from Start through End */
+      (*DMap)[i].N = 0;
+      Date = PeriodEnd(&Start, Interval, Dt, 0);
+      while (!After(&Date, &End)) {
+        (*DMap)[i].N++;
+        Date = PeriodEnd(&Start, Interval, Dt, (*DMap)[i].N);
+      }
+      if ((*DMap)[i].N < 1)
+        ReportError("Input Options File", 25);
+
+      if (!((*DMap)[i].DumpDate = (DATE *)calloc((*DMap)[i].N, sizeof(DATE))))
+        ReportError(Routine, 1);
+      for (j = 0; j < (*DMap)[i].N; j++)
+        (*DMap)[i].DumpDate[j] = PeriodEnd(&Start, Interval, Dt, j);
+      (*DMap)[i].PeriodStart = PeriodEnd(&Start, Interval, Dt, -1);
+      (*DMap)[i].Next = 0;
+      (*DMap)[i].NSteps = 0;
+
+      (*DMap)[i].MinVal = 0.0;
+      (*DMap)[i].MaxVal = 0.0;
+      continue;
+    }
+
     if (!CopyInt(&((*DMap)[i].N), VarStr[nmaps], 1))
       ReportError(KeyName[nmaps], 51);
 
@@ -506,6 +641,8 @@ void InitMapDump(LISTPTR Input, MAPSIZE * Map, int MaxSoilLayers,
     char *Path            - Directory to write output to
     int NPix              - Number of pixels to dump
     PIXDUMP **Pix         - Array of pixels to dump
+    int Format            - FALSE to open a Pixel.<name> file per pixel,
+                            else the pixels share a PIXSERIES file
 
   Returns      : number of accepted dump pixels (i.e. in the mask, etc)
 
@@ -514,7 +651,7 @@ void InitMapDump(LISTPTR Input, MAPSIZE * Map, int MaxSoilLayers,
   Comments     :
 *******************************************************************************/
 int InitPixDump(LISTPTR Input, MAPSIZE *Map, uchar **BasinMask, char *Path,
-  int NPix, PIXDUMP **Pix, OPTIONSTRUCT *Options)
+  int NPix, PIXDUMP **Pix, int Format, OPTIONSTRUCT *Options)
 {
   char *Routine = "InitPixDump";
   char Str[BUFSIZE + 1];
@@ -569,12 +706,91 @@ int InitPixDump(LISTPTR Input, MAPSIZE *Map, uchar **BasinMask, char *Path,
     else {
       printf("Accepting dump command for pixel named %s \n", temp_name);
       sprintf(Str, "%s", temp_name);
+      strcpy((*Pix)[ok].Name, Str);
       sprintf((*Pix)[ok].OutFile.FileName, "%sPixel.%s", Path, Str);
       (*Pix)[ok].Loc.N = (*Pix)[i].Loc.N;
       (*Pix)[ok].Loc.E = (*Pix)[i].Loc.E;
-      OpenFile(&((*Pix)[ok].OutFile.FilePtr), (*Pix)[ok].OutFile.FileName, "w", TRUE);
+      if (!Format)
+        OpenFile(&((*Pix)[ok].OutFile.FilePtr), (*Pix)[ok].OutFile.FileName, "w", TRUE);
       ok++;
     }
   }
   return ok;
 }
+
+/*******************************************************************************
+  Function name: ScanStatistic()
+
+  Purpose      : Read the statistic of an aggregated map or pixel dump
+
+  Returns      : 0 for NONE (or no entry), DUMP_MEAN, DUMP_SUM, DUMP_MIN or
+                 DUMP_MAX, and -1 for an invalid entry
+*******************************************************************************/
+static int ScanStatistic(char *Str)
+{
+  if (IsEmptyStr(Str) || strncmp(Str, "NONE", 4) == 0)
+    return 0;
+  if (strncmp(Str, "MEAN", 4) == 0)
+    return DUMP_MEAN;
+  if (strncmp(Str, "SUM", 3) == 0)
+    return DUMP_SUM;
+  if (strncmp(Str, "MIN", 3) == 0)
+    return DUMP_MIN;
+  if (strncmp(Str, "MAX", 3) == 0)
+    return DUMP_MAX;
+  return -1;
+}
+
+/*******************************************************************************
+  Function name: ScanInterval()
+
+  Purpose      : Read the aggregation period of a map or pixel dump, either
+                 MONTH or a number of hours that is a multiple of the time
+                 step
+
+  Returns      : period in seconds, DUMP_MONTH, or -1 for an invalid entry
+*******************************************************************************/
+static int ScanInterval(char *Str, int Dt)
+{
+  float Hours;
+  int Interval;
+
+  if (strncmp(Str, "MONTH", 5) == 0)
+    return DUMP_MONTH;
+  if (!CopyFloat(&Hours, Str, 1))
+    return -1;
+  Interval = SECPHOUR * Hours;
+  if (Interval <= 0 || Interval % Dt != 0)
+    return -1;
+  return Interval;
+}
+
+/*******************************************************************************
+  Function name: PeriodEnd()
+
+  Purpose      : End of the aggregation period n periods after the one
+                 ending at Start.  MONTH periods are calendar months, so the
+                 period n months after the month of Start ends at the last
+                 time step of that month, as in EndPixSeriesRecord()
+*******************************************************************************/
+static DATE PeriodEnd(DATE *Start, int Interval, int Dt, int n)
+{
+  int Month;
+  DATE First;
+
+  if (Interval != DUMP_MONTH)
+    return NextDate(Start, n * Interval);
+
+  /* first time step of the following month */
+  Month = Start->Year * MONTHPYEAR + Start->Month + n;
+  First.Year = Month / MONTHPYEAR;
+  First.Month = Month % MONTHPYEAR + 1;
+  First.Day = 1;
+  First.Hour = 0;
+  First.Min = 0;
+  First.Sec = 0;
+  First.JDay = DayOfYear(First.Year, First.Month, First.Day);
+  First.Julian = GregorianToJulianDay(First.Year, First.Month, First.Day,
+    First.Hour, First.Min, First.Sec);
+  return NextDate(&First, -Dt);
+}
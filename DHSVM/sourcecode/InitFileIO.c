@@ -27,6 +27,7 @@
 void (*CreateMapFileFmt) (char *FileName, ...);
 int (*Read2DMatrixFmt) (char *FileName, void *Matrix, int NumberType, int NY, int NX, int NDataSet, ...);
 int (*Write2DMatrixFmt) (char *FileName, void *Matrix, int NumberType, int NY, int NX, ...);
+void *(*Map2DMatrixFmt) (char *FileName, int NumberType, int NY, int NX, int NDataSet);
 
 /*******************************************************************************
   Function name: InitFileIO()
@@ -96,12 +97,14 @@ void InitFileIO(int FileFormat)
     CreateMapFileFmt = CreateMapFileBin;
     Read2DMatrixFmt = Read2DMatrixBin;
     Write2DMatrixFmt = Write2DMatrixBin;
+    Map2DMatrixFmt = Map2DMatrixBin;
   }
   else if (FileFormat == BYTESWAP) {
     strcpy(fileext, ".bin");
     CreateMapFileFmt = CreateMapFileBin;
     Read2DMatrixFmt = Read2DMatrixByteSwapBin;
     Write2DMatrixFmt = Write2DMatrixByteSwapBin;
+    Map2DMatrixFmt = Map2DMatrixByteSwapBin;
   }
   /************* NetCDF File Format (version 3.4) ****************/
   else if (FileFormat == NETCDF) {
@@ -110,6 +113,7 @@ void InitFileIO(int FileFormat)
     CreateMapFileFmt = CreateMapFileNetCDF;
     Read2DMatrixFmt = Read2DMatrixNetCDF;
     Write2DMatrixFmt = Write2DMatrixNetCDF;
+    Map2DMatrixFmt = NULL;
 #else
     ReportError((char *) Routine, 56);
 #endif
@@ -158,6 +162,38 @@ Read2DMatrix(char *FileName, void *Matrix, int NumberType, MAPSIZE *Map,
   return result;
 }
 
+/******************************************************************************/
+/*                              Map2DMatrix                                   */
+/******************************************************************************/
+/** 
+ * Returns a pointer to data set NDataSet of a binary file without copying
+ * it.  The data belong to the file cache and must not be modified.
+ * 
+ * @param FileName name of file to read
+ * @param NumberType 
+ * @param Map 
+ * @param NDataSet 
+ * 
+ * @return pointer to the (NY, NX) array, or NULL if the file format
+ * cannot be read in place (NetCDF); use Read2DMatrix in that case
+ */
+void *
+Map2DMatrix(char *FileName, int NumberType, MAPSIZE *Map, int NDataSet)
+{
+  if (Map2DMatrixFmt == NULL)
+    return NULL;
+  return Map2DMatrixFmt(FileName, NumberType, Map->NY, Map->NX, NDataSet);
+}
+
+/******************************************************************************/
+/*                            CloseMappedFiles                                */
+/******************************************************************************/
+void
+CloseMappedFiles(void)
+{
+  CloseMappedFilesBin();
+}
+
 /******************************************************************************/
 /*                              Write2DMatrix                                  */
 /******************************************************************************/
@@ -362,23 +362,10 @@ void InitPrecipLapseMap(char *PrecipLapseFile, MAPSIZE *Map, float ***PrecipLaps
 void InitPrismMap(int NY, int NX, float ***PrismMap)
 {
   const char *Routine = "InitPRISMMap";
-  int x;			/* counter */
-  int y;			/* counter */
 
+  /* the rows point at the map of the current month, see MonthlyMaps.c */
   if (!((*PrismMap) = (float **)calloc(NY, sizeof(float *))))
     ReportError((char *)Routine, 1);
-
-  for (y = 0; y < NY; y++) {
-    if (!((*PrismMap)[y] = (float *)calloc(NX, sizeof(float))))
-      ReportError((char *)Routine, 1);
-  }
-
-  for (y = 0; y < NY; y++) {
-    for (x = 0; x < NX; x++) {
-      (*PrismMap)[y][x] = 1.0;
-    }
-  }
-
 }
 
 /******************************************************************************/
@@ -391,23 +378,13 @@ void InitShadeMap(OPTIONSTRUCT * Options, int NDaySteps, MAPSIZE *Map,
   char VarName[BUFSIZE + 1];	/* Variable name */
   int x;			/* counter */
   int y;			/* counter */
-  int n;
   int NumberType;
   float *Array = NULL;
 
-  if (!((*ShadowMap) =
-    (unsigned char ***)calloc(NDaySteps, sizeof(unsigned char **))))
-    ReportError((char *)Routine, 1);
-  for (n = 0; n < NDaySteps; n++) {
-    if (!((*ShadowMap)[n] =
-      (unsigned char **)calloc(Map->NY, sizeof(unsigned char *))))
-      ReportError((char *)Routine, 1);
-    for (y = 0; y < Map->NY; y++) {
-      if (!((*ShadowMap)[n][y] =
-        (unsigned char *)calloc(Map->NX, sizeof(unsigned char))))
-        ReportError((char *)Routine, 1);
-    }
-  }
+  /* one map per hour, not per time step, for each month kept in memory,
+     see ShadeStore.c and MonthlyMaps.c */
+  *ShadowMap = InitShadeStore(NDaySteps, Map,
+			      Options->MonthlyCache > 0 ? Options->MonthlyCache : 1);
 
   if (!((*SkyViewMap) = (float **)calloc(Map->NY, sizeof(float *))))
     ReportError((char *)Routine, 1);
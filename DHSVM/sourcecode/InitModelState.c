@@ -443,7 +443,6 @@ void InitModelState(DATE *Start, int StepsPerDay, MAPSIZE *Map, OPTIONSTRUCT *Op
   }
   
   /* Initialize gap/opening snowpack states if gap is present */
-  TotNumGap = 0.;
   if (Options->CanopyGapping) {
 	CountGap = 0;
 	Count = 0;
@@ -474,9 +473,7 @@ void InitModelState(DATE *Start, int StepsPerDay, MAPSIZE *Map, OPTIONSTRUCT *Op
 		}
 	  }
 	}
-	/* total number of grid cells with a gap structure */
-    TotNumGap = CountGap;
-    printf("\n****Canopy Gap****\n%d out of %d cells have a gap structure\n\n", TotNumGap, Count);
+    printf("\n****Canopy Gap****\n%d out of %d cells have a gap structure\n\n", CountGap, Count);
   }
 }
 
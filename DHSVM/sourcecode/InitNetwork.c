@@ -10,6 +10,7 @@
  *               necessary adjustments for the soil profile are calculated
  * DESCRIP-END.
  * FUNCTIONS:    InitNetwork()
+ *               InitImperviousDrains()
  * COMMENTS:
  * $Id: InitNetwork.c,v 1.8 2004/05/03 03:28:45 colleen Exp $
  */
@@ -20,9 +21,13 @@
 #include "settings.h"
 #include "data.h"
 #include "DHSVMerror.h"
+#include "fileio.h"
 #include "functions.h"
+#include "getinit.h"
 #include "settings.h"
+#include "sizeofnt.h"
 #include "soilmoisture.h"
+#include "varid.h"
 #include "DHSVMChannel.h"
 
  /*****************************************************************************
@@ -33,12 +38,16 @@
 
    Comments     :
  *****************************************************************************/
-void InitNetwork(int NY, int NX, float DX, float DY, TOPOPIX **TopoMap,
+void InitNetwork(MAPSIZE *Map, TOPOPIX **TopoMap,
   SOILPIX **SoilMap, VEGPIX **VegMap, VEGTABLE *VType,
   ROADSTRUCT ***Network, CHANNEL *ChannelData,
   LAYER Veg, OPTIONSTRUCT *Options)
 {
   const char *Routine = "InitNetwork";
+  int NY = Map->NY;
+  int NX = Map->NX;
+  float DX = Map->DX;
+  float DY = Map->DY;
   int i;			/* counter */
   int x;			/* column counter */
   int y;			/* row counter */
@@ -156,7 +165,10 @@ void InitNetwork(int NY, int NX, float DX, float DY, TOPOPIX **TopoMap,
     if (VType[i].ImpervFrac > 0.0)
       doimpervious = 1;
 
-  if (doimpervious) {
+  if (doimpervious && !IsEmptyStr(Options->ImperviousDrainsYPath)) {
+    InitImperviousDrains(Map, TopoMap, Options);
+  }
+  else if (doimpervious) {
     if (!(inputfile = fopen(Options->ImperviousFilePath, "rt"))) {
       fprintf(stderr,
         "User has specified a percentage impervious area \n");
@@ -171,7 +183,11 @@ void InitNetwork(int NY, int NX, float DX, float DY, TOPOPIX **TopoMap,
       fprintf(stderr,
         "This file was not found: see InitNetwork.c \n");
       fprintf(stderr,
-        "The code find_nearest_channel.c will make the file\n");
+        "The code find_nearest_channel.c will make the file, or the\n");
+      fprintf(stderr,
+        "\"IMPERVIOUS DRAINS Y FILE\" and \"IMPERVIOUS DRAINS X FILE\" maps\n");
+      fprintf(stderr,
+        "(<output_file>.drains_y.bin and <output_file>.drains_x.bin)\n");
       ReportError(Options->ImperviousFilePath, 3);
     }
     for (y = 0; y < NY; y++) {
@@ -193,3 +209,73 @@ void InitNetwork(int NY, int NX, float DX, float DY, TOPOPIX **TopoMap,
     }
   }
 }
+
+/*****************************************************************************
+  Function name: InitImperviousDrains()
+
+  Purpose      : Read the row and column of the cell that impervious runoff
+                 from each pixel drains to from the two maps written by
+                 find_nearest_channel
+
+  Comments     : Replaces the per-pixel fscanf() of the text surface routing
+                 file
+*****************************************************************************/
+void InitImperviousDrains(MAPSIZE *Map, TOPOPIX **TopoMap,
+  OPTIONSTRUCT *Options)
+{
+  const char *Routine = "InitImperviousDrains";
+  char VarName[BUFSIZE + 1];
+  char *FileName[2];
+  int ID[2] = { 023, 024 };
+  int *Drains;
+  int NumberType;
+  int flag;
+  int i, k, x, y;
+
+  FileName[0] = Options->ImperviousDrainsYPath;
+  FileName[1] = Options->ImperviousDrainsXPath;
+
+  for (k = 0; k < 2; k++) {
+    GetVarName(ID[k], 0, VarName);
+    GetVarNumberType(ID[k], &NumberType);
+    if (!(Drains = (int *)calloc(Map->NX * Map->NY,
+      SizeOfNumberType(NumberType))))
+      ReportError((char *)Routine, 1);
+    flag = Read2DMatrix(FileName[k], Drains, NumberType, Map, 0, VarName, 0);
+
+    if ((Options->FileFormat == NETCDF && flag == 0) ||
+      (Options->FileFormat == BIN)) {
+      for (y = 0, i = 0; y < Map->NY; y++) {
+        for (x = 0; x < Map->NX; x++, i++) {
+          if (k == 0)
+            TopoMap[y][x].drains_y = Drains[i];
+          else
+            TopoMap[y][x].drains_x = Drains[i];
+        }
+      }
+    }
+    else if (Options->FileFormat == NETCDF && flag == 1) {
+      for (y = Map->NY - 1, i = 0; y >= 0; y--) {
+        for (x = 0; x < Map->NX; x++, i++) {
+          if (k == 0)
+            TopoMap[y][x].drains_y = Drains[i];
+          else
+            TopoMap[y][x].drains_x = Drains[i];
+        }
+      }
+    }
+    else ReportError((char *)Routine, 57);
+    free(Drains);
+  }
+
+  for (y = 0; y < Map->NY; y++) {
+    for (x = 0; x < Map->NX; x++) {
+      if (INBASIN(TopoMap[y][x].Mask)) {
+        if (TopoMap[y][x].drains_y < 0 || TopoMap[y][x].drains_y >= Map->NY ||
+          TopoMap[y][x].drains_x < 0 || TopoMap[y][x].drains_x >= Map->NX ||
+          !INBASIN(TopoMap[TopoMap[y][x].drains_y][TopoMap[y][x].drains_x].Mask))
+          ReportError(Options->ImperviousDrainsYPath, 71);
+      }
+    }
+  }
+}
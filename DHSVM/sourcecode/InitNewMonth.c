@@ -43,75 +43,19 @@ void InitNewMonth(TIMESTRUCT *Time, OPTIONSTRUCT *Options, MAPSIZE *Map,
   INPUTFILES *InFiles, int NVegs, VEGTABLE *VType, int NStats,
   METLOCATION *Stat, char *Path, VEGPIX ***VegMap)
 {
-  const char *Routine = "InitNewMonth";
-  char FileName[MAXSTRING + 1];
-  char VarName[BUFSIZE + 1];	/* Variable name */
   int i;
-  int j, jj;
+  int j;
   int y, x;
   float a, b, l;
-  int NumberType;
-  float *Array = NULL;
-  unsigned char *Array1 = NULL;
-  int flag;
 
   if (DEBUG)
     printf("Initializing new month\n");
 
   /* If PRISM precipitation fields are being used to interpolate the
-     observed precipitation fields, then read in the new months field */
-
-  if (Options->Prism == TRUE) {
-    printf("reading in new PRISM field for month %d \n", Time->Current.Month);
-    sprintf(FileName, "%s.%02d.%s", Options->PrismDataPath,
-      Time->Current.Month, Options->PrismDataExt);
-    GetVarName(205, 0, VarName);
-    GetVarNumberType(205, &NumberType);
-    if (!(Array = (float *)calloc(Map->NY * Map->NX, sizeof(float))))
-      ReportError((char *)Routine, 1);
-    flag = Read2DMatrix(FileName, Array, NumberType, Map, 0, VarName, 0);
-
-    if ((Options->FileFormat == NETCDF && flag == 0)
-      || (Options->FileFormat == BIN)) {
-      for (y = 0, i = 0; y < Map->NY; y++)
-        for (x = 0; x < Map->NX; x++, i++)
-          PrismMap[y][x] = Array[i];
-    }
-    else if (Options->FileFormat == NETCDF && flag == 1) {
-      for (y = Map->NY - 1, i = 0; y >= 0; y--)
-        for (x = 0; x < Map->NX; x++, i++)
-          PrismMap[y][x] = Array[i];
-    }
-    else ReportError((char *)Routine, 57);
-
-    free(Array);
-  }
-
-  if (Options->Shading == TRUE) {
-    printf("reading in new shadow map for month %d \n", Time->Current.Month);
-    sprintf(FileName, "%s.%02d.%s", Options->ShadingDataPath,
-      Time->Current.Month, Options->ShadingDataExt);
-    GetVarName(304, 0, VarName);
-    GetVarNumberType(304, &NumberType);
-    if (!(Array1 = (unsigned char *)calloc(Map->NY * Map->NX, sizeof(unsigned char))))
-      ReportError((char *)Routine, 1);
-    for (i = 0; i < Time->NDaySteps; i++) {
-	  /* if computational time step is finer than hourly, make the shade factor equal within
-	  the hourly interval */
-	  if (Time->NDaySteps > 24) {
-		jj = round(i / (Time->NDaySteps / 24));
-		Read2DMatrix(FileName, Array1, NumberType, Map, jj, VarName, jj);
-	  }
-	  else   
-      Read2DMatrix(FileName, Array1, NumberType, Map, i, VarName, i);
-      for (y = 0; y < Map->NY; y++) {
-        for (x = 0; x < Map->NX; x++) {
-          ShadowMap[i][y][x] = Array1[y * Map->NX + x];
-        }
-      }
-    }
-    free(Array1);
-  }
+     observed precipitation fields, or shading is on, then switch to the
+     new month's maps */
+  if (Options->Prism == TRUE || Options->Shading == TRUE)
+    SetMonthlyMaps(Time, Options, Map, PrismMap, ShadowMap);
 
   printf("changing LAI, albedo and diffuse transmission parameters\n");
 
@@ -416,16 +360,9 @@ void InitNewStep(INPUTFILES *InFiles, MAPSIZE *Map, TIMESTRUCT *Time,
        table gradients.  Flow directions are now calculated in RouteSubSurface*/
   if (Options->FlowGradient == WATERTABLE) {
     /* Calculate the WaterLevel, i.e. the height of the water table above
-       some datum */
-    for (y = 0; y < Map->NY; y++) {
-      for (x = 0; x < Map->NX; x++) {
-        if (INBASIN(TopoMap[y][x].Mask)) {
-          SoilMap[y][x].WaterLevel =
-            TopoMap[y][x].Dem - SoilMap[y][x].TableDepth;
-        }
-      }
-    }
-    /*     HeadSlopeAspect(Map, TopoMap, SoilMap); */
+       some datum, and mark the cells whose gradients HeadSlopeAspect()
+       has to recompute */
+    HeadWaterLevel(Map, TopoMap, SoilMap, Options->WaterTableTolerance);
   }
 
   if ((Options->MM5 == TRUE && Options->QPF == TRUE) || Options->MM5 == FALSE)
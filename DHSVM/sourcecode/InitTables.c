@@ -10,6 +10,8 @@
 * DESCRIP-END.
 * FUNCTIONS:    InitTables()
 *               InitSoilTable()
+*               InitHydraulicTables()
+*               FreeHydraulicTables()
 *               InitVegTable()
 *               InitSnowTable()
 * COMMENTS:
@@ -236,9 +238,122 @@ int InitSoilTable(OPTIONSTRUCT *Options, SOILTABLE ** SType,
         ReportError((*SType)[i].Desc, 11);
     }
 
+  for (i = 0; i < NSoils; i++) {
+    if (Options->HydraulicTables == TRUE)
+      InitHydraulicTables(&((*SType)[i]), Options->HydraulicTolerance);
+    else {
+      (*SType)[i].KsTable = NULL;
+      (*SType)[i].DrainTable = NULL;
+    }
+  }
+
   return NSoils;
 }
 
+/********************************************************************************
+Function Name: InitHydraulicTables()
+
+Purpose      : Tabulate the exp() and pow() terms of CalcTransmissivity() and
+               UnsaturatedFlow() for one soil type
+
+Required     :
+SOILTABLE *SType - soil type for which the tables are built
+float Tolerance  - maximum relative error of the linear interpolation
+
+Returns      : void
+
+Modifies     : SType->KsTable and SType->DrainTable
+
+Comments     : The linear interpolation error of f between two entries is
+               less than Delta^2/8 * max|f''|.  The spacing is chosen so that
+               this stays below Tolerance * f:
+                 exp(-k z)           : k * Delta = sqrt(4 * Tolerance)
+                 r^e, r >= MinRatio  : Delta = MinRatio *
+                                       sqrt(4 * Tolerance / (e * (e - 1)))
+               The decay table covers k * z in [0, MAXKSDECAY] and the
+               drainage table covers the moisture ratios that can drain,
+               with some room for spatially variable porosity and field
+               capacity.  Keys outside the tables fall back on exp() and
+               pow().
+********************************************************************************/
+void InitHydraulicTables(SOILTABLE *SType, float Tolerance)
+{
+  const char *Routine = "InitHydraulicTables";
+  const double MAXKSDECAY = 50.;
+  double Delta;
+  double Exponent;
+  double MinRatio;
+  unsigned long i;
+  int j;
+  FLOATTABLE *Table;
+
+  /* lateral conductivity decay with depth */
+  SType->KsTable = NULL;
+  if (!fequal(SType->KsLatExp, 0.0)) {
+    if (!(SType->KsTable = (FLOATTABLE *)calloc(1, sizeof(FLOATTABLE))))
+      ReportError((char *)Routine, 1);
+    Table = SType->KsTable;
+    Delta = sqrt(4. * Tolerance) / SType->KsLatExp;
+    Table->Offset = 0.;
+    Table->Delta = (float)Delta;
+    Table->Size = (unsigned long)(MAXKSDECAY / SType->KsLatExp / Delta) + 2;
+    if (!(Table->Data = (float *)calloc(Table->Size, sizeof(float))))
+      ReportError((char *)Routine, 1);
+    for (i = 0; i < Table->Size; i++)
+      Table->Data[i] = (float)exp(-SType->KsLatExp * i * (double)Table->Delta);
+  }
+
+  /* Brooks-Corey drainage for each layer */
+  if (!(SType->DrainTable = (FLOATTABLE *)calloc(SType->NLayers,
+    sizeof(FLOATTABLE))))
+    ReportError((char *)Routine, 1);
+  for (j = 0; j < SType->NLayers; j++) {
+    Table = &(SType->DrainTable[j]);
+    Exponent = 2.0 / SType->PoreDist[j] + 3.0;
+    MinRatio = 0.5 * SType->FCap[j] / SType->Porosity[j];
+    if (MinRatio < 0.05)
+      MinRatio = 0.05;
+    Delta = MinRatio * sqrt(4. * Tolerance / (Exponent * (Exponent - 1.)));
+    Table->Offset = (float)MinRatio;
+    Table->Delta = (float)Delta;
+    Table->Size = (unsigned long)((1. - MinRatio) / Delta) + 3;
+    if (!(Table->Data = (float *)calloc(Table->Size, sizeof(float))))
+      ReportError((char *)Routine, 1);
+    for (i = 0; i < Table->Size; i++)
+      Table->Data[i] = (float)pow(Table->Offset + i * (double)Table->Delta, Exponent);
+  }
+}
+
+/********************************************************************************
+Function Name: FreeHydraulicTables()
+
+Purpose      : Release the tables built by InitHydraulicTables(), before
+               they are rebuilt for changed soil parameters
+
+Required     :
+SOILTABLE *SType - soil type for which the tables were built
+
+Returns      : void
+
+Modifies     : SType->KsTable and SType->DrainTable
+********************************************************************************/
+void FreeHydraulicTables(SOILTABLE *SType)
+{
+  int j;
+
+  if (SType->KsTable != NULL) {
+    free(SType->KsTable->Data);
+    free(SType->KsTable);
+    SType->KsTable = NULL;
+  }
+  if (SType->DrainTable != NULL) {
+    for (j = 0; j < SType->NLayers; j++)
+      free(SType->DrainTable[j].Data);
+    free(SType->DrainTable);
+    SType->DrainTable = NULL;
+  }
+}
+
 /********************************************************************************
 Function Name: InitVegTable()
 
@@ -616,11 +731,24 @@ int InitVegTable(VEGTABLE **VType, LISTPTR Input, OPTIONSTRUCT *Options, LAYER *
   } /* end of the VEG TYPE loop */
 
   if (impervious) {
-    GetInitString(SectionName, "IMPERVIOUS SURFACE ROUTING FILE", "", VarStr[0],
-      (unsigned long)BUFSIZE, Input);
-    if (IsEmptyStr(VarStr[0]))
-      ReportError("IMPERVIOUS SURFACE ROUTING FILE", 51);
-    strcpy(Options->ImperviousFilePath, VarStr[veg_description]);
+    /* The drains_y/drains_x maps written by find_nearest_channel take
+       precedence over the text routing file */
+    GetInitString(SectionName, "IMPERVIOUS DRAINS Y FILE", "",
+      Options->ImperviousDrainsYPath, (unsigned long)BUFSIZE, Input);
+    GetInitString(SectionName, "IMPERVIOUS DRAINS X FILE", "",
+      Options->ImperviousDrainsXPath, (unsigned long)BUFSIZE, Input);
+    if (IsEmptyStr(Options->ImperviousDrainsYPath) !=
+        IsEmptyStr(Options->ImperviousDrainsXPath))
+      ReportError(IsEmptyStr(Options->ImperviousDrainsYPath) ?
+        "IMPERVIOUS DRAINS Y FILE" : "IMPERVIOUS DRAINS X FILE", 51);
+
+    if (IsEmptyStr(Options->ImperviousDrainsYPath)) {
+      GetInitString(SectionName, "IMPERVIOUS SURFACE ROUTING FILE", "", VarStr[0],
+        (unsigned long)BUFSIZE, Input);
+      if (IsEmptyStr(VarStr[0]))
+        ReportError("IMPERVIOUS SURFACE ROUTING FILE", 51);
+      strcpy(Options->ImperviousFilePath, VarStr[veg_description]);
+    }
   }
 
   return NVegs;
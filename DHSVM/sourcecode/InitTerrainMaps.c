@@ -38,13 +38,25 @@ void InitTerrainMaps(LISTPTR Input, OPTIONSTRUCT *Options, MAPSIZE *Map,
   VEGTABLE *VType, VEGPIX ***VegMap)
 
 {
+  int x;
+  int y;
+
   printf("\nInitializing terrain maps\n");
 
   InitTopoMap(Input, Options, Map, TopoMap);
   InitSoilMap(Input, Options, Map, Soil, *TopoMap, SoilMap, SType);
   InitVegMap(Options, Input, Map, VegMap, VType);
-  if (Options->CanopyGapping)
+
+  /* total number of grid cells with a gap structure, known before the
+     dumps are set up */
+  TotNumGap = 0;
+  if (Options->CanopyGapping) {
     InitCanopyGapMap(Options, Input, Map, Soil, Veg, VType, VegMap, SType, SoilMap);
+    for (y = 0; y < Map->NY; y++)
+      for (x = 0; x < Map->NX; x++)
+        if (INBASIN((*TopoMap)[y][x].Mask) && (*VegMap)[y][x].Gapping > 0.0)
+          TotNumGap++;
+  }
 }
 
 /*****************************************************************************
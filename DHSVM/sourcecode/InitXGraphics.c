@@ -18,6 +18,7 @@
 #include "settings.h"
 #include "data.h"
 #include "DHSVMerror.h"
+#include "functions.h"
 
 #ifdef HAVE_X11
 #include <X11/Xlib.h>
@@ -28,18 +29,16 @@
 Display *display;
 Window window;
 GC gc;
-XColor my_color[50];
-float **temp_array;
+XColor my_color[NGRAPHICSCOLORS];
 long black, white;
-int e, ndx;
 #endif
 
 void InitXGraphics(int argc, char **argv, int ny, int nx, int nd, 
-		   MET_MAP_PIX *** MetMap)
+		   GRAPHICSDUMP *Graphics)
 {
   /* following is for the X11 libraries */
 
-  int i, x, y, screen;		/* screen is an int. */
+  int i, screen;		/* screen is an int. */
   int border_width;
   int c1, c2, c3;
   float re, best_re;
@@ -69,8 +68,6 @@ void InitXGraphics(int argc, char **argv, int ny, int nx, int nd,
   dy = 0.95 * DisplayHeight(display, screen);
 
   border_width = 4;
-  x = 0;
-  y = 0;
 
   /* figure out the actual size of the window and stuff */
 
@@ -117,8 +114,8 @@ void InitXGraphics(int argc, char **argv, int ny, int nx, int nd,
   printf("best use of display for %d images: \n", nd);
   printf("Expand images by factor %f with %d columns\n", best_re, best_ndx);
 
-  e = best_e;
-  ndx = best_ndx;
+  Graphics->Expand = best_e;
+  Graphics->NPanelX = best_ndx;
 
   best_ndy = nd / best_ndx;
   if (best_ndy * best_ndx < nd)
@@ -154,44 +151,9 @@ void InitXGraphics(int argc, char **argv, int ny, int nx, int nd,
   XMapWindow(display, window);
 
   cmap = XDefaultColormap(display, screen);
-  /* black to blue */
-  for (i = 0; i < 10; i++) {
-    my_color[i].red = 0;
-    my_color[i].green = 0;
-    my_color[i].blue = 65535 * i / 9;
-  }
-  /* blue to cyan */
-  for (i = 10; i < 20; i++) {
-    my_color[i].red = 0;
-    my_color[i].green = i * 65535 / 19;
-    my_color[i].blue = 65535;
-  }
-  /*cyan to green */
-  for (i = 20; i < 25; i++) {
-    my_color[i].red = 0;
-    my_color[i].green = 65535;
-    my_color[i].blue = 65535 - (65535 * (i - 20) / 5);
-  }
-  /*green to yellow */
-  for (i = 25; i < 30; i++) {
-    my_color[i].red = (i - 25) * 65535 / 5;
-    my_color[i].green = 65535;
-    my_color[i].blue = 0;
-  }
-  /*yellow to magenta */
-  for (i = 30; i < 40; i++) {
-    my_color[i].red = 65535;
-    my_color[i].green = 65535 - (65535 * (i - 30) / 9);
-    my_color[i].blue = 65535 * (i - 30) / 9;
-  }
-  /*magenta to red */
-  for (i = 40; i < 50; i++) {
-    my_color[i].red = 65335;
-    my_color[i].green = 0;
-    my_color[i].blue = 65535 - (65535 * (i - 40) / 9);
-  }
-
-  for (i = 0; i < 50; i++) {
+  for (i = 0; i < NGRAPHICSCOLORS; i++) {
+    GraphicsPalette(i, &my_color[i].red, &my_color[i].green,
+		    &my_color[i].blue);
     if (XAllocColor(display, cmap, &my_color[i]) == 0) {
       printf("Can't do DHSVM colors\n");
       exit(3);
@@ -200,24 +162,5 @@ void InitXGraphics(int argc, char **argv, int ny, int nx, int nd,
 
   /* done initializing the X11 Display, available for drawing */
 
-  /* initialize the memory used solely by the drawing functions */
-
-  if (!((*MetMap) = (MET_MAP_PIX **) calloc(ny, sizeof(MET_MAP_PIX *))))
-    ReportError("InitXGraphics", 1);
-
-  for (y = 0; y < ny; y++) {
-    if (!((*MetMap)[y] = (MET_MAP_PIX *) calloc(nx, sizeof(MET_MAP_PIX))))
-      ReportError("InitXGraphics", 1);
-  }
-
-  if ((temp_array = (float **) malloc(ny * sizeof(float *))) == NULL) {
-    ReportError("draw.c", 1);
-  }
-  for (y = 0; y < ny; y++) {
-    if ((temp_array[y] = (float *) malloc(nx * sizeof(float))) == NULL) {
-      ReportError("draw.c", 1);
-    }
-  }
-
 #endif
 }
@@ -11,6 +11,7 @@
  * DESCRIP-END.
  * FUNCTIONS:    init_float_table()
  *               float float_lookup(float x, FLOATTABLE *table)
+ *               FloatInterpolate()
  * COMMENTS:
  * $Id: LookupTable.c,v 1.4 2003/07/01 21:26:19 olivier Exp $     
  */
@@ -84,3 +85,38 @@ float FloatLookup(float x, FLOATTABLE * Table)
 
   return Table->Data[i];
 }
+
+/*****************************************************************************
+  Function name: FloatInterpolate()
+
+  Purpose      : Linearly interpolate between table entries for key x
+                 
+  Required     : 
+    float x           - key to be looked up
+    FLOATTABLE *Table - Table structure that contains the entries.  Unlike
+                        InitFloatTable(), entry i holds the value at
+                        Offset + i * Delta
+    float *Value      - interpolated value
+
+  Returns      : int - TRUE if x is covered by the table, FALSE otherwise
+
+  Modifies     : float *Value
+
+  Comments     : Out of range keys are not an error, so that the caller can 
+                 fall back on the exact function
+*****************************************************************************/
+int FloatInterpolate(float x, FLOATTABLE * Table, float *Value)
+{
+  float r;
+  unsigned long i;
+
+  r = (x - Table->Offset) / Table->Delta;
+  if (r < 0. || r >= (float) (Table->Size - 1))
+    return 0;
+
+  i = (unsigned long) r;
+  r -= (float) i;
+  *Value = Table->Data[i] + r * (Table->Data[i + 1] - Table->Data[i]);
+
+  return 1;
+}
@@ -0,0 +1,283 @@
+/*
+ * SUMMARY:      MainEnsemble.c - Ensemble runs of DHSVM
+ * USAGE:        DHSVM_ENSEMBLE inputfile memberfile [processes]
+ *
+ * DESCRIPTION:  Runs an ensemble of DHSVM members that differ only in
+ *               their parameters.  The static inputs (tables, terrain,
+ *               channel network, met stations, met maps, interpolation
+ *               weights) are read once with DHSVMLoad(), then a process
+ *               is forked for each member, which shares these maps with
+ *               the others copy-on-write, changes its parameters with
+ *               DHSVMSetParameter() and runs with its output in
+ *               <Output Directory>member.<n>/.  At most <processes>
+ *               members run at the same time (default: number of CPUs).
+ *
+ *               The member file has one parameter change per line:
+ *
+ *               # member  section  key  class  layer  value
+ *               1 "SOILS" "LATERAL CONDUCTIVITY" 2 0 0.002
+ *               2 "CONSTANTS" "RAIN THRESHOLD" 0 0 1.5
+ *
+ *               with the section and key as in the input file and the
+ *               soil or vegetation class and layer from 1 (see
+ *               DHSVMSetParameter()).  Members are numbered from 1; a
+ *               member without changes is the base run.
+ * DESCRIP-END.
+ * FUNCTIONS:    main()
+ * COMMENTS:     The output of each member (standard out and standard
+ *               error) goes to DHSVM.log in its output directory.
+ */
+
+/******************************************************************************/
+/*				    INCLUDES                                  */
+/******************************************************************************/
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "settings.h"
+#include "DHSVMerror.h"
+#include "fileio.h"
+#include "getinit.h"
+#include "dhsvm.h"
+
+/******************************************************************************/
+/*				GLOBAL VARIABLES                              */
+/******************************************************************************/
+
+/* global strings, defined in DHSVMModel.c */
+extern char commandline[];
+
+typedef struct {
+  int Member;
+  char Section[BUFSIZE + 1];
+  char Key[BUFSIZE + 1];
+  int Class;
+  int Layer;
+  float Value;
+} MEMBERPARAM;
+
+static int ReadMembers(char *FileName, MEMBERPARAM **Param, int *NParams);
+static int RunMember(DHSVM *Model, int Member, char *Path,
+		     MEMBERPARAM *Param, int NParams);
+
+/******************************************************************************/
+/*				      MAIN                                    */
+/******************************************************************************/
+int main(int argc, char **argv)
+{
+  char OutputPath[BUFSIZE + 1];
+  char Path[BUFSIZE + 1];
+  int Code;
+  int i;
+  int Member;
+  int NMembers;
+  int NParams;
+  int NProcs;
+  int NRunning;
+  int NFailed;
+  int Status;
+  int *Result;
+  pid_t Pid;
+  pid_t *MemberPid;
+  DHSVM *Model = NULL;
+  LISTPTR Input = NULL;
+  MEMBERPARAM *Param = NULL;
+
+  if (argc < 3 || argc > 4) {
+    fprintf(stderr, "\nUsage: %s inputfile memberfile [processes]\n\n", argv[0]);
+    fprintf(stderr, "Runs one DHSVM member per member number in memberfile, \n");
+    fprintf(stderr, "each line of which changes one parameter of a member: \n");
+    fprintf(stderr, "  member \"section\" \"key\" class layer value\n");
+    fprintf(stderr, "The output of member n goes to <Output Directory>member.n/\n");
+    exit(EXIT_FAILURE);
+  }
+
+  NProcs = (int) sysconf(_SC_NPROCESSORS_ONLN);
+  if (argc == 4 && !CopyInt(&NProcs, argv[3], 1))
+    NProcs = 0;
+  if (NProcs < 1) {
+    fprintf(stderr, "%s: invalid number of processes\n", argv[0]);
+    exit(EXIT_FAILURE);
+  }
+
+  sprintf(commandline, "%.*s %.*s", BUFSIZE / 2 - 1, argv[0],
+	  BUFSIZE / 2 - 1, argv[1]);
+  printf("%s \n", commandline);
+
+  printf("\nRunning DHSVM %s ensemble\n", DHSVMVersion());
+
+  NMembers = ReadMembers(argv[2], &Param, &NParams);
+  printf("%d members, %d parameter changes, %d processes\n", NMembers,
+	 NParams, NProcs);
+
+  /* the member output directories are below the output directory */
+  ReadInitFile(argv[1], &Input);
+  GetInitString("OUTPUT", "OUTPUT DIRECTORY", "", OutputPath,
+		(unsigned long) BUFSIZE, Input);
+  DeleteList(Input);
+  if (IsEmptyStr(OutputPath))
+    ReportError("OUTPUT DIRECTORY", 51);
+
+  printf("\nSTARTING INITIALIZATION PROCEDURES\n\n");
+
+  if ((Code = DHSVMLoad(argv[1], &Model)) != DHSVM_OK)
+    exit(Code > 0 ? Code : EXIT_FAILURE);
+
+  if (!(MemberPid = (pid_t *) calloc(NMembers + 1, sizeof(pid_t))) ||
+      !(Result = (int *) calloc(NMembers + 1, sizeof(int))))
+    ReportError("MainEnsemble", 1);
+
+/*****************************************************************************
+  Run the members
+*****************************************************************************/
+  NRunning = 0;
+  for (Member = 1; Member <= NMembers; Member++) {
+    sprintf(Path, "%.*smember.%d/", BUFSIZE / 2, OutputPath, Member);
+    if (mkdir(Path, 0777) != 0 && errno != EEXIST)
+      ReportError(Path, 3);
+
+    /* wait for a process to finish */
+    while (NRunning >= NProcs) {
+      if ((Pid = wait(&Status)) < 0)
+	break;
+      for (i = 1; i < Member; i++) {
+	if (MemberPid[i] == Pid)
+	  Result[i] = WIFEXITED(Status) ? WEXITSTATUS(Status) : EXIT_FAILURE;
+      }
+      NRunning--;
+    }
+
+    fflush(stdout);
+    fflush(stderr);
+    if ((Pid = fork()) == 0)
+      exit(RunMember(Model, Member, Path, Param, NParams));
+    if (Pid < 0) {
+      perror("fork");
+      exit(EXIT_FAILURE);
+    }
+    MemberPid[Member] = Pid;
+    NRunning++;
+    printf("member %d started\n", Member);
+  }
+
+  while ((Pid = wait(&Status)) > 0) {
+    for (i = 1; i <= NMembers; i++) {
+      if (MemberPid[i] == Pid)
+	Result[i] = WIFEXITED(Status) ? WEXITSTATUS(Status) : EXIT_FAILURE;
+    }
+  }
+
+  DHSVMFinalize(Model);
+
+  printf("\nEND OF ENSEMBLE RUN\n\n");
+  for (Member = 1, NFailed = 0; Member <= NMembers; Member++) {
+    printf("member %d: %s (exit %d)\n", Member,
+	   Result[Member] == 0 ? "done" : "failed", Result[Member]);
+    if (Result[Member] != 0)
+      NFailed++;
+  }
+
+  free(MemberPid);
+  free(Result);
+  free(Param);
+
+  return NFailed == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/*****************************************************************************
+  RunMember()
+
+  Runs one member in the forked process and returns its exit code.
+*****************************************************************************/
+static int RunMember(DHSVM *Model, int Member, char *Path,
+		     MEMBERPARAM *Param, int NParams)
+{
+  char LogFile[BUFSIZE + 1];
+  int Code;
+  int i;
+
+  sprintf(LogFile, "%.*sDHSVM.log", BUFSIZE - 10, Path);
+  if (freopen(LogFile, "w", stdout) == NULL)
+    return EXIT_FAILURE;
+  dup2(fileno(stdout), fileno(stderr));
+
+  printf("%s member %d\n", commandline, Member);
+
+  for (i = 0; i < NParams; i++) {
+    if (Param[i].Member != Member)
+      continue;
+    printf("[%s] %s %d %d = %g\n", Param[i].Section, Param[i].Key,
+	   Param[i].Class, Param[i].Layer, Param[i].Value);
+    if ((Code = DHSVMSetParameter(Model, Param[i].Section, Param[i].Key,
+				  Param[i].Class, Param[i].Layer,
+				  Param[i].Value)) != DHSVM_OK) {
+      printf("parameter change failed (%d)\n", Code);
+      return Code > 0 ? Code : EXIT_FAILURE;
+    }
+  }
+
+  if ((Code = DHSVMStart(Model, Path)) == DHSVM_OK)
+    Code = DHSVMStep(Model, 0);
+  if (Code != DHSVM_OK) {
+    DHSVMFinalize(Model);
+    return Code > 0 ? Code : EXIT_FAILURE;
+  }
+  if ((Code = DHSVMFinalize(Model)) != DHSVM_OK)
+    return Code > 0 ? Code : EXIT_FAILURE;
+
+  printf("\nEND OF MODEL RUN\n\n");
+  return EXIT_SUCCESS;
+}
+
+/*****************************************************************************
+  ReadMembers()
+
+  Reads the parameter changes from the member file and returns the number
+  of members.
+*****************************************************************************/
+static int ReadMembers(char *FileName, MEMBERPARAM **Param, int *NParams)
+{
+  char Buffer[BUFSIZ + 1];
+  char *Str;
+  int NMembers = 0;
+  int NAlloc = 0;
+  FILE *InFile = NULL;
+  MEMBERPARAM *P;
+
+  *Param = NULL;
+  *NParams = 0;
+
+  OpenFile(&InFile, FileName, "r", FALSE);
+  while (fgets(Buffer, BUFSIZ, InFile) != NULL) {
+    for (Str = Buffer; *Str == ' ' || *Str == '\t'; Str++)
+      ;
+    if (*Str == '#' || *Str == '\n' || *Str == '\r' || *Str == '\0')
+      continue;
+
+    if (*NParams == NAlloc) {
+      NAlloc = NAlloc > 0 ? 2 * NAlloc : 16;
+      if (!(*Param = (MEMBERPARAM *) realloc(*Param,
+					     NAlloc * sizeof(MEMBERPARAM))))
+	ReportError("ReadMembers", 1);
+    }
+    P = &((*Param)[*NParams]);
+    if (sscanf(Str, "%d \"%255[^\"]\" \"%255[^\"]\" %d %d %f", &(P->Member),
+	       P->Section, P->Key, &(P->Class), &(P->Layer), &(P->Value)) != 6 ||
+	P->Member < 1)
+      ReportError(FileName, 5);
+    if (P->Member > NMembers)
+      NMembers = P->Member;
+    (*NParams)++;
+  }
+  fclose(InFile);
+
+  if (NMembers == 0)
+    ReportError(FileName, 5);
+
+  return NMembers;
+}
@@ -9,6 +9,7 @@
 * DESCRIPTION:  Generates meteorological conditions for each individual cell
 * DESCRIP-END.
 * FUNCTIONS:    MakeLocalMetData()
+*               InitLocalMetData()
 * COMMENTS:
 * $Id: MakeLocalMetData.c,v3.2 2018/03/30 ning Exp $     
 */
@@ -25,6 +26,126 @@
 #include "constants.h"
 #include "rad.h"
 
+/* The met and precipitation kernels below are specializations of the
+   interpolation for the met and precipitation sources of the run.  They are
+   selected once by InitLocalMetData(), so that the option tests are not
+   repeated for each station of each cell in each time step. */
+typedef void (*METKERNEL)(int y, int x, int NStats, METLOCATION *Stat,
+                          uchar *MetWeights, float LocalElev,
+                          PRECIPPIX *PrecipMap, float ***MM5Input,
+                          float ***WindModel, float **PrecipLapseMap,
+                          float SunMax, PIXMET *LocalMet);
+typedef void (*PRECIPKERNEL)(int y, int x, MAPSIZE *Map, int NStats,
+                             METLOCATION *Stat, uchar *MetWeights,
+                             float LocalElev, PRECIPPIX *PrecipMap,
+                             MAPSIZE *Radar, RADARPIX **RadarMap,
+                             float **PrismMap, float **PrecipLapseMap,
+                             float precipMultiplier, int Month);
+
+static void MM5Met(int y, int x, int NStats, METLOCATION *Stat,
+                   uchar *MetWeights, float LocalElev, PRECIPPIX *PrecipMap,
+                   float ***MM5Input, float ***WindModel,
+                   float **PrecipLapseMap, float SunMax, PIXMET *LocalMet);
+static void MM5ShadedMet(int y, int x, int NStats, METLOCATION *Stat,
+                         uchar *MetWeights, float LocalElev,
+                         PRECIPPIX *PrecipMap, float ***MM5Input,
+                         float ***WindModel, float **PrecipLapseMap,
+                         float SunMax, PIXMET *LocalMet);
+static void StationMet(int y, int x, int NStats, METLOCATION *Stat,
+                       uchar *MetWeights, float LocalElev,
+                       PRECIPPIX *PrecipMap, float ***MM5Input,
+                       float ***WindModel, float **PrecipLapseMap,
+                       float SunMax, PIXMET *LocalMet);
+static void StationModelWindMet(int y, int x, int NStats, METLOCATION *Stat,
+                                uchar *MetWeights, float LocalElev,
+                                PRECIPPIX *PrecipMap, float ***MM5Input,
+                                float ***WindModel, float **PrecipLapseMap,
+                                float SunMax, PIXMET *LocalMet);
+static void RadarPrecip(int y, int x, MAPSIZE *Map, int NStats,
+                        METLOCATION *Stat, uchar *MetWeights,
+                        float LocalElev, PRECIPPIX *PrecipMap,
+                        MAPSIZE *Radar, RADARPIX **RadarMap,
+                        float **PrismMap, float **PrecipLapseMap,
+                        float precipMultiplier, int Month);
+static void StationPrecip(int y, int x, MAPSIZE *Map, int NStats,
+                          METLOCATION *Stat, uchar *MetWeights,
+                          float LocalElev, PRECIPPIX *PrecipMap,
+                          MAPSIZE *Radar, RADARPIX **RadarMap,
+                          float **PrismMap, float **PrecipLapseMap,
+                          float precipMultiplier, int Month);
+static void StationSeprPrecip(int y, int x, MAPSIZE *Map, int NStats,
+                              METLOCATION *Stat, uchar *MetWeights,
+                              float LocalElev, PRECIPPIX *PrecipMap,
+                              MAPSIZE *Radar, RADARPIX **RadarMap,
+                              float **PrismMap, float **PrecipLapseMap,
+                              float precipMultiplier, int Month);
+static void LapseMapPrecip(int y, int x, MAPSIZE *Map, int NStats,
+                           METLOCATION *Stat, uchar *MetWeights,
+                           float LocalElev, PRECIPPIX *PrecipMap,
+                           MAPSIZE *Radar, RADARPIX **RadarMap,
+                           float **PrismMap, float **PrecipLapseMap,
+                           float precipMultiplier, int Month);
+static void PrismPrecip(int y, int x, MAPSIZE *Map, int NStats,
+                        METLOCATION *Stat, uchar *MetWeights,
+                        float LocalElev, PRECIPPIX *PrecipMap,
+                        MAPSIZE *Radar, RADARPIX **RadarMap,
+                        float **PrismMap, float **PrecipLapseMap,
+                        float precipMultiplier, int Month);
+static void OutsidePrismPrecip(int y, int x, MAPSIZE *Map, int NStats,
+                               METLOCATION *Stat, uchar *MetWeights,
+                               float LocalElev, PRECIPPIX *PrecipMap,
+                               MAPSIZE *Radar, RADARPIX **RadarMap,
+                               float **PrismMap, float **PrecipLapseMap,
+                               float precipMultiplier, int Month);
+static float SumWeights(int NStats, uchar *MetWeights);
+
+static METKERNEL LocalMetKernel = StationMet;
+static PRECIPKERNEL LocalPrecipKernel = StationPrecip;
+
+/*****************************************************************************
+Function name: InitLocalMetData()
+
+Purpose      : Selects the met and precipitation kernels used by
+               MakeLocalMetData() for the options of the run
+
+Required     :
+OPTIONSTRUCT *Options - options as set in InitConstants()
+
+Returns      : void
+
+Modifies     : the kernels used by MakeLocalMetData()
+*****************************************************************************/
+void InitLocalMetData(OPTIONSTRUCT *Options)
+{
+  if (Options->MM5 == TRUE && Options->Shading == TRUE)
+    LocalMetKernel = MM5ShadedMet;
+  else if (Options->MM5 == TRUE)
+    LocalMetKernel = MM5Met;
+  else if (Options->WindSource == MODEL)
+    LocalMetKernel = StationModelWindMet;
+  else
+    LocalMetKernel = StationMet;
+
+  /* with MM5 input the precipitation is interpolated from the stations only
+     for QPF, otherwise it is taken from the MM5 maps */
+  if (Options->MM5 == TRUE && Options->QPF == FALSE)
+    LocalPrecipKernel = NULL;
+  else if (Options->PrecipType == RADAR)
+    LocalPrecipKernel = RadarPrecip;
+  else if (Options->PrecipType != STATION)
+    LocalPrecipKernel = NULL;
+  else if (Options->Prism == TRUE && Options->Outside == TRUE)
+    LocalPrecipKernel = OutsidePrismPrecip;
+  else if (Options->Prism == TRUE)
+    LocalPrecipKernel = PrismPrecip;
+  else if (Options->PrecipLapse == MAP)
+    LocalPrecipKernel = LapseMapPrecip;
+  else if (Options->PrecipSepr)
+    LocalPrecipKernel = StationSeprPrecip;
+  else
+    LocalPrecipKernel = StationPrecip;
+}
+
 /*****************************************************************************
 Function name: MakeLocalMetData()
 
@@ -67,16 +188,7 @@ PIXMET MakeLocalMetData(int y, int x, MAPSIZE *Map, int DayStep, int NDaySteps,
                         unsigned char shadow, float SunMax,
                         float SineSolarAltitude)
 {
-  float CurrentWeight;		/* weight for current station */
-  float ScaleWind = 1;		/* Wind to be scaled by model factors if 
-                            WindSource == MODEL */
-  float Temp;			/* Temporary variable */
-  float WeightSum;		/* sum of the weights */
-  int i,j;			/* counter */
-  int RadarX;			/* X coordinate of radar map coordinate */
-  int RadarY;			/* Y coordinate of radar map coordinate */
-  float TempLapseRate;
-  int WindDirection = 0;	/* Direction of model wind */
+  int j;			/* counter */
   PIXMET LocalMet;		/* local met data */
 
   LocalMet.Tair = 0.0;
@@ -86,90 +198,10 @@ PIXMET MakeLocalMetData(int y, int x, MAPSIZE *Map, int DayStep, int NDaySteps,
   LocalMet.SinBeam = 0.0;
   LocalMet.SinDiffuse = 0.0;
   LocalMet.Lin = 0.0;
-  TempLapseRate = 0.0;
-
-  if (Options->MM5 == TRUE && Options->QPF == TRUE) {
-    WeightSum = 0.0;
-    for (i = 0; i < NStats; i++)
-      WeightSum += (float) MetWeights[i];
-  }
-
-  if (Options->MM5 == TRUE) {
-    LocalMet.Tair = MM5Input[MM5_temperature - 1][y][x] +
-      (LocalElev - MM5Input[MM5_terrain - 1][y][x]) * 
-      MM5Input[MM5_lapse - 1][y][x];
-    LocalMet.Rh = MM5Input[MM5_humidity - 1][y][x];
-    LocalMet.Wind = MM5Input[MM5_wind - 1][y][x];
-    LocalMet.Sin = MM5Input[MM5_shortwave - 1][y][x];
-
-    if (Options->Shading == TRUE) {
-      if (SunMax > 0.0) {
-        SeparateRadiation(LocalMet.Sin, LocalMet.Sin / SunMax,
-          &(LocalMet.SinBeam), &(LocalMet.SinDiffuse)); 
-      }
-      else {
-        /* if sun is below horizon, the force all shortwave to zero */
-        LocalMet.Sin = 0.0;
-        LocalMet.SinBeam = 0.0;
-        LocalMet.SinDiffuse = 0.0; 
-      }
-    }
-    LocalMet.Lin = MM5Input[MM5_longwave - 1][y][x];
-    LocalMet.Press = 101300.0;
-    PrecipMap->Precip = MM5Input[MM5_precip - 1][y][x];
-    if (PrecipLapseMap != NULL) {
-      PrecipMap->Precip *= PrecipLapseMap[y][x];
-    }
-  }
-  else {			/* MM5 is false and we need to interpolate the basic met records */
-    WeightSum = 0.0;
-    for (i = 0; i < NStats; i++) {
-      WeightSum += (float) MetWeights[i];
-      if (Options->WindSource == MODEL && Stat[i].IsWindModelLocation) {
-        ScaleWind = Stat[i].Data.Wind;
-        WindDirection = Stat[i].Data.WindDirection;
-      }
-    }
-    for (i = 0; i < NStats; i++) {
-      CurrentWeight = ((float) MetWeights[i]) / WeightSum;
-      LocalMet.Tair += CurrentWeight *
-        LapseT(Stat[i].Data.Tair, Stat[i].Elev, LocalElev,
-        Stat[i].Data.TempLapse);
-      LocalMet.Rh += CurrentWeight * Stat[i].Data.Rh;
-      if (Options->WindSource == STATION)
-        LocalMet.Wind += CurrentWeight * Stat[i].Data.Wind;
-      LocalMet.Lin += CurrentWeight * Stat[i].Data.Lin;
-      LocalMet.Sin += CurrentWeight * Stat[i].Data.Sin;
-      
-      LocalMet.SinBeam += CurrentWeight * Stat[i].Data.SinBeamObs;
-      LocalMet.SinDiffuse += CurrentWeight * Stat[i].Data.SinDiffuseObs;
-      
-      TempLapseRate += CurrentWeight * Stat[i].Data.TempLapse;
-    }
-    if (Options->WindSource == MODEL)
-      LocalMet.Wind = ScaleWind * WindModel[WindDirection - 1][y][x];
-
-    if (Options->PrecipType == RADAR) {
-      RadarY = (int) ((y + Radar->OffsetY) * Map->DY / Radar->DY);
-      RadarX = (int) ((x - Radar->OffsetX) * Map->DX / Radar->DX);
-      PrecipMap->Precip = RadarMap[RadarY][RadarX].Precip;
-    }
-    /* WORK IN PROGRESS, taken from old DHSVM version */
-    /* Air pressure */
-    /* In rare cases - i.e. when the lapse rate has a different sign for 
-    different met stations - you can end up with a TemplapseRate of 0.0
-    This will result in a crash, so a check was put in (Jul 28, 1997 - Bart
-    Nijssen).  It is somewhat awkward to interpolate lapse rates anyway, so
-    a better way of doing this would be welcome */
-    if (TempLapseRate != 0.0) {
-      Temp = 9.8067 / (TempLapseRate * 287.0);
-      LocalMet.Press = 101300. * pow(((288.0 - TempLapseRate * LocalElev) / 288.0), Temp);
-    }
-    else
-      LocalMet.Press = 101300.;
 
-  }				/* end of else MM5==TRUE, i.e. all basic met, except for precip */
-  /* has been interpolated */
+  /* basic met, except for precip */
+  LocalMetKernel(y, x, NStats, Stat, MetWeights, LocalElev, PrecipMap,
+                 MM5Input, WindModel, PrecipLapseMap, SunMax, &LocalMet);
 
   /* Here is how the following section works */
   /* Arc-Info (through use of the hillshade command) will give */
@@ -227,49 +259,10 @@ PIXMET MakeLocalMetData(int y, int x, MAPSIZE *Map, int DayStep, int NDaySteps,
   /* the incoming shortwave radiation adjusted for shading */
   LocalMet.Sin = RadMap->BeamIn + RadMap->DiffuseIn;
 
-  if (Options->QPF == TRUE || Options->MM5 == FALSE) {
-    if (Options->PrecipType == STATION && Options->Prism == FALSE) {
-      PrecipMap->Precip = 0.0;
-      PrecipMap->SnowFall = 0.0;
-	  PrecipMap->RainFall = 0.0;
-      for (i = 0; i < NStats; i++) {
-        CurrentWeight = ((float) MetWeights[i]) / WeightSum;
-        if (Options->PrecipLapse == MAP)
-          PrecipMap->Precip += CurrentWeight *
-          LapsePrecip(Stat[i].Data.Precip, 0, 1, PrecipLapseMap[y][x], precipMultiplier);
-        else {
-          PrecipMap->Precip += CurrentWeight *
-          LapsePrecip(Stat[i].Data.Precip, Stat[i].Elev, LocalElev,
-              Stat[i].Data.PrecipLapse, precipMultiplier);
-          if (Options->PrecipSepr) {
-            PrecipMap->SnowFall += CurrentWeight *
-              LapsePrecip(Stat[i].Data.Snow, Stat[i].Elev, LocalElev, Stat[i].Data.PrecipLapse, precipMultiplier);
-            PrecipMap->RainFall += CurrentWeight *
-              LapsePrecip(Stat[i].Data.Rain, Stat[i].Elev, LocalElev, Stat[i].Data.PrecipLapse, precipMultiplier);
-          }
-        }
-      }
-    }
-    else if (Options->PrecipType == STATION && Options->Prism == TRUE) {
-      PrecipMap->Precip = 0.0;
-      for (i = 0; i < NStats; i++) {
-        CurrentWeight = ((float) MetWeights[i]) / WeightSum;
-        /* this is the real prism interpolation */
-        /* note that X = position from left  boundary, ie # of columns */
-        /* note that Y = position from upper boundary, ie # of rows   */
-        if (Options->Outside == FALSE)
-          PrecipMap->Precip += CurrentWeight * Stat[i].Data.Precip /
-          PrismMap[Stat[i].Loc.N][Stat[i].Loc.E] * PrismMap[y][x];
-        else
-          PrecipMap->Precip += CurrentWeight * Stat[i].Data.Precip /
-          Stat[i].PrismPrecip[Month - 1] * PrismMap[y][x];
-        if (PrismMap[y][x] < 0){
-          printf("negative PrismMap value in MakeLocalMetData.c\n");
-          exit(0);
-        }
-      }
-    }
-  }
+  if (LocalPrecipKernel != NULL)
+    LocalPrecipKernel(y, x, Map, NStats, Stat, MetWeights, LocalElev,
+                      PrecipMap, Radar, RadarMap, PrismMap, PrecipLapseMap,
+                      precipMultiplier, Month);
 
   /* due to the nature of the interpolation scheme in DHSVM and the */
   /* interpolation scheme to handle the mess of different formats of met stations */
@@ -363,3 +356,319 @@ PIXMET MakeLocalMetData(int y, int x, MAPSIZE *Map, int DayStep, int NDaySteps,
 
   return LocalMet;
 }
+
+/*****************************************************************************
+Function name: MM5Met() and MM5ShadedMet()
+
+Purpose      : Basic met of a cell from the MM5 maps, with the shortwave
+               separated into beam and diffuse radiation for shading in
+               MM5ShadedMet().  The precipitation is taken from the MM5 map
+               as well.
+*****************************************************************************/
+static void MM5Met(int y, int x, int NStats, METLOCATION *Stat,
+                   uchar *MetWeights, float LocalElev, PRECIPPIX *PrecipMap,
+                   float ***MM5Input, float ***WindModel,
+                   float **PrecipLapseMap, float SunMax, PIXMET *LocalMet)
+{
+  LocalMet->Tair = MM5Input[MM5_temperature - 1][y][x] +
+    (LocalElev - MM5Input[MM5_terrain - 1][y][x]) * 
+    MM5Input[MM5_lapse - 1][y][x];
+  LocalMet->Rh = MM5Input[MM5_humidity - 1][y][x];
+  LocalMet->Wind = MM5Input[MM5_wind - 1][y][x];
+  LocalMet->Sin = MM5Input[MM5_shortwave - 1][y][x];
+  LocalMet->Lin = MM5Input[MM5_longwave - 1][y][x];
+  LocalMet->Press = 101300.0;
+  PrecipMap->Precip = MM5Input[MM5_precip - 1][y][x];
+  if (PrecipLapseMap != NULL) {
+    PrecipMap->Precip *= PrecipLapseMap[y][x];
+  }
+}
+
+static void MM5ShadedMet(int y, int x, int NStats, METLOCATION *Stat,
+                         uchar *MetWeights, float LocalElev,
+                         PRECIPPIX *PrecipMap, float ***MM5Input,
+                         float ***WindModel, float **PrecipLapseMap,
+                         float SunMax, PIXMET *LocalMet)
+{
+  MM5Met(y, x, NStats, Stat, MetWeights, LocalElev, PrecipMap, MM5Input,
+         WindModel, PrecipLapseMap, SunMax, LocalMet);
+
+  if (SunMax > 0.0) {
+    SeparateRadiation(LocalMet->Sin, LocalMet->Sin / SunMax,
+      &(LocalMet->SinBeam), &(LocalMet->SinDiffuse)); 
+  }
+  else {
+    /* if sun is below horizon, the force all shortwave to zero */
+    LocalMet->Sin = 0.0;
+    LocalMet->SinBeam = 0.0;
+    LocalMet->SinDiffuse = 0.0; 
+  }
+}
+
+/*****************************************************************************
+Function name: StationMet() and StationModelWindMet()
+
+Purpose      : Basic met of a cell interpolated from the met stations, with
+               the wind from the stations or, in StationModelWindMet(), from
+               the wind model scaled by the wind of the wind model station
+*****************************************************************************/
+static void StationMet(int y, int x, int NStats, METLOCATION *Stat,
+                       uchar *MetWeights, float LocalElev,
+                       PRECIPPIX *PrecipMap, float ***MM5Input,
+                       float ***WindModel, float **PrecipLapseMap,
+                       float SunMax, PIXMET *LocalMet)
+{
+  float CurrentWeight;		/* weight for current station */
+  float Temp;			/* Temporary variable */
+  float TempLapseRate = 0.0;
+  float WeightSum;		/* sum of the weights */
+  int i;
+
+  WeightSum = SumWeights(NStats, MetWeights);
+  for (i = 0; i < NStats; i++) {
+    CurrentWeight = ((float) MetWeights[i]) / WeightSum;
+    LocalMet->Tair += CurrentWeight *
+      LapseT(Stat[i].Data.Tair, Stat[i].Elev, LocalElev,
+      Stat[i].Data.TempLapse);
+    LocalMet->Rh += CurrentWeight * Stat[i].Data.Rh;
+    LocalMet->Wind += CurrentWeight * Stat[i].Data.Wind;
+    LocalMet->Lin += CurrentWeight * Stat[i].Data.Lin;
+    LocalMet->Sin += CurrentWeight * Stat[i].Data.Sin;
+    LocalMet->SinBeam += CurrentWeight * Stat[i].Data.SinBeamObs;
+    LocalMet->SinDiffuse += CurrentWeight * Stat[i].Data.SinDiffuseObs;
+    TempLapseRate += CurrentWeight * Stat[i].Data.TempLapse;
+  }
+
+  /* WORK IN PROGRESS, taken from old DHSVM version */
+  /* Air pressure */
+  /* In rare cases - i.e. when the lapse rate has a different sign for 
+  different met stations - you can end up with a TemplapseRate of 0.0
+  This will result in a crash, so a check was put in (Jul 28, 1997 - Bart
+  Nijssen).  It is somewhat awkward to interpolate lapse rates anyway, so
+  a better way of doing this would be welcome */
+  if (TempLapseRate != 0.0) {
+    Temp = 9.8067 / (TempLapseRate * 287.0);
+    LocalMet->Press = 101300. * pow(((288.0 - TempLapseRate * LocalElev) / 288.0), Temp);
+  }
+  else
+    LocalMet->Press = 101300.;
+}
+
+static void StationModelWindMet(int y, int x, int NStats, METLOCATION *Stat,
+                                uchar *MetWeights, float LocalElev,
+                                PRECIPPIX *PrecipMap, float ***MM5Input,
+                                float ***WindModel, float **PrecipLapseMap,
+                                float SunMax, PIXMET *LocalMet)
+{
+  float CurrentWeight;		/* weight for current station */
+  float ScaleWind = 1;		/* Wind to be scaled by model factors */
+  float Temp;			/* Temporary variable */
+  float TempLapseRate = 0.0;
+  float WeightSum;		/* sum of the weights */
+  int WindDirection = 0;	/* Direction of model wind */
+  int i;
+
+  WeightSum = SumWeights(NStats, MetWeights);
+  for (i = 0; i < NStats; i++) {
+    if (Stat[i].IsWindModelLocation) {
+      ScaleWind = Stat[i].Data.Wind;
+      WindDirection = Stat[i].Data.WindDirection;
+    }
+  }
+  for (i = 0; i < NStats; i++) {
+    CurrentWeight = ((float) MetWeights[i]) / WeightSum;
+    LocalMet->Tair += CurrentWeight *
+      LapseT(Stat[i].Data.Tair, Stat[i].Elev, LocalElev,
+      Stat[i].Data.TempLapse);
+    LocalMet->Rh += CurrentWeight * Stat[i].Data.Rh;
+    LocalMet->Lin += CurrentWeight * Stat[i].Data.Lin;
+    LocalMet->Sin += CurrentWeight * Stat[i].Data.Sin;
+    LocalMet->SinBeam += CurrentWeight * Stat[i].Data.SinBeamObs;
+    LocalMet->SinDiffuse += CurrentWeight * Stat[i].Data.SinDiffuseObs;
+    TempLapseRate += CurrentWeight * Stat[i].Data.TempLapse;
+  }
+  LocalMet->Wind = ScaleWind * WindModel[WindDirection - 1][y][x];
+
+  /* Air pressure, see StationMet() */
+  if (TempLapseRate != 0.0) {
+    Temp = 9.8067 / (TempLapseRate * 287.0);
+    LocalMet->Press = 101300. * pow(((288.0 - TempLapseRate * LocalElev) / 288.0), Temp);
+  }
+  else
+    LocalMet->Press = 101300.;
+}
+
+/*****************************************************************************
+Function name: RadarPrecip()
+
+Purpose      : Precipitation of a cell from the radar map
+*****************************************************************************/
+static void RadarPrecip(int y, int x, MAPSIZE *Map, int NStats,
+                        METLOCATION *Stat, uchar *MetWeights,
+                        float LocalElev, PRECIPPIX *PrecipMap,
+                        MAPSIZE *Radar, RADARPIX **RadarMap,
+                        float **PrismMap, float **PrecipLapseMap,
+                        float precipMultiplier, int Month)
+{
+  int RadarX;			/* X coordinate of radar map coordinate */
+  int RadarY;			/* Y coordinate of radar map coordinate */
+
+  RadarY = (int) ((y + Radar->OffsetY) * Map->DY / Radar->DY);
+  RadarX = (int) ((x - Radar->OffsetX) * Map->DX / Radar->DX);
+  PrecipMap->Precip = RadarMap[RadarY][RadarX].Precip;
+}
+
+/*****************************************************************************
+Function name: StationPrecip(), StationSeprPrecip() and LapseMapPrecip()
+
+Purpose      : Precipitation of a cell interpolated from the met stations
+               and lapsed with elevation, with the snow and rain lapsed
+               separately in StationSeprPrecip(), or scaled by the
+               precipitation lapse map in LapseMapPrecip()
+*****************************************************************************/
+static void StationPrecip(int y, int x, MAPSIZE *Map, int NStats,
+                          METLOCATION *Stat, uchar *MetWeights,
+                          float LocalElev, PRECIPPIX *PrecipMap,
+                          MAPSIZE *Radar, RADARPIX **RadarMap,
+                          float **PrismMap, float **PrecipLapseMap,
+                          float precipMultiplier, int Month)
+{
+  float CurrentWeight;		/* weight for current station */
+  float WeightSum;		/* sum of the weights */
+  int i;
+
+  WeightSum = SumWeights(NStats, MetWeights);
+  PrecipMap->Precip = 0.0;
+  PrecipMap->SnowFall = 0.0;
+  PrecipMap->RainFall = 0.0;
+  for (i = 0; i < NStats; i++) {
+    CurrentWeight = ((float) MetWeights[i]) / WeightSum;
+    PrecipMap->Precip += CurrentWeight *
+      LapsePrecip(Stat[i].Data.Precip, Stat[i].Elev, LocalElev,
+        Stat[i].Data.PrecipLapse, precipMultiplier);
+  }
+}
+
+static void StationSeprPrecip(int y, int x, MAPSIZE *Map, int NStats,
+                              METLOCATION *Stat, uchar *MetWeights,
+                              float LocalElev, PRECIPPIX *PrecipMap,
+                              MAPSIZE *Radar, RADARPIX **RadarMap,
+                              float **PrismMap, float **PrecipLapseMap,
+                              float precipMultiplier, int Month)
+{
+  float CurrentWeight;		/* weight for current station */
+  float WeightSum;		/* sum of the weights */
+  int i;
+
+  WeightSum = SumWeights(NStats, MetWeights);
+  PrecipMap->Precip = 0.0;
+  PrecipMap->SnowFall = 0.0;
+  PrecipMap->RainFall = 0.0;
+  for (i = 0; i < NStats; i++) {
+    CurrentWeight = ((float) MetWeights[i]) / WeightSum;
+    PrecipMap->Precip += CurrentWeight *
+      LapsePrecip(Stat[i].Data.Precip, Stat[i].Elev, LocalElev,
+        Stat[i].Data.PrecipLapse, precipMultiplier);
+    PrecipMap->SnowFall += CurrentWeight *
+      LapsePrecip(Stat[i].Data.Snow, Stat[i].Elev, LocalElev, Stat[i].Data.PrecipLapse, precipMultiplier);
+    PrecipMap->RainFall += CurrentWeight *
+      LapsePrecip(Stat[i].Data.Rain, Stat[i].Elev, LocalElev, Stat[i].Data.PrecipLapse, precipMultiplier);
+  }
+}
+
+static void LapseMapPrecip(int y, int x, MAPSIZE *Map, int NStats,
+                           METLOCATION *Stat, uchar *MetWeights,
+                           float LocalElev, PRECIPPIX *PrecipMap,
+                           MAPSIZE *Radar, RADARPIX **RadarMap,
+                           float **PrismMap, float **PrecipLapseMap,
+                           float precipMultiplier, int Month)
+{
+  float CurrentWeight;		/* weight for current station */
+  float WeightSum;		/* sum of the weights */
+  int i;
+
+  WeightSum = SumWeights(NStats, MetWeights);
+  PrecipMap->Precip = 0.0;
+  PrecipMap->SnowFall = 0.0;
+  PrecipMap->RainFall = 0.0;
+  for (i = 0; i < NStats; i++) {
+    CurrentWeight = ((float) MetWeights[i]) / WeightSum;
+    PrecipMap->Precip += CurrentWeight *
+      LapsePrecip(Stat[i].Data.Precip, 0, 1, PrecipLapseMap[y][x], precipMultiplier);
+  }
+}
+
+/*****************************************************************************
+Function name: PrismPrecip() and OutsidePrismPrecip()
+
+Purpose      : Precipitation of a cell interpolated from the met stations
+               with the PRISM map, using the PRISM value of the station
+               cell, or in OutsidePrismPrecip() the PRISM value given for
+               stations outside the model area
+*****************************************************************************/
+static void PrismPrecip(int y, int x, MAPSIZE *Map, int NStats,
+                        METLOCATION *Stat, uchar *MetWeights,
+                        float LocalElev, PRECIPPIX *PrecipMap,
+                        MAPSIZE *Radar, RADARPIX **RadarMap,
+                        float **PrismMap, float **PrecipLapseMap,
+                        float precipMultiplier, int Month)
+{
+  float CurrentWeight;		/* weight for current station */
+  float WeightSum;		/* sum of the weights */
+  int i;
+
+  WeightSum = SumWeights(NStats, MetWeights);
+  PrecipMap->Precip = 0.0;
+  for (i = 0; i < NStats; i++) {
+    CurrentWeight = ((float) MetWeights[i]) / WeightSum;
+    /* this is the real prism interpolation */
+    /* note that X = position from left  boundary, ie # of columns */
+    /* note that Y = position from upper boundary, ie # of rows   */
+    PrecipMap->Precip += CurrentWeight * Stat[i].Data.Precip /
+      PrismMap[Stat[i].Loc.N][Stat[i].Loc.E] * PrismMap[y][x];
+    if (PrismMap[y][x] < 0){
+      printf("negative PrismMap value in MakeLocalMetData.c\n");
+      exit(0);
+    }
+  }
+}
+
+static void OutsidePrismPrecip(int y, int x, MAPSIZE *Map, int NStats,
+                               METLOCATION *Stat, uchar *MetWeights,
+                               float LocalElev, PRECIPPIX *PrecipMap,
+                               MAPSIZE *Radar, RADARPIX **RadarMap,
+                               float **PrismMap, float **PrecipLapseMap,
+                               float precipMultiplier, int Month)
+{
+  float CurrentWeight;		/* weight for current station */
+  float WeightSum;		/* sum of the weights */
+  int i;
+
+  WeightSum = SumWeights(NStats, MetWeights);
+  PrecipMap->Precip = 0.0;
+  for (i = 0; i < NStats; i++) {
+    CurrentWeight = ((float) MetWeights[i]) / WeightSum;
+    PrecipMap->Precip += CurrentWeight * Stat[i].Data.Precip /
+      Stat[i].PrismPrecip[Month - 1] * PrismMap[y][x];
+    if (PrismMap[y][x] < 0){
+      printf("negative PrismMap value in MakeLocalMetData.c\n");
+      exit(0);
+    }
+  }
+}
+
+/*****************************************************************************
+Function name: SumWeights()
+
+Purpose      : Sum of the interpolation weights of the met stations
+*****************************************************************************/
+static float SumWeights(int NStats, uchar *MetWeights)
+{
+  float WeightSum = 0.0;
+  int i;
+
+  for (i = 0; i < NStats; i++)
+    WeightSum += (float) MetWeights[i];
+
+  return WeightSum;
+}
@@ -39,52 +39,52 @@
 *****************************************************************************/
 void MassBalance(DATE *Current, DATE *Start, FILES *Out, AGGREGATED *Total, WATERBALANCE *Mass)
 {
-  float NewWaterStorage;	/* water storage at the end of the time step */
-  float Output;			/* total water flux leaving the basin;  */
-  float Input;
-  float MassError;		/* mass balance error m  */
+  double NewWaterStorage;	/* water storage at the end of the time step */
+  double Output;			/* total water flux leaving the basin;  */
+  double Input;
+  double MassError;		/* mass balance error m  */
 
-  float deltaSWE;       /* change of SWE from last time step */
-  float NetWaterIn1;    /* incoming water to the soil (precip-deltaSWE+SnowVaporFlux) */
-  float NetWaterIn2;    /* rain or melt */
+  double deltaSWE;       /* change of SWE from last time step */
+  double NetWaterIn1;    /* incoming water to the soil (precip-deltaSWE+SnowVaporFlux) */
+  double NetWaterIn2;    /* rain or melt */
   
   /* Calculate the net water going into the soil column */
   if (IsEqualTime(Current, Start))
     deltaSWE = 0.;
   else
-    deltaSWE = Total->Snow.OldSwq - Total->Snow.Swq; 
-  NetWaterIn1 = Total->Precip.Precip + deltaSWE + Total->Snow.VaporMassFlux; 
+    deltaSWE = Total->Water.OldSwq - Total->Water.Swq;
+  NetWaterIn1 = Total->Water.Precip + deltaSWE + Total->Water.VaporMassFlux;
   
   if (fabs(NetWaterIn1) <= 1.e-12)
     NetWaterIn1 = 0.;
   
   /* 2nd approach */
-  if (Total->Snow.Swq>0|| (Total->Snow.Swq==0 && deltaSWE>0))
-     NetWaterIn2 = Total->Snow.Melt;
+  if (Total->Water.Swq>0|| (Total->Water.Swq==0 && deltaSWE>0))
+     NetWaterIn2 = Total->Water.Melt;
   else
-     NetWaterIn2 = Total->Precip.Precip - Total->Precip.SnowFall;
+     NetWaterIn2 = Total->Water.Precip - Total->Water.SnowFall;
  
-  NewWaterStorage = Total->Soil.IExcess + Total->Road.IExcess + 
+  NewWaterStorage = Total->Water.IExcess + Total->Water.RoadIExcess + 
     Total->CanopyWater + Total->SoilWater +
-    Total->Snow.Swq + Total->Soil.SatFlow + Total->Soil.DetentionStorage;
+    Total->Water.Swq + Total->Water.SatFlow + Total->Water.DetentionStorage;
 
-  Output = Total->ChannelInt + Total->RoadInt + Total->Evap.ETot;
-  Input = Total->Precip.Precip + Total->Snow.VaporMassFlux +
-    Total->Snow.CanopyVaporMassFlux + Total->CulvertReturnFlow;
+  Output = Total->ChannelInt + Total->RoadInt + Total->Water.ETot;
+  Input = Total->Water.Precip + Total->Water.VaporMassFlux +
+    Total->Water.CanopyVaporMassFlux + Total->CulvertReturnFlow;
 
   MassError = (NewWaterStorage - Mass->OldWaterStorage) + Output -
-    Total->Precip.Precip - Total->Snow.VaporMassFlux -
-    Total->Snow.CanopyVaporMassFlux - Total->CulvertReturnFlow;
+    Total->Water.Precip - Total->Water.VaporMassFlux -
+    Total->Water.CanopyVaporMassFlux - Total->CulvertReturnFlow;
 
   /* update */
   Mass->OldWaterStorage = NewWaterStorage;
-  Mass->CumPrecipIn += Total->Precip.Precip;
-  Mass->CumIExcess += Total->Soil.IExcess;
+  Mass->CumPrecipIn += Total->Water.Precip;
+  Mass->CumIExcess += Total->Water.IExcess;
   Mass->CumChannelInt += Total->ChannelInt;
   Mass->CumRoadInt += Total->RoadInt;
-  Mass->CumET += Total->Evap.ETot;
-  Mass->CumSnowVaporFlux += Total->Snow.VaporMassFlux +
-    Total->Snow.CanopyVaporMassFlux;
+  Mass->CumET += Total->Water.ETot;
+  Mass->CumSnowVaporFlux += Total->Water.VaporMassFlux +
+    Total->Water.CanopyVaporMassFlux;
   Mass->CumCulvertReturnFlow += Total->CulvertReturnFlow;
   Mass->CumCulvertToChannel += Total->CulvertToChannel;
   
@@ -107,12 +107,13 @@ void MassBalance(DATE *Current, DATE *Start, FILES *Out, AGGREGATED *Total, WATE
   }
   PrintDate(Current, Out->FilePtr);
   fprintf(Out->FilePtr, " %g %g %g %g %g %g %g %g %g %g %g %g \
-      %g %g %g %g %g %g %g %g %g %g %g\n", NetWaterIn1*1000, NetWaterIn2*1000, 
-      Total->Precip.Precip, Total->Precip.SnowFall, Total->Soil.IExcess,
-      Total->Snow.Swq, Total->Snow.Melt, Total->Evap.ETot, 
-      Total->CanopyWater, Total->SoilWater, Total->Soil.SatFlow, Total->Snow.VaporMassFlux,
-      Total->Snow.CanopyVaporMassFlux, Total->ChannelInt,  Total->RoadInt, Total->CulvertToChannel, 
+      %g %g %g %g %g %g %g %g %g %g %.10g\n", NetWaterIn1*1000, NetWaterIn2*1000, 
+      Total->Water.Precip, Total->Water.SnowFall, Total->Water.IExcess,
+      Total->Water.Swq, Total->Water.Melt, Total->Water.ETot, 
+      Total->CanopyWater, Total->SoilWater, Total->Water.SatFlow, Total->Water.VaporMassFlux,
+      Total->Water.CanopyVaporMassFlux, Total->ChannelInt,  Total->RoadInt, Total->CulvertToChannel, 
       Total->Rad.BeamIn+Total->Rad.DiffuseIn, Total->Rad.PixelNetShort, 
       Total->Rad.NetShort[0], Total->Rad.NetShort[1], Total->NetRad, Total->Rad.Tair, MassError);
+  Total->Water.OldSwq = Total->Water.Swq;
   Total->Snow.OldSwq = Total->Snow.Swq;
 }
@@ -9,6 +9,7 @@
  * DESCRIPTION:  Calculate mass and energy balance at each pixel
  * DESCRIP-END.
  * FUNCTIONS:    MassEnergyBalance()
+ *               ReportMassEnergyPaths()
  * COMMENTS:
  * $Id: MassEnergyBalance.c,v3.1.2 2013/08/18 ning Exp $
  */
@@ -30,6 +31,12 @@
 #include "soilmoisture.h"
 #include "Calendar.h"
 
+/* number of pixel time steps that took each path through
+   MassEnergyBalance(), reported by ReportMassEnergyPaths() */
+enum { PATH_PIXELS, PATH_NOSHORT, PATH_NOSNOWINT, PATH_NOSNOW,
+  PATH_GAP, PATH_GAPNOSNOW, NPATHS };
+static unsigned long PathCount[NPATHS];
+
  /*****************************************************************************
    Function name: MassEnergyBalance()
 
@@ -100,6 +107,8 @@ void MassEnergyBalance(OPTIONSTRUCT *Options, int y, int x,
   double Tmp;			    /* Temporary value */
   float Ls;			        /* Latent heat of sublimation (J/kg) */
 
+  PathCount[PATH_PIXELS]++;
+
   /* Edited by Zhuoran Duan zhuoran.duan@pnnl.gov 06/21/2006*/
   /*Add a function to modify soil moisture by add/extract SatFlow from previous time step*/
   DistributeSatflow(Dt, DX, DY, LocalSoil->SatFlow, SType->NLayers,
@@ -142,7 +151,12 @@ void MassEnergyBalance(OPTIONSTRUCT *Options, int y, int x,
   LocalVeg->MeltEnergy = 0.0;
   LocalVeg->MoistureFlux = 0.0;
 
-  /* calculate the radiation balance for pixels */
+  /* calculate the radiation balance for pixels. Without any incoming
+     shortwave (night, or shaded) only the longwave balance is calculated,
+     here and for the gap */
+  if (LocalMet->Sin == 0. && LocalMet->SinBeam == 0. &&
+    LocalMet->SinDiffuse == 0.)
+    PathCount[PATH_NOSHORT]++;
   RadiationBalance(Options, HeatFluxOption, CanopyRadAttOption,
     VType->OverStory, VType->UnderStory, SineSolarAltitude,
     LocalMet->VICSin, LocalMet->Sin, LocalMet->SinBeam,
@@ -215,6 +229,7 @@ void MassEnergyBalance(OPTIONSTRUCT *Options, int y, int x,
   }
   /* if no snow */
   else if (VType->NVegLayers > 0) {
+    PathCount[PATH_NOSNOWINT]++;
     LocalVeg->Tcanopy = LocalMet->Tair;
     LocalSnow->CanopyVaporMassFlux = 0.0;
     LocalPrecip->TempIntStorage = 0.0;
@@ -293,6 +308,7 @@ void MassEnergyBalance(OPTIONSTRUCT *Options, int y, int x,
       LocalVeg->Vf, LocalMet->Lin, LocalVeg->Tcanopy, Tsurf, LocalRad);
   }
   else {
+    PathCount[PATH_NOSNOW]++;
     LocalSnow->Outflow = 0.0;
     LocalSnow->VaporMassFlux = 0.0;
     LocalSnow->Qe = 0.;
@@ -321,6 +337,10 @@ void MassEnergyBalance(OPTIONSTRUCT *Options, int y, int x,
 
   /************ if canopy gap is present *************/
   if (LocalVeg->Gapping > 0.0) {
+    PathCount[PATH_GAP]++;
+    if (LocalVeg->Type[Opening].HasSnow != TRUE &&
+      LocalVeg->Type[Forest].HasSnow != TRUE && LocalPrecip->SnowFall == 0.)
+      PathCount[PATH_GAPNOSNOW]++;
 
     /* calculate intercept rain/snow */
     CanopyGapInterception(Options, &(LocalVeg->Type), HeatFluxOption, y, x,
@@ -544,7 +564,7 @@ void MassEnergyBalance(OPTIONSTRUCT *Options, int y, int x,
   UnsaturatedFlow(Dt, DX, DY, Infiltration, RoadbedInfiltration,
     LocalSoil->SatFlow, SType->NLayers, LocalSoil->Depth,
     LocalNetwork->Area, VType->RootDepth, SType->Ks,
-    SType->PoreDist, LocalSoil->Porosity, LocalSoil->FCap, LocalSoil->Perc,
+    SType->PoreDist, SType->DrainTable, LocalSoil->Porosity, LocalSoil->FCap, LocalSoil->Perc,
     LocalNetwork->PercArea, LocalNetwork->Adjust, LocalNetwork->CutBankZone,
     LocalNetwork->BankHeight, &(LocalSoil->TableDepth), &(LocalSoil->IExcess),
     LocalSoil->Moist, InfiltOption);
@@ -587,3 +607,31 @@ void MassEnergyBalance(OPTIONSTRUCT *Options, int y, int x,
       channel_grid_inc_other(ChannelData->stream_map, x, y, LocalRad, LocalMet, skyview[y][x]);
   }
 }
+
+/*****************************************************************************
+  Function name: ReportMassEnergyPaths()
+
+  Purpose      : Report how often the paths through MassEnergyBalance() that
+                 skip the shortwave, snow interception and snow pack
+                 calculations were taken, and reset the counts
+
+  Returns      : void
+*****************************************************************************/
+void ReportMassEnergyPaths(void)
+{
+  int i;
+
+  if (PathCount[PATH_PIXELS] == 0)
+    return;
+
+  printf("\n****Mass and Energy Balance****\n");
+  printf("%lu pixel time steps\n", PathCount[PATH_PIXELS]);
+  printf("%lu without incoming shortwave\n", PathCount[PATH_NOSHORT]);
+  printf("%lu with rain interception only\n", PathCount[PATH_NOSNOWINT]);
+  printf("%lu without a snow pack\n", PathCount[PATH_NOSNOW]);
+  printf("%lu with a canopy gap, %lu of them without snow\n\n",
+    PathCount[PATH_GAP], PathCount[PATH_GAPNOSNOW]);
+
+  for (i = 0; i < NPATHS; i++)
+    PathCount[i] = 0;
+}
@@ -0,0 +1,218 @@
+/*
+ * SUMMARY:      MonthlyMaps.c - Monthly PRISM and shade maps
+ * USAGE:        Part of DHSVM
+ *
+ * DESCRIPTION:  The PRISM precipitation maps and the shade maps change at
+ *               the start of each month.  Each month read is kept in a
+ *               slot:  PrismMap and ShadowMap point at the slot of the
+ *               current month, so a month that is still in memory is not
+ *               read again.  With MONTHLY MAP CACHE = ALL every month of the
+ *               run is read at the start, with n at most n months are
+ *               kept and the least recently used one is replaced, with
+ *               NONE (the default) the maps are read every month.
+ * DESCRIP-END.
+ * FUNCTIONS:    InitMonthlyMaps()
+ *               SetMonthlyMaps()
+ * COMMENTS:
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "settings.h"
+#include "data.h"
+#include "DHSVMerror.h"
+#include "functions.h"
+#include "fileio.h"
+#include "sizeofnt.h"
+#include "varid.h"
+
+#define MAXSLOTS 12
+
+static int NSlots = 0;
+static int SlotMonth[MAXSLOTS];		/* month in each slot, 0 if empty */
+static unsigned long SlotUsed[MAXSLOTS];	/* last use of each slot */
+static unsigned long Clock = 0;
+static float *PrismData[MAXSLOTS];	/* PRISM map of each slot, north to
+					   south */
+
+static int MonthSlot(int Month, int *Load);
+static void LoadMonth(int Month, int Slot, TIMESTRUCT *Time,
+		      OPTIONSTRUCT *Options, MAPSIZE *Map);
+
+/*****************************************************************************
+  InitMonthlyMaps()
+
+  Allocates the slots and, with MONTHLY MAP CACHE = ALL, reads the maps of
+  all months of the run.  Called after the PRISM and shade maps have been
+  allocated.
+*****************************************************************************/
+void InitMonthlyMaps(TIMESTRUCT *Time, OPTIONSTRUCT *Options, MAPSIZE *Map)
+{
+  const char *Routine = "InitMonthlyMaps";
+  int Load;
+  int Month;
+  int Year;
+  int Slot;
+  int n;
+
+  if (Options->Prism != TRUE && Options->Shading != TRUE)
+    return;
+
+  NSlots = Options->MonthlyCache > 0 ? Options->MonthlyCache : 1;
+  Clock = 0;
+  for (Slot = 0; Slot < MAXSLOTS; Slot++) {
+    SlotMonth[Slot] = 0;
+    SlotUsed[Slot] = 0;
+    free(PrismData[Slot]);
+    PrismData[Slot] = NULL;
+    if (Slot < NSlots && Options->Prism == TRUE &&
+	!(PrismData[Slot] = (float *) calloc(Map->NY * Map->NX, sizeof(float))))
+      ReportError((char *) Routine, 1);
+  }
+
+  if (Options->MonthlyCache != MAXSLOTS)
+    return;
+
+  Month = Time->Start.Month;
+  Year = Time->Start.Year;
+  for (n = 0; n < MAXSLOTS && (Year < Time->End.Year ||
+			       (Year == Time->End.Year &&
+				Month <= Time->End.Month)); n++) {
+    Slot = MonthSlot(Month, &Load);
+    LoadMonth(Month, Slot, Time, Options, Map);
+    if (++Month > 12) {
+      Month = 1;
+      Year++;
+    }
+  }
+}
+
+/*****************************************************************************
+  SetMonthlyMaps()
+
+  Points PrismMap and ShadowMap at the maps of the current month, reading
+  them if they are not in memory.
+*****************************************************************************/
+void SetMonthlyMaps(TIMESTRUCT *Time, OPTIONSTRUCT *Options, MAPSIZE *Map,
+		    float **PrismMap, unsigned char ***ShadowMap)
+{
+  int Load;
+  int Slot;
+  int y;
+
+  Slot = MonthSlot(Time->Current.Month, &Load);
+  if (Load || Options->MonthlyCache == 0)
+    LoadMonth(Time->Current.Month, Slot, Time, Options, Map);
+
+  if (Options->Prism == TRUE)
+    for (y = 0; y < Map->NY; y++)
+      PrismMap[y] = PrismData[Slot] + y * Map->NX;
+  if (Options->Shading == TRUE)
+    UseShadeSlot(ShadowMap, Time->NDaySteps, Slot);
+}
+
+/*****************************************************************************
+  MonthSlot()
+
+  Returns the slot of Month, or the least recently used slot with Load set
+  if the month is not in memory.
+*****************************************************************************/
+static int MonthSlot(int Month, int *Load)
+{
+  int Slot;
+  int i;
+
+  for (Slot = 0; Slot < NSlots; Slot++)
+    if (SlotMonth[Slot] == Month)
+      break;
+
+  *Load = (Slot == NSlots);
+  if (*Load) {
+    for (i = 1, Slot = 0; i < NSlots; i++)
+      if (SlotUsed[i] < SlotUsed[Slot])
+	Slot = i;
+    SlotMonth[Slot] = Month;
+  }
+  SlotUsed[Slot] = ++Clock;
+
+  return Slot;
+}
+
+/*****************************************************************************
+  LoadMonth()
+
+  Reads the PRISM and shade maps of Month into Slot.
+*****************************************************************************/
+static void LoadMonth(int Month, int Slot, TIMESTRUCT *Time,
+		      OPTIONSTRUCT *Options, MAPSIZE *Map)
+{
+  const char *Routine = "LoadMonth";
+  char FileName[MAXSTRING + 1];
+  char VarName[BUFSIZE + 1];	/* Variable name */
+  int NCells = Map->NY * Map->NX;
+  int NumberType;
+  int Mapped;
+  int flag;
+  int jj;
+  int y;
+  float *Array = NULL;
+  unsigned char *Array1 = NULL;
+  unsigned char *Slice;
+
+  if (Options->Prism == TRUE) {
+    printf("reading in new PRISM field for month %d \n", Month);
+    if (snprintf(FileName, sizeof(FileName), "%s.%02d.%s",
+		 Options->PrismDataPath, Month, Options->PrismDataExt) >=
+	(int) sizeof(FileName))
+      ReportError(Options->PrismDataPath, 72);
+    GetVarName(205, 0, VarName);
+    GetVarNumberType(205, &NumberType);
+    /* binary files are read in place from the mapped file */
+    if ((Array = (float *) Map2DMatrix(FileName, NumberType, Map, 0)) != NULL)
+      memcpy(PrismData[Slot], Array, NCells * sizeof(float));
+    else {
+      /* NetCDF, flag tells whether the rows are stored south to north */
+      if (!(Array = (float *) calloc(NCells, sizeof(float))))
+	ReportError((char *) Routine, 1);
+      flag = Read2DMatrix(FileName, Array, NumberType, Map, 0, VarName, 0);
+      if (flag == 0)
+	memcpy(PrismData[Slot], Array, NCells * sizeof(float));
+      else if (flag == 1) {
+	for (y = 0; y < Map->NY; y++)
+	  memcpy(PrismData[Slot] + (Map->NY - 1 - y) * Map->NX,
+		 Array + y * Map->NX, Map->NX * sizeof(float));
+      }
+      else
+	ReportError((char *) Routine, 57);
+      free(Array);
+    }
+  }
+
+  if (Options->Shading == TRUE) {
+    printf("reading in new shadow map for month %d \n", Month);
+    if (snprintf(FileName, sizeof(FileName), "%s.%02d.%s",
+		 Options->ShadingDataPath, Month, Options->ShadingDataExt) >=
+	(int) sizeof(FileName))
+      ReportError(Options->ShadingDataPath, 72);
+    GetVarName(304, 0, VarName);
+    GetVarNumberType(304, &NumberType);
+    /* binary shade files are read in place, one mapping for all maps */
+    Mapped = (Map2DMatrix(FileName, NumberType, Map, 0) != NULL);
+    if (!Mapped &&
+	!(Array1 = (unsigned char *) calloc(NCells, sizeof(unsigned char))))
+      ReportError((char *) Routine, 1);
+    /* one map per hour, shared by the time steps of that hour */
+    for (jj = 0; jj < NShadeSlices(Time->NDaySteps); jj++) {
+      if (Mapped)
+	Slice = (unsigned char *) Map2DMatrix(FileName, NumberType, Map, jj);
+      else {
+	Read2DMatrix(FileName, Array1, NumberType, Map, jj, VarName, jj);
+	Slice = Array1;
+      }
+      StoreShadeSlice(Slot, jj, Slice);
+    }
+    if (!Mapped)
+      free(Array1);
+  }
+}
@@ -0,0 +1,802 @@
+/*
+ * SUMMARY:      PixelSeries.c - Pixel dumps in one shared file
+ * USAGE:        Part of DHSVM
+ *
+ * DESCRIPTION:  Instead of one Pixel.<name> text file per dump location,
+ *               the selected variables of all dump pixels are gathered in a
+ *               (time, pixel, variable) buffer of 4-byte reals that is
+ *               written every few time steps with a single fwrite() to
+ *               Pixel.Series.bin, or with a single nc_put_vara_float() to
+ *               Pixel.Series.nc.  The variables are chosen per run in the
+ *               [OUTPUT] section.  With a PIXEL DUMP STATISTIC the time
+ *               steps are reduced in memory and only one record per
+ *               PIXEL DUMP INTERVAL is written.
+ * DESCRIP-END.
+ * FUNCTIONS:    InitPixSeries()
+ *               DumpPixSeries()
+ *               EndPixSeriesRecord()
+ *               ClosePixSeries()
+ * COMMENTS:     Pixel.Series describes the binary file:  the variable of
+ *               each column, the pixel of each row and the date of each
+ *               record.  Layers a pixel does not have are set to NA.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef HAVE_NETCDF
+#include <netcdf.h>
+#endif
+#include "settings.h"
+#include "data.h"
+#include "DHSVMerror.h"
+#include "fileio.h"
+#include "functions.h"
+#include "constants.h"
+#include "Calendar.h"
+
+/* the pixel variables, in the column order of the Pixel.<name> files */
+typedef enum {
+  PixW, PixPrecip, PixSnowFall, PixIExcess, PixHasSnow, PixSnowCover,
+  PixLastSnow, PixSwq, PixMelt, PixPackWater, PixTPack, PixTotalET,
+  PixPotTransp, PixActTransp, PixEvapCanopyInt, PixActTranspSoil, PixSoilEvap,
+  PixIntRain, PixIntSnow, PixSoilMoist, PixPerc, PixTableDepth, PixSatFlow,
+  PixDetentionStorage, PixNetShort, PixLongIn, PixPixelNetShort, PixTSurf,
+  PixSoilQnet, PixSoilQs, PixSoilQe, PixSoilQg, PixSoilQst, PixRa,
+  PixSnowQsw, PixSnowQlw, PixSnowQs, PixSnowQe, PixSnowQp, PixSnowMeltEnergy,
+  PixGapSwq, PixGapQsw, PixGapQlin, PixGapQlw, PixGapQs, PixGapQe, PixGapQp,
+  PixGapMeltEnergy, PixTair, PixInfiltAcc, PixGapNetShort, PixGapLongIn,
+  NPIXVARS
+} PIXVAR;
+
+/* layering of a variable */
+enum { Scalar, Story, Canopy, CanopySoil, SoilPlus, SoilLayer };
+
+/* options a variable depends on */
+enum { Always, HeatFlux, Gap, Dynamic };
+
+static const struct {
+  const char *Name;
+  const char *Units;
+  int Layers;
+  int Requires;
+} PixVar[NPIXVARS] = {
+  {"W", "mm", Scalar, Always},
+  {"Precip", "m", Scalar, Always},
+  {"Snow", "m", Scalar, Always},
+  {"IExcess", "m", Scalar, Always},
+  {"HasSnow", "-", Scalar, Always},
+  {"SnowCover", "-", Scalar, Always},
+  {"LastSnow", "days", Scalar, Always},
+  {"Swq", "m", Scalar, Always},
+  {"Melt", "m", Scalar, Always},
+  {"PackWater", "m", Scalar, Always},
+  {"TPack", "C", Scalar, Always},
+  {"TotalET", "m", Scalar, Always},
+  {"PotTransp", "m", Story, Always},
+  {"ActTransp", "m", Story, Always},
+  {"EvapCanopyInt", "m", Canopy, Always},
+  {"ActTranspSoil", "m", CanopySoil, Always},
+  {"SoilEvap", "m", Scalar, Always},
+  {"IntRain", "m", Canopy, Always},
+  {"IntSnow", "m", Canopy, Always},
+  {"SoilMoist", "-", SoilPlus, Always},
+  {"Perc", "m", SoilLayer, Always},
+  {"TableDepth", "m", Scalar, Always},
+  {"SatFlow", "m", Scalar, Always},
+  {"DetentionStorage", "m", Scalar, Always},
+  {"NetShort", "W/m2", Story, Always},
+  {"LongIn", "W/m2", Story, Always},
+  {"PixelNetShort", "W/m2", Scalar, Always},
+  {"TSurf", "C", Scalar, HeatFlux},
+  {"Soil.Qnet", "W/m2", Scalar, Always},
+  {"Soil.Qs", "W/m2", Scalar, Always},
+  {"Soil.Qe", "W/m2", Scalar, Always},
+  {"Soil.Qg", "W/m2", Scalar, Always},
+  {"Soil.Qst", "W/m2", Scalar, Always},
+  {"Ra", "s/m", Scalar, Always},
+  {"Snow.Qsw", "W/m2", Scalar, Always},
+  {"Snow.Qlw", "W/m2", Scalar, Always},
+  {"Snow.Qs", "W/m2", Scalar, Always},
+  {"Snow.Qe", "W/m2", Scalar, Always},
+  {"Snow.Qp", "W/m2", Scalar, Always},
+  {"Snow.MeltEnergy", "W/m2", Scalar, Always},
+  {"Gap.SWE", "m", Scalar, Gap},
+  {"Gap.Qsw", "W/m2", Scalar, Gap},
+  {"Gap.Qlin", "W/m2", Scalar, Gap},
+  {"Gap.Qlw", "W/m2", Scalar, Gap},
+  {"Gap.Qs", "W/m2", Scalar, Gap},
+  {"Gap.Qe", "W/m2", Scalar, Gap},
+  {"Gap.Qp", "W/m2", Scalar, Gap},
+  {"Gap.MeltEnergy", "W/m2", Scalar, Gap},
+  {"Tair", "C", Scalar, Always},
+  {"InfiltAcc", "m", Scalar, Dynamic},
+  {"Gap_SW", "W/m2", Scalar, Gap},
+  {"Gap_LW", "W/m2", Scalar, Gap}
+};
+
+struct _PIXSERIES {
+  int Format;			/* BIN or NETCDF */
+  int NPix;			/* Number of dump pixels */
+  int NCols;			/* Number of variable columns */
+  int MaxSoil;			/* Soil layers per story in the columns */
+  int *ColVar;			/* Variable of each column */
+  int *ColLayer;		/* Layer (or story * MaxSoil + soil) of each column */
+  int Statistic;		/* 0 for every time step, else DUMP_MEAN, ... */
+  int Interval;			/* Aggregation period in seconds or DUMP_MONTH */
+  int Dt;			/* Model time step in seconds */
+  int NSteps;			/* Time steps accumulated in the period */
+  float *Step;			/* NPix x NCols values of an aggregated time step */
+  double *Acc;			/* NPix x NCols running statistic */
+  int NFlush;			/* Number of records buffered before writing */
+  int NBuffered;		/* Number of records in the buffer */
+  float *Buffer;		/* NFlush x NPix x NCols values */
+  DATE *Dates;			/* Date of each buffered record */
+  DATE First;			/* Date of the first record */
+  size_t NRecords;		/* Number of records written */
+  char FileName[BUFSIZE + 1];
+  FILE *Index;			/* Pixel.Series */
+  FILE *Out;			/* Pixel.Series.bin */
+  int ncid;			/* Pixel.Series.nc */
+  int TimeVarID;
+  int ValueVarID;
+};
+
+static int NumberOfLayers(int Layers, int NSoil, int NCanopyStory);
+static void ColumnName(PIXSERIES *Series, int Col, char *Name);
+static void FlushPixSeries(PIXSERIES *Series);
+#ifdef HAVE_NETCDF
+static void pixseries_check_nc(int ncstatus, char *FileName);
+#endif
+
+/*******************************************************************************
+  Function name: InitPixSeries()
+
+  Purpose      : Select the variable columns, allocate the record buffer and
+                 create Pixel.Series and Pixel.Series.bin, or Pixel.Series.nc
+
+  Required     :
+    char *Path            - Directory to write output to
+    int Format            - BIN or NETCDF
+    char *Variables       - ALL or a list of variable names
+    int NFlush            - Number of records between writes
+    int Statistic         - 0, or DUMP_MEAN, DUMP_SUM, DUMP_MIN or DUMP_MAX
+                            of the time steps of each record
+    int Interval          - Period of a record in seconds, or DUMP_MONTH
+    int Dt                - Model time step in seconds
+    int NPix              - Number of dump pixels
+    PIXDUMP *Pix          - Dump pixels
+    int MaxSoilLayers     - Maximum number of soil layers
+    int MaxVegLayers      - Maximum number of vegetation layers
+    OPTIONSTRUCT *Options - Mode options
+
+  Returns      : PIXSERIES * - the pixel series
+
+  Comments     :
+*******************************************************************************/
+PIXSERIES *InitPixSeries(char *Path, int Format, char *Variables, int NFlush,
+  int Statistic, int Interval, int Dt, int NPix, PIXDUMP *Pix,
+  int MaxSoilLayers, int MaxVegLayers, OPTIONSTRUCT *Options)
+{
+  char *Routine = "InitPixSeries";
+  char Str[BUFSIZE + 1];
+  char Name[BUFSIZE + 1];
+  char *Token;
+  int Selected[NPIXVARS];
+  int Available[NPIXVARS];
+  int i;
+  int k;
+  int n;
+  PIXSERIES *Series;
+#ifdef HAVE_NETCDF
+  int dimids[3];
+  int strdim;
+  int VarID[5];
+  size_t NameLen;
+  size_t start[2];
+  size_t count[2];
+  float missing = NA;
+#endif
+
+  if (!(Series = (PIXSERIES *) calloc(1, sizeof(PIXSERIES))))
+    ReportError(Routine, 1);
+  Series->Format = Format;
+  Series->NPix = NPix;
+  Series->MaxSoil = MaxSoilLayers;
+  Series->NFlush = NFlush;
+  Series->Statistic = Statistic;
+  Series->Interval = Interval;
+  Series->Dt = Dt;
+
+  /* the variables that exist with the current options */
+  for (i = 0; i < NPIXVARS; i++) {
+    switch (PixVar[i].Requires) {
+    case HeatFlux:
+      Available[i] = Options->HeatFlux;
+      break;
+    case Gap:
+      Available[i] = (TotNumGap > 0);
+      break;
+    case Dynamic:
+      Available[i] = (Options->Infiltration == DYNAMIC);
+      break;
+    default:
+      Available[i] = TRUE;
+      break;
+    }
+    Selected[i] = FALSE;
+  }
+
+  strcpy(Str, Variables);
+  for (Token = strtok(Str, " ,\t"); Token != NULL; Token = strtok(NULL, " ,\t")) {
+    if (strcmp(Token, "ALL") == 0) {
+      for (i = 0; i < NPIXVARS; i++)
+        Selected[i] = Available[i];
+      continue;
+    }
+    for (i = 0; i < NPIXVARS; i++)
+      if (strcmp(Token, PixVar[i].Name) == 0)
+        break;
+    if (i == NPIXVARS || !Available[i])
+      ReportError(Token, 51);
+    Selected[i] = TRUE;
+  }
+
+  /* one column per layer, sized for the largest soil and vegetation */
+  for (i = 0; i < NPIXVARS; i++)
+    if (Selected[i])
+      Series->NCols += NumberOfLayers(PixVar[i].Layers, MaxSoilLayers,
+        MaxVegLayers);
+  if (Series->NCols == 0)
+    ReportError("PIXEL DUMP VARIABLES", 51);
+
+  if (!(Series->ColVar = (int *) calloc(Series->NCols, sizeof(int))))
+    ReportError(Routine, 1);
+  if (!(Series->ColLayer = (int *) calloc(Series->NCols, sizeof(int))))
+    ReportError(Routine, 1);
+  for (i = 0, n = 0; i < NPIXVARS; i++) {
+    if (Selected[i]) {
+      for (k = 0; k < NumberOfLayers(PixVar[i].Layers, MaxSoilLayers,
+        MaxVegLayers); k++, n++) {
+        Series->ColVar[n] = i;
+        Series->ColLayer[n] = k;
+      }
+    }
+  }
+
+  if (!(Series->Buffer = (float *) calloc((size_t) NFlush * NPix * Series->NCols,
+    sizeof(float))))
+    ReportError(Routine, 1);
+  if (!(Series->Dates = (DATE *) calloc(NFlush, sizeof(DATE))))
+    ReportError(Routine, 1);
+  if (Statistic) {
+    if (!(Series->Step = (float *) calloc((size_t) NPix * Series->NCols,
+      sizeof(float))))
+      ReportError(Routine, 1);
+    if (!(Series->Acc = (double *) calloc((size_t) NPix * Series->NCols,
+      sizeof(double))))
+      ReportError(Routine, 1);
+  }
+
+  if (Format == NETCDF) {
+#ifdef HAVE_NETCDF
+    NameLen = 1;
+    for (i = 0; i < NPix; i++)
+      if (strlen(Pix[i].Name) + 1 > NameLen)
+        NameLen = strlen(Pix[i].Name) + 1;
+    for (n = 0; n < Series->NCols; n++) {
+      ColumnName(Series, n, Name);
+      if (strlen(Name) + 1 > NameLen)
+        NameLen = strlen(Name) + 1;
+    }
+
+    sprintf(Series->FileName, "%sPixel.Series.nc", Path);
+    pixseries_check_nc(nc_create(Series->FileName, NC_CLOBBER | NC_NETCDF4,
+      &(Series->ncid)), Series->FileName);
+    pixseries_check_nc(nc_def_dim(Series->ncid, "time", NC_UNLIMITED,
+      &dimids[0]), Series->FileName);
+    pixseries_check_nc(nc_def_dim(Series->ncid, "pixel", NPix, &dimids[1]),
+      Series->FileName);
+    pixseries_check_nc(nc_def_dim(Series->ncid, "variable", Series->NCols,
+      &dimids[2]), Series->FileName);
+    pixseries_check_nc(nc_def_dim(Series->ncid, "name_strlen", NameLen,
+      &strdim), Series->FileName);
+    pixseries_check_nc(nc_def_var(Series->ncid, "time", NC_DOUBLE, 1, dimids,
+      &(Series->TimeVarID)), Series->FileName);
+    pixseries_check_nc(nc_def_var(Series->ncid, "Pixel", NC_FLOAT, 3, dimids,
+      &(Series->ValueVarID)), Series->FileName);
+    pixseries_check_nc(nc_put_att_float(Series->ncid, Series->ValueVarID,
+      "missing_value", NC_FLOAT, 1, &missing), Series->FileName);
+
+    dimids[0] = dimids[1];
+    dimids[1] = strdim;
+    pixseries_check_nc(nc_def_var(Series->ncid, "pixel_name", NC_CHAR, 2,
+      dimids, &VarID[0]), Series->FileName);
+    pixseries_check_nc(nc_def_var(Series->ncid, "pixel_row", NC_INT, 1,
+      dimids, &VarID[1]), Series->FileName);
+    pixseries_check_nc(nc_def_var(Series->ncid, "pixel_col", NC_INT, 1,
+      dimids, &VarID[2]), Series->FileName);
+    dimids[0] = dimids[2];
+    pixseries_check_nc(nc_def_var(Series->ncid, "variable_name", NC_CHAR, 2,
+      dimids, &VarID[3]), Series->FileName);
+    pixseries_check_nc(nc_def_var(Series->ncid, "variable_units", NC_CHAR, 2,
+      dimids, &VarID[4]), Series->FileName);
+    pixseries_check_nc(nc_enddef(Series->ncid), Series->FileName);
+
+    count[0] = 1;
+    start[1] = 0;
+    for (i = 0; i < NPix; i++) {
+      start[0] = i;
+      count[1] = strlen(Pix[i].Name) + 1;
+      pixseries_check_nc(nc_put_vara_text(Series->ncid, VarID[0], start, count,
+        Pix[i].Name), Series->FileName);
+      pixseries_check_nc(nc_put_var1_int(Series->ncid, VarID[1], start,
+        &(Pix[i].Loc.N)), Series->FileName);
+      pixseries_check_nc(nc_put_var1_int(Series->ncid, VarID[2], start,
+        &(Pix[i].Loc.E)), Series->FileName);
+    }
+    for (n = 0; n < Series->NCols; n++) {
+      start[0] = n;
+      ColumnName(Series, n, Name);
+      count[1] = strlen(Name) + 1;
+      pixseries_check_nc(nc_put_vara_text(Series->ncid, VarID[3], start, count,
+        Name), Series->FileName);
+      count[1] = strlen(PixVar[Series->ColVar[n]].Units) + 1;
+      pixseries_check_nc(nc_put_vara_text(Series->ncid, VarID[4], start, count,
+        PixVar[Series->ColVar[n]].Units), Series->FileName);
+    }
+#else
+    ReportError("PIXEL DUMP FORMAT", 56);
+#endif
+  }
+  else {
+    sprintf(Series->FileName, "%sPixel.Series.bin", Path);
+    OpenFile(&(Series->Out), Series->FileName, "wb", TRUE);
+
+    sprintf(Str, "%sPixel.Series", Path);
+    OpenFile(&(Series->Index), Str, "w", TRUE);
+    fprintf(Series->Index, "# Pixel.Series.bin: 4-byte reals, one record of "
+      "%d pixels x %d variables per date, missing values %d\n", NPix,
+      Series->NCols, NA);
+    fprintf(Series->Index, "# variables (column, name, units)\n%d\n",
+      Series->NCols);
+    for (n = 0; n < Series->NCols; n++) {
+      ColumnName(Series, n, Name);
+      fprintf(Series->Index, "%d %s %s\n", n + 1, Name,
+        PixVar[Series->ColVar[n]].Units);
+    }
+    fprintf(Series->Index, "# pixels (row, name, y, x)\n%d\n", NPix);
+    for (i = 0; i < NPix; i++)
+      fprintf(Series->Index, "%d \"%s\" %d %d\n", i + 1, Pix[i].Name,
+        Pix[i].Loc.N, Pix[i].Loc.E);
+    fprintf(Series->Index, "# dates (one per record)\n");
+  }
+
+  return Series;
+}
+
+/*******************************************************************************
+  Function name: DumpPixSeries()
+
+  Purpose      : Store the selected variables of one pixel in the current
+                 record.  The same values as DumpPix() writes to Pixel.<name>
+
+  Required     :
+    DATE *Current         - Current date
+    int first             - TRUE for the first time step
+    PIXSERIES *Series     - Pixel series
+    int Pixel             - Index of the dump pixel
+    EVAPPIX *Evap ... VEGPIX *Veg - State of the pixel
+    int NSoil             - Number of soil layers of the pixel
+    int NCanopyStory      - Number of vegetation layers of the pixel
+
+  Returns      : void
+
+  Modifies     : Snow->OldSwq
+*******************************************************************************/
+void DumpPixSeries(DATE *Current, int first, PIXSERIES *Series, int Pixel,
+  EVAPPIX *Evap, PRECIPPIX *Precip, PIXRAD *Rad, SNOWPIX *Snow, SOILPIX *Soil,
+  VEGPIX *Veg, int NSoil, int NCanopyStory)
+{
+  float *Value;
+  float W;
+  int k;
+  int n;
+  int story = 0;
+  int layer = 0;
+  int missing;
+
+  /* available water for runoff for NG-IDF */
+  if (first == 1)
+    W = Precip->Precip + Snow->VaporMassFlux;
+  else
+    W = Precip->Precip + (Snow->OldSwq - Snow->Swq) + Snow->VaporMassFlux;
+  if (W <= 1.e-9)
+    W = 0.;
+
+  if (Series->Statistic)
+    Value = Series->Step + (size_t) Pixel * Series->NCols;
+  else
+    Value = Series->Buffer +
+      ((size_t) Series->NBuffered * Series->NPix + Pixel) * Series->NCols;
+
+  for (n = 0; n < Series->NCols; n++) {
+    k = Series->ColLayer[n];
+    if (PixVar[Series->ColVar[n]].Layers == CanopySoil) {
+      /* columns are laid out for the largest soil */
+      story = k / Series->MaxSoil;
+      layer = k % Series->MaxSoil;
+      missing = (story >= NCanopyStory || layer >= NSoil);
+    }
+    else
+      missing = (k >= NumberOfLayers(PixVar[Series->ColVar[n]].Layers, NSoil,
+        NCanopyStory));
+    if (missing) {
+      Value[n] = NA;
+      continue;
+    }
+    switch (Series->ColVar[n]) {
+    case PixW:
+      Value[n] = W * 1000;
+      break;
+    case PixPrecip:
+      Value[n] = Precip->Precip;
+      break;
+    case PixSnowFall:
+      Value[n] = Precip->SnowFall;
+      break;
+    case PixIExcess:
+      Value[n] = Soil->IExcess;
+      break;
+    case PixHasSnow:
+      Value[n] = Snow->HasSnow;
+      break;
+    case PixSnowCover:
+      Value[n] = Snow->SnowCoverOver;
+      break;
+    case PixLastSnow:
+      Value[n] = Snow->LastSnow;
+      break;
+    case PixSwq:
+      Value[n] = Snow->Swq;
+      break;
+    case PixMelt:
+      Value[n] = Snow->Melt;
+      break;
+    case PixPackWater:
+      Value[n] = Snow->PackWater;
+      break;
+    case PixTPack:
+      Value[n] = Snow->TPack;
+      break;
+    case PixTotalET:
+      Value[n] = Evap->ETot;
+      break;
+    case PixPotTransp:
+      Value[n] = Evap->EPot[k];
+      break;
+    case PixActTransp:
+      Value[n] = Evap->EAct[k];
+      break;
+    case PixEvapCanopyInt:
+      Value[n] = Evap->EInt[k];
+      break;
+    case PixActTranspSoil:
+      Value[n] = Evap->ESoil[story][layer];
+      break;
+    case PixSoilEvap:
+      Value[n] = Evap->EvapSoil;
+      break;
+    case PixIntRain:
+      Value[n] = Precip->IntRain[k];
+      break;
+    case PixIntSnow:
+      Value[n] = Precip->IntSnow[k];
+      break;
+    case PixSoilMoist:
+      Value[n] = Soil->Moist[k];
+      break;
+    case PixPerc:
+      Value[n] = Soil->Perc[k];
+      break;
+    case PixTableDepth:
+      Value[n] = Soil->TableDepth;
+      break;
+    case PixSatFlow:
+      Value[n] = Soil->SatFlow;
+      break;
+    case PixDetentionStorage:
+      Value[n] = Soil->DetentionStorage;
+      break;
+    case PixNetShort:
+      Value[n] = Rad->NetShort[k];
+      break;
+    case PixLongIn:
+      Value[n] = Rad->LongIn[k];
+      break;
+    case PixPixelNetShort:
+      Value[n] = Rad->PixelNetShort;
+      break;
+    case PixTSurf:
+      Value[n] = Soil->TSurf;
+      break;
+    case PixSoilQnet:
+      Value[n] = Soil->Qnet;
+      break;
+    case PixSoilQs:
+      Value[n] = Soil->Qs;
+      break;
+    case PixSoilQe:
+      Value[n] = Soil->Qe;
+      break;
+    case PixSoilQg:
+      Value[n] = Soil->Qg;
+      break;
+    case PixSoilQst:
+      Value[n] = Soil->Qst;
+      break;
+    case PixRa:
+      Value[n] = Soil->Ra;
+      break;
+    case PixSnowQsw:
+      Value[n] = Snow->Qsw;
+      break;
+    case PixSnowQlw:
+      Value[n] = Snow->Qlw;
+      break;
+    case PixSnowQs:
+      Value[n] = Snow->Qs;
+      break;
+    case PixSnowQe:
+      Value[n] = Snow->Qe;
+      break;
+    case PixSnowQp:
+      Value[n] = Snow->Qp;
+      break;
+    case PixSnowMeltEnergy:
+      Value[n] = Snow->MeltEnergy;
+      break;
+    case PixGapSwq:
+      Value[n] = Veg->Type[Opening].Swq;
+      break;
+    case PixGapQsw:
+      Value[n] = Veg->Type[Opening].Qsw;
+      break;
+    case PixGapQlin:
+      Value[n] = Veg->Type[Opening].Qlin;
+      break;
+    case PixGapQlw:
+      Value[n] = Veg->Type[Opening].Qlw;
+      break;
+    case PixGapQs:
+      Value[n] = Veg->Type[Opening].Qs;
+      break;
+    case PixGapQe:
+      Value[n] = Veg->Type[Opening].Qe;
+      break;
+    case PixGapQp:
+      Value[n] = Veg->Type[Opening].Qp;
+      break;
+    case PixGapMeltEnergy:
+      Value[n] = Veg->Type[Opening].MeltEnergy;
+      break;
+    case PixTair:
+      Value[n] = Rad->Tair;
+      break;
+    case PixInfiltAcc:
+      Value[n] = Soil->InfiltAcc;
+      break;
+    case PixGapNetShort:
+      Value[n] = (Veg->Gapping > 0.0) ? Veg->Type[Opening].NetShort[1] : NA;
+      break;
+    case PixGapLongIn:
+      Value[n] = (Veg->Gapping > 0.0) ? Veg->Type[Opening].LongIn[1] : NA;
+      break;
+    default:
+      ReportError("DumpPixSeries", 15);
+      break;
+    }
+  }
+
+  /* store SWE */
+  Snow->OldSwq = Snow->Swq;
+}
+
+/*******************************************************************************
+  Function name: EndPixSeriesRecord()
+
+  Purpose      : Close the record of the current time step and write the
+                 buffer once it holds NFlush records.  An aggregated record
+                 is only closed at the end of its period, and is dated by
+                 its last time step
+*******************************************************************************/
+void EndPixSeriesRecord(DATE *Current, PIXSERIES *Series)
+{
+  DATE Next;
+  size_t n;
+
+  if (Series->Statistic) {
+    n = (size_t) Series->NPix * Series->NCols;
+    AccumulateStatistic(Series->Statistic, Series->NSteps, n, Series->Step,
+      Series->Acc);
+    Series->NSteps++;
+    if (Series->Interval == DUMP_MONTH) {
+      Next = NextDate(Current, Series->Dt);
+      if (!IsNewMonth(&Next, Series->Dt))
+        return;
+    }
+    else if (Series->NSteps * Series->Dt < Series->Interval)
+      return;
+    ReduceStatistic(Series->Statistic, Series->NSteps, n, Series->Acc,
+      Series->Buffer + Series->NBuffered * n);
+    Series->NSteps = 0;
+  }
+
+  if (Series->NRecords == 0 && Series->NBuffered == 0)
+    CopyDate(&(Series->First), Current);
+  CopyDate(&(Series->Dates[Series->NBuffered]), Current);
+  Series->NBuffered++;
+  if (Series->NBuffered == Series->NFlush)
+    FlushPixSeries(Series);
+}
+
+/*******************************************************************************
+  Function name: ClosePixSeries()
+
+  Purpose      : Write the records still in the buffer and close the files.
+                 An aggregation period that is not complete is dropped
+*******************************************************************************/
+void ClosePixSeries(PIXSERIES *Series)
+{
+  if (Series == NULL)
+    return;
+
+  FlushPixSeries(Series);
+  if (Series->Format == NETCDF) {
+#ifdef HAVE_NETCDF
+    pixseries_check_nc(nc_close(Series->ncid), Series->FileName);
+#endif
+  }
+  else {
+    fclose(Series->Out);
+    fclose(Series->Index);
+  }
+  free(Series->ColVar);
+  free(Series->ColLayer);
+  free(Series->Buffer);
+  free(Series->Dates);
+  free(Series->Step);
+  free(Series->Acc);
+  free(Series);
+}
+
+/*******************************************************************************
+  FlushPixSeries()
+*******************************************************************************/
+static void FlushPixSeries(PIXSERIES *Series)
+{
+  char Str[BUFSIZE + 1];
+  size_t NValues;
+  int i;
+#ifdef HAVE_NETCDF
+  size_t start[3];
+  size_t count[3];
+  double hours;
+  double first;
+#endif
+
+  if (Series->NBuffered == 0)
+    return;
+
+  NValues = (size_t) Series->NBuffered * Series->NPix * Series->NCols;
+
+  if (Series->Format == NETCDF) {
+#ifdef HAVE_NETCDF
+    first = GregorianToJulianDay(Series->First.Year, Series->First.Month,
+      Series->First.Day, Series->First.Hour, Series->First.Min,
+      Series->First.Sec);
+    if (Series->NRecords == 0) {
+      sprintf(Str, "hours since %04d-%02d-%02d %02d:%02d:%02d",
+        Series->First.Year, Series->First.Month, Series->First.Day,
+        Series->First.Hour, Series->First.Min, Series->First.Sec);
+      pixseries_check_nc(nc_redef(Series->ncid), Series->FileName);
+      pixseries_check_nc(nc_put_att_text(Series->ncid, Series->TimeVarID,
+        "units", strlen(Str), Str), Series->FileName);
+      pixseries_check_nc(nc_enddef(Series->ncid), Series->FileName);
+    }
+    for (i = 0; i < Series->NBuffered; i++) {
+      start[0] = Series->NRecords + i;
+      hours = 24. * (GregorianToJulianDay(Series->Dates[i].Year,
+        Series->Dates[i].Month, Series->Dates[i].Day, Series->Dates[i].Hour,
+        Series->Dates[i].Min, Series->Dates[i].Sec) - first);
+      pixseries_check_nc(nc_put_var1_double(Series->ncid, Series->TimeVarID,
+        start, &hours), Series->FileName);
+    }
+    start[0] = Series->NRecords;
+    start[1] = 0;
+    start[2] = 0;
+    count[0] = Series->NBuffered;
+    count[1] = Series->NPix;
+    count[2] = Series->NCols;
+    pixseries_check_nc(nc_put_vara_float(Series->ncid, Series->ValueVarID,
+      start, count, Series->Buffer), Series->FileName);
+#endif
+  }
+  else {
+    if (fwrite(Series->Buffer, sizeof(float), NValues, Series->Out) != NValues)
+      ReportError(Series->FileName, 41);
+    for (i = 0; i < Series->NBuffered; i++) {
+      SPrintDate(&(Series->Dates[i]), Str);
+      fprintf(Series->Index, "%s\n", Str);
+    }
+  }
+
+  Series->NRecords += Series->NBuffered;
+  Series->NBuffered = 0;
+}
+
+/*******************************************************************************
+  NumberOfLayers()
+*******************************************************************************/
+static int NumberOfLayers(int Layers, int NSoil, int NCanopyStory)
+{
+  switch (Layers) {
+  case Story:
+    return NCanopyStory + 1;
+  case Canopy:
+    return NCanopyStory;
+  case CanopySoil:
+    return NCanopyStory * NSoil;
+  case SoilPlus:
+    return NSoil + 1;
+  case SoilLayer:
+    return NSoil;
+  default:
+    return 1;
+  }
+}
+
+/*******************************************************************************
+  ColumnName()
+
+  Layered variables are named as in the Pixel.<name> headers, e.g.
+  PotTransp.Story0, ActTranspSoil.Story0.Soil1 and SoilMoist1
+*******************************************************************************/
+static void ColumnName(PIXSERIES *Series, int Col, char *Name)
+{
+  int Var = Series->ColVar[Col];
+  int k = Series->ColLayer[Col];
+
+  switch (PixVar[Var].Layers) {
+  case Story:
+  case Canopy:
+    sprintf(Name, "%s.Story%d", PixVar[Var].Name, k);
+    break;
+  case CanopySoil:
+    sprintf(Name, "%s.Story%d.Soil%d", PixVar[Var].Name, k / Series->MaxSoil,
+      k % Series->MaxSoil);
+    break;
+  case SoilPlus:
+  case SoilLayer:
+    sprintf(Name, "%s%d", PixVar[Var].Name, k + 1);
+    break;
+  default:
+    strcpy(Name, PixVar[Var].Name);
+    break;
+  }
+}
+
+#ifdef HAVE_NETCDF
+/*******************************************************************************
+  pixseries_check_nc()
+*******************************************************************************/
+static void pixseries_check_nc(int ncstatus, char *FileName)
+{
+  char str[BUFSIZE + 1];
+
+  if (ncstatus != NC_NOERR) {
+    sprintf(str, "%s -- %s", FileName, nc_strerror(ncstatus));
+    ReportError(str, 57);
+  }
+}
+#endif
@@ -11,6 +11,7 @@
  * FUNCTIONS:    RadiationBalance()
  *               LongwaveBalance()
  *               ShortwaveBalance()
+ *               NoShortwaveBalance()
  * Reference:
 
    Wigmosta, M. S., L. W. Vail, and D. P. Lettenmaier, A distributed
@@ -103,66 +104,72 @@ void RadiationBalance(OPTIONSTRUCT *Options, int HeatFluxOption,
     F = VType->HemiFract[0];
   }
 
-  /* Determine Albedo */
-  if (OverStory == TRUE) {                                                           
-    Albedo[0] = VType->Albedo[0];                                                                              
-    /* With snow, understory canopy albedo is set equal to snow albedo */
-    if (LocalSnow->HasSnow == TRUE)
-      Albedo[1] = LocalSnow->Albedo;
+  /* without any incoming shortwave (night, or shaded) the net shortwave of
+     all layers is zero, and the albedo and transmittance are not needed */
+  if (Rs == 0. && Rsb == 0. && Rsd == 0.)
+    NoShortwaveBalance(Options, LocalRad);
+  else {
+    /* Determine Albedo */
+    if (OverStory == TRUE) {                                                           
+      Albedo[0] = VType->Albedo[0];                                                                              
+      /* With snow, understory canopy albedo is set equal to snow albedo */
+      if (LocalSnow->HasSnow == TRUE)
+        Albedo[1] = LocalSnow->Albedo;
+      else if (Understory == TRUE)
+        Albedo[1] = VType->Albedo[1];
+      else
+        Albedo[1] = SoilAlbedo;
+    }
+    else if (LocalSnow->HasSnow == TRUE)
+      Albedo[0] = LocalSnow->Albedo;
     else if (Understory == TRUE)
-      Albedo[1] = VType->Albedo[1];
+      Albedo[0] = VType->Albedo[0];
     else
-      Albedo[1] = SoilAlbedo;
-  }
-  else if (LocalSnow->HasSnow == TRUE)
-    Albedo[0] = LocalSnow->Albedo;
-  else if (Understory == TRUE)
-    Albedo[0] = VType->Albedo[0];
-  else
-    Albedo[0] = SoilAlbedo;
+      Albedo[0] = SoilAlbedo;
 
 
-  /* Improved radiation scheme taking into account solar position */
-  if (OverStory == TRUE) {
-    if (Options->ImprovRadiation) {
-      if (SineSolarAltitude > 0. && Rs > 0.) {
-        Tau = exp(-VType->ExtnCoeff * h / SineSolarAltitude);
+    /* Improved radiation scheme taking into account solar position */
+    if (OverStory == TRUE) {
+      if (Options->ImprovRadiation) {
+        if (SineSolarAltitude > 0. && Rs > 0.) {
+          Tau = exp(-VType->ExtnCoeff * h / SineSolarAltitude);
+        }
+        else
+          Tau = 0.;
       }
-      else
-        Tau = 0.;
-    }
-    else if (CanopyRadAttOption == FIXED) { /* conventional radiation scheme */
-      Tau = exp(-VType->Atten * LocalVeg->LAI[0]);
-    }
-    /* Nijssen's simplified radiation scheme as in Nijssen and Lettenmaier, 1999 */
-    else if (CanopyRadAttOption == VARIABLE) {
-      /* Calculate transmittance of overstory canopy for direct radiation:
-         1) LAI * ClumpingFactor = Effective LAI
-         2) Formulation is typically based on the cos of the solar zenith angle,
-         which is the sin of the solar altitude (SA = 90 - SZA) */
-      Taub = exp(-LocalVeg->LAI[0] / VType->ClumpingFactor *
-        (VType->LeafAngleA / SineSolarAltitude + VType->LeafAngleB));
-
-      /* transmittance for diffuse radiation (cacluated in CheckOut.c as a function of
-         LeafAngleA and LeafAngleB and solar altitude) */
-      Taud = VType->Taud;
-
-      /* cacluate the total canopy transimittance for shortwave radiation (adjusted to
-         scattering and multiple reflection */
-      if (Rs > 0.0) {
-        Tau = Taub * Rsb / Rs + Taud * Rsd / Rs;
-        /* adjust Tau to scaterring parameter */
-        Tau = pow(Tau, (VType->Scat));
-        /* adjust Tau to over- and under- story reflection */
-        Tau = Tau / (1 - Albedo[0] * Albedo[1]);
+      else if (CanopyRadAttOption == FIXED) { /* conventional radiation scheme */
+        Tau = exp(-VType->Atten * LocalVeg->LAI[0]);
+      }
+      /* Nijssen's simplified radiation scheme as in Nijssen and Lettenmaier, 1999 */
+      else if (CanopyRadAttOption == VARIABLE) {
+        /* Calculate transmittance of overstory canopy for direct radiation:
+           1) LAI * ClumpingFactor = Effective LAI
+           2) Formulation is typically based on the cos of the solar zenith angle,
+           which is the sin of the solar altitude (SA = 90 - SZA) */
+        Taub = exp(-LocalVeg->LAI[0] / VType->ClumpingFactor *
+          (VType->LeafAngleA / SineSolarAltitude + VType->LeafAngleB));
+
+        /* transmittance for diffuse radiation (cacluated in CheckOut.c as a function of
+           LeafAngleA and LeafAngleB and solar altitude) */
+        Taud = VType->Taud;
+
+        /* cacluate the total canopy transimittance for shortwave radiation (adjusted to
+           scattering and multiple reflection */
+        if (Rs > 0.0) {
+          Tau = Taub * Rsb / Rs + Taud * Rsd / Rs;
+          /* adjust Tau to scaterring parameter */
+          Tau = pow(Tau, (VType->Scat));
+          /* adjust Tau to over- and under- story reflection */
+          Tau = Tau / (1 - Albedo[0] * Albedo[1]);
+        }
+        else
+          Tau = 0.;
       }
-      else
-        Tau = 0.;
     }
-  }
 
-  ShortwaveBalance(Options, OverStory, F, Rs, Rsb, Rsd, Tau, 
-    VType->Taud, Albedo, LocalRad);
+    ShortwaveBalance(Options, OverStory, F, Rs, Rsb, Rsd, Tau, 
+      VType->Taud, Albedo, LocalRad);
+  }
 
   if (LocalSnow->HasSnow == TRUE)
     Tsurf = LocalSnow->TSurf;
@@ -355,3 +362,27 @@ void ShortwaveBalance(OPTIONSTRUCT *Options, unsigned char OverStory,
     LocalRad->PixelDiffuse = Rsd;
   }
 }
+
+/*****************************************************************************
+  Function name: NoShortwaveBalance()
+
+  Purpose      : Set the net shortwave radiation for the individual canopy
+                 layers if there is no incoming shortwave radiation
+
+  Returns      : void
+
+  Modifies     :
+    PIXRAD *LocalRad  - Components of radiation balance for current pixel
+*****************************************************************************/
+void NoShortwaveBalance(OPTIONSTRUCT *Options, PIXRAD *LocalRad)
+{
+  LocalRad->NetShort[0] = 0.;
+  LocalRad->NetShort[1] = 0.;
+  LocalRad->PixelNetShort = 0.;
+
+  if (Options->StreamTemp) {
+    LocalRad->RBMNetShort = 0.;
+    LocalRad->PixelBeam = 0.;
+    LocalRad->PixelDiffuse = 0.;
+  }
+}
@@ -6,7 +6,8 @@
  * ORG:          University of Washington, Department of Civil Engineering
  * E-MAIL:       nijssen@u.washington.edu
  * ORIG-DATE:    Apr-96
- * DESCRIPTION:  Display a context-dependent error message and exit
+ * DESCRIPTION:  Display a context-dependent error message and exit, or
+ *               return to the library call that is running (ErrorReturn)
  * DESCRIP-END.
  * FUNCTIONS:    ReportError()
  *               ReportWarning()
@@ -20,6 +21,8 @@
 #include "data.h"
 #include "DHSVMerror.h"
 
+jmp_buf *ErrorReturn = NULL;
+
 static char *ErrorMessage[] = {
   "Cannot allocate enough memory in function:",	/* 1 */
   "Error while reading file:",	/* 2 */
@@ -91,12 +94,16 @@ static char *ErrorMessage[] = {
   "Riparian parameter < 0:", /* 68 */
   "No gridded met file is found within the basin boundary", /* 69 */
   "Unknown keyword: ",                                      /* 70 */
+  "Impervious drainage target outside the basin in:",       /* 71 */
+  "File name too long for:",                                /* 72 */
   NULL
 };
 
 void ReportError(char *ErrorString, int ErrorCode)
 {
   printf("%s %s\n", ErrorMessage[ErrorCode - 1], ErrorString);
+  if (ErrorReturn != NULL)
+    longjmp(*ErrorReturn, ErrorCode);
   exit(ErrorCode);
 }
 
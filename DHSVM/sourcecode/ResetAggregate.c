@@ -112,6 +112,19 @@ void ResetAggregate(LAYER * Soil, LAYER * Veg, AGGREGATED * Total,
   Total->Road.IExcess = 0.0;
   Total->Soil.DetentionStorage = 0.0;
 
+  /* mass balance totals, OldSwq is kept from the previous step */
+  Total->Water.Precip = 0.0;
+  Total->Water.SnowFall = 0.0;
+  Total->Water.ETot = 0.0;
+  Total->Water.Swq = 0.0;
+  Total->Water.Melt = 0.0;
+  Total->Water.VaporMassFlux = 0.0;
+  Total->Water.CanopyVaporMassFlux = 0.0;
+  Total->Water.IExcess = 0.0;
+  Total->Water.RoadIExcess = 0.0;
+  Total->Water.DetentionStorage = 0.0;
+  Total->Water.SatFlow = 0.0;
+
   if (Options->Infiltration == DYNAMIC)
     Total->Soil.InfiltAcc = 0.0;
   Total->SoilWater = 0.0;
@@ -100,7 +100,7 @@ void RouteSubSurface(int Dt, MAPSIZE *Map, TOPOPIX **TopoMap,
 		     ROADSTRUCT **Network, SOILTABLE *SType,
 		     SOILPIX **SoilMap, CHANNEL *ChannelData,
 		     TIMESTRUCT *Time, OPTIONSTRUCT *Options, 
-		     char *DumpPath, int MaxStreamID, SNOWPIX **SnowMap)
+		     int MaxStreamID, SNOWPIX **SnowMap)
 {
   const char *Routine = "RouteSubSurface";
   int x;			/* counter */
@@ -119,12 +119,6 @@ void RouteSubSurface(int Dt, MAPSIZE *Map, TOPOPIX **TopoMap,
   unsigned char ***SubDir;      /* Fraction of flux moving in each direction*/ 
   unsigned int **SubTotalDir;	/* Sum of Dir array */
 
-  int count, totalcount;
-  float mgrid, sat;
-  char buffer[32];
-  char satoutfile[100];         /* Character arrays to hold file name. */ 
-  FILE *fs;                     /* File pointer. */
-
   /*****************************************************************************
    Allocate memory 
   ****************************************************************************/
@@ -202,7 +196,8 @@ void RouteSubSurface(int Dt, MAPSIZE *Map, TOPOPIX **TopoMap,
 			Transmissivity = CalcTransmissivity(SoilMap[y][x].Depth, depth,
 				 SoilMap[y][x].KsLat,
 				 SType[SoilMap[y][x].Soil - 1].KsLatExp,
-                 SType[SoilMap[y][x].Soil - 1].DepthThresh);
+                 SType[SoilMap[y][x].Soil - 1].DepthThresh,
+                 SType[SoilMap[y][x].Soil - 1].KsTable);
 			
 			OutFlow = 
 				(Transmissivity * fract_used * SubFlowGrad[y][x] * Dt) / (Map->DX * Map->DY);
@@ -232,7 +227,8 @@ void RouteSubSurface(int Dt, MAPSIZE *Map, TOPOPIX **TopoMap,
 				 CalcTransmissivity(BankHeight, SoilMap[y][x].TableDepth,
 				 SoilMap[y][x].KsLat,
 				 SType[SoilMap[y][x].Soil - 1].KsLatExp,
-                 SType[SoilMap[y][x].Soil - 1].DepthThresh);
+                 SType[SoilMap[y][x].Soil - 1].DepthThresh,
+                 SType[SoilMap[y][x].Soil - 1].KsTable);
 			
 			water_out_road = (Transmissivity * fract_used *
 			      SubFlowGrad[y][x] * Dt) / (Map->DX * Map->DY);
@@ -279,7 +275,8 @@ void RouteSubSurface(int Dt, MAPSIZE *Map, TOPOPIX **TopoMap,
 				CalcTransmissivity(BankHeight, SoilMap[y][x].TableDepth,
 				 SoilMap[y][x].KsLat,
 				 SType[SoilMap[y][x].Soil - 1].KsLatExp,
-                 SType[SoilMap[y][x].Soil - 1].DepthThresh);
+                 SType[SoilMap[y][x].Soil - 1].DepthThresh,
+                 SType[SoilMap[y][x].Soil - 1].KsTable);
 
 			OutFlow = (Transmissivity * gradient * Dt) / (Map->DX * Map->DY);
 			
@@ -318,36 +315,5 @@ void RouteSubSurface(int Dt, MAPSIZE *Map, TOPOPIX **TopoMap,
   free(SubDir);
   free(SubTotalDir);
   free(SubFlowGrad);
-
-  /**********************************************************************/
-  /* Dump saturation extent file to screen.
-     Saturation extent is based on the number of pixels with a water table 
-     that is at least MTHRESH of soil depth. */ 
-  
-  count =0;
-  totalcount = 0;
-  for (y = 0; y < Map->NY; y++) {
-    for (x = 0; x < Map->NX; x++) {
-      if (INBASIN(TopoMap[y][x].Mask)) {
-	     mgrid = (SoilMap[y][x].Depth - SoilMap[y][x].TableDepth)/SoilMap[y][x].Depth;
-	     if (mgrid > MTHRESH) 
-		   count += 1;
-		 totalcount += 1;
-      }
-    }
-  }
- 
-  sat = 100.*((float)count/(float)totalcount);
-  
-  sprintf(satoutfile, "%ssaturation_extent.txt", DumpPath);
-  
-  if((fs = fopen(satoutfile,"a")) == NULL){
-    printf("Cannot open saturation extent output file.\n");
-    exit(0);
-  }
-  
-  SPrintDate(&(Time->Current), buffer);
-  fprintf(fs, "%-20s %.4f \n", buffer, sat); 
-  fclose(fs);    
 }
 
@@ -9,6 +9,8 @@
 * DESCRIPTION:  Route surface flow
 * DESCRIP-END.
 * FUNCTIONS:    RouteSurface()
+*               RouteCell()
+*               CascadeFraction()
 * Modification: Changes are made to exclude the impervious channel cell (with
 a non-zero impervious fraction) from surface routing. In the original
 code, some impervious channel cells are routed to themselves causing
@@ -26,6 +28,11 @@ overestimated runoff in those cells (Ning, 2013).
 #include "DHSVMerror.h"
 #include "functions.h"
 #include "constants.h"
+static void RouteCell(MAPSIZE * Map, TOPOPIX ** TopoMap, SOILPIX ** SoilMap,
+  VEGPIX ** VegMap, VEGTABLE * VType, int y, int x);
+static float CascadeFraction(MAPSIZE * Map, TIMESTRUCT * Time,
+  TOPOPIX ** TopoMap, OPTIONSTRUCT * Options, int y, int x, float Water);
+
 /*****************************************************************************
 RouteSurface()
 If the watertable calculated in WaterTableDepth() was negative, then water is
@@ -37,9 +44,11 @@ The net effect is that all pixels that have an impervious area are directly
 connected (over the coarse of a single time step) to the channel network, this
 assumption is likely to be true for small urban basins, and perhaps even for
 large rural basins with some urban development
-If Overland Routing = KINEMATIC, then "excess" water is routed to the outlet
-using a infinite difference approximation to the kinematic wave solution of
-the Saint-Venant equations.
+If Overland Routing = CASCADE, the cells are routed from the highest to the
+lowest, so that "excess" water can cascade down the hillslope to the channel
+within a single time step.  With an Overland Roughness (Manning's n) the
+fraction of the water that leaves a cell in a time step is limited by the
+kinematic wave travel time across the cell, the rest stays on the cell.
 *****************************************************************************/
 void RouteSurface(MAPSIZE * Map, TIMESTRUCT * Time, TOPOPIX ** TopoMap,
   SOILPIX ** SoilMap, OPTIONSTRUCT *Options,
@@ -52,7 +61,9 @@ void RouteSurface(MAPSIZE * Map, TIMESTRUCT * Time, TOPOPIX ** TopoMap,
   float StreamFlow;
   int TravelTime;
   int WaveLength;
-  int i, j, x, y, n, k;         /* Counters */
+  int i, j, x, y, k;            /* Counters */
+  float Water;			/* surface water leaving a cell (m) */
+  float Fraction;		/* fraction of it that leaves in this step */
 
 
   /* Allocate memory for Runon Matrix */
@@ -67,47 +78,31 @@ void RouteSurface(MAPSIZE * Map, TIMESTRUCT * Time, TOPOPIX ** TopoMap,
         }
       }
     }
-    for (y = 0; y < Map->NY; y++) {
-      for (x = 0; x < Map->NX; x++) {
-        if (INBASIN(TopoMap[y][x].Mask)) {
-          if (!channel_grid_has_channel(ChannelData->stream_map, x, y)) {
-            if (VType[VegMap[y][x].Veg - 1].ImpervFrac > 0.0) {
-              /* Calculate the outflow from impervious portion of urban cell straight to nearest channel cell */
-              SoilMap[TopoMap[y][x].drains_y][TopoMap[y][x].drains_x].IExcess +=
-                (1 - VType[VegMap[y][x].Veg - 1].DetentionFrac) *
-                VType[VegMap[y][x].Veg - 1].ImpervFrac * SoilMap[y][x].Runoff;
-              /* Retained water in detention storage */
-              SoilMap[y][x].DetentionIn = VType[VegMap[y][x].Veg - 1].DetentionFrac *
-                VType[VegMap[y][x].Veg - 1].ImpervFrac * SoilMap[y][x].Runoff;
-              /* Retained water in Detention storage routed to channel */
-              SoilMap[y][x].DetentionStorage += SoilMap[y][x].DetentionIn;
-              SoilMap[y][x].DetentionOut = SoilMap[y][x].DetentionStorage * VType[VegMap[y][x].Veg - 1].DetentionDecay;
-              SoilMap[TopoMap[y][x].drains_y][TopoMap[y][x].drains_x].IExcess += SoilMap[y][x].DetentionOut;
-              SoilMap[y][x].DetentionStorage -= SoilMap[y][x].DetentionOut;
-              if (SoilMap[y][x].DetentionStorage < 0.0)
-                SoilMap[y][x].DetentionStorage = 0.0;
-              /* Route the runoff from pervious portion of urban cell to the neighboring cell */
-              for (n = 0; n < NDIRS; n++) {
-                int xn = x + xdirection[n];
-                int yn = y + ydirection[n];
-                if (valid_cell(Map, xn, yn)) {
-                  SoilMap[yn][xn].IExcess += (1 - VType[VegMap[y][x].Veg - 1].ImpervFrac) * SoilMap[y][x].Runoff
-                    *((float)TopoMap[y][x].Dir[n] / (float)TopoMap[y][x].TotalDir);
-                }
-              }
-            }
-            else {
-              for (n = 0; n < NDIRS; n++) {
-                int xn = x + xdirection[n];
-                int yn = y + ydirection[n];
-                if (valid_cell(Map, xn, yn)) {
-                  SoilMap[yn][xn].IExcess += SoilMap[y][x].Runoff *((float)TopoMap[y][x].Dir[n] / (float)TopoMap[y][x].TotalDir);
-                }
-              }
-            }
-          }
-          else if (channel_grid_has_channel(ChannelData->stream_map, x, y)) {
-            SoilMap[y][x].IExcess += SoilMap[y][x].Runoff;
+    if (Options->OverlandRouting == CASCADE) {
+      /* from the highest cell down, so that the water reaching a cell from
+         upslope in this time step is passed on in the same time step */
+      for (k = Map->NumCells - 1; k >= 0; k--) {
+        y = Map->OrderedCells[k].y;
+        x = Map->OrderedCells[k].x;
+        if (channel_grid_has_channel(ChannelData->stream_map, x, y)) {
+          SoilMap[y][x].IExcess += SoilMap[y][x].Runoff;
+          continue;
+        }
+        Water = SoilMap[y][x].Runoff + SoilMap[y][x].IExcess;
+        Fraction = CascadeFraction(Map, Time, TopoMap, Options, y, x, Water);
+        SoilMap[y][x].IExcess = (1 - Fraction) * Water;
+        SoilMap[y][x].Runoff = Fraction * Water;
+        RouteCell(Map, TopoMap, SoilMap, VegMap, VType, y, x);
+      }
+    }
+    else {
+      for (y = 0; y < Map->NY; y++) {
+        for (x = 0; x < Map->NX; x++) {
+          if (INBASIN(TopoMap[y][x].Mask)) {
+            if (!channel_grid_has_channel(ChannelData->stream_map, x, y))
+              RouteCell(Map, TopoMap, SoilMap, VegMap, VType, y, x);
+            else
+              SoilMap[y][x].IExcess += SoilMap[y][x].Runoff;
           }
         }
       }
@@ -154,3 +149,129 @@ void RouteSurface(MAPSIZE * Map, TIMESTRUCT * Time, TOPOPIX ** TopoMap,
   }
 }
 
+
+/*****************************************************************************
+RouteCell()
+Routes the surface water SoilMap[y][x].Runoff of a cell without a channel to
+its downslope neighbors, or with an impervious fraction partly to the
+nearest channel cell and its detention storage.
+*****************************************************************************/
+static void RouteCell(MAPSIZE * Map, TOPOPIX ** TopoMap, SOILPIX ** SoilMap,
+  VEGPIX ** VegMap, VEGTABLE * VType, int y, int x)
+{
+  int n;
+
+  if (VType[VegMap[y][x].Veg - 1].ImpervFrac > 0.0) {
+    /* Calculate the outflow from impervious portion of urban cell straight to nearest channel cell */
+    SoilMap[TopoMap[y][x].drains_y][TopoMap[y][x].drains_x].IExcess +=
+      (1 - VType[VegMap[y][x].Veg - 1].DetentionFrac) *
+      VType[VegMap[y][x].Veg - 1].ImpervFrac * SoilMap[y][x].Runoff;
+    /* Retained water in detention storage */
+    SoilMap[y][x].DetentionIn = VType[VegMap[y][x].Veg - 1].DetentionFrac *
+      VType[VegMap[y][x].Veg - 1].ImpervFrac * SoilMap[y][x].Runoff;
+    /* Retained water in Detention storage routed to channel */
+    SoilMap[y][x].DetentionStorage += SoilMap[y][x].DetentionIn;
+    SoilMap[y][x].DetentionOut = SoilMap[y][x].DetentionStorage * VType[VegMap[y][x].Veg - 1].DetentionDecay;
+    SoilMap[TopoMap[y][x].drains_y][TopoMap[y][x].drains_x].IExcess += SoilMap[y][x].DetentionOut;
+    SoilMap[y][x].DetentionStorage -= SoilMap[y][x].DetentionOut;
+    if (SoilMap[y][x].DetentionStorage < 0.0)
+      SoilMap[y][x].DetentionStorage = 0.0;
+    /* Route the runoff from pervious portion of urban cell to the neighboring cell */
+    for (n = 0; n < NDIRS; n++) {
+      int xn = x + xdirection[n];
+      int yn = y + ydirection[n];
+      if (valid_cell(Map, xn, yn)) {
+        SoilMap[yn][xn].IExcess += (1 - VType[VegMap[y][x].Veg - 1].ImpervFrac) * SoilMap[y][x].Runoff
+          *((float)TopoMap[y][x].Dir[n] / (float)TopoMap[y][x].TotalDir);
+      }
+    }
+  }
+  else {
+    for (n = 0; n < NDIRS; n++) {
+      int xn = x + xdirection[n];
+      int yn = y + ydirection[n];
+      if (valid_cell(Map, xn, yn)) {
+        SoilMap[yn][xn].IExcess += SoilMap[y][x].Runoff *((float)TopoMap[y][x].Dir[n] / (float)TopoMap[y][x].TotalDir);
+      }
+    }
+  }
+}
+
+/*****************************************************************************
+CascadeFraction()
+Fraction of the surface water Water (m) on a cell that leaves it in a time
+step.  Without an Overland Roughness all of it leaves.  Otherwise the water
+crosses the cell at the kinematic wave celerity c = 5/3 * v, with the
+Manning velocity v = Water^(2/3) * Slope^(1/2) / n, so that a fraction
+Dt * c / DX of it leaves (at most all of it).  A flat cell has no Manning
+velocity, so like a cell without roughness all of its water leaves rather
+than ponding on it for good.
+*****************************************************************************/
+static float CascadeFraction(MAPSIZE * Map, TIMESTRUCT * Time,
+  TOPOPIX ** TopoMap, OPTIONSTRUCT * Options, int y, int x, float Water)
+{
+  float Celerity;
+
+  if (Options->OverlandRoughness <= 0.0 || TopoMap[y][x].Slope <= 0.0)
+    return 1.0;
+  if (Water <= 0.0)
+    return 0.0;
+
+  Celerity = 5. / 3. * pow(Water, 2. / 3.) * sqrt(TopoMap[y][x].Slope) /
+    Options->OverlandRoughness;
+
+  return MIN(1.0, Time->Dt * Celerity / Map->DX);
+}
+
+/*****************************************************************************
+  Test main.  Build the route_surface_test target (DHSVM_BUILD_TESTS) and
+  run it; it exits with EXIT_FAILURE if a cascade fraction is wrong
+*****************************************************************************/
+#ifdef TEST_ROUTESURFACE
+int main(void)
+{
+  MAPSIZE Map;
+  TIMESTRUCT Time;
+  OPTIONSTRUCT Options;
+  TOPOPIX Cell;
+  TOPOPIX *Row = &Cell;
+  TOPOPIX **TopoMap = &Row;
+  float Fraction;
+  int Failed = 0;
+
+  Map.DX = 90.;
+  Time.Dt = 3600;
+
+  /* without a roughness all of the water leaves */
+  Options.OverlandRoughness = 0.0;
+  Cell.Slope = 0.1;
+  Fraction = CascadeFraction(&Map, &Time, TopoMap, &Options, 0, 0, 0.001);
+  printf("no roughness:     %f\n", Fraction);
+  if (Fraction != 1.0)
+    Failed = 1;
+
+  /* a thin sheet on a sloping cell only partly leaves */
+  Options.OverlandRoughness = 0.4;
+  Fraction = CascadeFraction(&Map, &Time, TopoMap, &Options, 0, 0, 0.0001);
+  printf("sloping cell:     %f\n", Fraction);
+  if (Fraction <= 0.0 || Fraction >= 1.0)
+    Failed = 1;
+
+  /* a flat cell does not keep its water */
+  Cell.Slope = 0.0;
+  Fraction = CascadeFraction(&Map, &Time, TopoMap, &Options, 0, 0, 0.0001);
+  printf("flat cell:        %f\n", Fraction);
+  if (Fraction != 1.0)
+    Failed = 1;
+
+  /* no water, nothing to route */
+  Cell.Slope = 0.1;
+  Fraction = CascadeFraction(&Map, &Time, TopoMap, &Options, 0, 0, 0.0);
+  printf("no water:         %f\n", Fraction);
+  if (Fraction != 0.0)
+    Failed = 1;
+
+  printf("%s\n", Failed ? "FAILED" : "passed");
+  return Failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+#endif
@@ -0,0 +1,169 @@
+/*
+ * SUMMARY:      ShadeStore.c - Shade factors for each time step of the day
+ * USAGE:        Part of DHSVM
+ *
+ * DESCRIPTION:  The monthly shadow files hold one map of shade factors per
+ *               hour, or per time step for time steps of an hour or more.
+ *               The maps are stored once per map in the file:  with
+ *               sub-hourly time steps ShadowMap[step] is the row array of
+ *               the hour of the step, shared by all steps of that hour.  A
+ *               map with the same factor everywhere (the night hours, or
+ *               no topographic shading) has no storage of its own, all its
+ *               rows point to a single row with that factor.  The maps of
+ *               several months can be kept in slots (see MonthlyMaps.c);
+ *               UseShadeSlot() points ShadowMap at the maps of one slot.
+ * DESCRIP-END.
+ * FUNCTIONS:    InitShadeStore()
+ *               NShadeSlices()
+ *               ShadeSlice()
+ *               StoreShadeSlice()
+ *               UseShadeSlot()
+ * COMMENTS:     ShadowMap[step][y][x] is read as before; the rows must not
+ *               be written to except through StoreShadeSlice().
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "settings.h"
+#include "data.h"
+#include "DHSVMerror.h"
+#include "functions.h"
+
+static int StoreNY = 0;
+static int StoreNX = 0;
+static int StoreSlices = 0;			/* maps per slot */
+static int StoreSlots = 0;
+static unsigned char ***SliceRows = NULL;	/* row array of each map */
+static unsigned char **SliceData = NULL;	/* storage of each map, NULL
+						   if the map is constant */
+static unsigned char *ConstRow[MAXUCHAR + 1];	/* one row per constant factor */
+
+static unsigned char *ConstantRow(unsigned char Value);
+
+/*****************************************************************************
+  InitShadeStore()
+
+  Returns the ShadowMap array for NDaySteps time steps, with all shade
+  factors 0, and a store for the maps of NSlots months.
+*****************************************************************************/
+unsigned char ***InitShadeStore(int NDaySteps, MAPSIZE *Map, int NSlots)
+{
+  const char *Routine = "InitShadeStore";
+  unsigned char ***ShadowMap;
+  int n;
+  int y;
+
+  StoreNY = Map->NY;
+  StoreNX = Map->NX;
+  StoreSlices = NShadeSlices(NDaySteps);
+  StoreSlots = NSlots;
+
+  if (!(ShadowMap =
+	(unsigned char ***) calloc(NDaySteps, sizeof(unsigned char **))) ||
+      !(SliceRows = (unsigned char ***) calloc(StoreSlots * StoreSlices,
+						sizeof(unsigned char **))) ||
+      !(SliceData = (unsigned char **) calloc(StoreSlots * StoreSlices,
+					       sizeof(unsigned char *))))
+    ReportError((char *) Routine, 1);
+
+  for (n = 0; n < StoreSlots * StoreSlices; n++) {
+    if (!(SliceRows[n] =
+	  (unsigned char **) calloc(StoreNY, sizeof(unsigned char *))))
+      ReportError((char *) Routine, 1);
+    for (y = 0; y < StoreNY; y++)
+      SliceRows[n][y] = ConstantRow(0);
+  }
+
+  UseShadeSlot(ShadowMap, NDaySteps, 0);
+
+  return ShadowMap;
+}
+
+/*****************************************************************************
+  NShadeSlices()
+
+  Number of shade maps per day in the monthly shadow files.
+*****************************************************************************/
+int NShadeSlices(int NDaySteps)
+{
+  return ShadeSlice(NDaySteps - 1, NDaySteps) + 1;
+}
+
+/*****************************************************************************
+  ShadeSlice()
+
+  Map in the monthly shadow file for time step Step of the day.  If the
+  time step is finer than hourly, the shade factor is equal within the
+  hourly interval.
+*****************************************************************************/
+int ShadeSlice(int Step, int NDaySteps)
+{
+  if (NDaySteps > 24)
+    return Step / (NDaySteps / 24);
+  return Step;
+}
+
+/*****************************************************************************
+  StoreShadeSlice()
+
+  Stores shade map Slice (NY * NX factors) of the month in Slot.
+*****************************************************************************/
+void StoreShadeSlice(int Slot, int Slice, unsigned char *Data)
+{
+  const char *Routine = "StoreShadeSlice";
+  int NCells = StoreNY * StoreNX;
+  int i;
+  int y;
+
+  Slice += Slot * StoreSlices;
+
+  for (i = 1; i < NCells; i++)
+    if (Data[i] != Data[0])
+      break;
+
+  if (i >= NCells) {
+    free(SliceData[Slice]);
+    SliceData[Slice] = NULL;
+    for (y = 0; y < StoreNY; y++)
+      SliceRows[Slice][y] = ConstantRow(Data[0]);
+    return;
+  }
+
+  if (SliceData[Slice] == NULL &&
+      !(SliceData[Slice] =
+	(unsigned char *) malloc(NCells * sizeof(unsigned char))))
+    ReportError((char *) Routine, 1);
+  memcpy(SliceData[Slice], Data, NCells * sizeof(unsigned char));
+  for (y = 0; y < StoreNY; y++)
+    SliceRows[Slice][y] = SliceData[Slice] + y * StoreNX;
+}
+
+/*****************************************************************************
+  UseShadeSlot()
+
+  Points the time steps of ShadowMap at the shade maps of the month in Slot.
+*****************************************************************************/
+void UseShadeSlot(unsigned char ***ShadowMap, int NDaySteps, int Slot)
+{
+  int n;
+
+  for (n = 0; n < NDaySteps; n++)
+    ShadowMap[n] = SliceRows[Slot * StoreSlices + ShadeSlice(n, NDaySteps)];
+}
+
+/*****************************************************************************
+  ConstantRow()
+*****************************************************************************/
+static unsigned char *ConstantRow(unsigned char Value)
+{
+  const char *Routine = "ConstantRow";
+
+  if (ConstRow[Value] == NULL) {
+    if (!(ConstRow[Value] =
+	  (unsigned char *) malloc(StoreNX * sizeof(unsigned char))))
+      ReportError((char *) Routine, 1);
+    memset(ConstRow[Value], Value, StoreNX);
+  }
+  return ConstRow[Value];
+}
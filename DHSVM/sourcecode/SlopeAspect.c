@@ -15,7 +15,10 @@
  *               slope_aspect()
  *               flow_fractions()
  *               ElevationSlopeAspect()
+ *               InitHeadSlopeAspect()
+ *               HeadWaterLevel()
  *               HeadSlopeAspect()
+ *               SnowSlopeAspect()
  *               ElevationSlope()
  *               ElevationSlopeAspectfine()
  * COMMENTS:
@@ -73,15 +76,11 @@ static void slope_aspect(float dx, float dy, float celev, float
 {
   int n;
   float dzdx, dzdy;
-  float *dummyelev;
+  float dummyelev[NNEIGHBORS];
   /* this dummy varaible is added for calculation of elev difference,
   in which the elev of OUTSIDEBASIN cells (which is ZERO) is 
   replaced by the elev of the central cell */
 
-  /* allocate memory */
-  if (!(dummyelev = (float*) calloc(NNEIGHBORS, sizeof(float))))
-	  ReportError("slope_aspect( )", 1);
-  
   for (n = 0; n < NNEIGHBORS; n++) {
       if (nelev[n] == OUTSIDEBASIN) {
 		  dummyelev[n] = celev;
@@ -102,7 +101,6 @@ static void slope_aspect(float dx, float dy, float celev, float
 	  /* convert from radian to degree */
 	  *aspect = atan2(dzdx, dzdy) ;
   }
-  free(dummyelev);
   return;
 }
 /* -------------------------------------------------------------
@@ -119,17 +117,11 @@ static void flow_fractions(float dx, float dy, float slope, float aspect,
   float cosine = cos(aspect);
   float sine = sin(aspect);
   float total_width, effective_width;
-  float *cos, *sin;
+  float cos[NNEIGHBORS/2], sin[NNEIGHBORS/2];
   int n;
   float drop[NDIRS]; 
   float maxdrop; 
   int steepest;
- 
-  /* allocate memory */
-  if (!(cos = (float*) calloc(NDIRS/2, sizeof(float))))
-	  ReportError("slope_aspect( )", 1);
-  if (!(sin = (float*) calloc(NDIRS/2, sizeof(float))))
-	  ReportError("slope_aspect( )", 1);
 
  switch (NDIRS) {
   case 4:
@@ -229,8 +221,6 @@ static void flow_fractions(float dx, float dy, float slope, float aspect,
     ReportError("flow_fractions",65);
     assert(0);			/* other cases don't work either */
   }
-  free(sin);
-  free(cos);
   return;
 }
 /* -------------------------------------------------------------
@@ -376,87 +366,203 @@ void qs(ITEM *item, int left, int right)
 }
 /* -------------------------------------------------------------
    HeadSlopeAspect
-   This computes slope and aspect using the water table elevation. 
+   This computes slope and aspect using the water table elevation
+   (WaterLevel in the SOILPIX map, computed by HeadWaterLevel() in
+   InitNewStep()).  The flow directions are kept from one time step
+   to the next and are only recomputed for cells where the water
+   level of the cell or of a neighbor has changed by more than
+   Tolerance since the directions of that cell were last computed.
+   ------------------------------------------------------------- */
+static int HeadNY = 0;
+static int HeadNX = 0;
+static int HeadFresh = TRUE;		/* recompute all cells */
+static float *HeadLevel = NULL;		/* water level of the last
+					   recomputation of each cell */
+static unsigned char *HeadChanged = NULL;
+static float *HeadGrad = NULL;
+static unsigned char *HeadDir = NULL;	/* NNEIGHBORS per cell */
+static unsigned int *HeadTotalDir = NULL;
+
+static void HeadSlopeAspectRow(int y, MAPSIZE * Map, TOPOPIX ** TopoMap,
+			       SOILPIX ** SoilMap, float **FlowGrad,
+			       unsigned char ***Dir, unsigned int **TotalDir);
 
-   Comment: rewritten to fill the sinks (Ning, 2013)
+/* -------------------------------------------------------------
+   InitHeadSlopeAspect
+   Allocates the water table gradients of Map, all of which are
+   computed in the next time step.
    ------------------------------------------------------------- */
-void HeadSlopeAspect(MAPSIZE * Map, TOPOPIX ** TopoMap, SOILPIX ** SoilMap,
-		     float **FlowGrad, unsigned char ***Dir, unsigned int **TotalDir)
+void InitHeadSlopeAspect(MAPSIZE * Map)
+{
+  const char *Routine = "InitHeadSlopeAspect";
+  int NCells = Map->NY * Map->NX;
+
+  free(HeadLevel);
+  free(HeadChanged);
+  free(HeadGrad);
+  free(HeadDir);
+  free(HeadTotalDir);
+  if (!(HeadLevel = (float *) calloc(NCells, sizeof(float))) ||
+      !(HeadChanged = (unsigned char *) calloc(NCells, sizeof(unsigned char))) ||
+      !(HeadGrad = (float *) calloc(NCells, sizeof(float))) ||
+      !(HeadDir = (unsigned char *) calloc(NCells * NNEIGHBORS,
+					   sizeof(unsigned char))) ||
+      !(HeadTotalDir = (unsigned int *) calloc(NCells, sizeof(unsigned int))))
+    ReportError((char *) Routine, 1);
+  HeadNY = Map->NY;
+  HeadNX = Map->NX;
+  HeadFresh = TRUE;
+}
+
+/* -------------------------------------------------------------
+   HeadWaterLevel
+   Computes the water table elevation of each basin cell from the
+   water table depth and, in the same pass, marks the cells whose
+   water level has changed by more than Tolerance for the next call
+   of HeadSlopeAspect().
+   ------------------------------------------------------------- */
+void HeadWaterLevel(MAPSIZE * Map, TOPOPIX ** TopoMap, SOILPIX ** SoilMap,
+		    float Tolerance)
 {
   int x;
   int y;
-  int n;
-  float neighbor_elev[NNEIGHBORS];
+  int i;
 
-  /* let's assume for now that WaterLevel is the SOILPIX map is
-     computed elsewhere */
-  for (x = 0; x < Map->NX; x++) {
-    for (y = 0; y < Map->NY; y++) {
+  if (HeadLevel == NULL || HeadNY != Map->NY || HeadNX != Map->NX)
+    InitHeadSlopeAspect(Map);
+
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static) private(x, i)
+#endif
+  for (y = 0; y < Map->NY; y++) {
+    for (x = 0, i = y * Map->NX; x < Map->NX; x++, i++) {
+      HeadChanged[i] = FALSE;
       if (INBASIN(TopoMap[y][x].Mask)) {
-		  float slope, aspect;
-		  for (n = 0; n < NNEIGHBORS; n++) {
-			  int xn = x + xneighbor[n];
-			  int yn = y + yneighbor[n];			  
-			  if (valid_cell(Map, xn, yn)) {
-				  neighbor_elev[n] =
-					  ((TopoMap[yn][xn].Mask) ? SoilMap[yn][xn].WaterLevel : (float) OUTSIDEBASIN);
-			  }
-			  else {
-				  neighbor_elev[n] = (float) OUTSIDEBASIN;
-			  }
-		  }
-		  slope_aspect(Map->DX, Map->DY, SoilMap[y][x].WaterLevel, neighbor_elev,
-		     &slope, &aspect);
-		  flow_fractions(Map->DX, Map->DY, slope, aspect, SoilMap[y][x].WaterLevel, neighbor_elev,
-		       &(FlowGrad[y][x]), Dir[y][x], &(TotalDir[y][x])); 
+	SoilMap[y][x].WaterLevel =
+	  TopoMap[y][x].Dem - SoilMap[y][x].TableDepth;
+	if (HeadFresh ||
+	    fabs(SoilMap[y][x].WaterLevel - HeadLevel[i]) > Tolerance) {
+	  HeadChanged[i] = TRUE;
+	  HeadLevel[i] = SoilMap[y][x].WaterLevel;
+	}
       }
     }
   }
+}
+
+void HeadSlopeAspect(MAPSIZE * Map, TOPOPIX ** TopoMap, SOILPIX ** SoilMap,
+		     float **FlowGrad, unsigned char ***Dir,
+		     unsigned int **TotalDir)
+{
+  int y;
+
+  /* the changed cells are marked by HeadWaterLevel() */
+  assert(HeadLevel != NULL && HeadNY == Map->NY && HeadNX == Map->NX);
+
+  /* recompute the directions around them, row by row */
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+  for (y = 0; y < Map->NY; y++)
+    HeadSlopeAspectRow(y, Map, TopoMap, SoilMap, FlowGrad, Dir, TotalDir);
+
+  HeadFresh = FALSE;
   return;
 }
 
+/* -------------------------------------------------------------
+   HeadSlopeAspectRow
+   Recomputes the marked cells of row y and their neighbors, and
+   copies the gradients of the row to FlowGrad, Dir and TotalDir.
+   ------------------------------------------------------------- */
+static void HeadSlopeAspectRow(int y, MAPSIZE * Map, TOPOPIX ** TopoMap,
+			       SOILPIX ** SoilMap, float **FlowGrad,
+			       unsigned char ***Dir, unsigned int **TotalDir)
+{
+  int x;
+  int i;
+  int n;
+  int xn;
+  int yn;
+  int Recompute;
+  float slope, aspect;
+  float neighbor_elev[NNEIGHBORS];
+  unsigned char *CellDir;
+
+  for (x = 0, i = y * Map->NX; x < Map->NX; x++, i++) {
+    if (!INBASIN(TopoMap[y][x].Mask))
+      continue;
+    CellDir = &HeadDir[i * NNEIGHBORS];
+
+    Recompute = HeadChanged[i];
+    for (n = 0; n < NNEIGHBORS && !Recompute; n++) {
+      xn = x + xneighbor[n];
+      yn = y + yneighbor[n];
+      if (valid_cell(Map, xn, yn))
+	Recompute = HeadChanged[yn * Map->NX + xn];
+    }
+
+    if (Recompute) {
+      for (n = 0; n < NNEIGHBORS; n++) {
+	xn = x + xneighbor[n];
+	yn = y + yneighbor[n];
+	if (valid_cell(Map, xn, yn)) {
+	  neighbor_elev[n] =
+	    ((TopoMap[yn][xn].Mask) ? SoilMap[yn][xn].WaterLevel : (float) OUTSIDEBASIN);
+	}
+	else {
+	  neighbor_elev[n] = (float) OUTSIDEBASIN;
+	}
+	CellDir[n] = 0;
+      }
+      slope_aspect(Map->DX, Map->DY, SoilMap[y][x].WaterLevel, neighbor_elev,
+		   &slope, &aspect);
+      flow_fractions(Map->DX, Map->DY, slope, aspect, SoilMap[y][x].WaterLevel,
+		     neighbor_elev, &HeadGrad[i], CellDir, &HeadTotalDir[i]);
+    }
+
+    FlowGrad[y][x] = HeadGrad[i];
+    for (n = 0; n < NDIRS; n++)
+      Dir[y][x][n] = CellDir[n];
+    TotalDir[y][x] = HeadTotalDir[i];
+  }
+}
 
 
 /* -------------------------------------------------------------
 SnowSlopeAspect
-This computes slope and aspect using the SnowSurface Elevation.
+This computes slope and aspect of cell (y, x) using the snow surface
+elevation.
 ------------------------------------------------------------- */
 void SnowSlopeAspect(MAPSIZE *Map, TOPOPIX **TopoMap, SNOWPIX **Snow,
-  float **SubSnowGrad, unsigned char ***Dir, unsigned int **TotalDir)
+  int y, int x, float *SubSnowGrad, unsigned char *Dir, unsigned int *TotalDir)
 {
-  int x;
-  int y;
   int n;
   float neighbor_elev[NNEIGHBORS];
+  float slope, aspect;
 
-  for (x = 0; x < Map->NX; x++) {
-    for (y = 0; y < Map->NY; y++) {
-      if (INBASIN(TopoMap[y][x].Mask)) {
-        float slope, aspect;
-        for (n = 0; n < NNEIGHBORS; n++) {
-          int xn = x + xneighbor[n];
-          int yn = y + yneighbor[n];
-          if (valid_cell(Map, xn, yn)) {
-            /* snow elevation (swq+dem) of neighboring cells */
-            neighbor_elev[n] =
-              ((TopoMap[yn][xn].Mask) ? (TopoMap[yn][xn].Dem + Snow[yn][xn].Swq) : (float)OUTSIDEBASIN);
-          }
-          else {
-            neighbor_elev[n] = (float)OUTSIDEBASIN;
-          }
-        }
-
-        slope_aspect(Map->DX, Map->DY, (TopoMap[y][x].Dem + Snow[y][x].Swq), neighbor_elev,
-          &slope, &aspect);
-        flow_fractions(Map->DX, Map->DY, slope, aspect, (TopoMap[y][x].Dem + Snow[y][x].Swq), neighbor_elev,
-          &(SubSnowGrad[y][x]), Dir[y][x], &(TotalDir[y][x]));
-
-        /* Reset SubSnowGrad to slope, don't want width in computation */
-        SubSnowGrad[y][x] = slope;
-      }
+  for (n = 0; n < NNEIGHBORS; n++) {
+    int xn = x + xneighbor[n];
+    int yn = y + yneighbor[n];
+    if (valid_cell(Map, xn, yn)) {
+      /* snow elevation (swq+dem) of neighboring cells */
+      neighbor_elev[n] =
+        ((TopoMap[yn][xn].Mask) ? (TopoMap[yn][xn].Dem + Snow[yn][xn].Swq) : (float)OUTSIDEBASIN);
+    }
+    else {
+      neighbor_elev[n] = (float)OUTSIDEBASIN;
     }
   }
-  return;
+
+  slope_aspect(Map->DX, Map->DY, (TopoMap[y][x].Dem + Snow[y][x].Swq), neighbor_elev,
+    &slope, &aspect);
+  for (n = 0; n < NDIRS; n++)
+    Dir[n] = 0;
+  flow_fractions(Map->DX, Map->DY, slope, aspect, (TopoMap[y][x].Dem + Snow[y][x].Swq), neighbor_elev,
+    SubSnowGrad, Dir, TotalDir);
+
+  /* Reset SubSnowGrad to slope, don't want width in computation */
+  *SubSnowGrad = slope;
 }
 
 
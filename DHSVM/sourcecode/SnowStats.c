@@ -27,50 +27,33 @@
 /*****************************************************************************
   SnowStats()
   
-  Calculate the statistics for SWE analysis (peak, peak date, melt out date).  
+  Update the statistics for SWE analysis (peak, peak date, melt out date) of
+  one pixel for the date DNum.  Called for each basin pixel from Aggregate().
  
   The intial values are set to zero in the function InitNewYear on very first 
   timestep of a new water year.
 
   Dates were converted to unsigned int in format of YYYYMMDD.
 *****************************************************************************/
-void SnowStats(DATE *Now, MAPSIZE *Map, OPTIONSTRUCT *Options, 
-        TOPOPIX **TopoMap, SNOWPIX **Snow, int Dt)
+void SnowStats(int DNum, SNOWPIX *Snow)
 {
-  int x;
-  int y;
-  int DNum; 
-  //printf("updating SWE stats map\n");
- 
-  DNum = Now->Year * 10000 + Now->Month * 100 + Now->Day;
-  // printf("currnet year %d \n", Now->Year);
-  // printf("currnet month is %d \n", Now->Month);
-  // printf("currnet day is %d \n", Now->Day);
-  // printf("currnet DNum is %d \n", DNum);
-  for (y = 0; y < Map->NY; y++) {
-    for (x = 0; x < Map->NX; x++) {
-      if (INBASIN(TopoMap[y][x].Mask)) {
-           //printf("currnet SWE is %f \n", Snow[y][x].Swq);
-          // Update Peak SWE and Peak SWE date
-          if ( Snow[y][x].Swq > Snow[y][x].MaxSwe){
-            Snow[y][x].MaxSwe = Snow[y][x].Swq;
-            Snow[y][x].MaxSweDate = DNum; 
-            /* When the MaxSwe is updated, reset the melt out date to 0 so that it
-            overwrites previous in-corret dates*/
-            Snow[y][x].MeltOutDate = 0; 
-          }
+  // Update Peak SWE and Peak SWE date
+  if (Snow->Swq > Snow->MaxSwe) {
+    Snow->MaxSwe = Snow->Swq;
+    Snow->MaxSweDate = DNum;
+    /* When the MaxSwe is updated, reset the melt out date to 0 so that it
+    overwrites previous in-corret dates*/
+    Snow->MeltOutDate = 0;
+  }
 
-          // Update Peak SWE Date
-          /* Criteria :
-            1. If snow < 5mm
-            2. First date past the peak SWE date
-            3. And Preceding 7/15 day has snow  //for now this was not implimented
-          */
-         if ((Snow[y][x].Swq < MIN_SWE) && (DNum > Snow[y][x].MaxSweDate) && (Snow[y][x].MeltOutDate == 0)){
-            Snow[y][x].MeltOutDate = DNum;    
-            if (DEBUG) printf("SWE Melt out date is %d \n", Snow[y][x].MeltOutDate);
-            }
-      }
-    }
+  // Update Peak SWE Date
+  /* Criteria :
+    1. If snow < 5mm
+    2. First date past the peak SWE date
+    3. And Preceding 7/15 day has snow  //for now this was not implimented
+  */
+  if ((Snow->Swq < MIN_SWE) && (DNum > Snow->MaxSweDate) && (Snow->MeltOutDate == 0)) {
+    Snow->MeltOutDate = DNum;
+    if (DEBUG) printf("SWE Melt out date is %d \n", Snow->MeltOutDate);
   }
 }
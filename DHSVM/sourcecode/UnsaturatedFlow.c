@@ -46,6 +46,8 @@ float *RootDepth   - Depth of each of the soil layers (m)
 float *Ks          - Vertical saturated hydraulic conductivity in each
 soil layer (m/s)
 float *PoreDist    - Pore size distribution index for each soil layer
+FLOATTABLE *DrainTable - Table of (Moist/Porosity)^Exponent for each soil
+layer, or NULL to call pow()
 float *Porosity    - Porosity of each soil layer
 float *FCap        - Field capacity of each soil layer
 float *Perc        - Amount of water percolating from each soil layer to
@@ -115,7 +117,7 @@ calculated in AdjustStorage() and CutBankGeometry()
 void UnsaturatedFlow(int Dt, float DX, float DY, float Infiltration,
   float RoadbedInfiltration, float SatFlow, int NSoilLayers,
   float TotalDepth, float Area, float *RootDepth, float *Ks,
-  float *PoreDist, float *Porosity, float *FCap,
+  float *PoreDist, FLOATTABLE *DrainTable, float *Porosity, float *FCap,
   float *Perc, float *PercArea, float *Adjust,
   int CutBankZone, float BankHeight, float *TableDepth,
   float *Runoff, float *Moist, int InfiltOption)
@@ -126,6 +128,7 @@ void UnsaturatedFlow(int Dt, float DX, float DY, float Infiltration,
   float Drainage;		    /* amount of water drained from each soil
                                layer during the current timestep */
   float Exponent;		    /* Brooks-Corey exponent */
+  float Ratio;		        /* tabulated (Moist/Porosity)^Exponent */
   float FieldCapacity;		/* amount of water in soil at field capacity (m) */
   float MaxSoilWater;		/* maximum allowable amount of soil moiture in each layer (m) */
   float SoilWater;		    /* amount of water in each soil layer (m) */
@@ -171,6 +174,9 @@ void UnsaturatedFlow(int Dt, float DX, float DY, float Infiltration,
         /* this can happen because the moisture content can exceed the
         porosity the way the algorithm is implemented */
         Drainage = Ks[i];
+      else if (DrainTable != NULL &&
+        FloatInterpolate(Moist[i]/Porosity[i], &(DrainTable[i]), &Ratio))
+        Drainage = Ks[i] * Ratio;
       else
         Drainage = Ks[i] * pow((double)(Moist[i]/Porosity[i]), (double)Exponent);
       /* convert to m */
@@ -91,6 +91,14 @@ struct {
   022, "Basin.FlowDir",
        "FlowDir", "%.0f",
        "none", "FlowDir", NC_FLOAT, FALSE, FALSE, FALSE, 0}, {
+  023, "Basin.DrainsY",
+       "Impervious drainage row", "%d",
+       "", "Row of the channel cell impervious runoff drains to",
+       NC_INT, FALSE, FALSE, FALSE, 0}, {
+  024, "Basin.DrainsX",
+       "Impervious drainage column", "%d",
+       "", "Column of the channel cell impervious runoff drains to",
+       NC_INT, FALSE, FALSE, FALSE, 0}, {
   100, "Met.PrecipMultiplier",
 	   "PptMultiplier", "%.8f",
 	   "", "Precipitation Multiplier", NC_FLOAT, FALSE, FALSE, FALSE, 0 },{
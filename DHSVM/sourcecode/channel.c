@@ -254,6 +254,7 @@ static Channel *alloc_channel_segment(void)
   seg->last_inflow = 0.0;
   seg->last_outflow = 0.0;
   seg->inflow = 0.0;
+  seg->sub_inflow = 0.0;
   seg->outflow = 0.0;
   seg->storage= 0.0;
   seg->outlet = NULL;
@@ -301,7 +302,7 @@ Channel *channel_find_segment(Channel * head, SegmentID id)
 /* -------------------------------------------------------------
 channel_routing_parameters
 ------------------------------------------------------------- */
-void channel_routing_parameters(Channel *network, int deltat)
+void channel_routing_parameters(Channel *network, double deltat)
 {
   /*   float ck; */
   float y;
@@ -312,12 +313,32 @@ void channel_routing_parameters(Channel *network, int deltat)
     /*  for new routing scheme */
     segment->K = sqrt(segment->slope) * pow((double)y, 2.0 / 3.0) /
       (segment->class2->friction * segment->length);
-    segment->X = exp(-segment->K * deltat);
+    segment->X = exp(-segment->K * (float) deltat);
   }
 
   return;
 }
 
+/* -------------------------------------------------------------
+channel_routing_substeps
+Number of routing sub steps of deltat needed to keep the Courant
+number K * dt of every segment in network at or below courant.  1
+if courant is 0 (no sub steps).
+------------------------------------------------------------- */
+int channel_routing_substeps(Channel *network, int deltat, float courant)
+{
+  float maxK = 0.0;
+  Channel *segment;
+
+  for (segment = network; segment != NULL; segment = segment->next) {
+    if (segment->K > maxK)
+      maxK = segment->K;
+  }
+  if (courant <= 0.0 || maxK * deltat <= courant)
+    return 1;
+  return (int) ceil(maxK * deltat / courant);
+}
+
 /* -------------------------------------------------------------
 channel_read_network
 ------------------------------------------------------------- */
@@ -551,6 +572,103 @@ int channel_route_network(Channel * net, int deltat)
   return (err);
 }
 
+/* -------------------------------------------------------------
+channel_route_segment_substep
+Routes one sub step of length dt of the model time step deltat.
+The inflow from upstream is what the upstream segments released in
+this sub step, the lateral inflow is spread evenly over the time
+step; outflow accumulates over the sub steps.
+------------------------------------------------------------- */
+static int channel_route_segment_substep(Channel * segment, float dt,
+					 int deltat)
+{
+  float K = segment->K;
+  float X = segment->X;
+  float inflow;
+  float outflow;
+  float storage;
+
+  inflow = segment->sub_inflow / dt + segment->lateral_inflow / deltat;
+  segment->sub_inflow = 0.0;
+
+  storage = (inflow / K) + (segment->storage - inflow / K) * X;
+  if (storage < 0.0)
+    storage = 0.0;
+  outflow = inflow * dt - (storage - segment->storage);
+
+  segment->outflow += outflow;
+  segment->storage = storage;
+
+  /* as without sub steps, an outlet routed before the segment (as the
+     network outlet may be) does not route this inflow in this step */
+  if (segment->outlet != NULL) {
+    segment->outlet->inflow += outflow;
+    if (segment->outlet->order > segment->order)
+      segment->outlet->sub_inflow += outflow;
+  }
+
+  return (0);
+}
+
+/* -------------------------------------------------------------
+channel_route_network_substeps
+Routes the network in nsteps sub steps of deltat, so that the flow
+released by a segment reaches its outlet within the time step.  X
+of the segments must be that of the sub step length (see
+channel_routing_parameters()).
+------------------------------------------------------------- */
+int channel_route_network_substeps(Channel * net, int deltat, int nsteps)
+{
+  int order;
+  int order_count;
+  int nsegs;
+  int i;
+  int step;
+  int err = 0;
+  float dt;
+  Channel *current;
+  Channel **ordered;
+
+  if (nsteps <= 1)
+    return (channel_route_network(net, deltat));
+
+  /* the segments in computation order, once for all sub steps */
+  for (nsegs = 0, current = net; current != NULL; current = current->next)
+    nsegs++;
+  if ((ordered = (Channel **) malloc(nsegs * sizeof(Channel *))) == NULL) {
+    error_handler(ERRHDL_ERROR,
+		  "channel_route_network_substeps: malloc failed: %s",
+		  strerror(errno));
+    return (1);
+  }
+  for (i = 0, order = 1;; order += 1) {
+    order_count = 0;
+    for (current = net; current != NULL; current = current->next) {
+      if (current->order == order) {
+        ordered[i++] = current;
+        order_count += 1;
+      }
+    }
+    if (order_count == 0)
+      break;
+  }
+  nsegs = i;
+
+  dt = (float) deltat / nsteps;
+  for (i = 0; i < nsegs; i++) {
+    ordered[i]->outflow = 0.0;
+    ordered[i]->sub_inflow = 0.0;
+  }
+
+  for (step = 0; step < nsteps; step++) {
+    for (i = 0; i < nsegs; i++)
+      err += channel_route_segment_substep(ordered[i], dt, deltat);
+  }
+
+  free(ordered);
+  return (err);
+}
+
 /* -------------------------------------------------------------
 channel_step_initialize_network
 ------------------------------------------------------------- */
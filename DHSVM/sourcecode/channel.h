@@ -74,6 +74,7 @@ struct _channel_rec_ {
   float last_outflow;	/* cubic meters */
   float last_storage;	/* cubic meters */
   float inflow;			/* cubic meters */
+  float sub_inflow;		/* cubic meters, inflow in the current sub step */
   float outflow;		/* cubic meters */
   float storage;		/* cubic meters */
   float last_lateral_inflow;
@@ -110,11 +111,13 @@ void channel_free_classes(ChannelClass *head);
 /* Channel */
 Channel *channel_read_network(const char *file, ChannelClass * class_list, int *MaxID);
 int channel_read_rveg_param(Channel *net, const char *file, int *MaxID);
-void channel_routing_parameters(Channel *net, int deltat);
+void channel_routing_parameters(Channel *net, double deltat);
+int channel_routing_substeps(Channel *net, int deltat, float courant);
 Channel *channel_find_segment(Channel *net, SegmentID id);
 int channel_step_initialize_network(Channel *net);
 int channel_incr_lat_inflow(Channel *segment, float linflow);
 int channel_route_network(Channel *net, int deltat);
+int channel_route_network_substeps(Channel *net, int deltat, int nsteps);
 int channel_save_outflow(double time, Channel * net, FILE *file, FILE *file2);
 int channel_save_outflow_text(char *tstring, Channel *net, FILE *out,
 			      FILE *out2, int flag);
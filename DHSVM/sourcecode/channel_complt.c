@@ -10,6 +10,10 @@
  * DESCRIP-END.
  * FUNCTIONS:    channel_save_outflow_text_cplmt()
                  channel_save_outflow_cplmt()
+                 channel_read_rbm_segmap()
+                 channel_open_rbm_forcing()
+                 channel_rbm_forcing_record()
+                 channel_save_rbm_forcing()
  * Modification 
  * $Id: channel_complt.c, v 3.2  2013/04/23   Ning Exp $    
  */
@@ -20,11 +24,15 @@
 #include <math.h>
 #include <errno.h>
 #include "errorhandler.h"
+#include "DHSVMerror.h"
 //#include "channel.h"
 #include "functions.h"
 #include "constants.h"
 #include "tableio.h"
 #include "settings.h"
+#include "fileio.h"
+#include "Calendar.h"
+
 
 /* -------------------------------------------------------------
    ---------------------- Channel Functions --------------------
@@ -128,11 +136,7 @@ channel_save_outflow_text_cplmt
     fprintf(out15, "\n");                         
   }
 
-  Time->Current.JDay = DayOfYear(Time->Current.Year, Time->Current.Month, Time->Current.Day);
-  Time->Start.JDay = DayOfYear(Time->Start.Year, Time->Start.Month, Time->Start.Day);
-
-  if ((Time->Current.JDay>=Time->Start.JDay+1) || 
-	  (Time->Current.Year>Time->Start.Year)) {
+  if (rbm_output_step(Time)) {
   if (fprintf(out, "%s ", tstring) == EOF) {
     error_handler(ERRHDL_ERROR,"channel_save_outflow: write error:%s", strerror(errno));
     err++;
@@ -214,3 +218,155 @@ channel_save_outflow_text_cplmt
 }
 
 
+
+/* -------------------------------------------------------------
+   rbm_output_step
+   RBM forcing starts with the first full day after the model start
+   ------------------------------------------------------------- */
+int
+rbm_output_step(TIMESTRUCT *Time)
+{
+  Time->Current.JDay = DayOfYear(Time->Current.Year, Time->Current.Month, Time->Current.Day);
+  Time->Start.JDay = DayOfYear(Time->Start.Year, Time->Start.Month, Time->Start.Day);
+
+  return ((Time->Current.JDay>=Time->Start.JDay+1) || 
+	  (Time->Current.Year>Time->Start.Year));
+}
+
+/* -------------------------------------------------------------
+   channel_read_rbm_segmap
+   Reads the RBM segment order from <project>.segmap (written by
+   build_DHSVM_network.pl)
+   ------------------------------------------------------------- */
+void
+channel_read_rbm_segmap(const char *project, CHANNEL * netfile)
+{
+  char buffer[NAMESIZE];
+  char word[BUFSIZE + 1];
+  FILE *segmap;
+  int nhead, nseg, seq, id, i;
+
+  if (snprintf(buffer, sizeof(buffer), "%s.segmap", project) >=
+      (int) sizeof(buffer))
+    ReportError((char *) project, 72);
+  OpenFile(&segmap, buffer, "r", FALSE);
+  if (fscanf(segmap, "%d %d", &nhead, &nseg) != 2 || nseg <= 0)
+    error_handler(ERRHDL_FATAL, "%s: unable to read segment count", buffer);
+
+  if ((netfile->rbmseg = (Channel **) calloc(nseg, sizeof(Channel *))) == NULL)
+    error_handler(ERRHDL_FATAL, "channel_read_rbm_segmap: out of memory");
+  netfile->nrbmseg = nseg;
+
+  for (i = 0; i < nseg; i++) {
+    if (fscanf(segmap, "%s %d %s %d", word, &seq, word, &id) != 4)
+      error_handler(ERRHDL_FATAL, "%s: unable to read segment %d", buffer, i + 1);
+    if ((netfile->rbmseg[i] = channel_find_segment(netfile->streams, id)) == NULL)
+      error_handler(ERRHDL_FATAL, "%s: segment %d not in stream network", 
+		    buffer, id);
+  }
+  fclose(segmap);
+}
+
+/* -------------------------------------------------------------
+   channel_open_rbm_forcing
+   Reads the RBM segment order and opens the direct access forcing
+   file <project>.forcing.bin
+   ------------------------------------------------------------- */
+void
+channel_open_rbm_forcing(const char *project, CHANNEL * netfile)
+{
+  char buffer[NAMESIZE];
+
+  channel_read_rbm_segmap(project, netfile);
+
+  if (snprintf(buffer, sizeof(buffer), "%s.forcing.bin", project) >=
+      (int) sizeof(buffer))
+    ReportError((char *) project, 72);
+  OpenFile(&(netfile->streamforcing), buffer, "wb", TRUE);
+}
+
+/* -------------------------------------------------------------
+   channel_rbm_forcing_record
+   Fills the RBM_NFORCING values RBM expects for one segment:
+     pressure (mb), air temperature (C), net longwave and net shortwave 
+     (kcal/m2/s), vapor pressure (mb), wind (m/s), melt (m3/s),
+     inflow and outflow (cfs)
+   with the same unit conversions and flow floors as Create_File.
+   ------------------------------------------------------------- */
+void
+channel_rbm_forcing_record(Channel * seg, int Dt, float *record)
+{
+  float inflow, outflow;
+
+  inflow = seg->inflow / Dt * 35.315;
+  outflow = seg->outflow / Dt * 35.315;
+  if (inflow < 0.01 && outflow < 0.01) {
+    inflow = 0.01;
+    outflow = inflow;
+  }
+  if (inflow < 0.01 && outflow >= 0.01)
+    inflow = 0.01;
+
+  record[0] = 1013.;
+  record[1] = seg->ATP;
+  record[2] = 2.3884e-04 * seg->NLW;
+  record[3] = 2.3884e-04 * seg->NSW;
+  record[4] = 0.01 * seg->VP;
+  record[5] = seg->WND;
+  record[6] = seg->melt / Dt;
+  record[7] = inflow;
+  record[8] = outflow;
+}
+
+/* -------------------------------------------------------------
+   channel_save_rbm_forcing
+   Writes the RBM forcing that Create_File used to assemble from the 
+   *.Only files.  <project>.forcing gets the one-line header, and
+   <project>.forcing.bin gets one record per RBM segment per time
+   step, segments in RBM order, so that RBM can read segment n of
+   time step k as record (k - 1) * nseg + n.  Each record holds
+   the RBM_NFORCING 4-byte reals of channel_rbm_forcing_record().
+   ------------------------------------------------------------- */
+int
+channel_save_rbm_forcing(TIMESTRUCT *Time, const char *project, 
+			 CHANNEL * netfile, int flag)
+{
+  char buffer[NAMESIZE];
+  FILE *header;
+  float record[RBM_NFORCING];
+  int Dt, i;
+  int y, m, d, h, mi;
+  double sec;
+  int err = 0;
+
+  Dt = Time->Dt;
+
+  /* same start day (the day after the model start) and end date as
+     the *.Only headers */
+  if (flag == 1) {
+    if (snprintf(buffer, sizeof(buffer), "%s.forcing", project) >=
+        (int) sizeof(buffer))
+      ReportError((char *) project, 72);
+    OpenFile(&header, buffer, "w", TRUE);
+    JulianDayToGregorian(Time->Current.Julian + 1, &y, &m, &d, &h, &mi, &sec);
+    fprintf(header, "%04d%02d%02d:%02d %04d%02d%02d:%02d %4d%4d\n",
+	    y, m, d, 0, Time->End.Year, Time->End.Month, Time->End.Day,
+	    Time->End.Hour, SECPDAY / Dt, 1);
+    fclose(header);
+  }
+
+  if (!rbm_output_step(Time))
+    return (err);
+
+  for (i = 0; i < netfile->nrbmseg; i++) {
+    channel_rbm_forcing_record(netfile->rbmseg[i], Dt, record);
+    if (fwrite(record, sizeof(float), RBM_NFORCING, netfile->streamforcing) 
+	!= RBM_NFORCING) {
+      error_handler(ERRHDL_ERROR, "channel_save_rbm_forcing: write error:%s", 
+		    strerror(errno));
+      err++;
+    }
+  }
+
+  return (err);
+}
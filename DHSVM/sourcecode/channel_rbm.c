@@ -0,0 +1,145 @@
+/*
+ * SUMMARY:      channel_rbm.c - In-process RBM stream temperature model
+ * USAGE:        Part of DHSVM-RBM
+ *
+ * DESCRIPTION:  Runs the RBM semi-Lagrangian stream temperature model
+ *               inside the DHSVM time loop.  Each time step the RBM
+ *               forcing of every RBM cell is taken from its channel
+ *               segment in memory (the values channel_save_rbm_forcing()
+ *               would write) and handed to RBM, which advances the
+ *               temperatures by one step, so no *.Only or forcing files
+ *               are needed.  RBM reads the network, Leopold and Mohseni
+ *               files of the stand-alone program and writes
+ *               <project>.temp in the same format.
+ * DESCRIP-END.
+ * FUNCTIONS:    channel_rbm_init()
+ *               channel_rbm_step()
+ *               channel_rbm_close()
+ * COMMENTS:     The model itself is RBM/RBM.f, called through the
+ *               ISO_C_BINDING entry points of RBM/RBM_Coupled.f, which
+ *               are only built with DHSVM_USE_RBM (HAVE_RBM).
+ *               Scripts/compare_rbm.sh runs DHSVM with and without RBM
+ *               Coupled and checks that the two <project>.temp files are
+ *               identical.
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "errorhandler.h"
+#include "functions.h"
+#include "constants.h"
+#include "settings.h"
+
+struct _RBMSTATE {
+  int ncell;			/* number of RBM cells */
+  float *forcing;		/* RBM_NFORCING values per cell */
+};
+
+#ifdef HAVE_RBM
+
+/* RBM/RBM_Coupled.f */
+void rbm_coupled_init(const char *prefix, int nprefix, int nwpd, int *ncell);
+void rbm_coupled_step(float *forcing, int year, int jday, int period);
+void rbm_coupled_close(void);
+
+/* -------------------------------------------------------------
+   channel_rbm_init
+   Reads <project>.segmap and has RBM read <project>.net, .Leopold
+   and .Mohseni and open <project>.temp
+   ------------------------------------------------------------- */
+void
+channel_rbm_init(const char *project, int Dt, CHANNEL * netfile)
+{
+  RBMSTATE *rbm;
+
+  channel_read_rbm_segmap(project, netfile);
+
+  if ((rbm = (RBMSTATE *) calloc(1, sizeof(RBMSTATE))) == NULL)
+    error_handler(ERRHDL_FATAL, "channel_rbm_init: out of memory");
+  rbm_coupled_init(project, (int) strlen(project), SECPDAY / Dt,
+		   &(rbm->ncell));
+  if (rbm->ncell != netfile->nrbmseg)
+    error_handler(ERRHDL_FATAL,
+		  "%s: %d cells in the network file but %d in the segment map",
+		  project, rbm->ncell, netfile->nrbmseg);
+  if ((rbm->forcing = (float *) calloc(rbm->ncell * RBM_NFORCING,
+				       sizeof(float))) == NULL)
+    error_handler(ERRHDL_FATAL, "channel_rbm_init: out of memory");
+
+  error_handler(ERRHDL_STATUS, "channel_rbm_init: %d cells", rbm->ncell);
+  netfile->rbm = rbm;
+}
+
+/* -------------------------------------------------------------
+   channel_rbm_step
+   Advances the stream temperatures by one time step using the
+   current segment forcing and appends them to <project>.temp.
+   Like the forcing file, the coupled run starts with the first full
+   day after the model start.
+   ------------------------------------------------------------- */
+int
+channel_rbm_step(TIMESTRUCT * Time, CHANNEL * netfile)
+{
+  RBMSTATE *rbm = netfile->rbm;
+  int l;
+
+  if (rbm == NULL || !rbm_output_step(Time))
+    return (0);
+
+  for (l = 0; l < rbm->ncell; l++)
+    channel_rbm_forcing_record(netfile->rbmseg[l], Time->Dt,
+			       &(rbm->forcing[l * RBM_NFORCING]));
+  rbm_coupled_step(rbm->forcing, Time->Current.Year, Time->Current.JDay,
+		   Time->DayStep + 1);
+
+  return (0);
+}
+
+/* -------------------------------------------------------------
+   channel_rbm_close
+   ------------------------------------------------------------- */
+void
+channel_rbm_close(CHANNEL * netfile)
+{
+  RBMSTATE *rbm = netfile->rbm;
+
+  if (rbm == NULL)
+    return;
+
+  rbm_coupled_close();
+  free(rbm->forcing);
+  free(rbm);
+  netfile->rbm = NULL;
+}
+
+#else
+
+/* -------------------------------------------------------------
+   channel_rbm_init
+   ------------------------------------------------------------- */
+void
+channel_rbm_init(const char *project, int Dt, CHANNEL * netfile)
+{
+  error_handler(ERRHDL_FATAL,
+		"channel_rbm_init: RBM Coupled needs DHSVM built with RBM (DHSVM_USE_RBM)");
+}
+
+/* -------------------------------------------------------------
+   channel_rbm_step
+   ------------------------------------------------------------- */
+int
+channel_rbm_step(TIMESTRUCT * Time, CHANNEL * netfile)
+{
+  return (0);
+}
+
+/* -------------------------------------------------------------
+   channel_rbm_close
+   ------------------------------------------------------------- */
+void
+channel_rbm_close(CHANNEL * netfile)
+{
+}
+
+#endif
@@ -0,0 +1,300 @@
+/*
+ * SUMMARY:      channel_series.c - Columnar stream segment time series
+ * USAGE:        Part of DHSVM
+ *
+ * DESCRIPTION:  Replaces the per-segment fprintf() of Stream.Flow and
+ *               Streamflow.Only with one record per variable per time
+ *               step.  Each step the values of all selected segments are
+ *               gathered in one pass, then written with a single fwrite()
+ *               per variable to Stream.<Variable>.bin, or as one
+ *               (time, segment) slice per variable to Stream.Series.nc.
+ *               The segments are either those flagged SAVE in the stream
+ *               network file or all of them.
+ * DESCRIP-END.
+ * FUNCTIONS:    channel_series_init()
+ *               channel_series_save()
+ *               channel_series_close()
+ * COMMENTS:     Stream.Series describes the binary files:  the variables,
+ *               the segment of each column and the date of each record.
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#ifdef HAVE_NETCDF
+#include <netcdf.h>
+#endif
+#include "errorhandler.h"
+#include "DHSVMerror.h"
+#include "functions.h"
+#include "constants.h"
+#include "settings.h"
+#include "fileio.h"
+#include "Calendar.h"
+
+/* the segment variables, the last ones only with stream temperature */
+typedef enum {
+  SeriesInflow, SeriesLateralInflow, SeriesOutflow, SeriesStorageChange,
+  SeriesATP, SeriesNSW, SeriesNLW, SeriesVP, SeriesWND, SeriesMelt,
+  NSERIESVARS
+} SERIESVAR;
+
+#define NFLOWVARS (SeriesStorageChange + 1)
+
+static const struct {
+  const char *Name;
+  const char *LongName;
+  const char *Units;
+} SeriesVar[NSERIESVARS] = {
+  {"Inflow", "Segment inflow", "m3/timestep"},
+  {"LateralInflow", "Segment lateral inflow", "m3/timestep"},
+  {"Outflow", "Segment outflow", "m3/timestep"},
+  {"StorageChange", "Segment storage change", "m3/timestep"},
+  {"ATP", "Segment air temperature", "C"},
+  {"NSW", "Net shortwave radiation at the water surface", "W/m2"},
+  {"NLW", "Net longwave radiation at the water surface", "W/m2"},
+  {"VP", "Segment vapor pressure", "Pa"},
+  {"WND", "Segment wind speed", "m/s"},
+  {"Melt", "Segment snow melt inflow", "m3/timestep"}
+};
+
+struct _CHANNELSERIES {
+  int Format;			/* BIN or NETCDF */
+  int NVars;
+  int NSeg;
+  Channel **Seg;		/* selected segments, in network order */
+  float *Buffer;		/* NVars x NSeg values of the current step */
+  FILE *Index;			/* Stream.Series, dates of the records */
+  FILE *Out[NSERIESVARS];	/* Stream.<Variable>.bin */
+  int ncid;			/* Stream.Series.nc */
+  int TimeVarID;
+  int VarID[NSERIESVARS];
+  size_t NRecords;
+};
+
+#ifdef HAVE_NETCDF
+static void series_check_nc(int ncstatus, const char *FileName);
+#endif
+
+/* -------------------------------------------------------------
+   channel_series_init
+   Selects the segments and creates the output files
+   ------------------------------------------------------------- */
+void
+channel_series_init(OPTIONSTRUCT * Options, char *DumpPath, DATE * Start,
+		    CHANNEL * channel)
+{
+#ifndef HAVE_NETCDF
+  const char *Routine = "channel_series_init";
+#endif
+  char buffer[NAMESIZE];
+  CHANNELSERIES *series;
+  Channel *net;
+  int i, v;
+#ifdef HAVE_NETCDF
+  int dimids[2], segvar, *ids;
+  char units[BUFSIZE + 1];
+#endif
+
+  if (channel->streams == NULL)
+    return;
+
+  if ((series = (CHANNELSERIES *) calloc(1, sizeof(CHANNELSERIES))) == NULL)
+    error_handler(ERRHDL_FATAL, "channel_series_init: out of memory");
+  series->Format = Options->StreamSeries;
+  series->NVars = Options->StreamTemp ? NSERIESVARS : NFLOWVARS;
+
+  for (net = channel->streams; net != NULL; net = net->next)
+    if (Options->StreamSeriesAll || net->record)
+      series->NSeg++;
+  if (series->NSeg == 0)
+    error_handler(ERRHDL_WARNING,
+		  "channel_series_init: no stream segments are recorded");
+
+  if ((series->Seg = (Channel **) calloc(series->NSeg + 1, sizeof(Channel *)))
+      == NULL ||
+      (series->Buffer = (float *) calloc(series->NVars * series->NSeg + 1,
+					 sizeof(float))) == NULL)
+    error_handler(ERRHDL_FATAL, "channel_series_init: out of memory");
+  for (net = channel->streams, i = 0; net != NULL; net = net->next)
+    if (Options->StreamSeriesAll || net->record)
+      series->Seg[i++] = net;
+
+  if (series->Format == NETCDF) {
+#ifdef HAVE_NETCDF
+    if (snprintf(buffer, sizeof(buffer), "%sStream.Series.nc", DumpPath) >=
+        (int) sizeof(buffer))
+      ReportError(DumpPath, 72);
+    series_check_nc(nc_create(buffer, NC_CLOBBER | NC_NETCDF4, &(series->ncid)),
+		    buffer);
+    series_check_nc(nc_def_dim(series->ncid, "time", NC_UNLIMITED, &dimids[0]),
+		    buffer);
+    series_check_nc(nc_def_dim(series->ncid, "segment", series->NSeg > 0 ?
+			       series->NSeg : 1, &dimids[1]), buffer);
+    series_check_nc(nc_def_var(series->ncid, "time", NC_DOUBLE, 1, dimids,
+			       &(series->TimeVarID)), buffer);
+    sprintf(units, "hours since %04d-%02d-%02d %02d:%02d:%02d", Start->Year,
+	    Start->Month, Start->Day, Start->Hour, Start->Min, Start->Sec);
+    series_check_nc(nc_put_att_text(series->ncid, series->TimeVarID, "units",
+				    strlen(units), units), buffer);
+    series_check_nc(nc_def_var(series->ncid, "segment_id", NC_INT, 1,
+			       &dimids[1], &segvar), buffer);
+    for (v = 0; v < series->NVars; v++) {
+      series_check_nc(nc_def_var(series->ncid, SeriesVar[v].Name, NC_FLOAT, 2,
+				 dimids, &(series->VarID[v])), buffer);
+      series_check_nc(nc_put_att_text(series->ncid, series->VarID[v],
+				      "long_name", strlen(SeriesVar[v].LongName),
+				      SeriesVar[v].LongName), buffer);
+      series_check_nc(nc_put_att_text(series->ncid, series->VarID[v], "units",
+				      strlen(SeriesVar[v].Units),
+				      SeriesVar[v].Units), buffer);
+    }
+    series_check_nc(nc_enddef(series->ncid), buffer);
+
+    if ((ids = (int *) calloc(series->NSeg + 1, sizeof(int))) == NULL)
+      error_handler(ERRHDL_FATAL, "channel_series_init: out of memory");
+    for (i = 0; i < series->NSeg; i++)
+      ids[i] = series->Seg[i]->id;
+    series_check_nc(nc_put_var_int(series->ncid, segvar, ids), buffer);
+    free(ids);
+#else
+    ReportError((char *) Routine, 56);
+#endif
+  }
+  else {
+    if (snprintf(buffer, sizeof(buffer), "%sStream.Series", DumpPath) >=
+        (int) sizeof(buffer))
+      ReportError(DumpPath, 72);
+    OpenFile(&(series->Index), buffer, "w", TRUE);
+    fprintf(series->Index, "# variables (4-byte reals, one record of %d "
+	    "segments per date)\n%d\n", series->NSeg, series->NVars);
+    for (v = 0; v < series->NVars; v++) {
+      fprintf(series->Index, "Stream.%s.bin %s\n", SeriesVar[v].Name,
+	      SeriesVar[v].Units);
+      if (snprintf(buffer, sizeof(buffer), "%sStream.%s.bin", DumpPath,
+		   SeriesVar[v].Name) >= (int) sizeof(buffer))
+	ReportError(DumpPath, 72);
+      OpenFile(&(series->Out[v]), buffer, "wb", TRUE);
+    }
+    fprintf(series->Index, "# segments (column, id, name)\n%d\n", series->NSeg);
+    for (i = 0; i < series->NSeg; i++)
+      fprintf(series->Index, "%d %d \"%s\"\n", i + 1, series->Seg[i]->id,
+	      series->Seg[i]->record_name != NULL ?
+	      series->Seg[i]->record_name : "");
+    fprintf(series->Index, "# dates (one per record)\n");
+  }
+
+  channel->series = series;
+}
+
+/* -------------------------------------------------------------
+   channel_series_save
+   Gathers one step of all selected segments and writes it
+   ------------------------------------------------------------- */
+int
+channel_series_save(TIMESTRUCT * Time, CHANNELSERIES * series)
+{
+  char buffer[32];
+  Channel *seg;
+  float *value;
+  int i, v;
+  int err = 0;
+#ifdef HAVE_NETCDF
+  size_t start[2], count[2];
+  double hours;
+#endif
+
+  /* one pass through the segments, variables stored column by column */
+  for (i = 0; i < series->NSeg; i++) {
+    seg = series->Seg[i];
+    value = series->Buffer + i;
+    value[SeriesInflow * series->NSeg] = seg->inflow;
+    value[SeriesLateralInflow * series->NSeg] = seg->lateral_inflow;
+    value[SeriesOutflow * series->NSeg] = seg->outflow;
+    value[SeriesStorageChange * series->NSeg] = seg->storage - seg->last_storage;
+    if (series->NVars > NFLOWVARS) {
+      value[SeriesATP * series->NSeg] = seg->ATP;
+      value[SeriesNSW * series->NSeg] = seg->NSW;
+      value[SeriesNLW * series->NSeg] = seg->NLW;
+      value[SeriesVP * series->NSeg] = seg->VP;
+      value[SeriesWND * series->NSeg] = seg->WND;
+      value[SeriesMelt * series->NSeg] = seg->melt;
+    }
+  }
+
+  if (series->Format == NETCDF) {
+#ifdef HAVE_NETCDF
+    start[0] = series->NRecords;
+    start[1] = 0;
+    count[0] = 1;
+    count[1] = series->NSeg;
+    hours = (double) Time->Step * Time->Dt / 3600.;
+    series_check_nc(nc_put_var1_double(series->ncid, series->TimeVarID, start,
+				       &hours), "Stream.Series.nc");
+    for (v = 0; v < series->NVars; v++)
+      series_check_nc(nc_put_vara_float(series->ncid, series->VarID[v], start,
+					count, series->Buffer + v * series->NSeg),
+		      "Stream.Series.nc");
+#endif
+  }
+  else {
+    SPrintDate(&(Time->Current), buffer);
+    if (fprintf(series->Index, "%s\n", buffer) < 0) {
+      error_handler(ERRHDL_ERROR, "channel_series_save: write error:%s",
+		    strerror(errno));
+      err++;
+    }
+    for (v = 0; v < series->NVars; v++) {
+      if (fwrite(series->Buffer + v * series->NSeg, sizeof(float), series->NSeg,
+		 series->Out[v]) != (size_t) series->NSeg) {
+	error_handler(ERRHDL_ERROR, "channel_series_save: write error:%s",
+		      strerror(errno));
+	err++;
+      }
+    }
+  }
+  series->NRecords++;
+
+  return (err);
+}
+
+/* -------------------------------------------------------------
+   channel_series_close
+   ------------------------------------------------------------- */
+void
+channel_series_close(CHANNEL * channel)
+{
+  CHANNELSERIES *series = channel->series;
+  int v;
+
+  if (series == NULL)
+    return;
+
+  if (series->Format == NETCDF) {
+#ifdef HAVE_NETCDF
+    series_check_nc(nc_close(series->ncid), "Stream.Series.nc");
+#endif
+  }
+  else {
+    fclose(series->Index);
+    for (v = 0; v < series->NVars; v++)
+      fclose(series->Out[v]);
+  }
+  free(series->Seg);
+  free(series->Buffer);
+  free(series);
+  channel->series = NULL;
+}
+
+#ifdef HAVE_NETCDF
+/* -------------------------------------------------------------
+   series_check_nc
+   ------------------------------------------------------------- */
+static void
+series_check_nc(int ncstatus, const char *FileName)
+{
+  if (ncstatus != NC_NOERR)
+    error_handler(ERRHDL_FATAL, "%s: %s", FileName, nc_strerror(ncstatus));
+}
+#endif
@@ -19,6 +19,7 @@
 #include "settings.h"
 #include "Calendar.h"
 #include "channel.h"
+#include "lookuptable.h"
 
 typedef struct {
   int N;			/* Northing */
@@ -45,14 +46,48 @@ typedef struct {
   char FileLabel[BUFSIZE + 1];	/* File label */
   int NumberType;		/* Number type of variable */
   DATE *DumpDate;		/* Date(s) at which to dump */
+  int Statistic;		/* 0 for the state at DumpDate, else DUMP_MEAN,
+				   DUMP_SUM, DUMP_MIN or DUMP_MAX over the
+				   period ending at DumpDate */
+  DATE PeriodStart;		/* End of the previous period */
+  int Next;			/* Next DumpDate of an aggregated map */
+  int NSteps;			/* Time steps accumulated in the period */
+  int NSlots;			/* Fields accumulated per time step */
+  int Slot;			/* Field being accumulated */
+  double *Acc;			/* NSlots accumulated fields */
+  float *Capture;		/* If not NULL the first field is copied here
+				   instead of written, see DHSVMGetField() */
 } MAPDUMP;
 
 typedef struct {
 
   COORD Loc;			/* Location for which to dump */
+  char Name[BUFSIZE + 1];	/* Name of the dump location */
   FILES OutFile;		/* Files in which to dump */
 } PIXDUMP;
 
+typedef struct _PIXSERIES PIXSERIES;	/* Pixel dumps in one file, see PixelSeries.c */
+
+typedef struct {
+  int Mode;			/* GRAPHICS_X11 or GRAPHICS_PPM */
+  int Interval;			/* Time steps between frames */
+  int Step;			/* Time steps since the last frame */
+  int Resolution;		/* Longest side of a map in a PPM frame */
+  int Expand;			/* > 0: image pixels per grid cell,
+				   < 0: grid cells per image pixel */
+  int NPanelX;			/* Number of maps across the frame */
+  int PanelNX;			/* Map width in image pixels */
+  int PanelNY;			/* Map height in image pixels */
+  int Width;			/* Frame width */
+  int Height;			/* Frame height */
+  unsigned char *Image;		/* Colour index of each frame pixel */
+  float **Field;		/* Field being drawn */
+  char **Title;			/* Title of each map */
+  float *Min;			/* Colour bar range of each map */
+  float *Max;
+  int NFrames;			/* Number of frames written */
+} GRAPHICSDUMP;
+
 typedef struct {
   char Path[BUFSIZE + 1];			/* Path to dump to */
   char InitStatePath[BUFSIZE + 1];	/* Path for initial state */
@@ -60,12 +95,16 @@ typedef struct {
   FILES Balance;					/* File with summed mass balance values for entire basin */
   FILES FinalBalance;               /* File with summed mass balance values for the entire simulation period for entire basin */
   FILES Stream;
+  FILES Saturation;					/* File with the saturation extent of the basin */
   int NStates;						/* Number of model state dumps */
   DATE *DState;						/* Array with dates on which to dump state */
   int NPix;							/* Number of pixels for which to output timeseries */
   PIXDUMP *Pix;						/* Array with info on pixels for which to output timeseries */
+  int PixFormat;					/* FALSE for Pixel.<name> text files, else BIN or NETCDF */
+  PIXSERIES *PixSeries;				/* Shared pixel file if PixFormat is BIN or NETCDF */
   int NMaps;						/* Number of variables for which to output maps */
   MAPDUMP *DMap;					/* Array with info on each map to output */
+  GRAPHICSDUMP Graphics;			/* Live graphics, see GraphicsFrame.c */
 } DUMPSTRUCT;
 
 typedef struct {
@@ -245,18 +284,36 @@ typedef struct {
   int Rhoverride;				/* if TRUE then RH=100% if Precip>0 */
   int Shading;					/* if TRUE then terrain shading for solar is on */
   int StreamTemp;
+  int RBMText;                  /* if TRUE write the *.Only text files for Create_File */
+  int RBMCoupled;               /* if TRUE run RBM in the time loop instead of writing its forcing */
+  int StreamSeries;             /* FALSE for text stream output, else BIN or NETCDF records */
+  int StreamSeriesAll;          /* if TRUE the stream records hold all segments, else the SAVE ones */
   int CanopyShading;
   int ImprovRadiation;          /* if TRUE then improved radiation scheme is on */
   int CanopyGapping;            /* if canopy gapping is on */
   int SnowSlide;                /* if snow sliding option is true */
   int PrecipSepr;               /* if TRUE use separate input of rain and snow */
   int SnowStats;               /* if TRUE dumps snow statistics for each water year */
+  int HydraulicTables;         /* if TRUE use per-soil tables for exp() and pow() terms */
+  float HydraulicTolerance;    /* max relative error of the hydraulic tables */
+  int MonthlyCache;            /* months of PRISM and shade maps kept in memory,
+                                  0 to read them every month */
+  float WaterTableTolerance;   /* change of the water level (m) above which
+                                  the water table gradient of a cell is
+                                  recomputed */
+  int OverlandRouting;         /* CONVENTIONAL (one cell per time step) or
+                                  CASCADE (in order of elevation) */
+  float OverlandRoughness;     /* Manning's n of the travel time limit of
+                                  CASCADE routing, 0 for no limit */
   char PrismDataPath[BUFSIZE + 1];
   char PrismDataExt[BUFSIZE + 1];
   char ShadingDataPath[BUFSIZE + 1];
   char ShadingDataExt[BUFSIZE + 1];
   char SkyViewDataPath[BUFSIZE + 1];
   char ImperviousFilePath[BUFSIZ + 1];      
+  char RBMProject[BUFSIZ + 1];  /* RBM project prefix for direct forcing output or coupling, empty if not used */
+  char ImperviousDrainsYPath[BUFSIZ + 1];  /* binary map of impervious drainage rows */
+  char ImperviousDrainsXPath[BUFSIZ + 1];  /* binary map of impervious drainage columns */
   char PrecipMultiplierMapPath[BUFSIZ + 1];  
 } OPTIONSTRUCT;
 
@@ -437,6 +494,8 @@ typedef struct {
   float MaxInfiltrationRate;/* Maximum infiltration rate for upper layer (m/s) */
   float G_Infilt;                /* Mean capillary drive for dynamic maximum infiltration rate (m)   */
   float DepthThresh;    /* Threshold water table depth, beyond which transmissivity decays linearly with water table depth */
+  FLOATTABLE *KsTable;      /* exp(-KsLatExp * z) vs depth, NULL if not used */
+  FLOATTABLE *DrainTable;   /* (Moist/Porosity)^(2/PoreDist+3) for each layer, NULL if not used */
 } SOILTABLE;
 
 typedef struct {
@@ -591,18 +650,35 @@ typedef struct {
 } VEGTABLE;
 
 typedef struct {
-  float StartWaterStorage;
-  float OldWaterStorage;
-  float CumPrecipIn;
-  float CumET;
-  float CumIExcess;
-  float CumChannelInt;
-  float CumRoadInt;
-  float CumSnowVaporFlux;
-  float CumCulvertReturnFlow;
-  float CumCulvertToChannel;
+  double StartWaterStorage;
+  double OldWaterStorage;
+  double CumPrecipIn;
+  double CumET;
+  double CumIExcess;
+  double CumChannelInt;
+  double CumRoadInt;
+  double CumSnowVaporFlux;
+  double CumCulvertReturnFlow;
+  double CumCulvertToChannel;
 } WATERBALANCE;
 
+/* Basin averages of the pixel fields that enter the mass balance, kept in
+   double precision next to the float copies in AGGREGATED that are dumped */
+typedef struct {
+  double Precip;
+  double SnowFall;
+  double ETot;
+  double Swq;
+  double OldSwq;		/* Swq at the previous mass balance */
+  double Melt;
+  double VaporMassFlux;
+  double CanopyVaporMassFlux;
+  double IExcess;
+  double RoadIExcess;
+  double DetentionStorage;
+  double SatFlow;
+} WATERTOTALS;
+
 typedef struct {
   float accum_precip;
   float air_temp;
@@ -625,15 +701,17 @@ typedef struct {
   SNOWPIX Snow;
   SOILPIX Soil;
   VEGPIX Veg;
+  WATERTOTALS Water;
   float NetRad;
-  float SoilWater;
-  float CanopyWater;
+  double SoilWater;
+  double CanopyWater;
   float Runoff;
-  float ChannelInt;
-  float RoadInt;
+  double ChannelInt;
+  double RoadInt;
   unsigned long Saturated;
-  float CulvertReturnFlow;
-  float CulvertToChannel;
+  float SaturationExtent;	/* % of the basin with M above MTHRESH */
+  double CulvertReturnFlow;
+  double CulvertToChannel;
 } AGGREGATED;
 
 #endif
@@ -0,0 +1,71 @@
+/*
+ * SUMMARY:      dhsvm.h - interface of the DHSVM library
+ * USAGE:        Part of DHSVM
+ *
+ * DESCRIPTION:  Runs DHSVM from another program:  a model is initialized
+ *               once from an input file, then advanced a number of time
+ *               steps at a time.  Between steps the state maps can be
+ *               read, parameters changed, and the state saved in memory
+ *               and restored, so that a calibration can rerun a period
+ *               without reading the input files again.  DHSVMInit() is
+ *               DHSVMLoad(), which reads the static inputs, followed by
+ *               DHSVMStart(), which opens the output and reads the initial
+ *               state; a loaded model can be forked into ensemble members
+ *               that each change parameters and start with their own output.
+ * DESCRIP-END.
+ * FUNCTIONS:    DHSVMInit()
+ *               DHSVMLoad()
+ *               DHSVMStart()
+ *               DHSVMStep()
+ *               DHSVMFinished()
+ *               DHSVMGetSize()
+ *               DHSVMGetTime()
+ *               DHSVMGetField()
+ *               DHSVMGetOutflow()
+ *               DHSVMSetParameter()
+ *               DHSVMSnapshot()
+ *               DHSVMRestore()
+ *               DHSVMFreeSnapshot()
+ *               DHSVMFinalize()
+ *               DHSVMVersion()
+ * COMMENTS:     All calls return DHSVM_OK or an error code.  A positive
+ *               code is the ReportError() code of the error (the message
+ *               has been printed), DHSVM_FATAL a fatal error reported by
+ *               the channel or table modules.  After an error in
+ *               DHSVMStart() the model can only be finalized, after an
+ *               error in DHSVMStep() finalized or restored.  After an error
+ *               in DHSVMInit() or DHSVMLoad() no model is returned.
+ *
+ *               The model constants are global variables, so only one
+ *               model can be initialized at a time in a process.
+ */
+
+#ifndef DHSVM_H
+#define DHSVM_H
+
+#define DHSVM_OK           0
+#define DHSVM_FATAL       -1	/* fatal error (ERRHDL_FATAL) */
+#define DHSVM_INVALID     -2	/* invalid argument */
+#define DHSVM_UNSUPPORTED -3	/* not possible with the options of the model */
+
+typedef struct _DHSVM DHSVM;
+typedef struct _DHSVMSNAPSHOT DHSVMSNAPSHOT;
+
+int DHSVMInit(const char *ConfigFile, DHSVM **Model);
+int DHSVMLoad(const char *ConfigFile, DHSVM **Model);
+int DHSVMStart(DHSVM *Model, const char *OutputPath);
+int DHSVMStep(DHSVM *Model, int NSteps);
+int DHSVMFinished(DHSVM *Model);
+int DHSVMGetSize(DHSVM *Model, int *NY, int *NX);
+int DHSVMGetTime(DHSVM *Model, int *Step, int *NTotalSteps, int *Dt);
+int DHSVMGetField(DHSVM *Model, int ID, int Layer, float *Values);
+int DHSVMGetOutflow(DHSVM *Model, int SegmentID, float *Outflow);
+int DHSVMSetParameter(DHSVM *Model, const char *Section, const char *Key,
+		      int Class, int Layer, float Value);
+int DHSVMSnapshot(DHSVM *Model, DHSVMSNAPSHOT **Snapshot);
+int DHSVMRestore(DHSVM *Model, DHSVMSNAPSHOT *Snapshot);
+void DHSVMFreeSnapshot(DHSVMSNAPSHOT *Snapshot);
+int DHSVMFinalize(DHSVM *Model);
+const char *DHSVMVersion(void);
+
+#endif
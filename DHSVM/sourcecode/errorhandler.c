@@ -17,6 +17,7 @@
 #include <string.h>
 
 #include "errorhandler.h"
+#include "DHSVMerror.h"
 
 static FILE *LOG = NULL;
 static const char *Program = "unknown program";
@@ -78,6 +79,10 @@ void error_handler(ErrorLevel debug_level, const char *fmt, ...)
   }
   va_end(ap);
   if (debug_level <= ERRHDL_FATAL) {
+    if (ErrorReturn != NULL) {
+      fflush(out);
+      longjmp(*ErrorReturn, ERRHDL_FATAL);
+    }
     fprintf(out, "Fatal Error!, Aborting ...");
     fflush(out);
     error_handler_done();
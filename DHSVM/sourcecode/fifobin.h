@@ -17,6 +17,10 @@
 #define FIFOBIN_H
 
 void CreateMapFileBin(char *FileName, ...);
+void *Map2DMatrixBin(char *FileName, int NumberType, int NY, int NX,
+		     int NDataSet);
+void *Map2DMatrixByteSwapBin(char *FileName, int NumberType, int NY, int NX,
+			     int NDataSet);
 int Read2DMatrixBin(char *FileName, void *Matrix, int NumberType, int NY,
 		    int NX, int NDataSet, ...); 
 int Read2DMatrixByteSwapBin(char *FileName, void *Matrix, int NumberType,
@@ -25,6 +29,7 @@ int Write2DMatrixBin(char *FileName, void *Matrix, int NumberType, int NY,
 		     int NX, ...); 
 int Write2DMatrixByteSwapBin(char *FileName, void *Matrix, int NumberType,
 			     int NY, int NX, ...); 
+void CloseMappedFilesBin(void);
 void byte_swap_long(long *buffer, int number_of_swaps);
 void byte_swap_short(short *buffer, int number_of_swaps);
 
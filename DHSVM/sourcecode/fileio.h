@@ -38,6 +38,10 @@ int Read2DMatrix(char *FileName, void *Matrix, int NumberType,
 int Write2DMatrix(char *FileName, void *Matrix, int NumberType, 
                   MAPSIZE *Map, MAPDUMP *DMap, int index);
 
+void *Map2DMatrix(char *FileName, int NumberType, MAPSIZE *Map, int NDataSet);
+
+void CloseMappedFiles(void);
+
 
 /* generic file functions */
 void OpenFile(FILE **FilePtr, char *FileName, char *Mode,
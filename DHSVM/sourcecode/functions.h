@@ -24,10 +24,12 @@ void Aggregate(MAPSIZE *Map, OPTIONSTRUCT *Options, TOPOPIX **TopoMap,
 	       LAYER *Soil, LAYER *Veg, VEGPIX **VegMap, EVAPPIX **Evap,
 	       PRECIPPIX **Precip, PIXRAD **RadMap, SNOWPIX **Snow,
 	       SOILPIX **SoilMap, AGGREGATED *Total, VEGTABLE *VType,
-	       ROADSTRUCT **Network, CHANNEL *ChannelData, float *roadarea, int Dt);
+	       ROADSTRUCT **Network, CHANNEL *ChannelData, float *roadarea,
+	       DATE *Now, int Dt);
 
 void Avalanche(MAPSIZE *Map, TOPOPIX **TopoMap, TIMESTRUCT *Time, OPTIONSTRUCT *Options,
   SNOWPIX **SnowMap);
+void InitAvalanche(MAPSIZE *Map);
 
 void CalcAerodynamic(int NVegLayers, unsigned char OverStory,
 		     float n, float *Height, float Trunk, float *U,
@@ -46,7 +48,7 @@ float CalcKhDry(float Density);
 float CalcSnowAlbedo(float TSurf, unsigned short Last, SNOWPIX *LocalSnow, int StepsPerDay);
 
 float CalcTransmissivity(float SoilDepth, float WaterTable, float LateralKs,
-			 float KsExponent, float DepthThresh);
+			 float KsExponent, float DepthThresh, FLOATTABLE *KsTable);
 
 void CalcWeights(METLOCATION *Station, int NStats, int NX, int NY,
 		 uchar **BasinMask, uchar ****WeightArray,
@@ -67,7 +69,12 @@ void draw(DATE *Day, int first, int DayStep, MAPSIZE *Map, int NGraphics,
 	  SOILPIX **SoilMap, VEGPIX **VegMap, TOPOPIX **TopoMap, PRECIPPIX **PrecipMap, 
 	  float **PrismMap, float **SkyViewMap, unsigned char ***ShadowMap, 
 	  EVAPPIX **EvapMap, PIXRAD **RadMap, MET_MAP_PIX **MetMap,
-	  ROADSTRUCT **Network, OPTIONSTRUCT *Options);
+	  ROADSTRUCT **Network, GRAPHICSDUMP *Graphics, char *Path,
+	  OPTIONSTRUCT *Options);
+
+void DrawGraphicsPanel(GRAPHICSDUMP *Graphics, int Panel, int MapNumber,
+		       MAPSIZE *Map, TOPOPIX **TopoMap, char *Title, float min,
+		       float max);
 
 void DumpMap(MAPSIZE *Map, DATE *Current, MAPDUMP *DMap, TOPOPIX **TopoMap,
 	     EVAPPIX **EvapMap, PRECIPPIX **PrecipMap, PIXRAD **RadMap,
@@ -78,6 +85,17 @@ void DumpPix(DATE *Current, int first, FILES *OutFile, EVAPPIX *Evap,
         PRECIPPIX *Precip, PIXRAD *Rad, SNOWPIX *Snow, SOILPIX *Soil,
         VEGPIX *Veg, int NSoil, int NVeg, OPTIONSTRUCT *Options, int flag);
 
+void AccumulateStatistic(int Statistic, int NSteps, int n, float *Value,
+	double *Acc);
+void ReduceStatistic(int Statistic, int NSteps, int n, double *Acc,
+	float *Value);
+
+void DumpPixSeries(DATE *Current, int first, PIXSERIES *Series, int Pixel,
+	EVAPPIX *Evap, PRECIPPIX *Precip, PIXRAD *Rad, SNOWPIX *Snow,
+	SOILPIX *Soil, VEGPIX *Veg, int NSoil, int NCanopyStory);
+void EndPixSeriesRecord(DATE *Current, PIXSERIES *Series);
+void ClosePixSeries(PIXSERIES *Series);
+
 #ifdef TOPO_DUMP
 void DumpTopo(MAPSIZE *Map, TOPOPIX **TopoMap);
 #endif
@@ -132,8 +150,9 @@ void InitInterpolationWeights(MAPSIZE *Map, OPTIONSTRUCT *Options,
 			      TOPOPIX **TopoMap, uchar ****MetWeights,
 			      METLOCATION *Stats, int NStats);
 
-void InitMapDump(LISTPTR Input, MAPSIZE *Map, int MaxSoilLayers, int MaxVegLayers,
-		 char *Path, int TotalMapImages, int NMaps, MAPDUMP **DMap);
+void InitMapDump(LISTPTR Input, int Dt, MAPSIZE *Map, int MaxSoilLayers,
+		 int MaxVegLayers, char *Path, int TotalMapImages, int NMaps,
+		 MAPDUMP **DMap);
 
 void InitMappedConstants(LISTPTR Input, OPTIONSTRUCT *Options, MAPSIZE *Map,
                          SNOWPIX ***SnowMap);
@@ -172,11 +191,14 @@ void InitModelState(DATE *Start, int StepsPerDay, MAPSIZE *Map, OPTIONSTRUCT *Op
 		    ROADSTRUCT **Network, UNITHYDRINFO *HydrographInfo,
 		    float *Hydrograph);
 
-void InitNetwork(int NY, int NX, float DX, float DY, TOPOPIX **TopoMap, 
+void InitNetwork(MAPSIZE *Map, TOPOPIX **TopoMap, 
 		 SOILPIX **SoilMap, VEGPIX **VegMap, VEGTABLE *VType, 
 		 ROADSTRUCT ***Network, CHANNEL *ChannelData, 
 		 LAYER Veg, OPTIONSTRUCT *Options);
 
+void InitImperviousDrains(MAPSIZE *Map, TOPOPIX **TopoMap,
+			  OPTIONSTRUCT *Options);
+
 void InitNewDay(int DayOfYear, SOLARGEOMETRY *SolarGeo);
 
 void InitNewMonth(TIMESTRUCT *Time, OPTIONSTRUCT *Options, MAPSIZE *Map,
@@ -198,7 +220,11 @@ void InitParameterMaps(OPTIONSTRUCT *Options, MAPSIZE *Map, int Id,
   char *FileName, SNOWPIX ***SnowMap, int ParamType, float temp);
 
 int InitPixDump(LISTPTR Input, MAPSIZE *Map, uchar **BasinMask, char *Path,
-		int NPix, PIXDUMP **Pix, OPTIONSTRUCT *Options);
+		int NPix, PIXDUMP **Pix, int Format, OPTIONSTRUCT *Options);
+
+PIXSERIES *InitPixSeries(char *Path, int Format, char *Variables, int NFlush,
+		int Statistic, int Interval, int Dt, int NPix, PIXDUMP *Pix,
+		int MaxSoilLayers, int MaxVegLayers, OPTIONSTRUCT *Options);
     
 void InitPptMultiplierMap(OPTIONSTRUCT *Options, MAPSIZE *Map, float ***PptMultiplierMap);                            
 
@@ -209,6 +235,16 @@ void InitPrecipLapseMap(char *PrecipLapseFile, MAPSIZE *Map,
 
 void InitPrismMap(int NY, int NX, float ***PrismMap);
 
+unsigned char ***InitShadeStore(int NDaySteps, MAPSIZE *Map, int NSlots);
+int NShadeSlices(int NDaySteps);
+int ShadeSlice(int Step, int NDaySteps);
+void StoreShadeSlice(int Slot, int Slice, unsigned char *Data);
+void UseShadeSlot(unsigned char ***ShadowMap, int NDaySteps, int Slot);
+
+void InitMonthlyMaps(TIMESTRUCT *Time, OPTIONSTRUCT *Options, MAPSIZE *Map);
+void SetMonthlyMaps(TIMESTRUCT *Time, OPTIONSTRUCT *Options, MAPSIZE *Map,
+		    float **PrismMap, unsigned char ***ShadowMap);
+
 void InitShadeMap(OPTIONSTRUCT *Options, int NDaySteps, MAPSIZE *Map,
 		  unsigned char ****ShadowMap, float ***SkyViewMap);
 
@@ -232,6 +268,10 @@ void InitSoilMap(LISTPTR Input, OPTIONSTRUCT *Options, MAPSIZE *Map,
 int InitSoilTable(OPTIONSTRUCT *Options, SOILTABLE **SType, 
 			LISTPTR Input, LAYER *Soil, int InfiltOption);
 
+void InitHydraulicTables(SOILTABLE *SType, float Tolerance);
+
+void FreeHydraulicTables(SOILTABLE *SType);
+
 void InitStateDump(LISTPTR Input, int NStates, DATE **DState);
 
 void InitGraphicsDump(LISTPTR Input, int NGraphics, int ***which_graphics);
@@ -270,11 +310,22 @@ uchar IsStationLocation(COORD *Loc, int NStats, METLOCATION *Station,
 			int *WhichStation);
 
 void InitXGraphics(int argc, char **argv,
-		   int ny, int nx, int nd, MET_MAP_PIX ***MetMap);
+		   int ny, int nx, int nd, GRAPHICSDUMP *Graphics);
+
+void InitGraphicsFrame(MAPSIZE *Map, int NGraphics, GRAPHICSDUMP *Graphics,
+		       MET_MAP_PIX ***MetMap);
+
+void GraphicsPalette(int i, unsigned short *Red, unsigned short *Green,
+		     unsigned short *Blue);
+
+void WriteGraphicsFrame(GRAPHICSDUMP *Graphics, int NGraphics, char *Path,
+			char *DateStr);
 
 float LapsePrecip(float Precip, float FromElev, float ToElev, float PrecipLapse, float precipMultiplier);
 
 float LapseT(float Temp, float FromElev, float ToElev, float LapseRate);
+
+void InitLocalMetData(OPTIONSTRUCT *Options);
  
 PIXMET MakeLocalMetData(int y, int x, MAPSIZE *Map, int DayStep, int NDaySteps,
 			OPTIONSTRUCT *Options, int NStats, METLOCATION *Stat, 
@@ -296,6 +347,8 @@ void MassEnergyBalance(OPTIONSTRUCT *Options, int y, int x, float SineSolarAltit
             SNOWPIX *LocalSnow, PIXRAD *LocalRad, EVAPPIX *LocalEvap, PIXRAD *TotalRad,
             CHANNEL *ChannelData, float **skyview);
 
+void ReportMassEnergyPaths(void);
+
 float MaxRoadInfiltration(ChannelMapPtr **map, int col, int row);
 
 double pow (double a, double b);
@@ -328,7 +381,7 @@ void RouteSubSurface(int Dt, MAPSIZE *Map, TOPOPIX **TopoMap,
 		     ROADSTRUCT **Network, SOILTABLE *SType,
 		     SOILPIX **SoilMap, CHANNEL *ChannelData, 
 		     TIMESTRUCT *Time, OPTIONSTRUCT *Options, 
-		     char *DumpPath, int MaxStreamID, SNOWPIX **SnowMap);
+		     int MaxStreamID, SNOWPIX **SnowMap);
 
 void RouteSurface(MAPSIZE * Map, TIMESTRUCT * Time, TOPOPIX ** TopoMap,
   SOILPIX ** SoilMap, OPTIONSTRUCT *Options,
@@ -357,13 +410,27 @@ void StoreModelState(char *Path, DATE *Current, MAPSIZE *Map,
              LAYER *Veg, SOILPIX **SoilMap, LAYER *Soil, ROADSTRUCT **Network, 
 		     UNITHYDRINFO *HydrographInfo, float *Hydrograph, CHANNEL *ChannelData);
 
-void SnowStats(DATE *Now, MAPSIZE *Map, OPTIONSTRUCT *Options, 
-        TOPOPIX **TopoMap, SNOWPIX **Snow, int Dt);
+void SnowStats(int DNum, SNOWPIX *Snow);
 
 float viscosity(float Tair, float Rh);
 
 /* functions for John's RBM model */
 int channel_save_outflow_text_cplmt(TIMESTRUCT *Time, char *tstring, Channel *net, CHANNEL *netfile, int flag);
+int rbm_output_step(TIMESTRUCT *Time);
+void channel_read_rbm_segmap(const char *project, CHANNEL *netfile);
+void channel_open_rbm_forcing(const char *project, CHANNEL *netfile);
+void channel_rbm_forcing_record(Channel *seg, int Dt, float *record);
+int channel_save_rbm_forcing(TIMESTRUCT *Time, const char *project,
+			     CHANNEL *netfile, int flag);
+void channel_rbm_init(const char *project, int Dt, CHANNEL *netfile);
+int channel_rbm_step(TIMESTRUCT *Time, CHANNEL *netfile);
+void channel_rbm_close(CHANNEL *netfile);
+
+/* columnar stream segment output */
+void channel_series_init(OPTIONSTRUCT *Options, char *DumpPath, DATE *Start,
+			 CHANNEL *channel);
+int channel_series_save(TIMESTRUCT *Time, CHANNELSERIES *series);
+void channel_series_close(CHANNEL *channel);
 void CalcCanopyShading (TIMESTRUCT *Time, Channel *Channel, SOLARGEOMETRY *SolarGeo);
 
 float CalcShadeDensity(int ShadeCase, float HDEM, float WStream, float SunAzimuth,
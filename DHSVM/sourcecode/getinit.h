@@ -95,6 +95,9 @@ void MakeKeyString(char *Buffer);
 
 void ReadInitFile(char *TemplateFileName, LISTPTR * Input);
 
+void SetInitString(const char *Section, const char *Key, const char *Value,
+		   LISTPTR Input);
+
 void Strip(char *Buffer);
 
 #endif
@@ -24,5 +24,6 @@ typedef struct {
 float FloatLookup(float x, FLOATTABLE * Table);
 void InitFloatTable(unsigned long Size, float Offset, float Delta,
 		    float (*Function) (float), FLOATTABLE * Table);
+int FloatInterpolate(float x, FLOATTABLE * Table, float *Value);
 
 #endif
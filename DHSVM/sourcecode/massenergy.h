@@ -67,6 +67,8 @@ void ShortwaveBalance(OPTIONSTRUCT *Options, unsigned char OverStory,
               float F, float Rs, float Rsb, float Rsd, float Tau,
               float Taud, float *Albedo, PIXRAD * LocalRad);
 
+void NoShortwaveBalance(OPTIONSTRUCT *Options, PIXRAD *LocalRad);
+
 
 float SoilEvaporation(int Dt, float Temp, float Slope, float Gamma, 
               float Lv, float AirDens, float Vpd, float NetRad, 
@@ -77,6 +77,10 @@ typedef unsigned int unint;
 #define STATIC 1
 #define DYNAMIC 2
 
+/* Options for overland routing */
+#define CONVENTIONAL 1
+#define CASCADE      2
+
 /* Options for canopy radiation attenuation */
 #define FIXED    1
 #define VARIABLE 2
@@ -104,6 +108,27 @@ typedef unsigned int unint;
 #define MAP_OUTPUT 1
 #define IMAGE_OUTPUT 2
 
+/* Statistics of map and pixel dumps aggregated over a period */
+#define DUMP_MEAN 1
+#define DUMP_SUM 2
+#define DUMP_MIN 3
+#define DUMP_MAX 4
+
+/* Aggregation period of one calendar month */
+#define DUMP_MONTH 0
+
+/* Destination of the live graphics */
+#define GRAPHICS_X11 1
+#define GRAPHICS_PPM 2
+
+/* Live graphics frame:  colour ramp indices 0 - 49, then white and black,
+   and the space above and to the right of each map for its title and
+   colour bar */
+#define NGRAPHICSCOLORS 50
+#define GRAPHICS_WHITE 50
+#define GRAPHICS_BLACK 51
+#define GRAPHICS_BORDER 50
+
 #define MIN_SWE 0.005 
 
 // Canopy type used in canopy gapping option
@@ -120,7 +145,9 @@ enum KEYS {
   temp_lapse, precip_lapse, cressman_radius, cressman_stations, prism_data_path, 
   prism_data_ext, shading_data_path, shading_data_ext, skyview_data_path, 
   stream_temp, canopy_shading, improv_radiation, gapping, snowslide, sepr, 
-  snowstats, routing_neighbors, 
+  snowstats, routing_neighbors, hydraulic_tables, hydraulic_tolerance,
+  rbm_project, rbm_text, rbm_coupled, stream_series, stream_series_segments,
+  monthly_cache, water_table_tolerance, overland_routing, overland_roughness,
   /* Area */
   coordinate_system, extreme_north, extreme_west, center_latitude,
   center_longitude, time_zone_meridian, number_of_rows,
@@ -176,16 +203,19 @@ enum KEYS {
   vegtype_file = 0, vegfc_file, veglai_file,
   /* DHSVM channel keys */
   stream_network = 0, stream_map, stream_class, riparian_veg,
-  road_network, road_map, road_class,
+  road_network, road_map, road_class, channel_courant,
   /* number of each type of output */
   output_path =
     0, initial_state_path, npixels, nstates, nmapvars, nimagevars, ngraphics,
+    pixel_format, pixel_variables, pixel_flush, pixel_statistic, pixel_interval,
+    graphics_output, graphics_interval, graphics_resolution,
   /* pixel information */
   north = 0, east, name,
   /* state information */
   state_date = 0,
   /* map information */
-  map_variable = 0, map_layer, nmaps, map_date,
+  map_variable = 0, map_layer, nmaps, map_date, map_statistic, map_start,
+  map_end, map_interval,
   /* image information */
   image_variable = 0, image_layer, image_start, image_end, image_interval,
   image_upper, image_lower,
@@ -29,10 +29,13 @@ extern int yneighbor[NNEIGHBORS];
    available functions
    ------------------------------------------------------------- */
 void ElevationSlopeAspect(MAPSIZE * Map, TOPOPIX ** TopoMap);
+void InitHeadSlopeAspect(MAPSIZE * Map);
+void HeadWaterLevel(MAPSIZE * Map, TOPOPIX ** TopoMap, SOILPIX ** SoilMap,
+  float Tolerance);
 void HeadSlopeAspect(MAPSIZE * Map, TOPOPIX ** TopoMap, SOILPIX ** SoilMap,
   float **FlowGrad, unsigned char ***Dir, unsigned int **TotalDir);
 void SnowSlopeAspect(MAPSIZE * Map, TOPOPIX ** TopoMap, SNOWPIX ** Snow,
-  float **FlowGrad, unsigned char ***Dir, unsigned int **TotalDir);
+  int y, int x, float *FlowGrad, unsigned char *Dir, unsigned int *TotalDir);
 int valid_cell(MAPSIZE * Map, int x, int y);
 void quick(ITEM *OrderedCells, int count);
 #endif
@@ -17,6 +17,8 @@
 #ifndef SOILMOISTURE_H
 #define SOILMOISTURE_H
 
+#include "lookuptable.h"
+
 #define NO_CUT -10
 
 void AdjustStorage(int NSoilLayers, float TotalDepth, float *RootDepth,
@@ -44,7 +46,8 @@ void DistributeSatflow(int Dt, float DX, float DY, float SatFlow, int NSoilLayer
 void UnsaturatedFlow(int Dt, float DX, float DY, float Infiltration, 
 		     float RoadbedInfiltration, float SatFlow, int NSoilLayers, 
 		     float TotalDepth, float Area, float *RootDepth, float *Ks, 
-		     float *PoreDist, float *Porosity, float *FCap, float *Perc, 
+		     float *PoreDist, FLOATTABLE *DrainTable, float *Porosity, 
+		     float *FCap, float *Perc, 
 		     float *PercArea, float *Adjust, int CutBankZone, float BankHeight,
 			 float *TableDepth, float *Runoff, float *Moist, int InfiltOption);
 
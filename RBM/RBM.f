@@ -1,103 +1,12 @@
 c
-c      PROGRAM RMAIN
-C
-C     Dynamic river basin model for simulating water quality in
-C     branching river systems with freely-flowing river segments. 
-c
-c     This version uses Reverse Particle Tracking in the Lagrangian
-c     mode and Lagrangian interpolation in the Eulerian mode.
-c
-c     Topology and routing is set up to be consistent with output
-c     from the Distributed Hydrologic Soil and Vegetation Model (DHSVM)
-c     model developed by the Land Surface Hydrology Group at 
-c     the University of Washington.
-c
-C     For additional information visit:
-c
-c     http://www.hydro.washington.edu/Lettenmaier/Models/DHSVM/
-c
-c     or contact:
-c
-C     John Yearsley
-C     Land Surface Hydrology Group
-C     Dept. of Civil and Environmental Engineering
-C     Box 352700
-C     University of Washington
-C     Seattle, Washington
-C     98195-2700
-C     yearsley@hydro.washington.edu
-C
-      character*8  start_data,end_data     
-      character*200 Prefix
-      integer iargc
-      integer numarg
- 
-c     Command line input
-c
-      numarg = iargc ( )
-      if (numarg .lt. 1) then
-        write (*,*) 'Too few arguments were given'
-        write (*,*) ' '
-        write (*,*) 'First:  Location and prefix of input file'
-        write (*,*) '        (networkfile)'
-        write (*,*) 'eg: $ <program-name> <Project Name>'
-        write (*,*) ' '
-        stop
-      end if
-      call getarg ( 1, Prefix )
-c
-c     Identify and open necessary files
-c
-c     open the output file 
-      open(unit=20,file=TRIM(Prefix)//'.temp',status='unknown')
-c
-c     Open file with weather and inflow data
-      write(*,*) 'Forcing file -  ', TRIM(Prefix)//'.forcing'
-      open(unit=30,file=TRIM(Prefix)//'.forcing',STATUS='old')
-C
-c     open Mohseni file 
-      open(40,file=TRIM(Prefix)//'.Mohseni',STATUS='old')    
+c     Subroutines of the river basin model.  They are shared by the
+c     RBM program (RBM_Main.f), which reads the forcing files, and by
+c     the entry points DHSVM calls to run RBM in process
+c     (RBM_Coupled.f).
 c
-c     open Leopold file 
-      open(50,file=TRIM(Prefix)//'.Leopold',STATUS='old')    
-c
-c     Open network file
-      OPEN(UNIT=90,FILE=TRIM(Prefix)//'.net',STATUS='OLD')
-c
-c     Read header information from control file
-      do n=1,5
-        read(90,*)
-      end do
-c
-C     Call systems programs to get started
-C
-C     SUBROUTINE BEGIN reads control file, sets up topology and
-C     important properties of reaches
-      write(*,*) 'Calling BEGIN'
-      CALL BEGIN
-C
-C     SUBROUTINE SYSTMM performs the simulations
-C
-      CALL SYSTMM
-C
-C     Close files after simulation is complete
-C
-      write(*,*) ' Closing files after simulation'
-      CLOSE(30)
-      CLOSE(90)
-      STOP
-      END
-      SUBROUTINE BEGIN
+      SUBROUTINE READ_HEADER
+      use RBM_Data
       character*11 end_time,start_time
-      character*5 Dummy_B
-      character*10 Dummy_A
-      integer head_name,trib_cell,first_cell
-      dimension ndmo(12)
-      logical Test
-      INCLUDE 'RBM.fi'
-      data ndmo/0,31,59,90,120,151,181,212,243,273,304,334/
-      ndelta=2
-      delta_n=ndelta
 c
 c     Read the starting and ending times and the number of
 c     periods per day of weather data from the forcing file
@@ -119,9 +28,29 @@ c
 c     Establish the Julian day for which simulations begin
 c
       jul_start=julian(start_year,start_month,start_day)
+      RETURN
+      END
+      SUBROUTINE BEGIN
+c
+c     Reads the network, Mohseni and Leopold files (units 90, 40 and
+c     50) and sets up the reaches.  NWPD must be set before.
+c
+      use RBM_Data
+      character*5 Dummy_B
+      character*10 Dummy_A
+      integer head_name,trib_cell,first_cell
+      dimension ndmo(12)
+      logical Test
+      data ndmo/0,31,59,90,120,151,181,212,243,273,304,334/
+      ndelta=2
+      delta_n=ndelta
 c
       read(90,*) no_rch
       write(*,*) "Number of stream reaches - ",no_rch
+c
+c     Size and allocate the network arrays
+c
+      CALL NETWORK_SIZE(ndelta)
       read(40,*) Test,a_smooth
       b_smooth=1.- a_smooth
       do nr=1,no_rch
@@ -219,6 +148,10 @@ c
       nreach=no_rch
       xwpd=nwpd
       dt_comp=86400./xwpd
+c
+c     Group the reaches for the reach loop in SYSTMM
+c
+      CALL REACH_LEVELS
 C
 C     ******************************************************
 C                         Return to RMAIN
@@ -227,28 +160,174 @@ C
 c
       RETURN
   900 END
+      SUBROUTINE NETWORK_SIZE(ndelta)
+      use RBM_Data
+      character*10 Dummy_A
+      integer, allocatable :: rch_trib(:)
+c
+c     First pass through the network file to count the cells in
+c     each reach and the tributaries entering each cell
+c
+      allocate(no_celm(no_rch),no_cells(no_rch),main_stem(no_rch)
+     &        ,last_seg(no_rch),head_cell(no_rch),q_trib(no_rch)
+     &        ,T_trib(no_rch),elev(no_rch),alf_Mu(no_rch)
+     &        ,beta(no_rch),gmma(no_rch),mu(no_rch),rch_trib(no_rch))
+      ncell_total=0
+      max_cells=0
+      do nr=1,no_rch
+        read(90,*) Dummy_A,no_cells(nr),
+     &             Dummy_A,main_stem(nr),Dummy_A,rch_trib(nr)
+        do nc=1,no_cells(nr)
+          read(90,*)
+        end do
+        ncell_total=ncell_total+no_cells(nr)
+        max_cells=max(max_cells,no_cells(nr))
+      end do
+      max_seg=ndelta*max_cells
+      write(*,*) 'Number of cells - ',ncell_total
+c
+      allocate(no_tribs(0:ncell_total))
+      no_tribs=0
+      do nr=1,no_rch
+        if (rch_trib(nr).gt.ncell_total) then
+          write(*,*) 'Reach ',nr,' enters nonexistent cell '
+     &              ,rch_trib(nr)
+          stop
+        end if
+        if (rch_trib(nr).gt.0) then
+          no_tribs(rch_trib(nr))=no_tribs(rch_trib(nr))+1
+        end if
+      end do
+      max_tribs=max(1,maxval(no_tribs))
+      no_tribs=0
+      deallocate(rch_trib)
+c
+c     Cell 0 stands in for the cell beyond the end of a reach and
+c     stays zero throughout
+c
+      allocate(node(0:ncell_total),lat_flow(0:ncell_total)
+     &        ,trib(0:ncell_total,max_tribs)
+     &        ,qin(0:ncell_total),qout(0:ncell_total)
+     &        ,qdiff(0:ncell_total),depth(0:ncell_total)
+     &        ,width(0:ncell_total)
+     &        ,D_a(0:ncell_total),D_b(0:ncell_total)
+     &        ,D_min(0:ncell_total)
+     &        ,U_a(0:ncell_total),U_b(0:ncell_total)
+     &        ,U_min(0:ncell_total)
+     &        ,dx(0:ncell_total),dt(0:ncell_total),u(0:ncell_total)
+     &        ,QNS(0:ncell_total),QNA(0:ncell_total)
+     &        ,DBT(0:ncell_total),WIND(0:ncell_total)
+     &        ,EA(0:ncell_total),PRESS(0:ncell_total))
+      allocate(segment_cell(no_rch,0:max_seg+1)
+     &        ,x_dist(no_rch,0:max_seg+1)
+     &        ,temp(no_rch,-2:max_seg+1,2))
+      no_celm=0
+      last_seg=0
+      head_cell=0
+      q_trib=0.
+      T_trib=0.
+      elev=0.
+      node=0
+      lat_flow=0
+      trib=0
+      qin=0.
+      qout=0.
+      qdiff=0.
+      depth=0.
+      width=0.
+      D_a=0.
+      D_b=0.
+      D_min=0.
+      U_a=0.
+      U_b=0.
+      U_min=0.
+      dx=0.
+      dt=0.
+      u=0.
+      QNS=0.
+      QNA=0.
+      DBT=0.
+      WIND=0.
+      EA=0.
+      PRESS=0.
+      segment_cell=0
+      x_dist=0.
+      temp=0.
+c
+c     Back to the first reach for the second pass in BEGIN
+c
+      rewind(90)
+      do n=1,6
+        read(90,*)
+      end do
+      RETURN
+      END
+      SUBROUTINE REACH_LEVELS
+      use RBM_Data
+      integer, allocatable :: level(:)
+      logical changed
+c
+c     A reach mixes in the temperature of each tributary entering one
+c     of its cells.  The reaches were originally run in index order,
+c     so a tributary with a lower index contributes its temperature
+c     from the current time step and one with a higher index its
+c     temperature from the previous step.  Give every reach a level
+c     above that of any lower numbered reach it exchanges
+c     temperatures with.  Reaches on the same level are independent
+c     and running the levels in order reproduces the serial loop.
+c
+      allocate(level(nreach))
+      level=1
+  100 continue
+      changed=.FALSE.
+      do nr=1,nreach
+        do nc=head_cell(nr),head_cell(nr)+no_cells(nr)-1
+          do ntrb=1,no_tribs(nc)
+            nr_trib=trib(nc,ntrb)
+            if (nr_trib.ne.nr) then
+              nlo=min(nr,nr_trib)
+              nhi=max(nr,nr_trib)
+              if (level(nhi).le.level(nlo)) then
+                level(nhi)=level(nlo)+1
+                changed=.TRUE.
+              end if
+            end if
+          end do
+        end do
+      end do
+      if (changed) go to 100
+c
+c     List the reaches level by level, in index order within a level
+c
+      no_levels=maxval(level)
+      allocate(level_rch(nreach),level_start(no_levels+1))
+      n=0
+      do nl=1,no_levels
+        level_start(nl)=n+1
+        do nr=1,nreach
+          if (level(nr).eq.nl) then
+            n=n+1
+            level_rch(n)=nr
+          end if
+        end do
+      end do
+      level_start(no_levels+1)=n+1
+      write(*,*) 'Number of reach levels - ',no_levels
+      deallocate(level)
+      RETURN
+      END
       SUBROUTINE SYSTMM
-      real*4 xa(4),ta(4),T_head(1000),T_smth(1000)
-     *      ,dt_part(1000),x_part(1000)
+      use RBM_Data
       real*8 day_fract,hr_fract,sim_incr,year,prnt_time
-      integer no_dt(1000),nstrt_elm(1000)
-     .     ,ndltp(4),nterp(4),nptest(4),ndmo(12,2)
-      logical DONE
+      integer ndmo(12,2)
 
-      INCLUDE 'RBM.fi'
-      data ndltp/-2,-1,-2,-2/,nterp/4,3,2,3/
-      data lat/47.6/,pi/3.14159/,rfac/304.8/
+      data lat/47.6/,pi/3.14159/
       data ndmo/0,31,59,90,120,151,181,212,243,273,304,334
      &         ,0,31,60,91,121,152,182,213,244,274,305,335/
 c
 c
       hour_inc=1./nwpd
-      do nr=1,1000
-         T_head(nr)=mu(nr)
-         T_smth(nr)=mu(nr)
-      end do
-      n1=1
-      n2=2
+      CALL START_STATE
       nobs=0
 c
 c     Initialize the day counter used for calculating the
@@ -326,36 +405,25 @@ c     Hardwire annual average temperature for headwaters
 c
                do nc=1,no_cells(nr)
                  l_seg=l_seg+1
-                 read(30,*,end=900) l1
+                 if (nforce_bin.eq.1) then
+                   nrec=nobs*ncell_total+l_seg
+                   read(31,rec=nrec,err=900) press(l_seg),dbt(l_seg)
+     &                      ,qna(l_seg),qns(l_seg),ea(l_seg),wind(l_seg)
+     &                      ,q_melt,qin(l_seg),qout(l_seg)
+                 else
+                   read(30,*,end=900) l1
      &                      ,press(l_seg),dbt(l_seg)
      &                      ,qna(l_seg),qns(l_seg),ea(l_seg),wind(l_seg)
-     &                      ,qin(l_seg),qout(l_seg)
-                 if (qin(l_seg) < 0.5) then
-                     qin(l_seg)=qout(l_seg)
+     &                      ,q_melt,qin(l_seg),qout(l_seg)
                  end if
-                 qavg=0.5*(qin(l_seg)+qout(l_seg))
-c
-c    Stream speed estimated with Leopold coefficients
-c 
-                 u(l_seg)=U_a(l_seg)*(qavg**U_b(l_seg)) 
-                 u(l_seg) = amax1(u_min(l_seg),u(l_seg))
-c 
-                 qdiff(l_seg)=(qout(l_seg)-qin(l_seg))/delta_n
-c 
-                 dt(l_seg)=dx(l_seg)/u(l_seg)
-c
-c    Depth estimated with Leopold coefficients
-c 
-                 depth(l_seg)=D_a(l_seg)*(qavg**D_b(l_seg))
-                 depth(l_seg)=amax1(D_min(l_seg),depth(l_seg))
-c
-                 lat_flow(l_seg)=qout(l_seg)-qin(l_seg)
+                 CALL CELL_FLOW(l_seg)
                end do
 c
 c  Set the value of the tributary flow due to the reach, NR
 c
                q_trib(nr)=qout(l_seg)
 	     end do
+             nobs=nobs+1
 c
 c     Main stem inflows and outflows for each reach first
 c     Flows are cumulative and do not include tributaries if
@@ -365,92 +433,227 @@ c     Headwaters flow and temperature
 c
  90            continue
 c
-c     Begin cycling through the reaches 
-c
-               do nr=1,nreach
-                  nc_head=segment_cell(nr,1)
-                  T_smth(nr)=b_smooth*T_smth(nr)+a_smooth*dbt(nc_head)
-                  T_head(nr)=mu(nr)
-     &            +(alf_Mu(nr)/(1.+exp(gmma(nr)*(beta(nr)-T_smth(nr)))))
-c                  
-                  temp(nr,0,n1)=T_head(nr)
-                  temp(nr,-1,n1)=T_head(nr)
-                  temp(nr,-2,n1)=T_head(nr)
-                  temp(nr,no_celm(nr)+1,n1)=temp(nr,no_celm(nr),n1)
-                  x_head=x_dist(nr,0)
-                  x_bndry=x_head-1.0
+c     Begin cycling through the reaches, one level at a time
+c
+               CALL ADVANCE
+c
+c   Write file 20 with all temperature output 11/19/2008
+c
+               time=year+(day-1.+hour_inc*period)/xd_year
+               CALL WRITE_TEMP(nyear,nd)
+c
+c     End of weather period loop (NDD=1,NWPD)
+c
+            end do
+c
+c Reset daily loop counter
+c
+          nd_start=1
+c 
+C
+c     End of main loop (ND=1,365/366)
+c
+
+         end do
+c
+c    Update initial time for new year
+c
+      year=year+1
+c
+c     End of year loop
+c
+      end do
+c
+c Finish
+c
+  900 Continue
+c
+c
+c     ******************************************************
+c                        return to rmain
+c     ******************************************************
+c
+
+  950 return
+      end
+      SUBROUTINE START_STATE
+c
+c     Start the headwater temperatures from the Mohseni mean
+c
+      use RBM_Data
+      allocate(T_head(nreach),T_smth(nreach))
+      do nr=1,nreach
+         T_head(nr)=mu(nr)
+         T_smth(nr)=mu(nr)
+      end do
+      n1=1
+      n2=2
+      RETURN
+      END
+      SUBROUTINE CELL_FLOW(l_seg)
+c
+c     Velocity, depth and travel time of cell L_SEG from the inflow
+c     and outflow of its forcing
+c
+      use RBM_Data
+      if (qin(l_seg) < 0.5) then
+          qin(l_seg)=qout(l_seg)
+      end if
+      qavg=0.5*(qin(l_seg)+qout(l_seg))
+c
+c    Stream speed estimated with Leopold coefficients
+c 
+      u(l_seg)=U_a(l_seg)*(qavg**U_b(l_seg)) 
+      u(l_seg) = amax1(u_min(l_seg),u(l_seg))
+c 
+      qdiff(l_seg)=(qout(l_seg)-qin(l_seg))/delta_n
+c 
+      dt(l_seg)=dx(l_seg)/u(l_seg)
+c
+c    Depth estimated with Leopold coefficients
+c 
+      depth(l_seg)=D_a(l_seg)*(qavg**D_b(l_seg))
+      depth(l_seg)=amax1(D_min(l_seg),depth(l_seg))
+c
+      lat_flow(l_seg)=qout(l_seg)-qin(l_seg)
+      RETURN
+      END
+      SUBROUTINE ADVANCE
+c
+c     Advance all reaches by one time step, one level at a time
+c
+      use RBM_Data
+      do nl=1,no_levels
+        nr1=level_start(nl)
+        nr2=level_start(nl+1)-1
+!$omp parallel do schedule(dynamic) if(nr2.gt.nr1)
+        do nlr=nr1,nr2
+          call REACH(level_rch(nlr))
+        end do
+!$omp end parallel do
+      end do
+      RETURN
+      END
+      SUBROUTINE WRITE_TEMP(nyr,nday)
+c
+c     Write the temperatures of the step ending at TIME to unit 20,
+c     every second segment of each reach, and make them the starting
+c     temperatures of the next step
+c
+      use RBM_Data
+      do nr=1,nreach
+        do ns=2,no_celm(nr),2
+          ncell=segment_cell(nr,ns)
+          write(20,'(f11.5,i5,1x,i4,1x,2i5,1x,5f7.2,f9.2)') 
+     &          time,nyr,nday,ncell,ns,temp(nr,ns,n2)
+     &         ,T_head(nr),dbt(ncell)
+     &         ,depth(ncell),u(ncell),qin(ncell)
+        end do
+      end do
+      ntmp=n1
+      n1=n2
+      n2=ntmp
+      RETURN
+      END
+      SUBROUTINE REACH(nr)
+c
+c     Advance the temperatures of reach NR by one time step.  Reads
+c     T_trib of the reaches tributary to NR and writes TEMP(NR,:,N2)
+c     and T_TRIB(NR) only, so reaches on the same level (see
+c     REACH_LEVELS) can be run concurrently.
+c
+      use RBM_Data
+      real*4 xa(4),ta(4)
+     *      ,dt_part(max_seg),x_part(max_seg)
+      integer no_dt(max_seg),nstrt_elm(max_seg)
+     .     ,ndltp(4),nterp(4),nptest(4)
+      logical DONE
+      data ndltp/-2,-1,-2,-2/,nterp/4,3,2,3/
+      data rfac/304.8/
+c
+      nc_head=segment_cell(nr,1)
+      T_smth(nr)=b_smooth*T_smth(nr)+a_smooth*dbt(nc_head)
+      T_head(nr)=mu(nr)
+     &      +(alf_Mu(nr)/(1.+exp(gmma(nr)*(beta(nr)-T_smth(nr)))))
+c
+      temp(nr,0,n1)=T_head(nr)
+      temp(nr,-1,n1)=T_head(nr)
+      temp(nr,-2,n1)=T_head(nr)
+      temp(nr,no_celm(nr)+1,n1)=temp(nr,no_celm(nr),n1)
+      x_head=x_dist(nr,0)
+      x_bndry=x_head-1.0
 
 c     First do the reverse particle tracking
 c
 
-                  do ns=no_celm(nr),1,-1
+      do ns=no_celm(nr),1,-1
 c
 c     Segment is in cell SEGMENT_CELL(NC)
 c
 
-                     ncell=segment_cell(nr,ns)
-                     nx_s=1
-                     nx_part=ns
-                     dt_part(ns)=dt(ncell)
-                     dt_total=dt_part(ns)
-                     x_part(ns)=x_dist(nr,ns)
- 100                 continue
+         ncell=segment_cell(nr,ns)
+         nx_s=1
+         nx_part=ns
+         dt_part(ns)=dt(ncell)
+         dt_total=dt_part(ns)
+         x_part(ns)=x_dist(nr,ns)
+ 100     continue
 c
 c     Determine if the total elapsed travel time is equal to the
 c     computational interval
 c
 
-                     if(dt_total.lt.dt_comp) then
-                        x_part(ns)=x_part(ns)
-     .				         +dx(segment_cell(nr,nx_part))
+         if(dt_total.lt.dt_comp) then
+            x_part(ns)=x_part(ns)
+     .                +dx(segment_cell(nr,nx_part))
 c     If the particle has started upstream from the boundary point, give it
 c     the value of the boundary
 c
 
-                        if(x_part(ns).ge.x_bndry) then
-                           x_part(ns)=x_head
-                           dt_part(ns)=dt(segment_cell(nr,nx_part))
-                           dt_total=dt_total+dt_part(ns)
+            if(x_part(ns).ge.x_bndry) then
+               x_part(ns)=x_head
+               dt_part(ns)=dt(segment_cell(nr,nx_part))
+               dt_total=dt_total+dt_part(ns)
 c                           nx_part=head_cell(nr)
-                           go to 200
-                        end if
+               go to 200
+            end if
 c
 c     Increment the segment counter if the total time is less than the
 c     computational interval
 c
-                        nx_s=nx_s+1
-                        nx_part=nx_part-1
-                        dt_part(ns)=dt(segment_cell(nr,nx_part))
-                        dt_total=dt_total+dt_part(ns)
-                        go to 100
-                     else
+            nx_s=nx_s+1
+            nx_part=nx_part-1
+            dt_part(ns)=dt(segment_cell(nr,nx_part))
+            dt_total=dt_total+dt_part(ns)
+            go to 100
+         else
 c
 c     For the last segment of particle travel, adjust the particle location
 c     such that the total particle travel time is equal to the computational
 c     interval.
 c
 
-                        dt_before=dt_part(ns)
-                        dt_part(ns)
-     .                       =dt_comp-dt_total+dt_part(ns)
-                        x_part(ns)=x_part(ns)
-     .                            +u(segment_cell(nr,nx_part))
-     .                            *dt_part(ns)
-                        if(x_part(ns).ge.x_head) then
-                           x_part(ns)=x_head
-                           nx_s=nx_s-1
-                           dt_part(ns)=dt(head_cell(nr))
-                        end if
-                     end if
- 200                 continue
-                     if(nx_part.lt.1) nx_part=1
-                     nstrt_elm(ns)=nx_part
-                     no_dt(ns)=nx_s
-                  end do
-                  DONE=.FALSE.
-                  do ns=1,no_celm(nr)
-                     ncell=segment_cell(nr,ns)
-                     itest=no_celm(nr)
+            dt_before=dt_part(ns)
+            dt_part(ns)
+     .           =dt_comp-dt_total+dt_part(ns)
+            x_part(ns)=x_part(ns)
+     .                +u(segment_cell(nr,nx_part))
+     .                *dt_part(ns)
+            if(x_part(ns).ge.x_head) then
+               x_part(ns)=x_head
+               nx_s=nx_s-1
+               dt_part(ns)=dt(head_cell(nr))
+            end if
+         end if
+ 200     continue
+         if(nx_part.lt.1) nx_part=1
+         nstrt_elm(ns)=nx_part
+         no_dt(ns)=nx_s
+      end do
+      DONE=.FALSE.
+      do ns=1,no_celm(nr)
+         ncell=segment_cell(nr,ns)
+         itest=no_celm(nr)
 c
 c     Net solar radiation (kcal/meter^2/second)
 c
@@ -482,169 +685,116 @@ c     phper
 c
 
 
- 250                 continue
+ 250     continue
 c
 c     Now do the third-order interpolation to
 c     establish the starting temperature values
 c     for each parcel
 c
-                     nseg=nstrt_elm(ns)
-                     npndx=1
+         nseg=nstrt_elm(ns)
+         npndx=1
 c
 c     If starting element is the first one, then set
 c     the initial temperature to the boundary value
 c
-                     if (nseg.eq.1) then
-                        t0=T_head(nr)
-                        go to 350
-                     end if
+         if (nseg.eq.1) then
+            t0=T_head(nr)
+            go to 350
+         end if
 c
 c     Perform polynomial interpolation
 c
-                     do ntrp=1,nterp(npndx)
-                        npart=nseg+ntrp+ndltp(npndx)-1
-                        nptest(ntrp)=npart
-                        xa(ntrp)=x_dist(nr,npart)
-                        ta(ntrp)=temp(nr,npart,n1)
-                     end do
-                     x=x_part(ns)
-  280                continue
+         do ntrp=1,nterp(npndx)
+            npart=nseg+ntrp+ndltp(npndx)-1
+            nptest(ntrp)=npart
+            xa(ntrp)=x_dist(nr,npart)
+            ta(ntrp)=temp(nr,npart,n1)
+         end do
+         x=x_part(ns)
+  280    continue
 c
 c     Call the interpolation function
 c
 
-                     t0=tntrp(xa,ta,x,nterp(npndx))
-                     ttrp=t0
- 300                 continue
- 350                 continue
-                     dt_calc=dt_part(ns)
-                     nncell=segment_cell(nr,nstrt_elm(ns))
+         t0=tntrp(xa,ta,x,nterp(npndx))
+         ttrp=t0
+ 300     continue
+ 350     continue
+         dt_calc=dt_part(ns)
+         nncell=segment_cell(nr,nstrt_elm(ns))
 c
 c    Set NCELL0 for purposes of tributary input
 c
-                     ncell0=nncell
-                     dt_total=dt_calc
-                     do nm=no_dt(ns),1,-1
-                       u_river=u(nncell)/3.2808
-                       z=depth(nncell)
-                       call energy
-     &                      (t0,QSURF,A,B,ncell)
-                       t_eq=-B/A
-                       qdot=qsurf/(z*rfac)
-                       t0=t0+qdot*dt_calc  
+         ncell0=nncell
+         dt_total=dt_calc
+         do nm=no_dt(ns),1,-1
+           u_river=u(nncell)/3.2808
+           z=depth(nncell)
+           call energy
+     &          (t0,QSURF,A,B,ncell)
+           t_eq=-B/A
+           qdot=qsurf/(z*rfac)
+           t0=t0+qdot*dt_calc
 
-                       if(t0.lt.0.0) t0=0.0
- 400                   continue
+           if(t0.lt.0.0) t0=0.0
+ 400       continue
 c
 c     Look for a tributary.
-c 
-                       q1=qin(nncell)
+c
+           q1=qin(nncell)
 
-                       ntribs=no_tribs(nncell)
-                       if (ntribs.gt.0.and..not.DONE) then
-                         do ntrb=1,ntribs
-                           nr_trib=trib(nncell,ntrb)
-                           q2=q1+q_trib(nr_trib)
-                           t0=(q1*t0+q_trib(nr_trib)*T_trib(nr_trib))/q2
-                           q1=q1+q_trib(nr_trib)
+           ntribs=no_tribs(nncell)
+           if (ntribs.gt.0.and..not.DONE) then
+             do ntrb=1,ntribs
+               nr_trib=trib(nncell,ntrb)
+               q2=q1+q_trib(nr_trib)
+               t0=(q1*t0+q_trib(nr_trib)*T_trib(nr_trib))/q2
+               q1=q1+q_trib(nr_trib)
 c
   450 continue
-                         end do
-                         DONE=.TRUE.
-                       end if
-                       t00=t0
-                       if (lat_flow(nncell).gt.0) then
-                          q1=0.5*(qin(nncell)+qout(nncell))
-                          q2=q1+lat_flow(nncell)
+             end do
+             DONE=.TRUE.
+           end if
+           t00=t0
+           if (lat_flow(nncell).gt.0) then
+              q1=0.5*(qin(nncell)+qout(nncell))
+              q2=q1+lat_flow(nncell)
 c
 c  Modified nonpoint source temperature so as to be the same
 c  as the instream simulated temperature for Connecticut River 7/2015
-                          T_dist=t0
-                          t0=(q1*t0+lat_flow(nncell)*T_dist)/q2
-                          dtlat=t0-t00
-                        end if
- 500                    continue
-                        nseg=nseg+1
-                        nncell=segment_cell(nr,nseg)
+              T_dist=t0
+              t0=(q1*t0+lat_flow(nncell)*T_dist)/q2
+              dtlat=t0-t00
+            end if
+ 500        continue
+            nseg=nseg+1
+            nncell=segment_cell(nr,nseg)
 c
 c     Reset tributary flag is this is a new cell
 c
-                        if (ncell0.ne.nncell) then
-                           ncell0=nncell
-                           DONE=.FALSE.
-                        end if
-                        dt_calc=dt(nncell)
-                        dt_total=dt_total+dt_calc
-                      end do
-                      if (t0.lt.0.5) t0=0.5
-                     temp(nr,ns,n2)=t0
-	             T_trib(nr)=t0
-c
-c   Write file 20 with all temperature output 11/19/2008
-c
-                     nsmod=mod(ns,2)
-                     time=year+(day-1.+hour_inc*period)/xd_year
-                     if(nsmod.eq.0) then
-                       rmile_plot=x_dist(nr,ns)/5280.
-                       write(20,'(f11.5,i5,1x,i4,1x,2i5,1x,5f7.2,f9.2)') 
-     &                       time,nyear,nd,ncell,ns,t0
-     &                      ,T_head(nr),dbt(ncell)
-     &                      ,depth(ncell),u(ncell),qin(ncell)
-
-                     end if
+            if (ncell0.ne.nncell) then
+               ncell0=nncell
+               DONE=.FALSE.
+            end if
+            dt_calc=dt(nncell)
+            dt_total=dt_total+dt_calc
+           end do
+         if (t0.lt.0.5) t0=0.5
+         temp(nr,ns,n2)=t0
+         T_trib(nr)=t0
 c
 c     End of computational element loop
 c
 
-                  end do
-c     End of reach loop
-c
-
-               end do
-               ntmp=n1
-               n1=n2
-               n2=ntmp
-c
-c     End of weather period loop (NDD=1,NWPD)
-c
-            end do
-c
-c Reset daily loop counter
-c
-          nd_start=1
-c 
-C
-c     End of main loop (ND=1,365/366)
-c
-
-         end do
-c
-c    Update initial time for new year
-c
-      year=year+1
-c
-c     End of year loop
-c
       end do
-c
-c Finish
-c
-  900 Continue
-c
-c
-c     ******************************************************
-c                        return to rmain
-c     ******************************************************
-c
-
-  950 return
-      end
+      RETURN
+      END
       SUBROUTINE ENERGY
      &           (TSURF,QSURF,A,B,ncell)
+      use RBM_Data
       REAL*4 Ksw,LVP
       real*4 q_fit(2),T_fit(2),evrate
-      INCLUDE 'RBM.fi'
-      data evrate/1.5e-9/,pf/0.640/
+      data evrate/1.5e-9/
       parameter (pi=3.14159)
 c     
       td=nd
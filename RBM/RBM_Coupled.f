@@ -0,0 +1,104 @@
+c
+c     RBM_Coupled - entry points for running RBM inside DHSVM.
+c
+c     DHSVM (DHSVM/sourcecode/channel_rbm.c) calls these through
+c     ISO_C_BINDING instead of writing <Prefix>.forcing(.bin) and
+c     running the RBM program afterwards.  Every time step it passes
+c     the forcing of all cells, in network order, as the nine values
+c     of a <Prefix>.forcing.bin record.  The reaches are advanced with
+c     the same subroutines as the RBM program and <Prefix>.temp is
+c     written in the same format.
+c
+      subroutine rbm_coupled_init(prefix,nprefix,nwpd_in,ncell_out)
+     &  bind(C,name='rbm_coupled_init')
+      use iso_c_binding
+      use RBM_Data
+      integer(c_int), value :: nprefix,nwpd_in
+      character(kind=c_char) :: prefix(nprefix)
+      integer(c_int) :: ncell_out
+      character(len=:), allocatable :: name
+c
+      allocate(character(len=nprefix) :: name)
+      do n=1,nprefix
+        name(n:n)=prefix(n)
+      end do
+      open(unit=20,file=name//'.temp',status='unknown')
+      open(40,file=name//'.Mohseni',STATUS='old')
+      open(50,file=name//'.Leopold',STATUS='old')
+      OPEN(UNIT=90,FILE=name//'.net',STATUS='OLD')
+      do n=1,5
+        read(90,*)
+      end do
+c
+c     The forcing header is not read, DHSVM supplies the number of
+c     periods per day and starts with the first one
+c
+      nwpd=nwpd_in
+      nd_start=1
+      CALL BEGIN
+      CALL START_STATE
+      CLOSE(40)
+      CLOSE(50)
+      CLOSE(90)
+      ncell_out=ncell_total
+      RETURN
+      END
+      subroutine rbm_coupled_step(forcing,nyear,jday,nperiod)
+     &  bind(C,name='rbm_coupled_step')
+c
+c     Advance the temperatures by one time step.  FORCING holds
+c     press, dbt, qna, qns, ea, wind, melt, qin and qout of each cell.
+c     NYEAR, JDAY and NPERIOD give the time as in SYSTMM.
+c
+      use iso_c_binding
+      use RBM_Data
+      real(c_float), intent(in) :: forcing(9,*)
+      integer(c_int), value :: nyear,jday,nperiod
+      real*8 year
+      real day,period,hour_inc,xd_year
+c
+      l_seg=0
+      do nr=1,nreach
+        do nc=1,no_cells(nr)
+          l_seg=l_seg+1
+          press(l_seg)=forcing(1,l_seg)
+          dbt(l_seg)=forcing(2,l_seg)
+          qna(l_seg)=forcing(3,l_seg)
+          qns(l_seg)=forcing(4,l_seg)
+          ea(l_seg)=forcing(5,l_seg)
+          wind(l_seg)=forcing(6,l_seg)
+          qin(l_seg)=forcing(8,l_seg)
+          qout(l_seg)=forcing(9,l_seg)
+          CALL CELL_FLOW(l_seg)
+        end do
+        q_trib(nr)=qout(l_seg)
+      end do
+      nd=jday
+      CALL ADVANCE
+c
+      hour_inc=1./nwpd
+      year=nyear
+      day=jday
+      period=nperiod
+      xd_year=365.
+      if (mod(nyear,4).eq.0) xd_year=366.
+      time=year+(day-1.+hour_inc*period)/xd_year
+      CALL WRITE_TEMP(nyear,jday)
+      RETURN
+      END
+      subroutine rbm_coupled_close() bind(C,name='rbm_coupled_close')
+c
+c     Close <Prefix>.temp and release the network
+c
+      use iso_c_binding
+      use RBM_Data
+      CLOSE(20)
+      deallocate(no_celm,no_cells,main_stem,last_seg,head_cell
+     &          ,q_trib,T_trib,elev,alf_Mu,beta,gmma,mu
+     &          ,T_head,T_smth,level_rch,level_start)
+      deallocate(no_tribs,node,lat_flow,trib,qin,qout,qdiff,depth
+     &          ,width,D_a,D_b,D_min,U_a,U_b,U_min,dx,dt,u
+     &          ,QNS,QNA,DBT,WIND,EA,PRESS)
+      deallocate(segment_cell,x_dist,temp)
+      RETURN
+      END
@@ -0,0 +1,70 @@
+C
+C     RBM_Data - shared state of the river basin model.
+C
+C     Replaces the fixed-size COMMON blocks of RBM.fi.  Reach arrays
+C     are indexed 1:nreach, cell arrays 0:ncell_total (cell 0 is the
+C     empty cell past the end of a reach) and segment arrays by
+C     reach and segment.  Everything is allocated in BEGIN once the
+C     network file has been scanned, except the headwater state,
+C     which is allocated in START_STATE.
+C
+      module RBM_Data
+C
+C     UNDIMENSIONED INTEGER VARIABLES
+C
+      integer flow_cells,heat_cells
+     & ,NDAYS,nreach,nysim
+     & ,nyear1,nyear2
+     & ,n1,n2,no_rch,nwpd,nd,nd_start
+     & ,start_year,start_month,start_day,start_hour
+     & ,end_year,end_month,end_day,end_hour
+     & ,nforce_bin,ncell_total
+c
+c     Array extents: segments per reach and tributaries per cell
+c
+      integer max_seg,max_tribs
+c
+c     Reaches grouped by dependency level for the reach loop in
+c     SYSTMM (see REACH_LEVELS)
+c
+      integer no_levels
+      integer, allocatable :: level_rch(:),level_start(:)
+C
+C     UNDIMENSIONED FLOATING POINT VARIABLES
+C
+      real a_smooth,b_smooth,dt_comp
+     &    ,QSUM,temp_init
+     &    ,XTITLE,ysim,delta_n
+      real*8 time
+      real :: PF=0.640
+      real PHPER
+C
+C     Reach properties
+C
+      integer, allocatable :: no_celm(:),no_cells(:)
+     & ,main_stem(:),last_seg(:),head_cell(:)
+      real, allocatable :: q_trib(:),T_trib(:),elev(:)
+     & ,alf_Mu(:),beta(:),gmma(:)
+      real*4, allocatable :: mu(:)
+c
+c     Headwater temperatures and smoothed headwater air temperatures
+c
+      real*4, allocatable :: T_head(:),T_smth(:)
+C
+C     Cell hydraulics, Leopold coefficients and meteorology
+C
+      integer, allocatable :: no_tribs(:),node(:),lat_flow(:)
+     & ,trib(:,:)
+      real, allocatable :: qin(:),qout(:)
+     & ,qdiff(:),depth(:),width(:)
+     & ,D_a(:),D_b(:),D_min(:)
+     & ,U_a(:),U_b(:),U_min(:)
+     & ,dx(:),dt(:),u(:)
+     & ,QNS(:),QNA(:),DBT(:),WIND(:),EA(:),PRESS(:)
+C
+C     Segment geometry and temperatures
+C
+      integer, allocatable :: segment_cell(:,:)
+      real, allocatable :: temp(:,:,:),x_dist(:,:)
+c
+      end module RBM_Data
@@ -0,0 +1,123 @@
+c
+c      PROGRAM RMAIN
+C
+C     Dynamic river basin model for simulating water quality in
+C     branching river systems with freely-flowing river segments. 
+c
+c     This version uses Reverse Particle Tracking in the Lagrangian
+c     mode and Lagrangian interpolation in the Eulerian mode.
+c
+c     Topology and routing is set up to be consistent with output
+c     from the Distributed Hydrologic Soil and Vegetation Model (DHSVM)
+c     model developed by the Land Surface Hydrology Group at 
+c     the University of Washington.
+c
+C     For additional information visit:
+c
+c     http://www.hydro.washington.edu/Lettenmaier/Models/DHSVM/
+c
+c     or contact:
+c
+C     John Yearsley
+C     Land Surface Hydrology Group
+C     Dept. of Civil and Environmental Engineering
+C     Box 352700
+C     University of Washington
+C     Seattle, Washington
+C     98195-2700
+C     yearsley@hydro.washington.edu
+C
+      use RBM_Data
+      character*8  start_data,end_data     
+      character*200 Prefix
+      integer iargc
+      integer numarg
+      real*4 rec_forcing(9)
+      logical lbin
+      character*200 line
+ 
+c     Command line input
+c
+      numarg = iargc ( )
+      if (numarg .lt. 1) then
+        write (*,*) 'Too few arguments were given'
+        write (*,*) ' '
+        write (*,*) 'First:  Location and prefix of input file'
+        write (*,*) '        (networkfile)'
+        write (*,*) 'eg: $ <program-name> <Project Name>'
+        write (*,*) ' '
+        stop
+      end if
+      call getarg ( 1, Prefix )
+c
+c     Identify and open necessary files
+c
+c     open the output file 
+      open(unit=20,file=TRIM(Prefix)//'.temp',status='unknown')
+c
+c     Open file with weather and inflow data
+      write(*,*) 'Forcing file -  ', TRIM(Prefix)//'.forcing'
+      open(unit=30,file=TRIM(Prefix)//'.forcing',STATUS='old')
+c
+c     If DHSVM wrote the forcing directly, <Prefix>.forcing only has
+c     the header and the data are in the direct access file
+c     <Prefix>.forcing.bin, one record per cell per time step.
+c     A .forcing with data after the header was written by Create_File,
+c     so any .forcing.bin next to it is left over from an earlier run
+      inquire(file=TRIM(Prefix)//'.forcing.bin',exist=lbin)
+      if (lbin) then
+        read(30,*)
+        read(30,'(A)',end=10) line
+        if (LEN_TRIM(line).gt.0) then
+          write(*,*) 'Text forcing has data, ignoring ',
+     &               TRIM(Prefix)//'.forcing.bin'
+          lbin=.false.
+        end if
+   10   rewind(30)
+      end if
+      nforce_bin=0
+      if (.not.lbin) then
+        write(*,*) 'Text forcing -   ', TRIM(Prefix)//'.forcing'
+      else
+        write(*,*) 'Binary forcing - ', TRIM(Prefix)//'.forcing.bin'
+        inquire(iolength=lrec) rec_forcing
+        open(unit=31,file=TRIM(Prefix)//'.forcing.bin',STATUS='old'
+     &      ,access='direct',form='unformatted',recl=lrec)
+        nforce_bin=1
+      end if
+C
+c     open Mohseni file 
+      open(40,file=TRIM(Prefix)//'.Mohseni',STATUS='old')    
+c
+c     open Leopold file 
+      open(50,file=TRIM(Prefix)//'.Leopold',STATUS='old')    
+c
+c     Open network file
+      OPEN(UNIT=90,FILE=TRIM(Prefix)//'.net',STATUS='OLD')
+c
+c     Read header information from control file
+      do n=1,5
+        read(90,*)
+      end do
+c
+C     Call systems programs to get started
+C
+C     SUBROUTINE READ_HEADER reads the times from the forcing file,
+C     SUBROUTINE BEGIN reads control file, sets up topology and
+C     important properties of reaches
+      write(*,*) 'Calling BEGIN'
+      CALL READ_HEADER
+      CALL BEGIN
+C
+C     SUBROUTINE SYSTMM performs the simulations
+C
+      CALL SYSTMM
+C
+C     Close files after simulation is complete
+C
+      write(*,*) ' Closing files after simulation'
+      CLOSE(30)
+      if (nforce_bin.eq.1) CLOSE(31)
+      CLOSE(90)
+      STOP
+      END
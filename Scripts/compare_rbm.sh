@@ -0,0 +1,76 @@
+#!/bin/sh
+# Regression check of the in-process RBM (RBM Coupled = TRUE) against the
+# stand-alone RBM program (RBM/RBM_Main.f).
+#
+# DHSVM is run twice from the same configuration file:
+#   1. RBM Coupled = FALSE: DHSVM writes <project>.forcing(.bin), then the
+#      RBM program is run on it
+#   2. RBM Coupled = TRUE:  DHSVM runs RBM inside the time loop
+# and the two <project>.temp files are compared.  They should be identical.
+#
+# usage: compare_rbm.sh <DHSVM> <RBM> <config file> <project> [work dir]
+#   <project>   prefix of the RBM input files <project>.net,
+#               <project>.Leopold, <project>.Mohseni and <project>.segmap
+#               (from build_DHSVM_network.pl)
+#   <work dir>  scratch directory, default ./rbm_compare
+# The configuration file must have Stream Temperature = TRUE.  Relative
+# paths in it are taken relative to the directory of the file.
+
+if [ $# -lt 4 ]; then
+  echo "usage: $0 <DHSVM> <RBM> <config file> <project> [work dir]"
+  exit 2
+fi
+
+abspath() {
+  (cd "`dirname "$1"`" && echo "`pwd`/`basename "$1"`")
+}
+
+dhsvm=`abspath "$1"`
+rbm=`abspath "$2"`
+config=`abspath "$3"`
+project=`abspath "$4"`
+work=${5:-./rbm_compare}
+mkdir -p "$work" || exit 2
+work=`cd "$work" && pwd`
+name=`basename "$project"`
+configdir=`dirname "$config"`
+
+# one project and output directory per run
+for run in forcing coupled; do
+  mkdir -p "$work/$run/project" "$work/$run/output" || exit 2
+  for ext in net Leopold Mohseni segmap; do
+    cp "$project.$ext" "$work/$run/project/" || exit 2
+  done
+  rm -f "$work/$run/project/$name.temp" "$work/$run/project/$name.forcing" \
+        "$work/$run/project/$name.forcing.bin"
+  if [ $run = coupled ]; then coupled=TRUE; else coupled=FALSE; fi
+  sed -e '/^[ \t]*RBM Forcing Project[ \t]*=/Id' \
+      -e '/^[ \t]*RBM Coupled[ \t]*=/Id' \
+      -e '/^[ \t]*RBM Text Output[ \t]*=/Id' \
+      -e "s|^\([ \t]*Output Directory[ \t]*=\).*|\1 $work/$run/output/|I" \
+      -e "/^[ \t]*Stream Temperature[ \t]*=/Ia\\
+RBM Text Output = FALSE\\
+RBM Forcing Project = $work/$run/project/$name\\
+RBM Coupled = $coupled" \
+      "$config" > "$work/$run.config" || exit 2
+done
+
+cd "$configdir" || exit 2
+
+echo "DHSVM, RBM forcing (log in $work/forcing.log)"
+"$dhsvm" "$work/forcing.config" > "$work/forcing.log" 2>&1 || {
+  echo "DHSVM failed"; exit 1; }
+echo "RBM (log in $work/rbm.log)"
+"$rbm" "$work/forcing/project/$name" > "$work/rbm.log" 2>&1 || {
+  echo "RBM failed"; exit 1; }
+
+echo "DHSVM, RBM coupled (log in $work/coupled.log)"
+"$dhsvm" "$work/coupled.config" > "$work/coupled.log" 2>&1 || {
+  echo "DHSVM failed"; exit 1; }
+
+if cmp "$work/forcing/project/$name.temp" "$work/coupled/project/$name.temp"; then
+  echo "$name.temp identical"
+  exit 0
+fi
+echo "$name.temp differs between RBM and the coupled run"
+exit 1
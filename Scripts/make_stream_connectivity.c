@@ -6,295 +6,334 @@ Program: computes radiation attenuation for each stream segment at each time ste
 	-> headwater segments have no upstream segment
 	-> most segments have one upstream segment
 	-> confluence segments have an array of upstream segment
-  
+
   - azimuth.txt : ( all in same file)
 	-> estimated azimuth, use ArcInfo if need exact azimuth
 	-> segments are straight lines, get the 2 extremities x and y and
-	    derive the angle from north. The angle is +/- 180 because does 
+	    derive the angle from north. The angle is +/- 180 because does
 	    not take into account the flow direction.
             then get the 180-atan(dx/dy)
-	->NEVERMIND, azimuth provided in the map file, get the idea anyway 
+	->NEVERMIND, azimuth provided in the map file, get the idea anyway
         -> see SlopeAscpect.c
         -> NOTE that azimuth was derived by Lan but does not seem the default ( default is aspect?)
 
 Modified: Mar 12, 2014
+
+  - All tables are sized from the input files.  Segment ids are looked up
+    through a hash table, and the upstream segment lists and the cell lists
+    of each segment are built as compressed (offset + index) arrays in two
+    passes, so the run time is linear in the number of segments plus the
+    number of map cells and there is no limit on either.
+  - Blank lines and lines starting with # are skipped in both input files.
+  - <Nseg> is only used as a check; enter 0 to skip it.
 ******************************************************************************************************/
 #include <stdio.h>
 #include <stdlib.h>
 #include <math.h>
 #include <string.h>
 
-// to be updated for large basins as needed
-#define MAXCONV 15000	/* maxinum number of segments converging */ 
-#define MAX_XY  15000	/* max number of cell[x,y] crossed by one segment */
+#define LINESIZE 1024
+
+typedef struct {
+  int id;		/* segment id */
+  int next;		/* downstream segment id */
+  float length;		/* segment length */
+} SEGMENT;
+
+typedef struct {
+  int id;		/* segment id the cell belongs to */
+  float length;		/* length of the segment in the grid cell */
+  float elev;		/* elevation (cut depth) of the segment in the grid cell */
+  float azim;		/* azimuth of the segment in the grid cell */
+} SEGCELL;
+
+typedef struct {
+  int *key;
+  int *value;
+  int size;		/* power of 2 */
+} IDHASH;
+
+void *xrealloc(void *p, size_t n, const char *name);
+void hash_init(IDHASH *h, int n);
+int hash_find(IDHASH *h, int id);
+void hash_insert(IDHASH *h, int id, int value);
+int is_comment(const char *line);
 
 int main (int argc, char** argv)
 {
- int x, y, id, NX, NY, Nseg, seg;
- float length;
+ int x, y, id, Nseg, seg, nseg, ncell, ncellalloc, nsegalloc;
  int i;             /* counter */
- int *next; 		/* downstream seg id for present id*/
- int **before;		/* upstream seg id for present id */
- int *ct_before; 	/* number of upstream seg for present id */
- int *ct_id;		/* number of cells[x,y] crossed by seg id */
- int *segid;		/* seg id for seg number */
- int **seg_id;		/* seg id present in [x,y] */
- float *seg_length; /* segment length */
- int *x_id;		    /* x of [x,y] number ct_id in segment id; */
- int *y_id;		    /* y of [x,y] number ct_id in segment id; */
  int data;          /* temporarily store the destination cell */
- float *length_id;	        /* lenght of the entire cell id */
- float **length_xy;	        /* lenght if segment in gridcell*/ 
- float **azim_xy, dataf;    /* azimuth of the segment */
- float **elev_xy, hxy;      /* elevation of the segment */
- float lid,lxy, hid;
- char convergence[150], outputdir[100];
+ SEGMENT *segs;     /* segments in network file order */
+ SEGCELL *cells;    /* map file records in file order */
+ IDHASH segindex;   /* seg id -> index into segs */
+ int *up_start;	    /* upstream segments of segs[i] are up_list[up_start[i]..up_start[i+1]) */
+ int *up_list;
+ int *cell_start;   /* cells of segs[i] are cell_list[cell_start[i]..cell_start[i+1]) */
+ int *cell_list;
+ int *fill;
+ float *length_id;  /* length of the entire segment id */
+ float lid, hid, lxy, hxy, dataf, junkf;
+ char convergence[BUFSIZ], line[LINESIZE];
  int junki;
- float junkf;
- char junkc[350];
  int nskip;        /* header line number in stream map file */
  FILE *fmap,*fnetwork,*fconv;
- int NsegDummy;
 
 if (argc != 6 ){
   printf("Command line arguments: enter <mapfile> <networkfile> <output directory> <Nseg> <skip>\n");
   printf("skip = lines of the header in stream map file\n");
+  printf("Nseg = number of segments expected in the network file, 0 to skip the check\n");
   exit (0);
  }
  sscanf(argv[4],"%d", &Nseg);
  sscanf(argv[5],"%d", &nskip);
 
- Nseg++; // Nseg is 1 greater than the original hereafter
- NsegDummy = Nseg + 400;  //Increase the dimension of the matrix in case that streamnetwork is mannually 
-                          //modified to remove the redundant outlet "-1".
- 
  /*handle file names */
  fmap = fopen(argv[1], "r");
  if (fmap == NULL) {
-   fprintf(stderr,"NULL  %s \n", argv[1]); 
+   fprintf(stderr,"NULL  %s \n", argv[1]);
    exit(-1);
  }
  fprintf(stdout, " %s opened for reading\n", argv[1]);
 
  fnetwork = fopen(argv[2], "r");
- if (fmap == NULL) {
-   fprintf(stderr,"NULL  %s \n", argv[2]); 
+ if (fnetwork == NULL) {
+   fprintf(stderr,"NULL  %s \n", argv[2]);
    exit(-1);
  }
  fprintf(stdout, " %s opened for reading\n", argv[2]);
 
- sprintf(outputdir,argv[3]);
- strcpy(convergence, outputdir);
- strcat(convergence, "convergence.txt");
+ snprintf(convergence, sizeof(convergence), "%sconvergence.txt", argv[3]);
  fprintf(stdout, " %s opened for writing \n", convergence);
 
- /* allocate */
- if (!(segid = (int*) calloc(NsegDummy, sizeof(int)))) {
-   fprintf(stderr,"Failed to allocate variable 'segid'\n"); 
-   exit(-1);
- }
-
- if (!(seg_length = (float*) calloc(NsegDummy, sizeof(float)))) {
-   fprintf(stderr,"Failed to allocate variable 'segid'\n"); 
-   exit(-1);
- }
-
- if (!(next = (int*) calloc(NsegDummy, sizeof(int)))) {
-   fprintf(stderr,"Failed to allocate variable 'next'\n"); 
-   exit(-1);
- }
- if (!(before = (int**) calloc(MAXCONV,sizeof(int*)))) {
-   fprintf(stderr,"Failed to allocate variable 'before'\n"); 
-   exit(-1);
- }
- for (seg = 0; seg < MAXCONV; seg++){
-   if (!(before[seg] = (int*) calloc(NsegDummy, sizeof(int)))) {
-	 fprintf(stderr, "Failed to allocate variable 'before'\n");
-	 exit(-1);
+ /***** read network file *****/
+ nseg = 0;
+ nsegalloc = 1024;
+ segs = (SEGMENT *) xrealloc(NULL, nsegalloc * sizeof(SEGMENT), "segs");
+ while (fgets(line, LINESIZE, fnetwork) != NULL) {
+   if (is_comment(line))
+     continue;
+   /* the 6th column of the network file is the destination segment of
+   the present segment; anything after it (SAVE flag and name) is ignored */
+   if (sscanf(line, "%d %d %f %f %d %d", &id, &junki, &junkf, &dataf, &junki, &data) != 6) {
+     fprintf(stderr, "error reading %s at segment %d\n", argv[2], nseg);
+     exit(-1);
    }
+   if (nseg == nsegalloc) {
+     nsegalloc *= 2;
+     segs = (SEGMENT *) xrealloc(segs, nsegalloc * sizeof(SEGMENT), "segs");
+   }
+   segs[nseg].id = id;
+   segs[nseg].next = data;
+   segs[nseg].length = dataf;
+   nseg++;
  }
- if (!(ct_before = (int*) calloc(NsegDummy,sizeof(int)))) {
-   fprintf(stderr, "Failed to allocate variable 'ct_before'\n");
-   exit(-1);
- }
- if (!(ct_id = (int*) calloc(NsegDummy,sizeof(int)))) {
-   fprintf(stderr, "Failed to allocate variable 'ct_id'\n");
-   exit(-1);
- }
- if (!(length_id = (float*)calloc(NsegDummy,sizeof(float)))) {
-   fprintf(stderr, "Failed to allocate variable 'length_id'\n");
-   exit(-1);
- }
- if (!(azim_xy = (float**)calloc(MAX_XY,sizeof(float*)))) {
-   fprintf(stderr, "Failed to allocate variable 'azim_xy'\n");
-   exit(-1);
- }
- if (!(elev_xy = (float**)calloc(MAX_XY,sizeof(float*)))) {
-   fprintf(stderr, "Failed to allocate variable 'elev_xy'\n");
-   exit(-1);
- }
- if (!(length_xy = (float**)calloc(MAX_XY,sizeof(float*)))) {
-   fprintf(stderr, "Failed to allocate variable 'length_xy'\n");
+ fclose(fnetwork);
+ fprintf(stdout,"Read %d segments\n", nseg);
+ if (Nseg > 0 && nseg != Nseg) {
+   fprintf(stderr,"Error in the number of segment expected\n");
    exit(-1);
  }
- for (x = 0; x < MAX_XY; x++){
-   if (!(length_xy[x] = (float*) calloc(NsegDummy,sizeof(float)))) {
-	 fprintf(stderr, "Failed to allocate variable 'length_xy'\n");
-     exit(-1);
-   }
-   if (!(elev_xy[x] = (float*) calloc(NsegDummy,sizeof(float)))) {
-	 fprintf(stderr, "Failed to allocate variable 'elev_xy'\n");
-     exit(-1);
-   }
-   if (!(azim_xy[x] = (float*) calloc(NsegDummy,sizeof(float)))) {
-	 fprintf(stderr, "Failed to allocate variable 'azim_xy'\n");
-     exit(-1);
-   }
-  }
 
- /***** read network file *****/
- seg = -1;
- while (!feof(fnetwork)){
-   seg++;
-   if (seg >= Nseg) {
-     fprintf(stderr,
-		 "Increase the maximum number of segment in the basin in the code (Nseg)\n");
+ hash_init(&segindex, nseg);
+ for (seg = 0; seg < nseg; seg++) {
+   if (hash_find(&segindex, segs[seg].id) >= 0) {
+     fprintf(stderr, "segment id %d appears twice in %s\n", segs[seg].id, argv[2]);
      exit(-1);
-   }  
-
-   /* the 6th column of the network file is the destination segment of 
-   the present segment */
-   if (fscanf(fnetwork, "%d %d %f %f %d %d \n",&id,&junki,&junkf,&length,&junki,&data)!= 6){
-	 /* if the segment is the outlet, then it has 7 columns.
-	 Here just to skip reading the last save flags */
-	 if (data == 0 || data == -1 ) {
-		fgets(junkc, 100, fnetwork);
-		seg--;
-	 }
-	 else {
-       fprintf(stderr, "error reading %s at segment %d\n", argv[2], seg);
-       exit(-1);
-	 }
-   }
-   segid[seg] = id;
-   seg_length[seg] = length;
-   
-   /* assign the destination cell to the present channel id */
-   next[id] = data;
-   if (data == -1 ) {
-	 data = 0; // outlet case of -1;
-	 printf("next-id = %d\n", next[51]);
    }
+   hash_insert(&segindex, segs[seg].id, seg);
+ }
 
-   ct_before[data]++;
-   if ( ct_before[data] >= MAXCONV ) {
-     fprintf(stderr,"Increase max num of stream that can converge at once %d\n",ct_before[next[id]]);
-     fprintf(stderr,"  seg %d , id, %d, next_id %d\n", seg, id, next[id]);
-     exit(-1);
+ /* upstream adjacency: count, then fill in network file order.  Outlets
+    (next = 0 or -1) have no downstream segment */
+ up_start = (int *) xrealloc(NULL, (nseg + 1) * sizeof(int), "up_start");
+ fill = (int *) xrealloc(NULL, (nseg + 1) * sizeof(int), "fill");
+ memset(up_start, 0, (nseg + 1) * sizeof(int));
+ for (seg = 0; seg < nseg; seg++) {
+   if (segs[seg].next > 0) {
+     if ((i = hash_find(&segindex, segs[seg].next)) < 0) {
+       fprintf(stderr, "segment %d drains to unknown segment %d\n",
+	       segs[seg].id, segs[seg].next);
+       exit(-1);
+     }
+     up_start[i + 1]++;
    }
-   before[ct_before[data]][data] = id;
  }
- fclose(fnetwork);
- fprintf(stdout,"Read %d segments\n", seg + 1);
- if ((seg+1) != (Nseg-1)) {
-   fprintf(stderr,"Error in the number of segment expected\n");
-   exit(-1);
+ for (seg = 0; seg < nseg; seg++)
+   up_start[seg + 1] += up_start[seg];
+ up_list = (int *) xrealloc(NULL, (up_start[nseg] + 1) * sizeof(int), "up_list");
+ memcpy(fill, up_start, (nseg + 1) * sizeof(int));
+ for (seg = 0; seg < nseg; seg++) {
+   if (segs[seg].next > 0) {
+     i = hash_find(&segindex, segs[seg].next);
+     up_list[fill[i]++] = segs[seg].id;
+   }
  }
- printf("next-id = %d\n", next[51]);
+
  /************ read map file **************/
 
  /* skip the headers */
  for (i = 0; i < nskip; i++)
-	fgets(junkc, 1000, fmap);
+	fgets(line, LINESIZE, fmap);
 
- while (!feof(fmap)){
-   /* initialize the variables */
-   id = -99;
-   lxy = -99;
-   
+ ncell = 0;
+ ncellalloc = 4096;
+ cells = (SEGCELL *) xrealloc(NULL, ncellalloc * sizeof(SEGCELL), "cells");
+ while (fgets(line, LINESIZE, fmap) != NULL) {
+   if (is_comment(line))
+     continue;
    /* read in cell location, channel id, length and azimuth in sequence */
-   if (fscanf(fmap,"%d %d %d %f %f %f %f \n",&x, &y, &id, &lxy, &hxy, &junkf, &dataf)!= 7){
-     fprintf(stderr, "error reading %s at cell[%d][%d]\n", argv[1], x, y);
+   if (sscanf(line,"%d %d %d %f %f %f %f", &x, &y, &id, &lxy, &hxy, &junkf, &dataf)!= 7){
+     fprintf(stderr, "error reading %s at line: %s\n", argv[1], line);
      exit(-1);
    }
-   length_id[id] += lxy;
-   ct_id[id]++;
-
-   if (ct_id[id] >= MAX_XY) {
-     fprintf(stderr,"Increase MAX_XY: seg_id %d has (%d+1) upstream cells largert than MAX_XY %d\n",id,ct_id[id],MAX_XY);
+   if (hash_find(&segindex, id) < 0) {
+     fprintf(stderr, "cell[%d][%d] belongs to unknown segment %d\n", x, y, id);
      exit(-1);
    }
-   length_xy[ct_id[id]][id] = lxy;
-   azim_xy[ct_id[id]][id] = dataf;
-   elev_xy[ct_id[id]][id] = hxy;
+   if (ncell == ncellalloc) {
+     ncellalloc *= 2;
+     cells = (SEGCELL *) xrealloc(cells, ncellalloc * sizeof(SEGCELL), "cells");
+   }
+   cells[ncell].id = id;
+   cells[ncell].length = lxy;
+   cells[ncell].elev = hxy;
+   cells[ncell].azim = dataf;
+   ncell++;
  }
  fclose(fmap);
 
+ /* per-segment cell lists, in map file order */
+ cell_start = (int *) xrealloc(NULL, (nseg + 1) * sizeof(int), "cell_start");
+ length_id = (float *) xrealloc(NULL, (nseg + 1) * sizeof(float), "length_id");
+ memset(cell_start, 0, (nseg + 1) * sizeof(int));
+ memset(length_id, 0, (nseg + 1) * sizeof(float));
+ for (i = 0; i < ncell; i++) {
+   seg = hash_find(&segindex, cells[i].id);
+   cell_start[seg + 1]++;
+   length_id[seg] += cells[i].length;
+ }
+ for (seg = 0; seg < nseg; seg++)
+   cell_start[seg + 1] += cell_start[seg];
+ cell_list = (int *) xrealloc(NULL, (ncell + 1) * sizeof(int), "cell_list");
+ memcpy(fill, cell_start, (nseg + 1) * sizeof(int));
+ for (i = 0; i < ncell; i++) {
+   seg = hash_find(&segindex, cells[i].id);
+   cell_list[fill[seg]++] = i;
+ }
+
  /******** write convergence file *****/
  fconv = fopen(convergence, "w");
  if (fconv == NULL) {
-   fprintf(stderr,"NULL  %s \n", convergence); 
+   fprintf(stderr,"NULL  %s \n", convergence);
    exit(-1);
  }
 
- for (seg = 0; seg < (Nseg-1); seg++){
-   id = segid[seg];
+ for (seg = 0; seg < nseg; seg++){
+   id = segs[seg].id;
 
-   /* compute the weighted avg azimuth for the diff id based on azim_xy **/
-   y = ct_id[id] ;
-   lid = -99;
-   hid = -99;
-   if (y == 0 && id > 0) {
+   /* compute the length-weighted avg azimuth and elevation for the segment */
+   if (cell_start[seg + 1] == cell_start[seg] && id > 0) {
      fprintf(stderr,"Error zero xy in seg id %d\n",id);
      exit(-1);
    }
-   else {
-     lid = 0;
-	 hid = 0.;
-     for (x = 1; x <= y; x++){
-       lid += azim_xy[x][id] * length_xy[x][id] / length_id[id];
-	   hid += elev_xy[x][id] * length_xy[x][id] / length_id[id];
-     }
-     if ( lid < 0 || lid > 360 ) {
-       fprintf(stderr,"Error azimuth %f\n",lid);
-       exit(-1);
-     }
-	 if (hid < 0) {
-       fprintf(stderr,"Error azimuth %f\n",hid);
-       exit(-1);
-     }
+   lid = 0;
+   hid = 0.;
+   for (i = cell_start[seg]; i < cell_start[seg + 1]; i++) {
+     lid += cells[cell_list[i]].azim * cells[cell_list[i]].length / length_id[seg];
+     hid += cells[cell_list[i]].elev * cells[cell_list[i]].length / length_id[seg];
    }
-   fprintf(fconv,"%d %d %.3f %.2f %.2f ",id, next[id], seg_length[seg], hid, lid);
-   y = ct_before[id] ;
-   if (y > 0)  {
-     for (x = 1; x <= y; x++) {
-       fprintf(fconv," %d ", before[x][id]);
-     }
+   if ( lid < 0 || lid > 360 ) {
+     fprintf(stderr,"Error azimuth %f\n",lid);
+     exit(-1);
    }
+   if (hid < 0) {
+     fprintf(stderr,"Error elevation %f\n",hid);
+     exit(-1);
+   }
+   fprintf(fconv,"%d %d %.3f %.2f %.2f ",id, segs[seg].next, segs[seg].length, hid, lid);
+   for (i = up_start[seg]; i < up_start[seg + 1]; i++)
+     fprintf(fconv," %d ", up_list[i]);
    fprintf(fconv,"\n");
  }
- fclose(fconv);  
+ fclose(fconv);
 
  /***** clean up *****/
- free(segid);
- free(next);
- free(ct_before);
- for (x = 0; x < MAXCONV; x++) 
-   free(before[x]);
- free(before);
-
- free(length_id); 
- for (x = 0; x < MAX_XY; x++) 
-   free(length_xy[x]);
- free(length_xy);
- for (x = 0; x < MAX_XY; x++) 
-   free(azim_xy[x]);
- free(azim_xy);
-
- free(ct_id);
+ free(segs);
+ free(cells);
+ free(segindex.key);
+ free(segindex.value);
+ free(up_start);
+ free(up_list);
+ free(cell_start);
+ free(cell_list);
+ free(fill);
+ free(length_id);
 
  printf("completed .........................\n");
 
  return 0;
 }
 
+/******************************************************************************************************
+  xrealloc: realloc or bail out
+******************************************************************************************************/
+void *xrealloc(void *p, size_t n, const char *name)
+{
+  if (!(p = realloc(p, n))) {
+    fprintf(stderr, "Failed to allocate variable '%s'\n", name);
+    exit(-1);
+  }
+  return p;
+}
+
+/******************************************************************************************************
+  is_comment: blank lines and lines starting with # carry no data
+******************************************************************************************************/
+int is_comment(const char *line)
+{
+  while (*line == ' ' || *line == '\t')
+    line++;
+  return (*line == '#' || *line == '\n' || *line == '\r' || *line == '\0');
+}
+
+/******************************************************************************************************
+  open addressing hash table from segment id to segment index
+******************************************************************************************************/
+void hash_init(IDHASH *h, int n)
+{
+  int i;
+
+  h->size = 16;
+  while (h->size < 2 * n)
+    h->size *= 2;
+  h->key = (int *) xrealloc(NULL, h->size * sizeof(int), "hash");
+  h->value = (int *) xrealloc(NULL, h->size * sizeof(int), "hash");
+  for (i = 0; i < h->size; i++)
+    h->value[i] = -1;
+}
+
+static unsigned int hash_slot(IDHASH *h, int id)
+{
+  return ((unsigned int) id * 2654435761u) & (unsigned int) (h->size - 1);
+}
+
+int hash_find(IDHASH *h, int id)
+{
+  unsigned int i;
+
+  for (i = hash_slot(h, id); h->value[i] >= 0; i = (i + 1) & (h->size - 1))
+    if (h->key[i] == id)
+      return h->value[i];
+  return -1;
+}
+
+void hash_insert(IDHASH *h, int id, int value)
+{
+  unsigned int i;
+
+  for (i = hash_slot(h, id); h->value[i] >= 0; i = (i + 1) & (h->size - 1))
+    ;
+  h->key[i] = id;
+  h->value[i] = value;
+}